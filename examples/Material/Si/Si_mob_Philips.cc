@@ -202,12 +202,16 @@ private:
   //---------------------------------------------------------------------------
   // Electron low field mobility
   PetscScalar ElecMobPhilips(const PetscScalar &p,const PetscScalar &n,const PetscScalar &Tl) const
+  {
+    return ElecMobPhilips(p, n, Tl, ReadDopingNa(), ReadDopingNd());
+  }
+  PetscScalar ElecMobPhilips(PetscScalar p, PetscScalar n, PetscScalar Tl, PetscScalar N_A, PetscScalar N_D) const
   {
     PetscScalar mu_lattice = MMXN_UM*std::pow(Tl/T300,-TETN_UM);
     PetscScalar mu1 = MMXN_UM*MMXN_UM/(MMXN_UM-MMNN_UM)*std::pow(Tl/T300,3*ALPN_UM-1.5);
     PetscScalar mu2 = MMXN_UM*MMNN_UM/(MMXN_UM-MMNN_UM)*sqrt(T300/Tl);
-    PetscScalar Na  = ReadDopingNa()+1e0*std::pow(cm,-3);
-    PetscScalar Nd  = ReadDopingNd()+1e0*std::pow(cm,-3);
+    PetscScalar Na  = N_A+1e0*std::pow(cm,-3);
+    PetscScalar Nd  = N_D+1e0*std::pow(cm,-3);
     PetscScalar Nds = Nd*(1.0+1.0/(CRFD_UM+(NRFD_UM/Nd)*(NRFD_UM/Nd)));
     PetscScalar Nas = Na*(1.0+1.0/(CRFA_UM+(NRFA_UM/Na)*(NRFA_UM/Na)));
     PetscScalar Nsc = Nds+Nas+fabs(p);
@@ -249,12 +253,16 @@ private:
   //---------------------------------------------------------------------------
   // Hole low field mobility
   PetscScalar HoleMobPhilips(const PetscScalar &p,const PetscScalar &n,const PetscScalar &Tl) const
+  {
+    return HoleMobPhilips(p, n, Tl, ReadDopingNa(), ReadDopingNd());
+  }
+  PetscScalar HoleMobPhilips(PetscScalar p, PetscScalar n, PetscScalar Tl, PetscScalar N_A, PetscScalar N_D) const
   {
     PetscScalar mu_lattice = MMXP_UM*std::pow(Tl/T300,-TETP_UM);
     PetscScalar mu1 = MMXP_UM*MMXP_UM/(MMXP_UM-MMNP_UM)*std::pow(Tl/T300,3*ALPP_UM-1.5);
     PetscScalar mu2 = MMXP_UM*MMNP_UM/(MMXP_UM-MMNP_UM)*sqrt(T300/Tl);
-    PetscScalar Na  = ReadDopingNa()+1e0*std::pow(cm,-3);
-    PetscScalar Nd  = ReadDopingNd()+1e0*std::pow(cm,-3);
+    PetscScalar Na  = N_A+1e0*std::pow(cm,-3);
+    PetscScalar Nd  = N_D+1e0*std::pow(cm,-3);
     PetscScalar Nds = Nd*(1.0+1.0/(CRFD_UM+(NRFD_UM/Nd)*(NRFD_UM/Nd)));
     PetscScalar Nas = Na*(1.0+1.0/(CRFA_UM+(NRFA_UM/Na)*(NRFA_UM/Na)));
     PetscScalar Nsc = Nds+Nas+fabs(n);
@@ -335,6 +343,49 @@ public:
     return mu0/adtl::pow(1+adtl::pow(mu0*fabs(Ep)/vsat,BETAP),1.0/BETAP);
   }
 
+  //---------------------------------------------------------------------------
+  // batched version, the doping of each node is gathered first,
+  // then the mobility is evaluated in loops over contiguous arrays
+  void ElecMob_Batch(unsigned int size, const PMI_Context *context,
+                     const PetscScalar *p,  const PetscScalar *n,  const PetscScalar *Tl,
+                     const PetscScalar *Ep, const PetscScalar *Et, const PetscScalar *Tn, PetscScalar *result) const
+  {
+    std::vector<PetscScalar> Na(size), Nd(size);
+    for(unsigned int i=0; i<size; ++i)
+    {
+      Na[i] = ReadDopingNa(context[i]);
+      Nd[i] = ReadDopingNd(context[i]);
+    }
+
+    PMI_SIMD_LOOP
+    for(unsigned int i=0; i<size; ++i)
+    {
+      PetscScalar vsat = VSATN0/(1+VSATN_A*exp(Tl[i]/(2*T300)));
+      PetscScalar mu0  = ElecMobPhilips(p[i], n[i], Tl[i], Na[i], Nd[i]);
+      result[i] = mu0/std::pow(1+std::pow(mu0*fabs(Ep[i])/vsat,BETAN),1.0/BETAN);
+    }
+  }
+
+  void HoleMob_Batch(unsigned int size, const PMI_Context *context,
+                     const PetscScalar *p,  const PetscScalar *n,  const PetscScalar *Tl,
+                     const PetscScalar *Ep, const PetscScalar *Et, const PetscScalar *Tp, PetscScalar *result) const
+  {
+    std::vector<PetscScalar> Na(size), Nd(size);
+    for(unsigned int i=0; i<size; ++i)
+    {
+      Na[i] = ReadDopingNa(context[i]);
+      Nd[i] = ReadDopingNd(context[i]);
+    }
+
+    PMI_SIMD_LOOP
+    for(unsigned int i=0; i<size; ++i)
+    {
+      PetscScalar vsat = VSATP0/(1+VSATP_A*exp(Tl[i]/(2*T300)));
+      PetscScalar mu0  = HoleMobPhilips(p[i], n[i], Tl[i], Na[i], Nd[i]);
+      result[i] = mu0/std::pow(1+std::pow(mu0*fabs(Ep[i])/vsat,BETAP),1.0/BETAP);
+    }
+  }
+
 // constructor
 public:
   GSS_Si_Mob_Philips(const PMIS_Environment &env):PMIS_Mobility(env)
@@ -29,6 +29,10 @@
 #include "mpi.h"
 #endif
 
+#ifdef HAVE_OPENMP
+#include <omp.h>
+#endif
+
 
 #include <cstdlib>
 #include <cstring>
@@ -79,6 +83,22 @@ namespace Genius {
    */
   bool is_last_processor();
 
+  /**
+   * @returns the number of shared memory threads used by each processor.
+   * always 1 when genius is built without OpenMP
+   */
+  unsigned int n_threads();
+
+  /**
+   * set the number of shared memory threads used by each processor
+   */
+  void set_n_threads(unsigned int n);
+
+  /**
+   * @returns the index of the calling thread in [0, n_threads())
+   */
+  unsigned int thread_id();
+
 #ifdef HAVE_MPI
   /**
    * @return MPI_Comm global communicator
@@ -146,6 +166,11 @@ namespace Genius {
      */
     static int  _processor_id;
 
+    /**
+     * The number of shared memory threads of each processor.
+     */
+    static int  _n_threads;
+
 #ifdef HAVE_MPI
     /**
      * MPI_Comm global communicator
@@ -217,6 +242,22 @@ inline bool Genius::is_last_processor()
 }
 
 
+inline unsigned int Genius::n_threads()
+{
+  return static_cast<unsigned int>(GeniusPrivateData::_n_threads);
+}
+
+
+inline unsigned int Genius::thread_id()
+{
+#ifdef HAVE_OPENMP
+  return static_cast<unsigned int>(omp_get_thread_num());
+#else
+  return 0;
+#endif
+}
+
+
 #ifdef HAVE_MPI
 inline  const MPI_Comm & Genius::comm_world()
 {
@@ -101,6 +101,11 @@ private:
   * if we are in mixA mode
   */
  bool            _mixA;
+
+ /**
+  * the DC branch written last, -1 before the first record
+  */
+ int             _branch;
 };
 
 #endif
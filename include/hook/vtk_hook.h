@@ -29,6 +29,9 @@
 #include <vector>
 #include <string>
 
+class VTKIO;
+class AsyncWriter;
+
 /**
  * write vtk file
  */
@@ -67,11 +70,36 @@ public:
 
 private:
 
+  /**
+   * write current solution to vtk file, value is the time (voltage, current, frequency) of XDMF series
+   */
+  void _export_vtk(const std::string & filename, double value);
+
+  /**
+   * keeps the mesh part of vtk grid between output points
+   */
+  VTKIO *         _vtk_io;
+
+  /**
+   * write vtk file in background thread, NULL when async output is disabled
+   */
+  AsyncWriter *   _writer;
+
   /**
    * the output file name
    */
   std::string     _vtk_prefix;
 
+  /**
+   * .vtu, or .pvtu when each processor writes its own piece, .bin for XDMF series
+   */
+  std::string     _vtk_suffix;
+
+  /**
+   * write XDMF series, the geometry is only written when the mesh changed
+   */
+  bool            _xdmf;
+
   /**
   * count
   */
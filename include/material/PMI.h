@@ -36,6 +36,10 @@
 #include "vector_value.h"
 #include "tensor_value.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 
 using namespace adtl;
 
@@ -47,6 +51,13 @@ class FVM_NodeData;
 //enable calibrate
 #define __CALIBRATE__
 
+// hint for vectorizing the loops of batched PMI functions
+#if defined(_OPENMP) && _OPENMP >= 201307
+#define PMI_SIMD_LOOP _Pragma("omp simd")
+#else
+#define PMI_SIMD_LOOP
+#endif
+
 // This is the head file of physical model interface (PMI), which contains base class of:
 //   physical model interface of semiconductor   PMIS
 //   physical model interface of insulator       PMII
@@ -57,29 +68,65 @@ class FVM_NodeData;
 // re-implemented virtual functions.
 
 /**
- * PMI_Environment, this structure will be passed to PMI class when initializing.
- * It contains interface information for linking main genius code to each PMI class
+ * PMI_Context, the evaluation context of PMI functions.
+ * It holds the node to be evaluated, its data, current time and the
+ * independent variable number of automatically differentiation.
+ * Each thread owns one context, so a PMI object can be shared by threads.
  */
-struct PMI_Environment
+struct PMI_Context
 {
   /**
-   * the location of current Point, use "pointer to pointer" method
-   * here pp_point point to p_point in the material class which point to
-   * current Point as a buffer.
+   * current Point
+   */
+  const Point         *    point;
+
+  /**
+   * data of current node
+   */
+  const FVM_NodeData  *    node_data;
+
+  /**
+   * current time
+   */
+  PetscScalar              clock;
+
+  /**
+   * independent variable number of AD, 0 for keeping the current value
+   */
+  unsigned int             ad_num;
+
+  /**
+   * constructor
    */
-  const Point         **    pp_point;
+  PMI_Context()
+  : point(0), node_data(0), clock(0.0), ad_num(0)
+  {}
 
   /**
-   * the location of current node_data, use "pointer to pointer" method
-   * here pp_node_data point to pnode_data in the material class which point to
-   * current FVM_NodeData as a buffer.
+   * constructor
    */
-  const FVM_NodeData **    pp_node_data;
+  PMI_Context(const Point* _point_, const FVM_NodeData *_node_data_, PetscScalar _clock_, unsigned int _ad_num_=0)
+  : point(_point_), node_data(_node_data_), clock(_clock_), ad_num(_ad_num_)
+  {}
+};
+
+
+/**
+ * PMI_Environment, this structure will be passed to PMI class when initializing.
+ * It contains interface information for linking main genius code to each PMI class
+ */
+struct PMI_Environment
+{
+  /**
+   * the evaluation contexts, one for each thread.
+   * they are owned by the material class, PMI reads the one of the calling thread
+   */
+  PMI_Context  *           p_context;
 
   /**
-   * the pointer to current time
+   * the number of evaluation contexts
    */
-  const PetscScalar  *     p_clock;
+  unsigned int             n_context;
 
   /**
    * const pointer to region variables
@@ -114,17 +161,17 @@ struct PMI_Environment
   /**
    * constructor
    */
-  PMI_Environment(const Point** point, const FVM_NodeData **node_data, const PetscScalar *time,
+  PMI_Environment(PMI_Context *context, unsigned int n,
                   const std::map<std::string, SimulationVariable> ** variables,
                   double _m_, double _s_, double _V_, double _C_, double _K_)
-  : pp_point(point), pp_node_data(node_data), p_clock(time), pp_variables(variables), m(_m_), s(_s_), V(_V_), C(_C_), K(_K_)
+  : p_context(context), n_context(n), pp_variables(variables), m(_m_), s(_s_), V(_V_), C(_C_), K(_K_)
   {}
 
   /**
    * constructor
    */
   PMI_Environment(double _m_, double _s_, double _V_, double _C_, double _K_)
-  : pp_point(0), pp_node_data(0), p_clock(0), pp_variables(0), m(_m_), s(_s_), V(_V_), C(_C_), K(_K_)
+  : p_context(0), n_context(0), pp_variables(0), m(_m_), s(_s_), V(_V_), C(_C_), K(_K_)
   {}
 
 };
@@ -284,23 +331,51 @@ protected:
   const std::map<std::string, SimulationVariable>  ** pp_variables;
 
   /**
-   * the location of current point, use "pointer to pointer" method
-   * here pp_point point to p_point in the material class which point to
-   * current Point as a buffer.
+   * the evaluation contexts, one for each thread
    */
-  const Point            **pp_point;
+  PMI_Context            *p_context;
 
   /**
-   * the location of current node_data, use "pointer to pointer" method
-   * here pp_node_data point to pnode_data in the material class which point to
-   * current FVM_NodeData as a buffer.
+   * the number of evaluation contexts
    */
-  const FVM_NodeData    **pp_node_data;
+  unsigned int            n_context;
 
   /**
-   * the pointer to current time
+   * @return the evaluation context of the calling thread, NULL if no context is linked
    */
-  const PetscScalar     *p_clock;
+  const PMI_Context * context() const
+  {
+    if( !p_context ) return 0;
+#ifdef _OPENMP
+    unsigned int t = static_cast<unsigned int>(omp_get_thread_num());
+    return t < n_context ? p_context + t : 0;
+#else
+    return p_context;
+#endif
+  }
+
+  /**
+   * @return data of current node, NULL if not available
+   */
+  const FVM_NodeData * node_data() const
+  {
+    const PMI_Context * c = context();
+    return c ? c->node_data : 0;
+  }
+
+  /**
+   * set the evaluation context of the calling thread, the previous one is returned.
+   * the default batched functions use it to fall back to the scalar version
+   */
+  PMI_Context bind_context(const PMI_Context &c) const
+  {
+    PMI_Context previous;
+    if( !context() ) return previous;
+    PMI_Context * current = const_cast<PMI_Context *>(context());
+    previous = *current;
+    *current = c;
+    return previous;
+  }
 
 protected:
   /**
@@ -321,6 +396,11 @@ protected:
   std::string _calibrate_error_info;
 
 public:
+  /**
+   * aux function return current node.
+   */
+  const Point * ReadPoint () const;
+
   /**
    * aux function return node coordinate.
    */
@@ -498,6 +578,16 @@ public:
    */
   PetscScalar ReadDopingNd () const;
 
+  /**
+   * aux function return total Acceptor concentration of the node in given context
+   */
+  PetscScalar ReadDopingNa (const PMI_Context &c) const;
+
+  /**
+   * aux function return total Donor concentration of the node in given context
+   */
+  PetscScalar ReadDopingNd (const PMI_Context &c) const;
+
   /**
    * aux function return minimal distance to surface
    */
@@ -950,6 +1040,35 @@ public:
    */
   virtual AutoDScalar BB_Tunneling(const AutoDScalar &Tl, const AutoDScalar &E) =0;
 
+  //---------------------------------------------------------------------------
+  // batched functions, evaluate \p size nodes in one call, the ith node is evaluated in \p context[i].
+  // the default implementation calls the scalar function node by node,
+  // model can override them with a vectorized version
+
+  /**
+   * batched version of band gap
+   */
+  virtual void Eg_Batch            (unsigned int size, const PMI_Context *context,
+                                    const PetscScalar *Tl, PetscScalar *result);
+
+  /**
+   * batched version of conduction band shift due to band gap narrowing
+   */
+  virtual void EgNarrowToEc_Batch  (unsigned int size, const PMI_Context *context,
+                                    const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *result);
+
+  /**
+   * batched version of valence band shift due to band gap narrowing
+   */
+  virtual void EgNarrowToEv_Batch  (unsigned int size, const PMI_Context *context,
+                                    const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *result);
+
+  /**
+   * batched version of total recombination rate
+   */
+  virtual void Recomb_Batch        (unsigned int size, const PMI_Context *context,
+                                    const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *result);
+
 
 };
 
@@ -1030,6 +1149,24 @@ public:
   virtual AutoDScalar HoleMob (const AutoDScalar &p,  const AutoDScalar &n,  const AutoDScalar &Tl,
                                const AutoDScalar &Ep, const AutoDScalar &Et, const AutoDScalar &Tp) const=0;
 
+  /**
+   * batched version of electron mobility, evaluate \p size nodes in one call,
+   * the ith node is evaluated in \p context[i].
+   * the default implementation calls the scalar function node by node
+   */
+  virtual void ElecMob_Batch (unsigned int size, const PMI_Context *context,
+                              const PetscScalar *p,  const PetscScalar *n,  const PetscScalar *Tl,
+                              const PetscScalar *Ep, const PetscScalar *Et, const PetscScalar *Tn, PetscScalar *result) const;
+
+  /**
+   * batched version of hole mobility, evaluate \p size nodes in one call,
+   * the ith node is evaluated in \p context[i].
+   * the default implementation calls the scalar function node by node
+   */
+  virtual void HoleMob_Batch (unsigned int size, const PMI_Context *context,
+                              const PetscScalar *p,  const PetscScalar *n,  const PetscScalar *Tl,
+                              const PetscScalar *Ep, const PetscScalar *Et, const PetscScalar *Tp, PetscScalar *result) const;
+
 };
 
 
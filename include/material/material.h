@@ -25,9 +25,11 @@
 #define __material_h__
 
 #include <string>
+#include <vector>
 #include <map>
 
 #include "genius_common.h"
+#include "genius_env.h"
 
 #include "material_define.h"
 #include "physical_unit.h"
@@ -71,17 +73,35 @@ public:
   virtual ~MaterialBase();
 
   /**
-   * mapping Point, its Data and current time to internal image.
-   * the PMI has second order pointer to these internal image.
-   * so PMI can read information
+   * set the evaluation context of the calling thread.
+   * PMI reads Point, its Data, current time from the context of the calling thread,
+   * thus one material object can be shared by threads as long as each thread maps its own node.
+   * the AD independent variable number is also synchronized if context.ad_num is not zero
+   */
+  void mapping(const PMI_Context & context)
+  {
+    _contexts[Genius::thread_id()] = context;
+    if( context.ad_num ) set_ad_num(context.ad_num);
+  }
+
+  /**
+   * mapping Point, its Data and current time to the context of the calling thread.
+   * kept for compatibility, the AD independent variable number is not changed
    */
   void mapping(const Point* point, const FVM_NodeData* node_data, PetscScalar time)
   {
-    p_point = point;
-    p_node_data = node_data;
-    clock = time;
+    PMI_Context & context = _contexts[Genius::thread_id()];
+    context.point = point;
+    context.node_data = node_data;
+    context.clock = time;
   }
 
+  /**
+   * @return the evaluation context of the calling thread
+   */
+  const PMI_Context & context() const
+  { return _contexts[Genius::thread_id()]; }
+
   /**
    * @return PMI_Environment
    */
@@ -139,19 +159,10 @@ protected:
   const std::string          material;
 
   /**
-   * pointer to current point, which is updated by mapping function
-   */
-  const Point                *p_point;
-
-  /**
-   * pointer to data of current node, which is updated by mapping function
-   */
-  const FVM_NodeData         *p_node_data;
-
-  /**
-   * current time, which is updated by mapping function
+   * evaluation context of each thread, which is updated by mapping function.
+   * the PMI holds pointer to it, so it never resized after construction
    */
-  PetscScalar                clock;
+  std::vector<PMI_Context>   _contexts;
 
   /**
    * region point based variables
@@ -0,0 +1,374 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __adolc_n_h__
+#define __adolc_n_h__
+
+#include "adolc.h"
+
+namespace adtl
+{
+
+  /**
+   * AD scalar with compile time number of directions.
+   *
+   * adtl::AutoDScalar always carries ADTL_NUMBER_DIRECTIONS derivative slots and
+   * uses the runtime numdir, each temporary has to clear the whole array.
+   * When the stencil size is known at compile time (i.e. 6 for a DDM1 edge),
+   * AutoDScalarN<N> only holds N slots, and all the derivative loops have fixed trip count,
+   * which can be unrolled/vectorized by compiler.
+   *
+   * AutoDScalarN is not involved in the PMI interface, material functions still work
+   * on AutoDScalar. Use the explicit constructor from AutoDScalar and expand() to
+   * convert between them.
+   */
+  template <unsigned int N>
+  class AutoDScalarN
+  {
+  public:
+    // ctors
+    AutoDScalarN(): val(0)
+    { for (unsigned int _i=0; _i<N; ++_i) adval[_i]=0.0; }
+
+    AutoDScalarN(const PetscScalar v): val(v)
+    { for (unsigned int _i=0; _i<N; ++_i) adval[_i]=0.0; }
+
+    AutoDScalarN(const PetscScalar v, const PetscScalar * adv): val(v)
+    { for (unsigned int _i=0; _i<N; ++_i) adval[_i]=adv[_i]; }
+
+    /**
+     * take the first N directions of AutoDScalar \p a
+     */
+    explicit AutoDScalarN(const AutoDScalar &a): val(a.getValue())
+    {
+      const PetscScalar * adv = a.getADValue();
+      for (unsigned int _i=0; _i<N; ++_i) adval[_i]=adv[_i];
+    }
+
+    /**
+     * take the first \p n directions of AutoDScalar \p a, and place them at direction offset+i
+     */
+    AutoDScalarN(const AutoDScalar &a, unsigned int offset, unsigned int n): val(a.getValue())
+    {
+      for (unsigned int _i=0; _i<N; ++_i) adval[_i]=0.0;
+      const PetscScalar * adv = a.getADValue();
+      for (unsigned int _i=0; _i<n; ++_i) adval[offset+_i]=adv[_i];
+    }
+
+    /**
+     * take direction order[i] of AutoDScalar \p a as the ith direction, i < \p n.
+     * it is the inverse of expand(), for the values computed on AutoDScalar which only
+     * depend on the variables in \p order
+     */
+    static AutoDScalarN gather(const AutoDScalar &a, const unsigned int *order, unsigned int n=N)
+    {
+      AutoDScalarN tmp(a.getValue());
+      for (unsigned int _i=0; _i<n; ++_i)
+        tmp.adval[_i]=a.getADValue(order[_i]);
+      return tmp;
+    }
+
+    /**
+     * convert to AutoDScalar, the ith direction is placed at direction order[i], i < \p n
+     */
+    AutoDScalar expand(const unsigned int *order, unsigned int n=N) const
+    {
+      AutoDScalar tmp(val);
+      for (unsigned int _i=0; _i<n; ++_i)
+        tmp.setADValue(order[_i], adval[_i]);
+      return tmp;
+    }
+
+    /*******************  temporary results  ******************************/
+    // sign
+    AutoDScalarN operator - () const
+    {
+      AutoDScalarN tmp(-val, 0);
+      for (unsigned int _i=0; _i<N; ++_i) tmp.adval[_i]=-adval[_i];
+      return tmp;
+    }
+
+    AutoDScalarN operator + () const
+    { return *this; }
+
+    // addition
+    AutoDScalarN operator + (const PetscScalar v) const
+    { return AutoDScalarN(val+v, adval); }
+
+    AutoDScalarN operator + (const AutoDScalarN& a) const
+    {
+      AutoDScalarN tmp(val+a.val, 0);
+      for (unsigned int _i=0; _i<N; ++_i) tmp.adval[_i]=adval[_i]+a.adval[_i];
+      return tmp;
+    }
+
+    friend AutoDScalarN operator + (const PetscScalar v, const AutoDScalarN& a)
+    { return AutoDScalarN(v+a.val, a.adval); }
+
+    // substraction
+    AutoDScalarN operator - (const PetscScalar v) const
+    { return AutoDScalarN(val-v, adval); }
+
+    AutoDScalarN operator - (const AutoDScalarN& a) const
+    {
+      AutoDScalarN tmp(val-a.val, 0);
+      for (unsigned int _i=0; _i<N; ++_i) tmp.adval[_i]=adval[_i]-a.adval[_i];
+      return tmp;
+    }
+
+    friend AutoDScalarN operator - (const PetscScalar v, const AutoDScalarN& a)
+    {
+      AutoDScalarN tmp(v-a.val, 0);
+      for (unsigned int _i=0; _i<N; ++_i) tmp.adval[_i]=-a.adval[_i];
+      return tmp;
+    }
+
+    // multiplication
+    AutoDScalarN operator * (const PetscScalar v) const
+    {
+      AutoDScalarN tmp(val*v, 0);
+      for (unsigned int _i=0; _i<N; ++_i) tmp.adval[_i]=adval[_i]*v;
+      return tmp;
+    }
+
+    AutoDScalarN operator * (const AutoDScalarN& a) const
+    {
+      AutoDScalarN tmp(val*a.val, 0);
+      for (unsigned int _i=0; _i<N; ++_i) tmp.adval[_i]=adval[_i]*a.val+val*a.adval[_i];
+      return tmp;
+    }
+
+    friend AutoDScalarN operator * (const PetscScalar v, const AutoDScalarN& a)
+    { return a*v; }
+
+    // division
+    AutoDScalarN operator / (const PetscScalar v) const
+    { return (*this)*(1.0/v); }
+
+    AutoDScalarN operator / (const AutoDScalarN& a) const
+    {
+      AutoDScalarN tmp(val/a.val, 0);
+      const PetscScalar t = 1.0/(a.val*a.val);
+      for (unsigned int _i=0; _i<N; ++_i) tmp.adval[_i]=(adval[_i]*a.val-val*a.adval[_i])*t;
+      return tmp;
+    }
+
+    friend AutoDScalarN operator / (const PetscScalar v, const AutoDScalarN& a)
+    {
+      AutoDScalarN tmp(v/a.val, 0);
+      const PetscScalar t = -v/(a.val*a.val);
+      for (unsigned int _i=0; _i<N; ++_i) tmp.adval[_i]=t*a.adval[_i];
+      return tmp;
+    }
+
+    // functions
+    friend AutoDScalarN exp(const AutoDScalarN &a)
+    {
+      AutoDScalarN tmp(::exp(a.val), 0);
+      for (unsigned int _i=0; _i<N; ++_i) tmp.adval[_i]=tmp.val*a.adval[_i];
+      return tmp;
+    }
+
+    friend AutoDScalarN log(const AutoDScalarN &a)
+    {
+      AutoDScalarN tmp(::log(a.val), 0);
+      for (unsigned int _i=0; _i<N; ++_i)
+        if (a.val>0 || (a.val==0 && a.adval[_i]>=0)) tmp.adval[_i]=a.adval[_i]/a.val;
+        else tmp.adval[_i]=std::numeric_limits<PetscScalar>::quiet_NaN();
+      return tmp;
+    }
+
+    friend AutoDScalarN sqrt(const AutoDScalarN &a)
+    {
+      AutoDScalarN tmp(::sqrt(a.val), 0);
+      for (unsigned int _i=0; _i<N; ++_i)
+      {
+        if (a.val>0)
+          tmp.adval[_i]=0.5*a.adval[_i]/tmp.val;
+        else if (a.val==0 && a.adval[_i]==0)
+          tmp.adval[_i]=0;
+        else
+          tmp.adval[_i]=std::numeric_limits<PetscScalar>::quiet_NaN();
+      }
+      return tmp;
+    }
+
+    friend AutoDScalarN pow(const AutoDScalarN &a, PetscScalar v)
+    {
+      AutoDScalarN tmp(std::pow(a.val, v), 0);
+      PetscScalar tmp2;
+      if(v-1 < 0 && a.val==0.0) tmp2 = 0.0;
+      else tmp2=v*std::pow(a.val, v-1);
+      for (unsigned int _i=0; _i<N; ++_i) tmp.adval[_i]=tmp2*a.adval[_i];
+      return tmp;
+    }
+
+    friend AutoDScalarN pow(const AutoDScalarN &a, const AutoDScalarN &b)
+    {
+      AutoDScalarN tmp(std::pow(a.val, b.val), 0);
+      PetscScalar tmp2=b.val*std::pow(a.val, b.val-1);
+      PetscScalar tmp3=::log(a.val)*tmp.val;
+      for (unsigned int _i=0; _i<N; ++_i) tmp.adval[_i]=tmp2*a.adval[_i]+tmp3*b.adval[_i];
+      return tmp;
+    }
+
+    friend AutoDScalarN pow(PetscScalar v, const AutoDScalarN &a)
+    {
+      AutoDScalarN tmp(std::pow(v, a.val), 0);
+      PetscScalar tmp2=tmp.val*::log(v);
+      for (unsigned int _i=0; _i<N; ++_i) tmp.adval[_i]=tmp2*a.adval[_i];
+      return tmp;
+    }
+
+    friend AutoDScalarN sinh(const AutoDScalarN &a)
+    {
+      AutoDScalarN tmp(::sinh(a.val), 0);
+      PetscScalar tmp2=::cosh(a.val);
+      for (unsigned int _i=0; _i<N; ++_i) tmp.adval[_i]=a.adval[_i]*tmp2;
+      return tmp;
+    }
+
+    friend AutoDScalarN cosh(const AutoDScalarN &a)
+    {
+      AutoDScalarN tmp(::cosh(a.val), 0);
+      PetscScalar tmp2=::sinh(a.val);
+      for (unsigned int _i=0; _i<N; ++_i) tmp.adval[_i]=a.adval[_i]*tmp2;
+      return tmp;
+    }
+
+    friend AutoDScalarN tanh(const AutoDScalarN &a)
+    {
+      AutoDScalarN tmp(::tanh(a.val), 0);
+      PetscScalar tmp2=::cosh(a.val);
+      tmp2*=tmp2;
+      for (unsigned int _i=0; _i<N; ++_i) tmp.adval[_i]=a.adval[_i]/tmp2;
+      return tmp;
+    }
+
+    friend AutoDScalarN fabs(const AutoDScalarN &a)
+    {
+      AutoDScalarN tmp(::fabs(a.val), 0);
+      for (unsigned int _i=0; _i<N; ++_i)
+      {
+        int as = 0;
+        if (a.val>0 || (a.val==0 && a.adval[_i]>0)) as=1;
+        if (a.val<0 || (a.val==0 && a.adval[_i]<0)) as=-1;
+        tmp.adval[_i]=a.adval[_i]*as;
+      }
+      return tmp;
+    }
+
+    /*******************  nontemporary results  ***************************/
+    // assignment
+    void operator = (const PetscScalar v)
+    {
+      val=v;
+      for (unsigned int _i=0; _i<N; ++_i) adval[_i]=0.0;
+    }
+
+    void operator += (const PetscScalar v)
+    { val+=v; }
+
+    void operator += (const AutoDScalarN& a)
+    {
+      val+=a.val;
+      for (unsigned int _i=0; _i<N; ++_i) adval[_i]+=a.adval[_i];
+    }
+
+    void operator -= (const PetscScalar v)
+    { val-=v; }
+
+    void operator -= (const AutoDScalarN& a)
+    {
+      val-=a.val;
+      for (unsigned int _i=0; _i<N; ++_i) adval[_i]-=a.adval[_i];
+    }
+
+    void operator *= (const PetscScalar v)
+    {
+      val*=v;
+      for (unsigned int _i=0; _i<N; ++_i) adval[_i]*=v;
+    }
+
+    void operator *= (const AutoDScalarN& a)
+    {
+      for (unsigned int _i=0; _i<N; ++_i) adval[_i]=adval[_i]*a.val+val*a.adval[_i];
+      val*=a.val;
+    }
+
+    void operator /= (const PetscScalar v)
+    { (*this) *= 1.0/v; }
+
+    void operator /= (const AutoDScalarN& a)
+    { (*this) = (*this)/a; }
+
+    // comparision, only the value is compared
+    bool operator <  (const PetscScalar v) const { return val<v;  }
+    bool operator <= (const PetscScalar v) const { return val<=v; }
+    bool operator >  (const PetscScalar v) const { return val>v;  }
+    bool operator >= (const PetscScalar v) const { return val>=v; }
+    bool operator <  (const AutoDScalarN &a) const { return val<a.val;  }
+    bool operator <= (const AutoDScalarN &a) const { return val<=a.val; }
+    bool operator >  (const AutoDScalarN &a) const { return val>a.val;  }
+    bool operator >= (const AutoDScalarN &a) const { return val>=a.val; }
+
+    /*******************  getter / setter  ********************************/
+    PetscScalar getValue() const { return val; }
+    void setValue(const PetscScalar v) { val=v; }
+    const PetscScalar * getADValue() const { return adval; }
+    PetscScalar getADValue(const unsigned int p) const { return adval[p]; }
+    void setADValue(const unsigned int p, const PetscScalar v) { adval[p]=v; }
+
+    /**
+     * @return the number of directions
+     */
+    static unsigned int size() { return N; }
+
+  private:
+
+    /**
+     * private constructor which left adval uninitialized, for temporary results
+     */
+    AutoDScalarN(const PetscScalar v, int): val(v) {}
+
+    PetscScalar val;
+    PetscScalar adval[N];
+  };
+
+
+  /**
+   * AD scalar for the DDM1 edge stencil: 2 nodes * 3 variables
+   */
+  typedef AutoDScalarN<6>  AutoDScalar6;
+
+  /**
+   * AD scalar for the DDM2 edge stencil: 2 nodes * 4 variables
+   */
+  typedef AutoDScalarN<8>  AutoDScalar8;
+
+  /**
+   * AD scalar for the EBM3 edge stencil: 2 nodes * at most 6 variables
+   */
+  typedef AutoDScalarN<12> AutoDScalar12;
+}
+
+#endif
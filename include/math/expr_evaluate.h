@@ -71,6 +71,12 @@ public:
   double operator () (double x, double y, double z, double t)
   { return eval(x,y,z,t); }
 
+  /**
+   * evalute an expression at n points with the same time t,
+   * coordinate arrays x, y, z and result array should have length n
+   */
+  void eval(unsigned int n, const double *x, const double *y, const double *z, double t, double *result);
+
 private:
 
   /**
@@ -88,6 +94,12 @@ private:
    */
   ExprEval::Expression e;
 
+  /**
+   * address of independent variable x, y, z and t in vlist,
+   * bind once at construction instead of name lookup at each evaluation
+   */
+  double *_x, *_y, *_z, *_t;
+
 };
 
 #endif
@@ -172,6 +172,18 @@ inline AutoDScalar Ip_dd(PetscScalar Vt,const AutoDScalar &dVv,const AutoDScalar
   return Vt*(p1*bern(-dVv/Vt)-p2*bern(dVv/Vt))/h;
 }
 
+template <unsigned int N>
+inline AutoDScalarN<N> In_dd(PetscScalar Vt,const AutoDScalarN<N> &dVc,const AutoDScalarN<N> &n1,const AutoDScalarN<N> &n2, PetscScalar h)
+{
+  return Vt*(n2*bern(-dVc/Vt)-n1*bern(dVc/Vt))/h;
+}
+
+template <unsigned int N>
+inline AutoDScalarN<N> Ip_dd(PetscScalar Vt,const AutoDScalarN<N> &dVv,const AutoDScalarN<N> &p1,const AutoDScalarN<N> &p2, PetscScalar h)
+{
+  return Vt*(p1*bern(-dVv/Vt)-p2*bern(dVv/Vt))/h;
+}
+
 
 inline PetscScalar In_uw(PetscScalar ,PetscScalar dVc,PetscScalar n1,PetscScalar n2,PetscScalar h)
 {
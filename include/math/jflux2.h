@@ -87,6 +87,18 @@ inline AutoDScalar In_lt(Real kb,Real e, const AutoDScalar &dV, const AutoDScala
   return (E*n + Vt*dndx + kb*n/e*dT/h);
 }
 
+template <unsigned int N>
+inline AutoDScalarN<N> In_lt(Real kb,Real e, const AutoDScalarN<N> &dV, const AutoDScalarN<N> &n1, const AutoDScalarN<N> &n2,
+                             const AutoDScalarN<N> &T, const AutoDScalarN<N> &dT, Real h)
+{
+  AutoDScalarN<N> E  = -dV/h;
+  AutoDScalarN<N> Vt = kb*T/e;
+  AutoDScalarN<N> alpha = -dV/(2*Vt)+ dT/(2*T);
+  AutoDScalarN<N> n  = n1*aux2(alpha) + n2*aux2(-alpha);
+  AutoDScalarN<N> dndx = aux1(alpha)*(n2-n1)/h;
+  return (E*n + Vt*dndx + kb*n/e*dT/h);
+}
+
 
 
 //-----------------------------------------------------------------------------
@@ -112,5 +124,17 @@ inline AutoDScalar Ip_lt(Real kb,Real e, const AutoDScalar &dV, const AutoDScala
   return (E*p-Vt*dpdx - kb*p/e*dT/h);
 }
 
+template <unsigned int N>
+inline AutoDScalarN<N> Ip_lt(Real kb,Real e, const AutoDScalarN<N> &dV, const AutoDScalarN<N> &p1, const AutoDScalarN<N> &p2,
+                             const AutoDScalarN<N> &T, const AutoDScalarN<N> &dT,Real h)
+{
+  AutoDScalarN<N> E  = -dV/h;
+  AutoDScalarN<N> Vt = kb*T/e;
+  AutoDScalarN<N> alpha = -dV/(2*Vt)- dT/(2*T);
+  AutoDScalarN<N> p  = p1*aux2(-alpha) + p2*aux2(alpha);
+  AutoDScalarN<N> dpdx = aux1(alpha)*(p2-p1)/h;
+  return (E*p-Vt*dpdx - kb*p/e*dT/h);
+}
+
 
 #endif // #define __flux2_h__
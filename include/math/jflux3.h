@@ -52,6 +52,15 @@ inline AutoDScalar Theta(const AutoDScalar &T1, const AutoDScalar &T2)
         else
                 return T1/(1-0.5*x);
 }
+template <unsigned int N>
+inline AutoDScalarN<N> Theta(const AutoDScalarN<N> &T1, const AutoDScalarN<N> &T2)
+{
+        AutoDScalarN<N> x = T2/T1-1;
+        if(fabs(x)>1e-6)
+                return (T2-T1)/log(fabs(T2/T1));
+        else
+                return T1/(1-0.5*x);
+}
 
 //-----------------------------------------------------------------------------
 // FIXME I am very afraid about float exception of exp operator here.
@@ -126,6 +135,15 @@ inline AutoDScalar In_eb(Real kb, Real e, const AutoDScalar &V1, const AutoDScal
   return kb*0.5*(Tn1+Tn2)*theta*(bern(alpha)*n2/Tn2 - bern(-alpha)*n1/Tn1)/h;
 }
 
+template <unsigned int N>
+inline AutoDScalarN<N> In_eb(Real kb, Real e, const AutoDScalarN<N> &V1, const AutoDScalarN<N> &V2,
+                         const AutoDScalarN<N> &n1,const AutoDScalarN<N> &n2, const AutoDScalarN<N> &Tn1,const AutoDScalarN<N> &Tn2, Real h)
+{
+  AutoDScalarN<N> theta = Theta(Tn1,Tn2);
+  AutoDScalarN<N> alpha = (e/kb*(V2-V1)-2*(Tn2-Tn1))/theta;
+  return kb*0.5*(Tn1+Tn2)*theta*(bern(alpha)*n2/Tn2 - bern(-alpha)*n1/Tn1)/h;
+}
+
 
 
 //-----------------------------------------------------------------------------
@@ -146,6 +164,15 @@ inline AutoDScalar Ip_eb(Real kb, Real e, const AutoDScalar &V1, const AutoDScal
   return kb*0.5*(Tp1+Tp2)*theta*(bern(alpha)*p1/Tp1 - bern(-alpha)*p2/Tp2)/h;
 }
 
+template <unsigned int N>
+inline AutoDScalarN<N> Ip_eb(Real kb, Real e, const AutoDScalarN<N> &V1, const AutoDScalarN<N> &V2,
+                         const AutoDScalarN<N> &p1,const AutoDScalarN<N> &p2, const AutoDScalarN<N> &Tp1,const AutoDScalarN<N> &Tp2, Real h)
+{
+  AutoDScalarN<N> theta = Theta(Tp1,Tp2);
+  AutoDScalarN<N> alpha = (e/kb*(V2-V1)+2*(Tp2-Tp1))/theta;
+  return kb*0.5*(Tp1+Tp2)*theta*(bern(alpha)*p1/Tp1 - bern(-alpha)*p2/Tp2)/h;
+}
+
 
 
 
@@ -175,6 +202,19 @@ inline AutoDScalar Sn_eb(Real kb, Real e, const  AutoDScalar &V1,const  AutoDSca
   return -2.0*kb*Dn/h*theta*(bern(alpha)*bern(1.25*phi)/bern(phi)*n2 - bern(-alpha)*bern(-1.25*phi)/bern(-phi)*n1);
 }
 
+template <unsigned int N>
+inline AutoDScalarN<N> Sn_eb(Real kb, Real e, const  AutoDScalarN<N> &V1,const  AutoDScalarN<N> &V2,
+                         const AutoDScalarN<N> &n1, const AutoDScalarN<N> &n2, const AutoDScalarN<N> &Tn1,const AutoDScalarN<N> &Tn2, Real h)
+{
+  AutoDScalarN<N> theta = Theta(Tn1,Tn2);
+  AutoDScalarN<N> alpha = (e/kb*(V2-V1)-2*(Tn2-Tn1))/theta;
+  AutoDScalarN<N> phi   = (e/kb*(V2-V1)-(Tn2-Tn1))/theta-log(fabs(n2/n1));
+  AutoDScalarN<N> Dn    = kb*0.5*(Tn1+Tn2)/e;
+  if(alpha > BP4_BERN || 1.25*phi > BP4_BERN)
+    return -2.0*kb*Dn/h*theta*( - bern(-alpha)*bern(-1.25*phi)/bern(-phi)*n1);
+  return -2.0*kb*Dn/h*theta*(bern(alpha)*bern(1.25*phi)/bern(phi)*n2 - bern(-alpha)*bern(-1.25*phi)/bern(-phi)*n1);
+}
+
 
 
 //-----------------------------------------------------------------------------
@@ -203,6 +243,19 @@ inline AutoDScalar Sp_eb(Real kb, Real e, const  AutoDScalar &V1,const  AutoDSca
   return   -2.0*kb*Dp/h*theta*(bern(alpha)*bern(1.25*phi)/bern(phi)*p2 - bern(-alpha)*bern(-1.25*phi)/bern(-phi)*p1);
 }
 
+template <unsigned int N>
+inline AutoDScalarN<N> Sp_eb(Real kb, Real e, const  AutoDScalarN<N> &V1,const  AutoDScalarN<N> &V2,
+                         const AutoDScalarN<N> &p1, const AutoDScalarN<N> &p2, const AutoDScalarN<N> &Tp1,const AutoDScalarN<N> &Tp2, Real h)
+{
+  AutoDScalarN<N> theta = Theta(Tp1,Tp2);
+  AutoDScalarN<N> alpha = (-e/kb*(V2-V1)-2*(Tp2-Tp1))/theta;
+  AutoDScalarN<N> phi   = (-e/kb*(V2-V1)-(Tp2-Tp1))/theta-log(fabs(p2/p1));
+  AutoDScalarN<N> Dp    = kb*0.5*(Tp1+Tp2)/e;
+  if(alpha > BP4_BERN || 1.25*phi > BP4_BERN)
+    return -2.0*kb*Dp/h*theta*(- bern(-alpha)*bern(-1.25*phi)/bern(-phi)*p1);
+  return   -2.0*kb*Dp/h*theta*(bern(alpha)*bern(1.25*phi)/bern(phi)*p2 - bern(-alpha)*bern(-1.25*phi)/bern(-phi)*p1);
+}
+
 
 
 #endif // #define __flux3_h__
@@ -13,6 +13,7 @@
 #endif
 
 #include "adolc.h"
+#include "adolc_n.h"
 using namespace adtl;
 
 /* define the constant */
@@ -111,6 +112,25 @@ inline AutoDScalar bern ( const AutoDScalar &x )
 
 } /* bern */
 
+template <unsigned int N>
+inline AutoDScalarN<N> bern ( const AutoDScalarN<N> &x )
+{
+  AutoDScalarN<N> y;
+
+  if (x <= BP0_BERN)
+  { return(-x); }
+  else if (x <  BP1_BERN)
+  { return(x / (exp(x) - 1.0)); }
+  else if (x <= BP2_BERN)
+  { return(1.0 - x/2.0 * (1.0 - x/6.0 * (1.0 - x*x/60.0))); }
+  else if (x <  BP3_BERN)
+  { y = exp(-x);   return((x * y) / (1.0 - y)); }
+  else if (x <  BP4_BERN)
+  { return(x * exp(-x)); }
+  else { return 0; }
+
+} /* bern */
+
 
 /* ----------------------------------------------------------------------------
  * pd1bern:  This function returns the total derivative of the Bernoulli
@@ -210,6 +230,14 @@ inline AutoDScalar aux1 ( const AutoDScalar &x )
   return y;
 } /* aux1 */
 
+template <unsigned int N>
+inline AutoDScalarN<N> aux1 ( const AutoDScalarN<N> &x )
+{
+  AutoDScalarN<N> y = pd1aux1(x.getValue()) * x;
+  y.setValue(aux1(x.getValue()));
+  return y;
+} /* aux1 */
+
 
 
 /* ----------------------------------------------------------------------------
@@ -270,6 +298,14 @@ inline AutoDScalar aux2 ( const AutoDScalar &x )
   return y;
 } /* aux2 */
 
+template <unsigned int N>
+inline AutoDScalarN<N> aux2 ( const AutoDScalarN<N> &x )
+{
+  AutoDScalarN<N> y = pd1aux2(x.getValue()) * x;
+  y.setValue(aux2(x.getValue()));
+  return y;
+} /* aux2 */
+
 
 /* ----------------------------------------------------------------------------
  * pd1erf:  This function returns the derivative of the error function with
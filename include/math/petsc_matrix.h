@@ -268,8 +268,17 @@ public:
 
 private:
   
+  /**
+   * the first assembly is buffered in _mat_local, since the nonzero pattern is unknown.
+   */
   bool _mat_buf_mode;
 
+  /**
+   * after the first final assembly, the nonzero pattern is frozen in CSR format.
+   * values are accumulated into the CSR slots and sent to PETSc row by row at final assembly
+   */
+  bool _mat_frozen_mode;
+
   /**
    * matrix data type to store local values
    */
@@ -289,6 +298,53 @@ private:
   
   void flush_buf();
 
+  /**
+   * CSR row pointer of the frozen pattern, size of local rows + 1
+   */
+  std::vector<PetscInt> _csr_row_ptr;
+
+  /**
+   * global column index of the frozen pattern, sorted within each row
+   */
+  std::vector<PetscInt> _csr_col;
+
+  /**
+   * values of the frozen pattern
+   */
+  std::vector<T> _csr_val;
+
+  /**
+   * local entries out of the frozen pattern, they are inserted at final assembly
+   * and merged into the pattern afterwards
+   */
+  std::map< std::pair<unsigned int, unsigned int>, T > _mat_extra;
+
+  /**
+   * @return the slot of local entry (i,j) in the frozen pattern, NULL if it does not exist.
+   * binary search in the row
+   */
+  T * frozen_slot(const unsigned int i, const unsigned int j);
+
+  /**
+   * const version of frozen_slot
+   */
+  const T * frozen_slot(const unsigned int i, const unsigned int j) const;
+
+  /**
+   * add value to entry (i,j) in frozen mode
+   */
+  void frozen_add(const unsigned int i, const unsigned int j, const T value);
+
+  /**
+   * build the frozen pattern (and values) from the assembled PETSc matrix
+   */
+  void freeze_pattern();
+
+  /**
+   * send the frozen values to PETSc and assemble the matrix
+   */
+  void flush_frozen();
+
 private:  
 
   /**
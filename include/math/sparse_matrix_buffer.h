@@ -0,0 +1,102 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+
+#ifndef __sparse_matrix_buffer_h__
+#define __sparse_matrix_buffer_h__
+
+// C++ includes
+#include <vector>
+
+// Local includes
+#include "genius_common.h"
+#include "sparse_matrix.h"
+
+
+/**
+ * Rows added to a SparseMatrix by one thread of a threaded assembly loop.
+ * SparseMatrix::add_row is not thread safe, each thread fills its own buffer,
+ * and the buffers are added to the matrix by thread order after the loop.
+ * For a statically scheduled loop this keeps the row order of the serial loop.
+ */
+template <typename T>
+class SparseMatrixBuffer
+{
+public:
+
+  /**
+   * buffer a row, the same as SparseMatrix::add_row
+   */
+  void add_row (unsigned int row, int n, const int * cols, const T* dm)
+  {
+    _rows.push_back(row);
+    _row_size.push_back(n);
+    _cols.insert(_cols.end(), cols, cols+n);
+    _values.insert(_values.end(), dm, dm+n);
+  }
+
+  /**
+   * buffer a single entry, the same as SparseMatrix::add
+   */
+  void add (const unsigned int i, const unsigned int j, const T value)
+  {
+    const int col = j;
+    this->add_row(i, 1, &col, &value);
+  }
+
+  /**
+   * add the buffered rows to \p matrix
+   */
+  void add_to (SparseMatrix<T> * matrix) const
+  {
+    unsigned int begin = 0;
+    for(unsigned int r=0; r<_rows.size(); ++r)
+    {
+      matrix->add_row(_rows[r], _row_size[r], &_cols[begin], &_values[begin]);
+      begin += _row_size[r];
+    }
+  }
+
+  /**
+   * clear the buffer
+   */
+  void clear ()
+  {
+    _rows.clear();
+    _row_size.clear();
+    _cols.clear();
+    _values.clear();
+  }
+
+private:
+
+  std::vector<unsigned int>  _rows;
+
+  std::vector<int>           _row_size;
+
+  std::vector<int>           _cols;
+
+  std::vector<T>             _values;
+};
+
+
+#endif
@@ -167,6 +167,36 @@ public:
    */
   virtual void delete_remote_elements (bool volume_elem=true, bool surface_elem=true ) {}
 
+  /**
+   * Resize the node and elem container to the global size \p nn and \p ne
+   * without creating any object. Used by processors which only receive
+   * their own piece of the mesh but keep the global numbering.
+   */
+  virtual void resize_nodes_and_elems (unsigned int , unsigned int ) {}
+
+  /**
+   * When set, MeshCommunication::broadcast() only synchronizes the mesh
+   * description (subdomains and boundary labels). Elements and nodes stay
+   * on the first processor until the mesh is partitioned, then each
+   * processor receives its local elements with one ghost layer by
+   * MeshCommunication::distribute().
+   */
+  void set_scatter_on_partition (bool flag) { _scatter_on_partition = flag; }
+
+  /**
+   * @returns true if the mesh is scattered after partition
+   */
+  bool scatter_on_partition () const { return _scatter_on_partition; }
+
+  /**
+   * @returns true if the mesh is scattered by the coming partition.
+   * MeshCommunication::distribute() only scatters a level 0 mesh, a mesh with element
+   * hierarchy is kept by all the processors and the remote elements are deleted after partition.
+   * scatter_on_partition() itself is kept, the mesh is scattered again once it has no hierarchy.
+   * the first processor holds the whole mesh and decides, must be executed in parallel
+   */
+  bool scatter_now () const;
+
   /**
    * pack all the mesh node location (x, y, z) one by one into an real array
    * with size 3*n_nodes(), should be executed in parallel
@@ -444,9 +474,10 @@ public:
 
   /**
    * Call the default partitioner (currently \p metis_partition()).
-   * @param serial  do partition in serial
+   * @param local  the mesh only exists on this processor, do partition
+   *               without any communication
    */
-  void partition (const unsigned int n_parts=Genius::n_processors());
+  void partition (const unsigned int n_parts=Genius::n_processors(), bool local=false);
 
   /**
    * build the partition cluster, the elems belongs to the same cluster will be partitioned into the same block
@@ -838,6 +869,11 @@ protected:
    */
   bool _is_prepared;
 
+  /**
+   * Flag indicating the mesh is scattered to processors after partition
+   */
+  bool _scatter_on_partition;
+
   /**
    * A \p PointLocator class for this mesh.
    * This will not actually be built unless needed. Further, since we want
@@ -859,6 +895,12 @@ protected:
    */
   friend class Partitioner;
 
+  /**
+   * The \p MeshCommunication class is a friend so that it can set
+   * mesh dimension and bounding box of a scattered mesh.
+   */
+  friend class MeshCommunication;
+
   /**
    * Make the \p BoundaryInfo class a friend so that
    * it can create and interact with \p BoundaryMesh.
@@ -86,10 +86,13 @@ public:
   void broadcast (MeshBase& ) const;
 
   /**
-   * Each processor will broadcasts its elements and nodes
-   * to its neighboring processors.
+   * This method takes a partitioned mesh which resides on processor 0
+   * and sends each processor its local elements plus one layer of ghost
+   * elements, together with the boundary elements and boundary information
+   * needed by boundary condition setup. Processor 0 keeps the whole mesh.
+   * The mesh description should be synchronized by \p broadcast() before.
    */
-  void distribute (MeshBase& ) const {}
+  void distribute (MeshBase& ) const;
 
   
 private:
@@ -104,6 +107,12 @@ private:
    */
   void broadcast_bcs (MeshBase&, BoundaryInfo&) const;
 
+  /**
+   * only broadcast subdomain and boundary labels, used when the mesh
+   * is scattered after partition
+   */
+  void broadcast_mesh_info (MeshBase& ) const;
+
   /**
    * The processors who neighbor the current
    * processor
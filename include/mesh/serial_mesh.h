@@ -113,6 +113,16 @@ class SerialMesh : public UnstructuredMesh
    */
   virtual void delete_remote_elements (bool volume_elem=true, bool surface_elem=true);
 
+  /**
+   * Resize the node and elem container to the global size \p nn and \p ne,
+   * the new slots are NULL
+   */
+  virtual void resize_nodes_and_elems (unsigned int nn, unsigned int ne)
+  {
+    _nodes.resize(nn, static_cast<Node*>(NULL));
+    _elements.resize(ne, static_cast<Elem*>(NULL));
+  }
+
   /**
    * pack all the mesh node location (x, y, z) one by one into an real array
    * with size 3*n_nodes(), should be executed in parallel
@@ -32,6 +32,9 @@
 /**
  * The \p MetisPartitioner uses the Metis graph partitioner
  * to partition the elements.
+ * Each cluster is partitioned alone, weighted by subdomain weight,
+ * then its parts are assigned to processors so that the load
+ * summed over all the clusters is balanced.
  */
 
 // ------------------------------------------------------------
@@ -42,8 +45,12 @@ class MetisPartitioner : public Partitioner
 
   /**
    * Constructor.
+   * with \p serial_partition, every processor does the same partition.
+   * with \p local_partition, only this processor holds the mesh and no
+   * communication is involved.
    */
-   MetisPartitioner (const bool serial_partition=false):_serial_partition(serial_partition) {}
+   MetisPartitioner (const bool serial_partition=false, const bool local_partition=false)
+   :_serial_partition(serial_partition), _local_partition(local_partition) {}
 
 protected:
 
@@ -57,6 +64,8 @@ protected:
 private:
 
   const bool _serial_partition;
+
+  const bool _local_partition;
 };
 
 
@@ -139,6 +139,12 @@ public:
    */
   int  do_solve   ( const Parser::Card & c );
 
+  /**
+   * create the solver by SolverSpecify and run it, called by do_solve.
+   * with adaptive refinement, it is called again for the rest of the sweep on the refined mesh
+   */
+  int  run_solver ();
+
   /**
    * process and do "EXPORT" card
    */
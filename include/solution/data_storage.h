@@ -328,6 +328,66 @@ public:
   template <typename T>
   const T & data(const unsigned int , const unsigned int ) const;
 
+  /**
+   * append all the allocated data at offset to a flat buffer
+   * complex, vector and tensor value are stored as 2, 3 and 9 scalars
+   */
+  void pack(const unsigned int offset, std::vector<PetscScalar> & buffer) const
+  {
+    for(unsigned int n=0; n<_scalar_fill.size(); ++n)
+      if( _scalar_fill[n] )
+        buffer.push_back(_scalar_block[n][offset]);
+
+    for(unsigned int n=0; n<_complex_fill.size(); ++n)
+      if( _complex_fill[n] )
+      {
+        buffer.push_back(_complex_block[n][offset].real());
+        buffer.push_back(_complex_block[n][offset].imag());
+      }
+
+    for(unsigned int n=0; n<_vector_fill.size(); ++n)
+      if( _vector_fill[n] )
+        for(unsigned int i=0; i<3; ++i)
+          buffer.push_back(_vector_block[n][offset](i));
+
+    for(unsigned int n=0; n<_tensor_fill.size(); ++n)
+      if( _tensor_fill[n] )
+        for(unsigned int i=0; i<3; ++i)
+          for(unsigned int j=0; j<3; ++j)
+            buffer.push_back(_tensor_block[n][offset](i,j));
+  }
+
+  /**
+   * restore the data at offset from a flat buffer created by pack(), start at position pos
+   * @return the position after the data
+   */
+  unsigned int unpack(const unsigned int offset, const std::vector<PetscScalar> & buffer, unsigned int pos)
+  {
+    for(unsigned int n=0; n<_scalar_fill.size(); ++n)
+      if( _scalar_fill[n] )
+        _scalar_block[n][offset] = buffer[pos++];
+
+    for(unsigned int n=0; n<_complex_fill.size(); ++n)
+      if( _complex_fill[n] )
+      {
+        _complex_block[n][offset] = std::complex<PetscScalar>(buffer[pos], buffer[pos+1]);
+        pos += 2;
+      }
+
+    for(unsigned int n=0; n<_vector_fill.size(); ++n)
+      if( _vector_fill[n] )
+        for(unsigned int i=0; i<3; ++i)
+          _vector_block[n][offset](i) = buffer[pos++];
+
+    for(unsigned int n=0; n<_tensor_fill.size(); ++n)
+      if( _tensor_fill[n] )
+        for(unsigned int i=0; i<3; ++i)
+          for(unsigned int j=0; j<3; ++j)
+            _tensor_block[n][offset](i,j) = buffer[pos++];
+
+    return pos;
+  }
+
   /**
    * approx memory usage
    */
@@ -25,6 +25,7 @@
 #define __external_circuit_h__
 
 #include <string>
+#include <vector>
 #include <complex>
 
 #include "genius_common.h"
@@ -292,6 +293,28 @@ public:
     _current_old = _current;
   }
 
+  /**
+   * append the state of the circuit to \p state, which is kept when the system is rebuilt
+   */
+  virtual void save_state(std::vector<Real> & state) const
+  {
+    state.push_back(_potential);
+    state.push_back(_potential_old);
+    state.push_back(_current);
+    state.push_back(_current_old);
+  }
+
+  /**
+   * restore the state saved by save_state() from \p state, \p pos is moved over the values read
+   */
+  virtual void load_state(const std::vector<Real> & state, unsigned int & pos)
+  {
+    _potential     = state[pos++];
+    _potential_old = state[pos++];
+    _current       = state[pos++];
+    _current_old   = state[pos++];
+  }
+
 
 protected:
   /**
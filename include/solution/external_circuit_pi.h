@@ -188,6 +188,26 @@ public:
     _V1 = _V1_last;
   }
 
+  /**
+   * the state with the internal node
+   */
+  virtual void save_state(std::vector<Real> & state) const
+  {
+    ExternalCircuit::save_state(state);
+    state.push_back(_V1);
+    state.push_back(_V1_last);
+  }
+
+  /**
+   * restore the state with the internal node
+   */
+  virtual void load_state(const std::vector<Real> & state, unsigned int & pos)
+  {
+    ExternalCircuit::load_state(state, pos);
+    _V1      = state[pos++];
+    _V1_last = state[pos++];
+  }
+
   /**
    * init op state before transient simulation
    */
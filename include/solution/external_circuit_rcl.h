@@ -168,6 +168,26 @@ public:
     _cap_current = _cap_current_old;
   }
 
+  /**
+   * the state with the capacitance current
+   */
+  virtual void save_state(std::vector<Real> & state) const
+  {
+    ExternalCircuit::save_state(state);
+    state.push_back(_cap_current);
+    state.push_back(_cap_current_old);
+  }
+
+  /**
+   * restore the state with the capacitance current
+   */
+  virtual void load_state(const std::vector<Real> & state, unsigned int & pos)
+  {
+    ExternalCircuit::load_state(state, pos);
+    _cap_current     = state[pos++];
+    _cap_current_old = state[pos++];
+  }
+
   /**
    * init op state before transient simulation
    */
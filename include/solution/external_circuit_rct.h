@@ -159,6 +159,28 @@ public:
     _v = _v_last;
   }
 
+  /**
+   * the state with the nodes of TL
+   */
+  virtual void save_state(std::vector<Real> & state) const
+  {
+    ExternalCircuit::save_state(state);
+    state.insert(state.end(), _v.begin(), _v.end());
+    state.insert(state.end(), _v_last.begin(), _v_last.end());
+  }
+
+  /**
+   * restore the state with the nodes of TL
+   */
+  virtual void load_state(const std::vector<Real> & state, unsigned int & pos)
+  {
+    ExternalCircuit::load_state(state, pos);
+    for(unsigned int i=0; i<_v.size(); ++i)
+      _v[i] = state[pos++];
+    for(unsigned int i=0; i<_v_last.size(); ++i)
+      _v_last[i] = state[pos++];
+  }
+
   /**
    * init op state before transient simulation
    */
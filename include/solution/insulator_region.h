@@ -187,7 +187,7 @@ private:
   /**
    * @return truncated partial area associated with edge ne of elem
    */
-  Real truncated_partial_area(const Elem * elem, unsigned int ne) const;
+  virtual Real truncated_partial_area(const Elem * elem, unsigned int ne) const;
 
 private:
   /**
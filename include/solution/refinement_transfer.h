@@ -0,0 +1,125 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+
+
+#ifndef __refinement_transfer_h__
+#define __refinement_transfer_h__
+
+#include <map>
+#include <vector>
+#include <string>
+
+#include "simulation_region.h"
+
+class SimulationSystem;
+class MeshBase;
+class Node;
+
+
+/**
+ * transfer the solution of a simulation system to the mesh after hierarchical refinement.
+ * node data are kept by mesh node, the nodes created by refinement get the value
+ * prolonged from the nodes of parent element by its embedding matrix,
+ * which avoids building a scattered data interpolator over the whole mesh.
+ *
+ * doping, mole fraction and solution variables are all transferred in this way.
+ * cell data are not kept, they will be computed by the next solve.
+ */
+class RefinementTransfer
+{
+public:
+
+  /**
+   * record the local node data of all the regions and the state of external circuits.
+   * every processor should hold the whole mesh, but only keeps the data of its local nodes
+   */
+  RefinementTransfer(SimulationSystem & system);
+
+  /**
+   * compute the data of new nodes from the nodes of parent element.
+   * each processor only prolongs the elements it owns, whose nodes all have local data.
+   * call it after mesh refinement, before the element hierarchy is removed (i.e. flatten)
+   */
+  void prolong();
+
+  /**
+   * record the node id of the data, call it after the nodes are renumbered
+   * and before the system is rebuilt
+   */
+  void update_node_id();
+
+  /**
+   * fill the data into the rebuilt system, call it after SimulationSystem::init_region().
+   * must executed in parallel.
+   */
+  void restore();
+
+private:
+
+  SimulationSystem & _system;
+
+  MeshBase & _mesh;
+
+  /**
+   * node data of a region
+   */
+  struct RegionData
+  {
+    /**
+     * number of values for each node
+     */
+    unsigned int width;
+
+    /**
+     * the record index of mesh node id. refinement appends new nodes and the id of
+     * a node deleted by coarsening is not reused until renumbering, so the id is
+     * a safe key while the mesh is refined and coarsened in one pass
+     */
+    std::map<unsigned int, unsigned int> node_record;
+
+    /**
+     * the record index of nodes alive after prolong(), node id is not stable over renumbering
+     */
+    std::map<const Node *, unsigned int> live_record;
+
+    /**
+     * values of all the records
+     */
+    std::vector<PetscScalar> values;
+
+    /**
+     * data indexed by node id, filled by update_node_id()
+     */
+    SimulationRegion::DataBackup backup;
+  };
+
+  std::vector<RegionData> _region_data;
+
+  /**
+   * state of external circuits
+   */
+  std::map<std::string, std::vector<Real> > _circuit_state;
+};
+
+
+#endif
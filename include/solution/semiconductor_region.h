@@ -317,7 +317,7 @@ private:
   /**
    * @return truncated partial area associated with edge ne of elem
    */
-  Real truncated_partial_area(const Elem * elem, unsigned int ne) const;
+  virtual Real truncated_partial_area(const Elem * elem, unsigned int ne) const;
 
   /**
    * elem has its circumcircle center outside the region
@@ -390,6 +390,11 @@ public:
    */
   virtual void DDM1_Jacobian(PetscScalar * x, SparseMatrix<PetscScalar> *jac, InsertMode &add_value_flag);
 
+  /**
+   * build function and its jacobian for L1 DDM in one pass, the function is taken from AD values
+   */
+  virtual void DDM1_Function_Jacobian(PetscScalar * x, Vec f, SparseMatrix<PetscScalar> *jac, InsertMode &add_value_flag);
+
   /**
    * build time derivative term and its jacobian for L1 DDM
    */
@@ -37,6 +37,7 @@
 #include "sparse_matrix.h"
 #include "advanced_model.h"
 #include "enum_region.h"
+#include "perf_log.h"
 
 #if defined(HAVE_TR1_UNORDERED_MAP)
 #include <tr1/unordered_map>
@@ -139,6 +140,18 @@ public:
   static void set_subdomain_id_to_region_map(const std::map<unsigned int,  SimulationRegion *> &_map)
   { _subdomain_id_to_region_map = _map; }
 
+  /**
+   * the order of on local fvm nodes and edges in each region,
+   * which decides the dof order and the memory access pattern of node/edge loops
+   */
+  enum NodeOrdering { OrderByID, OrderRCM, OrderHilbert };
+
+  /**
+   * set the node ordering for all the regions
+   */
+  static void set_node_ordering(NodeOrdering order)
+  { _node_ordering = order; }
+
   /**
    * reseve memory for region data block
    */
@@ -205,6 +218,18 @@ public:
    */
   unsigned int n_on_processor_node() const;
 
+  /**
+   * @return the on local FVM Node number (on processor nodes + ghost nodes) in this region
+   */
+  unsigned int n_on_local_node() const
+  { return _region_local_node.size(); }
+
+  /**
+   * @return nth on local FVM Node in this region
+   */
+  const FVM_Node * get_on_local_node(unsigned int n) const
+  { return _region_local_node[n]; }
+
   /**
    * get all the region node ids by order,
    * must executed in parallel.
@@ -484,10 +509,72 @@ public:
   { return _region_elem_edge_in_edges_index.find(elem)->second[e]; }
 
   /**
-   * (re)build _region_local_node and _region_processor_node for fast iteration
+   * @return the location of the two fvm_nodes of nth edge in on local node array,
+   * so that per node values can be evaluated once and looked up by edge
+   */
+  const std::pair<unsigned int, unsigned int> & edge_local_node_index(unsigned int n) const
+  { return _region_edge_local_node_index[n]; }
+
+  /**
+   * the static geometry of the edges of region cells, stored as structure of arrays.
+   * the edges of nth region cell take the range [cell_begin[n], cell_begin[n+1])
+   * of the arrays, ordered by the local edge index of the elem.
+   * the assemblers read it instead of querying elem geometry for every edge in every iteration.
+   */
+  struct CellEdgeTable
+  {
+    /// offset of the first edge of each cell, size n_cell()+1
+    std::vector<unsigned int>  cell_begin;
+
+    /// the local index of the two edge nodes in the elem
+    std::vector<unsigned int>  node1;
+    std::vector<unsigned int>  node2;
+
+    /// fvm_node of the two edge nodes
+    std::vector<FVM_Node *>    fvm_node1;
+    std::vector<FVM_Node *>    fvm_node2;
+
+    /// the location of the edge in region edges, same as elem_edge_index()
+    std::vector<unsigned int>  edge_index;
+
+    /// true when node1 has a larger id than node2, the edge is inverse to the region edge
+    std::vector<unsigned char> inverse;
+
+    /// the length of the edge
+    std::vector<Real>          length;
+
+    /// partial area/volume associated with the edge
+    std::vector<Real>          partial_area;
+    std::vector<Real>          partial_volume;
+
+    /// truncated partial area/volume associated with the edge
+    std::vector<Real>          truncated_partial_area;
+    std::vector<Real>          truncated_partial_volume;
+  };
+
+  /**
+   * @return the edge geometry table of region cells
+   */
+  const CellEdgeTable & cell_edge_table() const
+  { return _cell_edge_table; }
+
+  /**
+   * (re)build _region_local_node and _region_processor_node for fast iteration,
+   * also the on local node index of each edge
    */
   void rebuild_region_fvm_node_list();
 
+  /**
+   * reorder _region_local_node, _region_processor_node, _region_ghost_node
+   * and _region_edges by the node ordering, called by rebuild_region_fvm_node_list()
+   */
+  void reorder_region_fvm_node_list();
+
+  /**
+   * build _cell_edge_table, called by rebuild_region_fvm_node_list()
+   */
+  void build_cell_edge_table();
+
   /**
    * for some pre process
    */
@@ -504,6 +591,13 @@ public:
    */
   virtual void sync_fvm_node_volume();
 
+  /**
+   * sync the global offset of ghost fvm_node from the processor which owns it.
+   * the global offset of on processor fvm_node should be set before calling it.
+   * must executed in parallel.
+   */
+  void sync_fvm_node_global_offset();
+
   /**
    * delete fvm_node NOT on this processor, dangerous
    */
@@ -628,6 +722,39 @@ public:
   template <typename T>
   bool sync_point_variable(const std::string &v);
 
+  /**
+   * node and cell data of a region, indexed by root node id and elem id.
+   * it keeps valid when the region is rebuilt on a repartitioned mesh.
+   */
+  struct DataBackup
+  {
+    std::vector<unsigned int> node_ids;
+    std::vector<PetscScalar>  node_values;
+    std::vector<unsigned int> cell_ids;
+    std::vector<PetscScalar>  cell_values;
+  };
+
+  /**
+   * keep the data of local nodes (ghost nodes included) and on processor cells of this region.
+   * nothing is gathered, each processor only holds its own part
+   */
+  void backup_data(DataBackup &) const;
+
+  /**
+   * restore local node and cell data from the backup of all the processors.
+   * the records are fetched by id from the processors which hold them, through processor id%n_processors.
+   * the region should be built from the same mesh as the backup.
+   * must executed in parallel.
+   */
+  void restore_data(const DataBackup &);
+
+  /**
+   * timer of the assembly work in this region.
+   * solvers accumulate residual/jacobian evaluation time here, which is the measured partition cost
+   */
+  PerfData & assembly_perf()
+  { return _assembly_perf; }
+
 
   /**
    * @return ChargeIntegralBC pointer if this region is a floating metal
@@ -820,6 +947,11 @@ protected:
    */
   static std::map<unsigned int,  SimulationRegion *>  _subdomain_id_to_region_map;
 
+  /**
+   * the node ordering of all the regions
+   */
+  static NodeOrdering _node_ordering;
+
   /**
    * neighbor regions
    */
@@ -884,12 +1016,27 @@ protected:
    */
   DataStorage _node_data_storage;
 
+  /**
+   * accumulated assembly time of this region on this processor
+   */
+  PerfData _assembly_perf;
+
   /**
    * the edges belongs to this regon, for fast FVM integral
    * the two fvm_node of this edge is ordered as id(1) \< id(2)
    */
   std::vector< std::pair<FVM_Node *, FVM_Node *> > _region_edges;
 
+  /**
+   * the location of the two fvm_nodes of each edge in _region_local_node
+   */
+  std::vector< std::pair<unsigned int, unsigned int> > _region_edge_local_node_index;
+
+  /**
+   * the edge geometry of region cells
+   */
+  CellEdgeTable _cell_edge_table;
+
   /**
    * the corresponding location of an element's edge in _region_edges
    * by given an element pointer, and the local index of the edge
@@ -951,6 +1098,12 @@ protected:
    */
   std::map<std::string, SimulationVariable>  _region_cell_variables;
 
+  /**
+   * @return truncated partial area associated with edge ne of elem, used by _cell_edge_table.
+   * default to the truncated partial area of elem, region may override it
+   */
+  virtual Real truncated_partial_area(const Elem * elem, unsigned int ne) const;
+
 
 public:
 
@@ -1072,6 +1225,22 @@ public:
    */
   virtual void DDM1_Jacobian(PetscScalar * x, SparseMatrix<PetscScalar> *jac, InsertMode &add_value_flag)=0;
 
+  /**
+   * @brief virtual function for evaluating level 1 DDM equation and its Jacobian in one pass.
+   *
+   * @param x                local unknown vector
+   * @param f                petsc global function vector
+   * @param jac              petsc global jacobian matrix
+   * @param add_value_flag   flag for last operator is ADD_VALUES
+   *
+   * @note region can override it to take the function from the AD values of jacobian
+   */
+  virtual void DDM1_Function_Jacobian(PetscScalar * x, Vec f, SparseMatrix<PetscScalar> *jac, InsertMode &add_value_flag)
+  {
+    this->DDM1_Function(x, f, add_value_flag);
+    this->DDM1_Jacobian(x, jac, add_value_flag);
+  }
+
   /**
    * @brief virtual function for evaluating time derivative term of level 1 DDM equation.
    *
@@ -133,6 +133,33 @@ public:
    */
   std::vector< std::vector<unsigned int > > build_subdomain_cluster();
 
+  /**
+   * measure the load imbalance among processors by the assembly time of regions.
+   * the measured assembly cost per node of each region is recorded and will be used
+   * as partition weight in later mesh partition.
+   * @return the ratio of max to average assembly time, 1.0 when nothing is measured
+   */
+  double load_imbalance();
+
+  /**
+   * partition the mesh again by the measured cost and rebuild the system on it.
+   * a distributed mesh is partitioned on the first processor, which holds the whole mesh,
+   * and scattered again. the node/cell data of all the regions and the state of external
+   * circuits are kept by node/cell id.
+   * must executed in parallel.
+   */
+  void repartition();
+
+  /**
+   * save the state of the external circuit of each electrode, including its internal nodes, indexed by bc label
+   */
+  void backup_circuit_state(std::map<std::string, std::vector<Real> > &) const;
+
+  /**
+   * restore external circuit state saved by backup_circuit_state()
+   */
+  void restore_circuit_state(const std::map<std::string, std::vector<Real> > &);
+
   /**
    * the enveriment temperature
    */
@@ -470,6 +497,17 @@ private:
    */
   void build_region_fvm_mesh();
 
+  /**
+   * set the partition weight of each subdomain before mesh partition.
+   * use measured assembly cost per node if exist, else the weight of material
+   */
+  void set_partition_weight();
+
+  /**
+   * measured assembly cost per node of each subdomain
+   */
+  std::map<unsigned int, double> _subdomain_cost;
+
   /**
    * all the boundary conditions
    */
@@ -26,7 +26,10 @@
 
 // C++ includes
 #include <map>
+#include <set>
 #include <fstream>
+#include <sstream>
+#include <vector>
 
 // Local includes
 #include "genius_common.h"
@@ -37,10 +40,12 @@
 
 // Forward declarations
 class MeshBase;
+class AsyncWriter;
 
 
 #ifdef HAVE_VTK
 class vtkUnstructuredGrid;
+class vtkDataSetAttributes;
 #endif
 
 
@@ -68,12 +73,20 @@ public:
    */
   VTKIO (const SimulationSystem& system);
 
+  /**
+   * destructor, free the cached grid
+   */
+  ~VTKIO ();
+
 
   /**
    * This method implements reading a mesh from a specified file
    * in VTK format.
+   * only .pvtu file written by this class is supported now, it restores
+   * potential, carrier densities and temperatures to the system built
+   * on the same mesh. each processor reads the piece files it needs.
    */
-  virtual void read (const std::string& ) {}
+  virtual void read (const std::string& );
 
   /**
    * This method implements writing a mesh to a specified fil
@@ -81,6 +94,30 @@ public:
    */
   virtual void write (const std::string& );
 
+  /**
+   * write one point of a solution series to .vtu file.
+   * nodes, cells and mesh info are built at the first call and reused by
+   * later calls as long as the mesh and its partition are not changed,
+   * only the solution data are gathered again.
+   * for .pvtu file, each processor writes its own piece to a .vtu file and
+   * processor 0 writes the index.
+   * when \p writer is given, processor 0 passes the grid to it and returns
+   * before the file is written. in this case, the VTKIO object must live
+   * until the writer finished all the jobs.
+   */
+  void write_series (const std::string& , AsyncWriter * writer=0);
+
+  /**
+   * write one point of a solution series in XDMF format, for the series on a fixed mesh
+   * without the cost of writing the mesh again.
+   * the geometry (nodes, cells and mesh info) goes to a binary file only when it is changed,
+   * each point writes its field arrays to the binary file \p name. the index \p index_name (.xmf)
+   * lists all the points written so far and is rewritten after each point.
+   * \p value is the time (bias or frequency) of this point.
+   * \p writer is used as write_series() does
+   */
+  void write_xdmf_series (const std::string& index_name, const std::string& name, double value, AsyncWriter * writer=0);
+
 private:
 
   // boundary info
@@ -88,6 +125,12 @@ private:
   std::vector<unsigned short int> _sl;
   std::vector<short int>          _il;
 
+  /**
+   * mesh size when the cached grid was built
+   */
+  unsigned int _geometry_n_nodes;
+  unsigned int _geometry_n_elem;
+
 
   // < <region, id>, id >
   std::map< std::pair<unsigned int, unsigned int>, unsigned int > _region_node_id_map;
@@ -169,12 +212,146 @@ private:
                                    std::vector<float > & sol_z,
                                    const std::string & sol_name, vtkUnstructuredGrid* grid);
 
+  /**
+   * write nodes, cells and mesh info of on processor elements into a vtkUnstructuredGrid,
+   * and build the communication pattern for the piece nodes owned by other processors
+   */
+  void piece_to_vtk(const MeshBase& mesh, vtkUnstructuredGrid* grid);
+
+  /**
+   * queue the on processor node values \p region_sol (ordered as \p region_order) as one
+   * channel of the node field being written in piece mode
+   */
+  void piece_queue_channel(const std::vector< std::vector<unsigned int> >& region_order,
+                           const std::vector< std::vector<float> > & region_sol);
+
+  /**
+   * exchange the queued channels of all the node fields with neighbor pieces in one pass,
+   * and add them to the point data of \p grid
+   */
+  void piece_write_node_fields(vtkUnstructuredGrid* grid);
+
+  /**
+   * write the .pvtu index file, array names are taken from \p grid
+   */
+  void write_pvtu_index(const std::string& name, vtkUnstructuredGrid* grid);
+
+  /**
+   * @return the file name of piece \p p of .pvtu file \p name
+   */
+  static std::string piece_file_name(const std::string& name, unsigned int p);
+
+  /**
+   * read node solution from a piece file. the read node are recorded in \p read_nodes,
+   * @return the number of on local nodes set by this piece
+   */
+  unsigned int read_piece(const std::string& name, std::vector< std::set<unsigned int> > & read_nodes);
+
+  /**
+   * each processor writes its own piece of a .pvtu file
+   */
+  bool _piece_mode;
+
+  /**
+   * number of piece points
+   */
+  unsigned int _piece_n_points;
+
+  /**
+   * piece point index of the on processor nodes of all the regions, in the order of
+   * SimulationRegion::on_processor_nodes. invalid_uint if the node is not in this piece
+   */
+  std::vector<unsigned int> _piece_local_point;
+
+  /**
+   * map elem id to piece cell index
+   */
+  std::map<unsigned int, unsigned int> _piece_elem_index;
+
+  /**
+   * map boundary face (elem id, side) to piece cell index
+   */
+  std::map< std::pair<unsigned int, unsigned short int>, unsigned int > _piece_face_index;
+
+  /**
+   * processors whose piece requires on processor nodes of this processor, and
+   * the index of these nodes in _piece_local_point
+   */
+  std::vector<unsigned int> _piece_send_procs;
+  std::vector< std::vector<unsigned int> > _piece_send_index;
+
+  /**
+   * processors own piece nodes of this processor, and the piece point index of these nodes
+   */
+  std::vector<unsigned int> _piece_recv_procs;
+  std::vector< std::vector<unsigned int> > _piece_recv_point;
+
+  /**
+   * node field queued in piece mode, waits for piece_write_node_fields()
+   */
+  struct PieceNodeField
+  {
+    enum Kind { SCALAR, COMPLEX, VECTOR };
+    Kind kind;
+    std::string name;
+    /**
+     * index of its first channel in _piece_channels
+     */
+    unsigned int channel;
+  };
+
+  std::vector<PieceNodeField> _piece_fields;
+
+  /**
+   * on processor node values of the queued fields, one vector for each component
+   */
+  std::vector< std::vector<float> > _piece_channels;
+
   /**
    * pointer to the VTK grid
    */
   vtkUnstructuredGrid* _vtk_grid;
 
+  /**
+   * rebuild the cached grid _vtk_grid when the mesh or its partition is changed,
+   * the pending job of \p writer is finished before it
+   * @return true if the grid is rebuilt
+   */
+  bool update_cached_grid(bool piece_mode, AsyncWriter * writer);
+
+  /**
+   * write the nodes and cells of \p grid as XDMF mixed topology to \p buffer
+   * @return the xml of topology and geometry, reference to binary file \p file
+   */
+  static std::string xdmf_geometry(vtkUnstructuredGrid* grid, const std::string & file, std::vector<char> & buffer);
+
+  /**
+   * append the numeric arrays of \p data to \p buffer and their XDMF attributes to \p xml.
+   * arrays also in \p skip are not written
+   */
+  static void xdmf_arrays(vtkDataSetAttributes * data, vtkDataSetAttributes * skip, const std::string & center,
+                          const std::string & file, std::vector<char> & buffer, std::ostringstream & xml);
+
+  /**
+   * number of geometry files of XDMF series
+   */
+  unsigned int _xdmf_n_geometry;
+
+  /**
+   * the xml of topology, geometry and mesh info of current geometry file
+   */
+  std::string _xdmf_geometry_xml;
+
+  /**
+   * the xml of each point of XDMF series
+   */
+  std::vector<std::string> _xdmf_steps;
+
   class XMLUnstructuredGridWriter;
+
+  class GridWriteJob;
+
+  class RawWriteJob;
 #endif
 
 
@@ -187,10 +364,14 @@ private:
 inline
 VTKIO::VTKIO (SimulationSystem& system) :
     FieldInput<SimulationSystem> (system),
-    FieldOutput<SimulationSystem> (system)
+    FieldOutput<SimulationSystem> (system),
+    _geometry_n_nodes(0), _geometry_n_elem(0)
 {
 #ifdef HAVE_VTK
   _vtk_grid = NULL;
+  _piece_mode = false;
+  _piece_n_points = 0;
+  _xdmf_n_geometry = 0;
 #endif
 }
 
@@ -198,10 +379,14 @@ VTKIO::VTKIO (SimulationSystem& system) :
 
 inline
 VTKIO::VTKIO (const SimulationSystem& system) :
-    FieldOutput<SimulationSystem>(system)
+    FieldOutput<SimulationSystem>(system),
+    _geometry_n_nodes(0), _geometry_n_elem(0)
 {
 #ifdef HAVE_VTK
   _vtk_grid = NULL;
+  _piece_mode = false;
+  _piece_n_points = 0;
+  _xdmf_n_geometry = 0;
 #endif
 }
 
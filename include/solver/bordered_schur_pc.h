@@ -0,0 +1,152 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __bordered_schur_pc_h__
+#define __bordered_schur_pc_h__
+
+#include <vector>
+
+#include "petscksp.h"
+#include "dense_matrix.h"
+
+
+/**
+ * Bordered preconditioner for the extra dofs of electrode and external circuit.
+ * These dofs are numbered after all the node dofs and owned by the last processor,
+ * the system is split as
+ *
+ * | A  B | x1     f
+ * |      |     =
+ * | C  D | x2     g
+ *
+ * A is the sparse PDE block, B and C are the couplings of border dofs x2 to contact nodes.
+ * With A^-1 approximated by the inner preconditioner, the few border dofs are
+ * eliminated by the dense Schur complement
+ *
+ * S  = D - C*A^-1*B
+ * x2 = S^-1 (g - C*A^-1*f)
+ * x1 = A^-1*f - A^-1*B*x2
+ *
+ * The inner preconditioner never sees the dense border rows and columns.
+ */
+class BorderedSchurPC
+{
+public:
+
+  /**
+   * constructor. inner is the configured preconditioner for the PDE block,
+   * J is the full preconditioning matrix, the dofs from border_begin are border dofs
+   */
+  BorderedSchurPC(PC inner, Mat J, PetscInt border_begin);
+
+  /**
+   * free the inner preconditioner and the sub matrices
+   */
+  ~BorderedSchurPC();
+
+  /**
+   * set pc as PCSHELL of this bordered preconditioner
+   */
+  void attach(PC pc);
+
+  /**
+   * extract sub matrices, setup the inner preconditioner and build the Schur complement.
+   * called when the jacobian matrix is changed
+   */
+  PetscErrorCode setup();
+
+  /**
+   * apply the preconditioner z = P^-1 r
+   */
+  PetscErrorCode apply(Vec r, Vec z);
+
+  /**
+   * @return the number of border dofs
+   */
+  PetscInt n_border() const
+  { return _n_border; }
+
+private:
+
+  /**
+   * the preconditioner of PDE block
+   */
+  PC             _inner;
+
+  /**
+   * the full matrix
+   */
+  Mat            _J;
+
+  /**
+   * global index of the first border dof
+   */
+  PetscInt       _border_begin;
+
+  /**
+   * number of border dofs
+   */
+  PetscInt       _n_border;
+
+  /**
+   * number of PDE dofs on this processor
+   */
+  PetscInt       _n_local_pde;
+
+  /**
+   * index set of the PDE dofs and border dofs on this processor
+   */
+  IS             _is_pde, _is_border;
+
+  /**
+   * sub matrices of J
+   */
+  Mat            _A, _B, _C, _D;
+
+  /**
+   * work vectors in PDE space
+   */
+  Vec            _f, _y, _t;
+
+  /**
+   * work vectors in border space, they only have entries on the last processor
+   */
+  Vec            _e, _g;
+
+  /**
+   * A^-1*B, each column is a vector in PDE space
+   */
+  std::vector<Vec> _X;
+
+  /**
+   * the Schur complement, only valid on the last processor
+   */
+  DenseMatrix<PetscScalar> _S;
+
+  /**
+   * the sub matrices are extracted
+   */
+  bool           _setup;
+};
+
+
+#endif
@@ -180,6 +180,11 @@ public:
    */
   virtual void build_petsc_sens_jacobian(Vec x, Mat *jac, Mat *pc);
 
+  /**
+   * wrap function for evaluating the residual and Jacobian at x in one pass
+   */
+  virtual void build_petsc_sens_residual_jacobian(Vec x, Vec r);
+
   /**
    * set electrode dI/dV for IV trace
    */
@@ -23,6 +23,8 @@
 #ifndef __ddm_ac_solver_h__
 #define __ddm_ac_solver_h__
 
+#include <vector>
+
 #include "enum_petsc_type.h"
 #include "fvm_linear_solver.h"
 #include "petscksp.h"
@@ -41,7 +43,7 @@ public:
    * as well as parallel scatter
    */
   DDMACSolver(SimulationSystem & system)
-  : FVM_LinearSolver(system),_first_create(true)
+  : FVM_LinearSolver(system),_first_create(true),_mor_expansions(0)
   {
     system.record_active_solver(this->solver_type());
   }
@@ -230,15 +232,190 @@ private:
    */
   Mat            C_;
 
+  /**
+   * the region part of AC matrix at omega = 0 and omega = 1.
+   * the matrix is linear to omega except on the boundaries,
+   * so it is assembled once for all the frequencies
+   */
+  Mat            K0_, K1_;
+
+  /**
+   * the transformation matrix at omega = 0 and omega = 1
+   */
+  Mat            T0_, T1_;
+
+  /**
+   * the boundary part of A_ at current frequency, A_ = K0_ + omega*(K1_-K0_) + B_
+   */
+  Mat            B_;
+
+  /**
+   * the on processor rows of B_ which have entries, they are the boundary rows of A
+   */
+  std::vector<PetscInt> _bc_rows;
+
   /**
    * flag to show if A_ is created
    */
   bool           _first_create;
 
+  /**
+   * orthonormal basis of the reduced order model for fast AC sweep.
+   * it is spanned by the solution and its moments at each expansion frequency,
+   * together with their rotated companions, i.e. the vectors multiplied by the imaginary unit
+   */
+  std::vector<Vec> _mor_basis;
+
+  /**
+   * out of the boundary rows, A V = P0 V + omega P1 V + omega^2 P2 V, where
+   * P0 = T0 K0, P1 = (T1-T0) K0 + T0 (K1-K0) and P2 = (T1-T0)(K1-K0) do not depend on frequency.
+   * the columns P0 v, P1 v and P2 v of each basis vector v are factorized as Q R when v is added,
+   * _mor_q holds the orthonormal Q and _mor_r the columns of R
+   */
+  std::vector<Vec> _mor_q;
+
+  std::vector< std::vector<PetscScalar> > _mor_r;
+
+  /**
+   * the boundary rows of P0 v, P1 v and P2 v, in the order of _mor_r.
+   * only these rows are projected again at each frequency
+   */
+  std::vector< std::vector<PetscScalar> > _mor_z;
+
+  /**
+   * local index of the boundary rows in the reduced model, and the flag of each local row
+   */
+  std::vector<PetscInt> _mor_boundary_rows;
+
+  std::vector<unsigned char> _mor_boundary_flag;
+
+  /**
+   * the global columns of B_ on the boundary rows, the scatter of a vector to these columns
+   * and the values of each basis vector on them. B_ V is evaluated on the boundary rows
+   * without the full length vectors
+   */
+  std::vector<PetscInt> _mor_boundary_cols;
+
+  VecScatter     _mor_col_scatter;
+
+  Vec            _mor_col_vec;
+
+  std::vector< std::vector<PetscScalar> > _mor_vc;
+
+  /**
+   * local index of the real and imaginary part of each complex dof
+   */
+  std::vector<PetscInt> _mor_re_index;
+
+  std::vector<PetscInt> _mor_im_index;
+
+  /**
+   * number of expansion frequencies, i.e. the full solves in the fast sweep
+   */
+  unsigned int   _mor_expansions;
+
+  /**
+   * create matrix with the size of AC system
+   */
+  void create_ac_matrix(Mat & mat, bool transformation);
+
+  /**
+   * assemble the frequency independent matrices K0_, K1_, T0_ and T1_
+   */
+  void assemble_ddm_ac();
+
   /**
    * building the Matrix A, RHS vector b under certain freq omega
    */
   void build_ddm_ac(PetscScalar omega);
+
+  /**
+   * fill the boundary part B_ and the rhs b_ under certain freq omega
+   */
+  void build_ddm_ac_boundary(PetscScalar omega);
+
+  /**
+   * form A = T*A_ and b = T*b_ from B_ and b_, only required by the full solve
+   */
+  void build_ddm_ac_system(PetscScalar omega);
+
+  /**
+   * solve the AC system with current rhs
+   */
+  void solve_ac();
+
+  /**
+   * distribute the frequencies to processors, each one solves the whole AC system
+   * of its frequencies by sequential direct solver
+   */
+  void solve_freq_parallel();
+
+  /**
+   * solve the AC system for each port, fill SolverSpecify::ACPortY and ACPortZ
+   */
+  void solve_ports(PetscScalar omega);
+
+  /**
+   * solve the AC system with reduced order model. when the residual of the reduced
+   * solution is too large, a full solve is done and the model is expanded at current frequency
+   */
+  void solve_mor();
+
+  /**
+   * solve the AC system in the basis in least square sense. the cached Q R of the frequency
+   * independent part is combined with the boundary rows evaluated at this frequency.
+   * @return true when the relative residual is less than SolverSpecify::ACMORTol
+   */
+  bool mor_reduced_solve(PetscReal & error);
+
+  /**
+   * add the AC solution x and its moments at current frequency to the basis.
+   * the matrix A should not be changed since x is solved
+   */
+  void mor_expand();
+
+  /**
+   * orthonormalize v against the basis and append it, together with its rotated companion.
+   * @return false if v is linearly dependent to the basis
+   */
+  bool mor_add_basis(Vec v);
+
+  /**
+   * orthonormalize v against the basis, append it and factorize its columns of A V
+   * @return false if v is linearly dependent to the basis
+   */
+  bool mor_append_basis(Vec v);
+
+  /**
+   * keep the boundary rows of p apart and append its remains to the Q R factorization.
+   * p is owned by the reduced model after this call
+   */
+  void mor_append_column(Vec p);
+
+  /**
+   * the rotated companion of v, u = i*v, i.e. (re, im) -> (-im, re) for each complex dof
+   */
+  void mor_rotate(Vec v, Vec u) const;
+
+  /**
+   * fix the boundary rows of the reduced model by the rows of B_
+   */
+  void mor_set_boundary_rows();
+
+  /**
+   * @return true if B_ has entries out of the boundary rows of the reduced model
+   */
+  bool mor_boundary_changed() const;
+
+  /**
+   * free the basis of the reduced order model, the model is restarted
+   */
+  void mor_reset();
+
+  /**
+   * free the reduced order model
+   */
+  void mor_clear();
 };
 
 
@@ -98,6 +98,13 @@ public:
    */
   virtual void snes_solve();
 
+  /**
+   * IV trace reuses the jacobian of converged solution for continuation,
+   * which must be up to date
+   */
+  virtual bool jacobian_reuse_allowed() const
+  { return SolverSpecify::Type != SolverSpecify::TRACE; }
+
   /**
    * load previous state into solution vector, empty here
    */
@@ -182,6 +189,12 @@ public:
 
 protected:
 
+  /**
+   * one V or I sweep of dcsweep with branch electrode(s) fixed.
+   * the branches of a family are solved one after another, each from the same saved system state
+   */
+  int solve_dcsweep_branch(PetscInt & total_lits);
+
   /**
    * the global privious solution vector at n step
    */
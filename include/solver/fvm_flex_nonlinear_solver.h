@@ -35,6 +35,8 @@
 //#include "petscksp.h"
 #include "petscsnes.h"
 
+class BorderedSchurPC;
+
 
 
 
@@ -202,6 +204,53 @@ public:
    */
   virtual void build_petsc_sens_jacobian(Vec x, Mat *jac, Mat *pc)=0;
 
+  /**
+   * test if the jacobian should be assembled (and factorized) again at this Newton iteration.
+   * the old one is kept when SolverSpecify::JacobianReuse is set and the residual still decreases fast enough
+   */
+  bool jacobian_rebuild_test();
+
+  /**
+   * force the jacobian to be rebuilt at next Newton iteration, i.e. after nonlinear solver diverged
+   */
+  void jacobian_invalidate()  { _jacobian_age = -1; }
+
+  /**
+   * derived class returns false when it needs an up-to-date jacobian after each solve
+   */
+  virtual bool jacobian_reuse_allowed() const { return true; }
+
+  /**
+   * evaluate the residual and Jacobian at x in one pass. the default implementation calls them one by one,
+   * derived solver can override it to share the physical model evaluation
+   */
+  virtual void build_petsc_sens_residual_jacobian(Vec x, Vec r);
+
+  /**
+   * residual evaluation with SolverSpecify::FusedAssembly, the jacobian is built at the same time
+   * and kept for the following jacobian request at the same x
+   */
+  void build_petsc_sens_fused(Vec x, Vec r);
+
+  /**
+   * @return true if the jacobian at x has been built by the fused residual evaluation
+   */
+  bool jacobian_fused_at(Vec x);
+
+  /**
+   * @return true when residual and jacobian are evaluated in one pass.
+   * it does not pay when jacobian is reused, or residual is evaluated for matrix free operator.
+   * only Newton with basic line search evaluates the residual at accepted iterates alone,
+   * line search and trust region also evaluate it at trial points which never get a jacobian.
+   * the residual which finally passes the convergence test still builds one unused jacobian per solve,
+   * clear_nonlinear_data() reports how many fused evaluations were not used
+   */
+  bool fused_evaluation() const
+  {
+    return SolverSpecify::FusedAssembly && !SolverSpecify::JacobianReuse && !SolverSpecify::JacobianMatrixFree &&
+           _nonlinear_solver_type == SolverSpecify::Newton;
+  }
+
   /**
    * virtual function for snes monitor. derived class can override it as needed.
    */
@@ -260,6 +309,51 @@ protected:
    */
   Mat            J;
 
+  /**
+   * the matrix free operator for Jacobian-free Newton-Krylov, J is then only the preconditioner
+   */
+  Mat            J_mf;
+
+  /**
+   * Newton iterations since the jacobian was assembled, -1 for no valid jacobian
+   */
+  int            _jacobian_age;
+
+  /**
+   * residual norm at previous jacobian request
+   */
+  PetscReal      _jacobian_fnorm;
+
+  /**
+   * jacobian requested by Newton iterations
+   */
+  unsigned int   _n_jacobian_request;
+
+  /**
+   * jacobian really assembled
+   */
+  unsigned int   _n_jacobian_assemble;
+
+  /**
+   * the solution vector the last fused residual/jacobian evaluation is taken at
+   */
+  Vec            x_fused;
+
+  /**
+   * the jacobian is built by fused evaluation at x_fused and not requested yet
+   */
+  bool           _jacobian_fused;
+
+  /**
+   * residual evaluations which also built the jacobian
+   */
+  unsigned int   _n_residual_fused;
+
+  /**
+   * jacobian requests served by the fused evaluation
+   */
+  unsigned int   _n_jacobian_fused;
+
   /**
    * the left scaling vector of J
    */
@@ -324,6 +418,12 @@ protected:
    */
   PC             pc;
 
+  /**
+   * bordered Schur complement for electrode/circuit dofs, the original preconditioner
+   * is kept inside and applies to the PDE block
+   */
+  BorderedSchurPC * _border_pc;
+
   /**
    * array for ksp residual history
    */
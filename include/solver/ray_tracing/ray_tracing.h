@@ -36,6 +36,7 @@
 
 
 class ObjectTree;
+class ElemBVH;
 class LightThread;
 class LightLenses;
 class ARCoatings;
@@ -128,10 +129,20 @@ private:
    */
   void build_elem_carrier_density();
 
+  /**
+   * free carrier absorption of each elem for a special lamda
+   */
+  std::vector<double> _elem_free_carrier_absorption;
+
+  /**
+   * build _elem_free_carrier_absorption
+   */
+  void build_elem_free_carrier_absorption(double lamda);
+
   /**
    * @return free carrier absorption of given elem
    */
-  double get_free_carrier_absorption(const Elem*, double) const;
+  double get_free_carrier_absorption(const Elem*) const;
 
   /**
    * record all the elements which contains this Node as its vertex
@@ -234,6 +245,11 @@ private:
    */
   ObjectTree *surface_elem_tree;
 
+  /**
+   * a flat BVH over the same boundary elements, used by ray tracing threads
+   */
+  ElemBVH *surface_elem_bvh;
+
   /**
    * when the light source can be considered as plane wave, this struct stores the plane norm to wave direction.
    * we will build a bounding sphere(C,R) of the mesh, then we build the plane with plane_norm = light_direction
@@ -331,9 +347,24 @@ private:
   void define_lenses();
 
   /**
-   * do ray tracing of a single ray
+   * energy deposit and power statistic of the rays traced by one thread,
+   * they are summed to the solver by thread order after all the rays are traced
+   */
+  struct RayAccumulator
+  {
+    std::vector<double> band_absorption_energy_in_elem;
+    std::vector<double> total_absorption_energy_in_elem;
+    double incident_power;
+    double pass_power;
+    double escape_power;
+    double absorb_power;
+  };
+
+  /**
+   * do ray tracing of a single ray, first_hit is the boundary elem the ray hits first,
+   * NULL if the ray misses the mesh
    */
-  void ray_tracing(LightThread *);
+  void ray_tracing(LightThread *, const Elem * first_hit, RayAccumulator &) const;
 
   /**
    * save the energy deposit. for parallel simulation, we must gather this vector
@@ -30,6 +30,7 @@
 #include <map>
 #include <deque>
 #include <string>
+#include <complex>
 
 #include "enum_petsc_type.h"
 #include "enum_solver_specify.h"
@@ -89,6 +90,62 @@ namespace SolverSpecify
    */
   extern int     NSLagJacobian;
 
+  /**
+   * reuse the jacobian and its factorization across Newton iterations and time steps
+   */
+  extern bool    JacobianReuse;
+
+  /**
+   * max Newton iterations a jacobian can be reused before it is rebuilt
+   */
+  extern int     JacobianReuseMax;
+
+  /**
+   * rebuild the reused jacobian when residual reduction of a Newton iteration is worse than this ratio
+   */
+  extern double  JacobianReuseRatio;
+
+  /**
+   * Jacobian-free Newton-Krylov: finite difference of residual as operator,
+   * the assembled jacobian is only used as preconditioner
+   */
+  extern bool    JacobianMatrixFree;
+
+  /**
+   * evaluate residual together with jacobian in one pass
+   */
+  extern bool    FusedAssembly;
+
+  /**
+   * eliminate the electrode/circuit dofs by a bordered solve with dense Schur complement,
+   * the preconditioner only applies to the sparse PDE block
+   */
+  extern bool    BorderSchur;
+
+  /**
+   * repartition the mesh after solve when the measured load imbalance (max/average assembly time) exceeds it.
+   * disabled when it is not larger than 1
+   */
+  extern double  RepartitionThreshold;
+
+  /**
+   * refine the mesh every AdaptInterval bias points (DC sweep) or time steps (transient).
+   * 0 for no adaptive refinement
+   */
+  extern unsigned int AdaptInterval;
+
+  /**
+   * set by the solver when it stops the sweep for mesh adaptation.
+   * the start point (VStart, IStart or TStart) is moved to the next bias point / time step
+   */
+  extern bool    AdaptPending;
+
+  /**
+   * the solve continues a sweep stopped for mesh adaptation. the transient keeps
+   * its time step, BDF2 state and external circuit state instead of a new start
+   */
+  extern bool    AdaptContinue;
+
   /**
    * linear solver scheme: LU, BCGS, GMRES ...
    */
@@ -493,6 +550,23 @@ namespace SolverSpecify
    */
   extern int       DC_Cycles;
 
+  /**
+   * electrode(s) held at each branch voltage while the DC sweep is repeated,
+   * i.e. Vd of an Id-Vg family. the branches are swept one after another. empty for a single sweep
+   */
+  extern std::vector<std::string>    Electrode_VBranch;
+
+  /**
+   * the branch voltages, one full DC sweep for each
+   */
+  extern std::vector<double>         VBranch;
+
+  /**
+   * index of the branch in VBranch being swept, hooks record it
+   * to split a family of curves per branch
+   */
+  extern unsigned int   VBranch_Index;
+
 
   /**
    * use node set, only for mixA solver
@@ -563,6 +637,52 @@ namespace SolverSpecify
    */
   extern double    Freq;
 
+  /**
+   * each electrode in Electrode_ACScan is excited as an individual port,
+   * the full admittance matrix of the ports is computed
+   */
+  extern bool      ACMultiPort;
+
+  /**
+   * admittance matrix of the ports at current frequency, row major.
+   * Y(i,j) is the current of port i when port j is excited, in the internal unit
+   */
+  extern std::vector< std::complex<double> > ACPortY;
+
+  /**
+   * impedance matrix of the ports at current frequency, the inverse of ACPortY
+   */
+  extern std::vector< std::complex<double> > ACPortZ;
+
+  /**
+   * fast AC sweep by reduced order model. the AC system is projected to a small
+   * basis built from the solution moments at a few expansion frequencies
+   */
+  extern bool      ACMOR;
+
+  /**
+   * relative residual tolerance of reduced solution, a new expansion frequency
+   * is added when the reduced solution exceeds it
+   */
+  extern double    ACMORTol;
+
+  /**
+   * number of basis vectors (solution and its moments) added at each expansion frequency
+   */
+  extern unsigned int ACMOROrder;
+
+  /**
+   * max number of basis vectors of the reduced model, the model is restarted
+   * at current frequency when an expansion would exceed it
+   */
+  extern unsigned int ACMORMaxBasis;
+
+  /**
+   * frequency parallel AC sweep, each processor solves the whole AC system
+   * of its own frequencies
+   */
+  extern bool      ACFreqParallel;
+
   //------------------------------------------------------
   // parameters for pseudo time stepping method
   //------------------------------------------------------
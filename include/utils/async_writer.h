@@ -0,0 +1,126 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+
+#ifndef __async_writer_h__
+#define __async_writer_h__
+
+#include <deque>
+#include <vector>
+
+#ifndef WINDOWS
+#include <pthread.h>
+#endif
+
+
+/**
+ * a single background thread which runs file output jobs in submit order,
+ * so the solver can go on while the data of the last output point is written.
+ *
+ * a job must own all the data it writes, the caller should not touch it after submit.
+ * finished jobs are deleted by the thread calling submit() or wait(), not by the
+ * background thread, since the destructor may release objects shared with the caller.
+ * on WINDOWS, the job is run at once by submit()
+ */
+class AsyncWriter
+{
+public:
+
+  /**
+   * base class of output job
+   */
+  class Job
+  {
+  public:
+    virtual ~Job() {}
+
+    /**
+     * do the output, called by background thread
+     */
+    virtual void run()=0;
+  };
+
+  /**
+   * @param max_pending  submit() blocks while so many jobs are waiting,
+   * which limits the memory hold by the snapshots
+   */
+  AsyncWriter(unsigned int max_pending=2);
+
+  /**
+   * wait all the jobs and stop the background thread
+   */
+  ~AsyncWriter();
+
+  /**
+   * queue a job, the AsyncWriter takes the ownership of it
+   */
+  void submit(Job * job);
+
+  /**
+   * block until all the submitted jobs are finished
+   */
+  void wait();
+
+  /**
+   * @return the number of jobs have been finished
+   */
+  unsigned int n_finished_jobs() const
+  { return _n_finished; }
+
+private:
+
+  /**
+   * delete the finished jobs, must be called with mutex locked
+   */
+  void _reap();
+
+  unsigned int _max_pending;
+
+  unsigned int _n_finished;
+
+  /**
+   * jobs wait for running, the front one may be running
+   */
+  std::deque<Job *> _pending;
+
+  /**
+   * jobs finished but not deleted
+   */
+  std::vector<Job *> _finished;
+
+#ifndef WINDOWS
+  static void * _thread_entry(void *);
+
+  void _loop();
+
+  bool _started;
+
+  bool _stop;
+
+  pthread_t       _thread;
+  pthread_mutex_t _mutex;
+  pthread_cond_t  _cond;
+#endif
+};
+
+
+#endif
@@ -0,0 +1,123 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+
+#ifndef __elem_bvh_h__
+#define __elem_bvh_h__
+
+#include <vector>
+
+#include "point.h"
+
+// Forward Declarations
+class Elem;
+
+
+/**
+ * a flat bounding volume hierarchy over a set of elements for fast ray-elem
+ * intersection test. the tree nodes are stored depth first in a single array,
+ * the left child of an interior node always follows its parent, only the offset
+ * of the right child is recorded.
+ * the query functions are const and can be called by several threads at the same time.
+ */
+class ElemBVH
+{
+public:
+
+  /**
+   * build the hierarchy over elems, the elements are not owned by ElemBVH
+   */
+  ElemBVH (const std::vector<const Elem *> & elems);
+
+  /**
+   * the number of rays traced together by the packet version of hit()
+   */
+  static const unsigned int packet_size = 8;
+
+  /**
+   * @return the first elem the ray(p,d) hit, NULL if missed
+   */
+  const Elem * hit(const Point & p, const Point & d) const;
+
+  /**
+   * find the first elem hit for each of the n rays (p[i], d[i]), the result is stored in elems[i].
+   * rays are traversed by packets of packet_size, coherent rays share the node tests.
+   */
+  void hit(unsigned int n, const Point * p, const Point * d, const Elem ** elems) const;
+
+  /**
+   * @return the number of tree nodes
+   */
+  unsigned int n_nodes() const
+  { return _nodes.size(); }
+
+private:
+
+  struct BVHNode
+  {
+    /// lower corner of the bounding box
+    double lo[3];
+
+    /// upper corner of the bounding box
+    double hi[3];
+
+    /// for leaf, the first element in _elems, else the index of right child
+    unsigned int offset;
+
+    /// number of elements for leaf, 0 for interior node
+    unsigned short count;
+
+    /// split axis of interior node
+    unsigned short axis;
+  };
+
+  /**
+   * the tree nodes, root at 0
+   */
+  std::vector<BVHNode> _nodes;
+
+  /**
+   * elements, reordered so that each leaf owns a continuous range
+   */
+  std::vector<const Elem *> _elems;
+
+  /**
+   * recursively build the subtree over _elems[begin, end)
+   * @return the index of the subtree root
+   */
+  unsigned int _build(unsigned int begin, unsigned int end,
+                      std::vector<std::pair<Point, Point> > & bbox,
+                      std::vector<Point> & centroid);
+
+  /**
+   * ray-box slab test against node, inv is the inverse of ray direction.
+   * @return true if the ray hits the box before tmax
+   */
+  static bool _hit_box(const BVHNode & node, const double * p, const double * inv, double tmax);
+
+  /**
+   * set inverse of ray direction, zero component is replaced by a tiny value to avoid NaN
+   */
+  static void _inverse_dir(const Point & d, double * inv);
+};
+
+#endif
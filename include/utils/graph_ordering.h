@@ -0,0 +1,64 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+
+#ifndef __graph_ordering_h__
+#define __graph_ordering_h__
+
+// C++ includes
+#include <vector>
+
+// Local includes
+#include "genius_common.h"
+#include "genius_env.h"
+#include "point.h"
+
+
+/**
+ * Functions to reorder the vertices of a graph (i.e. the fvm nodes of a region)
+ * so that vertices near each other are also near each other in memory.
+ * This makes array accesses in node/edge loops cache friendly and reduces the
+ * bandwidth of the assembled matrix.
+ *
+ * All the functions return a permutation \p order, where order[k] is the old
+ * index of the vertex which should be placed at the k-th position.
+ */
+namespace GraphOrdering
+{
+
+  /**
+   * Reverse Cuthill-McKee ordering of a graph given in CSR format.
+   * each connected component begins with a pseudo-peripheral vertex.
+   */
+  void reverse_cuthill_mckee(const std::vector<unsigned int> & xadj,
+                             const std::vector<unsigned int> & adjncy,
+                             std::vector<unsigned int> & order);
+
+  /**
+   * Order the points along the 3D Hilbert space-filling curve
+   * over their bounding box
+   */
+  void hilbert(const std::vector<Point> & pts, std::vector<unsigned int> & order);
+
+}
+
+#endif // #define __graph_ordering_h__
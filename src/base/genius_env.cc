@@ -23,6 +23,7 @@
 #include "genius_common.h"
 #include "genius_env.h"
 
+#include <algorithm>
 #include <ios>
 #include <fstream>
 #include <string>
@@ -35,6 +36,7 @@
 // Genius::GeniusPrivateData data initialization
 int  Genius::GeniusPrivateData::_n_processors = 1;
 int  Genius::GeniusPrivateData::_processor_id = 0;
+int  Genius::GeniusPrivateData::_n_threads = 1;
 
 #ifdef HAVE_MPI
 MPI_Comm Genius::GeniusPrivateData::_comm_world;
@@ -89,6 +91,18 @@ bool Genius::clean_processors()
 }
 
 
+void Genius::set_n_threads(unsigned int n)
+{
+#ifdef HAVE_OPENMP
+  GeniusPrivateData::_n_threads = std::max(1, static_cast<int>(n));
+  omp_set_num_threads(GeniusPrivateData::_n_threads);
+#else
+  // no thread support, keep serial
+  GeniusPrivateData::_n_threads = 1;
+#endif
+}
+
+
 #ifdef WINDOWS
 #else
 #include <unistd.h>
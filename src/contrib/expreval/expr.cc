@@ -129,6 +129,9 @@ void Expression::Parse(const string &exstr)
     
     // Parse the expression
     m_expr = p->Parse(exstr);
+
+    // Compile it to flat code
+    m_expr->Compile(m_program);
     }
     
 // Clear the expression
@@ -136,6 +139,7 @@ void Expression::Clear()
     {
     delete m_expr;
     m_expr = 0; 
+    m_program.Clear();
     }
 
 // Evaluate an expression
@@ -143,11 +147,25 @@ double Expression::Evaluate()
     {
     if(m_expr)
         {
-        return m_expr->Evaluate();
+        return m_program.Run();
         }
     else
         {
         throw(EmptyExpressionException());
         }    
     }
+
+// Evaluate an expression at n points
+void Expression::Evaluate(Program::size_type n, const vector<double*> &vars,
+        const vector<const double*> &values, double *result)
+    {
+    if(m_expr)
+        {
+        m_program.Run(n, vars, values, result);
+        }
+    else
+        {
+        throw(EmptyExpressionException());
+        }
+    }
             
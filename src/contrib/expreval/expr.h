@@ -9,6 +9,9 @@
 
 // Includes
 #include <string>
+#include <vector>
+
+#include "expr_program.h"
 
 // Part of expreval namespace
 namespace ExprEval
@@ -52,12 +55,18 @@ namespace ExprEval
             
             // Evaluate expression
             double Evaluate();
+
+            // Evaluate expression at n points, variable vars[k] takes the
+            // value values[k][i] for point i
+            void Evaluate(Program::size_type n, const ::std::vector<double*> &vars,
+                    const ::std::vector<const double*> &values, double *result);
             
         protected:
             ValueList *m_vlist;
             FunctionList *m_flist;
             DataList *m_dlist;
             Node *m_expr;
+            Program m_program;
             unsigned long m_abortcount;
             unsigned long m_abortreset;
         };
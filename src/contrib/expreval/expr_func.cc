@@ -26,6 +26,63 @@ using namespace ExprEval;
 // Anonymous namespace for items
 namespace
     {
+    // Plain functions called by compiled code
+    //--------------------------------------------------------------------------
+    double abs_Func(double x) { return fabs(x); }
+    double sqrt_Func(double x) { return sqrt(x); }
+    double sin_Func(double x) { return sin(x); }
+    double cos_Func(double x) { return cos(x); }
+    double tan_Func(double x) { return tan(x); }
+    double sinh_Func(double x) { return sinh(x); }
+    double cosh_Func(double x) { return cosh(x); }
+    double tanh_Func(double x) { return tanh(x); }
+    double asin_Func(double x) { return asin(x); }
+    double acos_Func(double x) { return acos(x); }
+    double atan_Func(double x) { return atan(x); }
+    double asinh_Func(double x) { return boost::math::asinh(x); }
+    double acosh_Func(double x) { return boost::math::acosh(x); }
+    double atanh_Func(double x) { return boost::math::atanh(x); }
+    double log_Func(double x) { return log10(x); }
+    double ln_Func(double x) { return log(x); }
+    double exp_Func(double x) { return exp(x); }
+    double ceil_Func(double x) { return ceil(x); }
+    double floor_Func(double x) { return floor(x); }
+    double atan2_Func(double y, double x) { return atan2(y, x); }
+    double min_Func(double a, double b) { return b < a ? b : a; }
+    double max_Func(double a, double b) { return b > a ? b : a; }
+    double equal_Func(double a, double b) { return a == b ? 1.0 : 0.0; }
+    double above_Func(double a, double b) { return a > b ? 1.0 : 0.0; }
+    double below_Func(double a, double b) { return a < b ? 1.0 : 0.0; }
+
+    // Compute the complementary error function erfc(x).
+    // Erfc(x) = (2/sqrt(pi)) Integral(exp(-t^2))dt between x and infinity
+    //
+    //--- Nve 14-nov-1998 UU-SAP Utrecht
+    double erfc_Func(double x)
+        {
+        // The parameters of the Chebyshev fit
+        const double a1 = -1.26551223,   a2 = 1.00002368,
+                     a3 =  0.37409196,   a4 = 0.09678418,
+                     a5 = -0.18628806,   a6 = 0.27886807,
+                     a7 = -1.13520398,   a8 = 1.48851587,
+                     a9 = -0.82215223,  a10 = 0.17087277;
+
+        double result = 1; // The return value
+        double z = fabs(x);
+
+        if (z <= 0) return result; // erfc(0)=1
+
+        double t = 1/(1+0.5*z);
+
+        result = t*exp((-z*z) +a1+t*(a2+t*(a3+t*(a4+t*(a5+t*(a6+t*(a7+t*(a8+t*(a9+t*a10)))))))));
+
+        if (x < 0) result = 2-result; // erfc(-x)=2-erfc(x)
+
+        return result;
+        }
+
+    double erf_Func(double x) { return 1 - erfc_Func(x); }
+
     // Absolute value
     //--------------------------------------------------------------------------
     class abs_FunctionNode : public FunctionNode
@@ -40,6 +97,11 @@ namespace
                 {
                 return fabs(m_nodes[0]->Evaluate());
                 }
+
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, abs_Func, false);
+                }
         };
 
     class abs_FunctionFactory : public FunctionFactory
@@ -186,6 +248,19 @@ namespace
 
                 return result;
                 }
+
+            void Compile(Program &prog)
+                {
+                vector<Node*>::size_type pos;
+
+                m_nodes[0]->Compile(prog);
+
+                for(pos = 1; pos < m_nodes.size(); pos++)
+                    {
+                    m_nodes[pos]->Compile(prog);
+                    prog.EmitCall(min_Func, GetName(), false);
+                    }
+                }
         };
 
     class min_FunctionFactory : public FunctionFactory
@@ -227,6 +302,19 @@ namespace
 
                 return result;
                 }
+
+            void Compile(Program &prog)
+                {
+                vector<Node*>::size_type pos;
+
+                m_nodes[0]->Compile(prog);
+
+                for(pos = 1; pos < m_nodes.size(); pos++)
+                    {
+                    m_nodes[pos]->Compile(prog);
+                    prog.EmitCall(max_Func, GetName(), false);
+                    }
+                }
         };
 
     class max_FunctionFactory : public FunctionFactory
@@ -264,6 +352,11 @@ namespace
 
                 return result;
                 }
+
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, sqrt_Func);
+                }
         };
 
     class sqrt_FunctionFactory : public FunctionFactory
@@ -301,6 +394,11 @@ namespace
 
                 return result;
                 }
+
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, sin_Func);
+                }
         };
 
     class sin_FunctionFactory : public FunctionFactory
@@ -338,6 +436,11 @@ namespace
 
                 return result;
                 }
+
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, cos_Func);
+                }
         };
 
     class cos_FunctionFactory : public FunctionFactory
@@ -375,6 +478,11 @@ namespace
 
                 return result;
                 }
+
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, tan_Func);
+                }
         };
 
     class tan_FunctionFactory : public FunctionFactory
@@ -412,6 +520,11 @@ namespace
 
                 return result;
                 }
+
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, sinh_Func);
+                }
         };
 
     class sinh_FunctionFactory : public FunctionFactory
@@ -449,6 +562,11 @@ namespace
 
                 return result;
                 }
+
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, cosh_Func);
+                }
         };
 
     class cosh_FunctionFactory : public FunctionFactory
@@ -486,6 +604,11 @@ namespace
 
                 return result;
                 }
+
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, tanh_Func);
+                }
         };
 
     class tanh_FunctionFactory : public FunctionFactory
@@ -523,6 +646,11 @@ namespace
 
                 return result;
                 }
+
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, asin_Func);
+                }
         };
 
     class asin_FunctionFactory : public FunctionFactory
@@ -560,6 +688,11 @@ namespace
 
                 return result;
                 }
+
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, acos_Func);
+                }
         };
 
     class acos_FunctionFactory : public FunctionFactory
@@ -597,6 +730,11 @@ namespace
 
                 return result;
                 }
+
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, atan_Func);
+                }
         };
 
     class atan_FunctionFactory : public FunctionFactory
@@ -634,6 +772,11 @@ namespace
 
                 return result;
                 }
+
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, atan2_Func);
+                }
         };
 
     class atan2_FunctionFactory : public FunctionFactory
@@ -671,6 +814,11 @@ namespace
 
                 return result;
                 }
+
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, asinh_Func);
+                }
         };
 
     class asinh_FunctionFactory : public FunctionFactory
@@ -709,6 +857,11 @@ namespace
 
                 return result;
                 }
+
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, acosh_Func);
+                }
         };
 
     class acosh_FunctionFactory : public FunctionFactory
@@ -747,6 +900,11 @@ namespace
 
                 return result;
                 }
+
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, atanh_Func);
+                }
         };
 
     class atanh_FunctionFactory : public FunctionFactory
@@ -784,6 +942,11 @@ namespace
 
                 return result;
                 }
+
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, log_Func);
+                }
         };
 
     class log_FunctionFactory : public FunctionFactory
@@ -821,6 +984,11 @@ namespace
 
                 return result;
                 }
+
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, ln_Func);
+                }
         };
 
     class ln_FunctionFactory : public FunctionFactory
@@ -858,6 +1026,11 @@ namespace
 
                 return result;
                 }
+
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, exp_Func);
+                }
         };
 
     class exp_FunctionFactory : public FunctionFactory
@@ -930,31 +1103,12 @@ namespace
 
             double DoEvaluate()
                 {
-                   // Compute the complementary error function erfc(x).
-                   // Erfc(x) = (2/sqrt(pi)) Integral(exp(-t^2))dt between x and infinity
-                   //
-                   //--- Nve 14-nov-1998 UU-SAP Utrecht
-
-                   // The parameters of the Chebyshev fit
-                   const double a1 = -1.26551223,   a2 = 1.00002368,
-                                a3 =  0.37409196,   a4 = 0.09678418,
-                                a5 = -0.18628806,   a6 = 0.27886807,
-                                a7 = -1.13520398,   a8 = 1.48851587,
-                                a9 = -0.82215223,  a10 = 0.17087277;
-
-                  double result = 1; // The return value
-                  double x = m_nodes[1]->Evaluate();
-                  double z = fabs(x);
-
-                  if (z <= 0) return result; // erfc(0)=1
-
-                  double t = 1/(1+0.5*z);
-
-                  result = t*exp((-z*z) +a1+t*(a2+t*(a3+t*(a4+t*(a5+t*(a6+t*(a7+t*(a8+t*(a9+t*a10)))))))));
-
-                  if (x < 0) result = 2-result; // erfc(-x)=2-erfc(x)
+                return erfc_Func(m_nodes[0]->Evaluate());
+                }
 
-                  return result;
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, erfc_Func, false);
                 }
         };
 
@@ -984,31 +1138,12 @@ namespace
 
             double DoEvaluate()
                 {
-                   // Compute the complementary error function erfc(x).
-                   // Erfc(x) = (2/sqrt(pi)) Integral(exp(-t^2))dt between x and infinity
-                   //
-                   //--- Nve 14-nov-1998 UU-SAP Utrecht
-
-                   // The parameters of the Chebyshev fit
-                   const double a1 = -1.26551223,   a2 = 1.00002368,
-                                a3 =  0.37409196,   a4 = 0.09678418,
-                                a5 = -0.18628806,   a6 = 0.27886807,
-                                a7 = -1.13520398,   a8 = 1.48851587,
-                                a9 = -0.82215223,  a10 = 0.17087277;
-
-                  double result = 1; // The return value
-                  double x = m_nodes[1]->Evaluate();
-                  double z = fabs(x);
-
-                  if (z <= 0) return result; // erfc(0)=1
-
-                  double t = 1/(1+0.5*z);
-
-                  result = t*exp((-z*z) +a1+t*(a2+t*(a3+t*(a4+t*(a5+t*(a6+t*(a7+t*(a8+t*(a9+t*a10)))))))));
-
-                  if (x < 0) result = 2-result; // erfc(-x)=2-erfc(x)
+                return erf_Func(m_nodes[0]->Evaluate());
+                }
 
-                  return 1-result;
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, erf_Func, false);
                 }
         };
 
@@ -1040,6 +1175,11 @@ namespace
                 {
                 return ceil(m_nodes[0]->Evaluate());
                 }
+
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, ceil_Func, false);
+                }
         };
 
     class ceil_FunctionFactory : public FunctionFactory
@@ -1070,6 +1210,11 @@ namespace
                 {
                 return floor(m_nodes[0]->Evaluate());
                 }
+
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, floor_Func, false);
+                }
         };
 
     class floor_FunctionFactory : public FunctionFactory
@@ -1364,6 +1509,20 @@ namespace
                 else
                     return m_nodes[1]->Evaluate();
                 }
+
+            void Compile(Program &prog)
+                {
+                m_nodes[0]->Compile(prog);
+                Program::size_type to_else = prog.EmitJump(Program::OpJumpZero);
+
+                m_nodes[1]->Compile(prog);
+                Program::size_type to_end = prog.EmitJump(Program::OpJump);
+
+                prog.PatchJump(to_else);
+                m_nodes[2]->Compile(prog);
+
+                prog.PatchJump(to_end);
+                }
         };
 
     class if_FunctionFactory : public FunctionFactory
@@ -1439,6 +1598,11 @@ namespace
                 else
                     return 0.0;
                 }
+
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, equal_Func, false);
+                }
         };
 
     class equal_FunctionFactory : public FunctionFactory
@@ -1472,6 +1636,11 @@ namespace
                 else
                     return 0.0;
                 }
+
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, above_Func, false);
+                }
         };
 
     class above_FunctionFactory : public FunctionFactory
@@ -1505,6 +1674,11 @@ namespace
                 else
                     return 0.0;
                 }
+
+            void Compile(Program &prog)
+                {
+                CompileCall(prog, below_Func, false);
+                }
         };
 
     class below_FunctionFactory : public FunctionFactory
@@ -43,6 +43,12 @@ double Node::Evaluate()
     return DoEvaluate();
     }
 
+// Compile, evaluate this node by tree walk
+void Node::Compile(Program &prog)
+    {
+    prog.EmitNode(this);
+    }
+
 // Function node
 //------------------------------------------------------------------------------
 
@@ -70,6 +76,33 @@ string FunctionNode::GetName() const
     return m_factory->GetName();
     }
 
+// Compile a call to unary math function
+void FunctionNode::CompileCall(Program &prog, Program::Func1 f, bool checkerr)
+    {
+    if(m_nodes.size() != 1 || !m_refs.empty() || !m_data.empty())
+        {
+        prog.EmitNode(this);
+        return;
+        }
+
+    m_nodes[0]->Compile(prog);
+    prog.EmitCall(f, GetName(), checkerr);
+    }
+
+// Compile a call to binary math function
+void FunctionNode::CompileCall(Program &prog, Program::Func2 f, bool checkerr)
+    {
+    if(m_nodes.size() != 2 || !m_refs.empty() || !m_data.empty())
+        {
+        prog.EmitNode(this);
+        return;
+        }
+
+    m_nodes[0]->Compile(prog);
+    m_nodes[1]->Compile(prog);
+    prog.EmitCall(f, GetName(), checkerr);
+    }
+
 // Set argument count
 void FunctionNode::SetArgumentCount(long argMin, long argMax, long refMin, long refMax,
         long dataMin, long dataMax)
@@ -368,6 +401,24 @@ double MultiNode::DoEvaluate()
     return result;
     }
 
+// Compile
+void MultiNode::Compile(Program &prog)
+    {
+    vector<Node*>::size_type pos;
+
+    for(pos = 0; pos < m_nodes.size(); pos++)
+        {
+        // only the value of the last one is kept
+        if(pos > 0)
+            prog.EmitOp(Program::OpPop);
+
+        m_nodes[pos]->Compile(prog);
+        }
+
+    if(m_nodes.empty())
+        prog.EmitValue(0.0);
+    }
+
 // Parse
 void MultiNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -475,6 +526,13 @@ double AssignNode::DoEvaluate()
     return (*m_var = m_rhs->Evaluate());
     }
 
+// Compile
+void AssignNode::Compile(Program &prog)
+    {
+    m_rhs->Compile(prog);
+    prog.EmitAssign(m_var);
+    }
+
 // Parse
 void AssignNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -563,6 +621,14 @@ double AddNode::DoEvaluate()
     return m_lhs->Evaluate() + m_rhs->Evaluate();
     }
 
+// Compile
+void AddNode::Compile(Program &prog)
+    {
+    m_lhs->Compile(prog);
+    m_rhs->Compile(prog);
+    prog.EmitOp(Program::OpAdd);
+    }
+
 // Parse
 void AddNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -607,6 +673,14 @@ double SubtractNode::DoEvaluate()
     return m_lhs->Evaluate() - m_rhs->Evaluate();
     }
 
+// Compile
+void SubtractNode::Compile(Program &prog)
+    {
+    m_lhs->Compile(prog);
+    m_rhs->Compile(prog);
+    prog.EmitOp(Program::OpSubtract);
+    }
+
 // Parse
 void SubtractNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -651,6 +725,14 @@ double MultiplyNode::DoEvaluate()
     return m_lhs->Evaluate() * m_rhs->Evaluate();
     }
 
+// Compile
+void MultiplyNode::Compile(Program &prog)
+    {
+    m_lhs->Compile(prog);
+    m_rhs->Compile(prog);
+    prog.EmitOp(Program::OpMultiply);
+    }
+
 // Parse
 void MultiplyNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -704,6 +786,14 @@ double DivideNode::DoEvaluate()
         }
     }
 
+// Compile
+void DivideNode::Compile(Program &prog)
+    {
+    m_lhs->Compile(prog);
+    m_rhs->Compile(prog);
+    prog.EmitOp(Program::OpDivide);
+    }
+
 // Parse
 void DivideNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -747,6 +837,13 @@ double NegateNode::DoEvaluate()
     return -(m_rhs->Evaluate());
     }
 
+// Compile
+void NegateNode::Compile(Program &prog)
+    {
+    m_rhs->Compile(prog);
+    prog.EmitOp(Program::OpNegate);
+    }
+
 // Parse
 void NegateNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -796,6 +893,14 @@ double ExponentNode::DoEvaluate()
     return result;
     }
 
+// Compile
+void ExponentNode::Compile(Program &prog)
+    {
+    m_lhs->Compile(prog);
+    m_rhs->Compile(prog);
+    prog.EmitOp(Program::OpExponent);
+    }
+
 // Parse
 void ExponentNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -837,6 +942,12 @@ double VariableNode::DoEvaluate()
     return *m_var;
     }
 
+// Compile
+void VariableNode::Compile(Program &prog)
+    {
+    prog.EmitVariable(m_var);
+    }
+
 // Parse
 void VariableNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -907,6 +1018,12 @@ double ValueNode::DoEvaluate()
     return m_val;
     }
 
+// Compile
+void ValueNode::Compile(Program &prog)
+    {
+    prog.EmitValue(m_val);
+    }
+
 // Parse
 void ValueNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
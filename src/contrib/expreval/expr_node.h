@@ -11,6 +11,7 @@
 #include <vector>
 
 #include "expr_parser.h"
+#include "expr_program.h"
 
 // Part of expreval namespace
 namespace ExprEval
@@ -34,6 +35,9 @@ namespace ExprEval
 
             double Evaluate(); // Calls Expression::TestAbort, then DoEvaluate
 
+            // Emit code of this node, default is a call to Evaluate
+            virtual void Compile(Program &prog);
+
         protected:
             Expression *m_expr;
         };
@@ -71,6 +75,10 @@ namespace ExprEval
             // Function name (using factory)
             ::std::string GetName() const;
 
+            // Compile arguments and a call to a math function
+            void CompileCall(Program &prog, Program::Func1 f, bool checkerr = true);
+            void CompileCall(Program &prog, Program::Func2 f, bool checkerr = true);
+
             // Normal, reference, and data parameters
             ::std::vector<Node*> m_nodes;
             ::std::vector<double*> m_refs;
@@ -88,6 +96,7 @@ namespace ExprEval
             ~MultiNode();
 
             double DoEvaluate();
+            void Compile(Program &prog);
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
 
@@ -104,6 +113,7 @@ namespace ExprEval
             ~AssignNode();
 
             double DoEvaluate();
+            void Compile(Program &prog);
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
 
@@ -121,6 +131,7 @@ namespace ExprEval
             ~AddNode();
 
             double DoEvaluate();
+            void Compile(Program &prog);
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
 
@@ -138,6 +149,7 @@ namespace ExprEval
             ~SubtractNode();
 
             double DoEvaluate();
+            void Compile(Program &prog);
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
 
@@ -155,6 +167,7 @@ namespace ExprEval
             ~MultiplyNode();
 
             double DoEvaluate();
+            void Compile(Program &prog);
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
 
@@ -172,6 +185,7 @@ namespace ExprEval
             ~DivideNode();
 
             double DoEvaluate();
+            void Compile(Program &prog);
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
 
@@ -189,6 +203,7 @@ namespace ExprEval
             ~NegateNode();
 
             double DoEvaluate();
+            void Compile(Program &prog);
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
 
@@ -205,6 +220,7 @@ namespace ExprEval
             ~ExponentNode();
 
             double DoEvaluate();
+            void Compile(Program &prog);
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
 
@@ -222,6 +238,7 @@ namespace ExprEval
             ~VariableNode();
 
             double DoEvaluate();
+            void Compile(Program &prog);
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
 
@@ -238,6 +255,7 @@ namespace ExprEval
             ~ValueNode();
 
             double DoEvaluate();
+            void Compile(Program &prog);
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
 
@@ -0,0 +1,393 @@
+// File:    expr_program.cc
+// Purpose: Compiled expression program
+//------------------------------------------------------------------------------
+
+
+// Includes
+#include <cmath>
+#include <cerrno>
+
+#include "expr_program.h"
+#include "expr_node.h"
+#include "expr_except.h"
+
+using namespace std;
+using namespace ExprEval;
+
+// Points evaluated together by block evaluation
+static const Program::size_type BlockSize = 64;
+
+// Program
+//------------------------------------------------------------------------------
+
+// Constructor
+Program::Program() : m_depth(0), m_maxdepth(0), m_block(true)
+    {
+    }
+
+// Clear
+void Program::Clear()
+    {
+    m_code.clear();
+    m_depth = 0;
+    m_maxdepth = 0;
+    m_block = true;
+    }
+
+bool Program::Empty() const
+    {
+    return m_code.empty();
+    }
+
+// Emit
+void Program::Emit(const Instruction &inst, long delta)
+    {
+    m_code.push_back(inst);
+
+    m_depth += delta;
+    if(m_depth > m_maxdepth)
+        m_maxdepth = m_depth;
+    }
+
+void Program::EmitValue(double val)
+    {
+    Instruction inst = Instruction();
+    inst.op = OpValue;
+    inst.val = val;
+    Emit(inst, 1);
+    }
+
+void Program::EmitVariable(double *var)
+    {
+    Instruction inst = Instruction();
+    inst.op = OpVariable;
+    inst.var = var;
+    Emit(inst, 1);
+    }
+
+void Program::EmitAssign(double *var)
+    {
+    Instruction inst = Instruction();
+    inst.op = OpAssign;
+    inst.var = var;
+    Emit(inst, 0);
+
+    // the variable may be read later by the same point
+    m_block = false;
+    }
+
+void Program::EmitOp(OpCode op)
+    {
+    Instruction inst = Instruction();
+    inst.op = op;
+    Emit(inst, op == OpNegate ? 0 : -1);
+    }
+
+void Program::EmitCall(Func1 f, const string &name, bool checkerr)
+    {
+    Instruction inst = Instruction();
+    inst.op = OpCall1;
+    inst.f1 = f;
+    inst.name = name;
+    inst.checkerr = checkerr;
+    Emit(inst, 0);
+    }
+
+void Program::EmitCall(Func2 f, const string &name, bool checkerr)
+    {
+    Instruction inst = Instruction();
+    inst.op = OpCall2;
+    inst.f2 = f;
+    inst.name = name;
+    inst.checkerr = checkerr;
+    Emit(inst, -1);
+    }
+
+void Program::EmitNode(Node *node)
+    {
+    Instruction inst = Instruction();
+    inst.op = OpNode;
+    inst.node = node;
+    Emit(inst, 1);
+
+    m_block = false;
+    }
+
+Program::size_type Program::EmitJump(OpCode op)
+    {
+    Instruction inst = Instruction();
+    inst.op = op;
+
+    // OpJumpZero pops the condition. OpJump leaves the value of one branch,
+    // the other branch pushes its own value again
+    Emit(inst, -1);
+
+    m_block = false;
+
+    return m_code.size() - 1;
+    }
+
+void Program::PatchJump(size_type pos)
+    {
+    m_code[pos].target = m_code.size();
+    }
+
+// Evaluate once
+double Program::Run() const
+    {
+    if(m_code.empty())
+        throw(EmptyExpressionException());
+
+    if(m_stack.size() < static_cast<size_type>(m_maxdepth))
+        m_stack.resize(m_maxdepth);
+
+    double *stack = &m_stack[0];
+    long sp = -1;
+
+    size_type pc = 0;
+    const size_type end = m_code.size();
+
+    while(pc < end)
+        {
+        const Instruction &inst = m_code[pc++];
+
+        switch(inst.op)
+            {
+            case OpValue:
+                stack[++sp] = inst.val;
+                break;
+
+            case OpVariable:
+                stack[++sp] = *inst.var;
+                break;
+
+            case OpAssign:
+                *inst.var = stack[sp];
+                break;
+
+            case OpPop:
+                --sp;
+                break;
+
+            case OpAdd:
+                stack[sp - 1] += stack[sp];
+                --sp;
+                break;
+
+            case OpSubtract:
+                stack[sp - 1] -= stack[sp];
+                --sp;
+                break;
+
+            case OpMultiply:
+                stack[sp - 1] *= stack[sp];
+                --sp;
+                break;
+
+            case OpDivide:
+                if(stack[sp] == 0.0)
+                    throw(DivideByZeroException());
+                stack[sp - 1] /= stack[sp];
+                --sp;
+                break;
+
+            case OpNegate:
+                stack[sp] = -stack[sp];
+                break;
+
+            case OpExponent:
+                errno = 0;
+                stack[sp - 1] = pow(stack[sp - 1], stack[sp]);
+                if(errno)
+                    throw(MathException("^"));
+                --sp;
+                break;
+
+            case OpCall1:
+                errno = 0;
+                stack[sp] = inst.f1(stack[sp]);
+                if(inst.checkerr && errno)
+                    throw(MathException(inst.name));
+                break;
+
+            case OpCall2:
+                errno = 0;
+                stack[sp - 1] = inst.f2(stack[sp - 1], stack[sp]);
+                if(inst.checkerr && errno)
+                    throw(MathException(inst.name));
+                --sp;
+                break;
+
+            case OpNode:
+                stack[++sp] = inst.node->Evaluate();
+                break;
+
+            case OpJumpZero:
+                if(stack[sp--] == 0.0)
+                    pc = inst.target;
+                break;
+
+            case OpJump:
+                pc = inst.target;
+                break;
+            }
+        }
+
+    return stack[0];
+    }
+
+// Evaluate n points
+void Program::Run(size_type n, const vector<double*> &vars,
+        const vector<const double*> &values, double *result) const
+    {
+    if(m_code.empty())
+        throw(EmptyExpressionException());
+
+    if(!m_block)
+        {
+        for(size_type i = 0; i < n; i++)
+            {
+            for(size_type k = 0; k < vars.size(); k++)
+                *vars[k] = values[k][i];
+
+            result[i] = Run();
+            }
+
+        return;
+        }
+
+    // Source array of each variable instruction, null for unbound ones
+    vector<const double*> src(m_code.size(), 0);
+    for(size_type pc = 0; pc < m_code.size(); pc++)
+        {
+        if(m_code[pc].op != OpVariable)
+            continue;
+
+        for(size_type k = 0; k < vars.size(); k++)
+            {
+            if(m_code[pc].var == vars[k])
+                src[pc] = values[k];
+            }
+        }
+
+    for(size_type start = 0; start < n; start += BlockSize)
+        {
+        size_type m = (n - start < BlockSize) ? n - start : BlockSize;
+
+        RunBlock(start, m, src, result + start);
+        }
+    }
+
+// Evaluate a block of points, each stack entry holds BlockSize values
+void Program::RunBlock(size_type start, size_type m, const vector<const double*> &src,
+        double *result) const
+    {
+    if(m_stack.size() < static_cast<size_type>(m_maxdepth) * BlockSize)
+        m_stack.resize(static_cast<size_type>(m_maxdepth) * BlockSize);
+
+    double *stack = &m_stack[0];
+    long sp = -1;
+
+    for(size_type pc = 0; pc < m_code.size(); pc++)
+        {
+        const Instruction &inst = m_code[pc];
+
+        double *a = stack + (sp - 1) * BlockSize;
+        double *b = stack + sp * BlockSize;
+        double *c = stack + (sp + 1) * BlockSize;
+
+        switch(inst.op)
+            {
+            case OpValue:
+                for(size_type j = 0; j < m; j++)
+                    c[j] = inst.val;
+                ++sp;
+                break;
+
+            case OpVariable:
+                if(src[pc])
+                    {
+                    for(size_type j = 0; j < m; j++)
+                        c[j] = src[pc][start + j];
+                    }
+                else
+                    {
+                    for(size_type j = 0; j < m; j++)
+                        c[j] = *inst.var;
+                    }
+                ++sp;
+                break;
+
+            case OpPop:
+                --sp;
+                break;
+
+            case OpAdd:
+                for(size_type j = 0; j < m; j++)
+                    a[j] += b[j];
+                --sp;
+                break;
+
+            case OpSubtract:
+                for(size_type j = 0; j < m; j++)
+                    a[j] -= b[j];
+                --sp;
+                break;
+
+            case OpMultiply:
+                for(size_type j = 0; j < m; j++)
+                    a[j] *= b[j];
+                --sp;
+                break;
+
+            case OpDivide:
+                for(size_type j = 0; j < m; j++)
+                    {
+                    if(b[j] == 0.0)
+                        throw(DivideByZeroException());
+                    }
+                for(size_type j = 0; j < m; j++)
+                    a[j] /= b[j];
+                --sp;
+                break;
+
+            case OpNegate:
+                for(size_type j = 0; j < m; j++)
+                    b[j] = -b[j];
+                break;
+
+            case OpExponent:
+                errno = 0;
+                for(size_type j = 0; j < m; j++)
+                    a[j] = pow(a[j], b[j]);
+                if(errno)
+                    throw(MathException("^"));
+                --sp;
+                break;
+
+            case OpCall1:
+                errno = 0;
+                for(size_type j = 0; j < m; j++)
+                    b[j] = inst.f1(b[j]);
+                if(inst.checkerr && errno)
+                    throw(MathException(inst.name));
+                break;
+
+            case OpCall2:
+                errno = 0;
+                for(size_type j = 0; j < m; j++)
+                    a[j] = inst.f2(a[j], b[j]);
+                if(inst.checkerr && errno)
+                    throw(MathException(inst.name));
+                --sp;
+                break;
+
+            default:
+                // assign, node call and jumps are not evaluated by blocks
+                break;
+            }
+        }
+
+    for(size_type j = 0; j < m; j++)
+        result[j] = stack[j];
+    }
@@ -0,0 +1,113 @@
+// File:    expr_program.h
+// Purpose: Compiled expression program
+//------------------------------------------------------------------------------
+
+
+#ifndef __EXPREVAL_PROGRAM_H
+#define __EXPREVAL_PROGRAM_H
+
+// Includes
+#include <string>
+#include <vector>
+
+// Part of expreval namespace
+namespace ExprEval
+    {
+    // Forward declarations
+    class Node;
+
+    // Program class
+    //--------------------------------------------------------------------------
+    // A flat stack machine code compiled from the node tree. Variables are
+    // bound by address at compile time, so evaluation does no lookup and no
+    // virtual call. Nodes which can not be compiled are kept as a call to
+    // the node itself.
+    class Program
+        {
+        public:
+            typedef double (*Func1)(double);
+            typedef double (*Func2)(double, double);
+            typedef ::std::vector<double>::size_type size_type;
+
+            enum OpCode
+                {
+                OpValue,        // push constant
+                OpVariable,     // push variable
+                OpAssign,       // store top to variable, keep it on stack
+                OpPop,          // drop top
+                OpAdd,
+                OpSubtract,
+                OpMultiply,
+                OpDivide,
+                OpNegate,
+                OpExponent,
+                OpCall1,        // unary function
+                OpCall2,        // binary function
+                OpNode,         // evaluate a node by tree walk
+                OpJumpZero,     // pop top, jump if it is zero
+                OpJump
+                };
+
+            Program();
+
+            // Clear the code
+            void Clear();
+            bool Empty() const;
+
+            // Emit instructions, used by Node::Compile
+            void EmitValue(double val);
+            void EmitVariable(double *var);
+            void EmitAssign(double *var);
+            void EmitOp(OpCode op);
+            void EmitCall(Func1 f, const ::std::string &name, bool checkerr);
+            void EmitCall(Func2 f, const ::std::string &name, bool checkerr);
+            void EmitNode(Node *node);
+
+            // Emit a jump, the target is set by PatchJump
+            size_type EmitJump(OpCode op);
+            void PatchJump(size_type pos);
+
+            // Evaluate with current variable values
+            double Run() const;
+
+            // Evaluate n points. Variable vars[k] takes the value values[k][i]
+            // for point i. Programs without branch and node call are evaluated
+            // by blocks of points, others point by point.
+            void Run(size_type n, const ::std::vector<double*> &vars,
+                    const ::std::vector<const double*> &values, double *result) const;
+
+        private:
+            struct Instruction
+                {
+                OpCode op;
+                double val;
+                double *var;
+                Func1 f1;
+                Func2 f2;
+                Node *node;
+                size_type target;
+                bool checkerr;
+                ::std::string name;
+                };
+
+            void Emit(const Instruction &inst, long delta);
+
+            void RunBlock(size_type start, size_type m, const ::std::vector<const double*> &src,
+                    double *result) const;
+
+            ::std::vector<Instruction> m_code;
+
+            // Stack depth while emitting, and the max one
+            long m_depth;
+            long m_maxdepth;
+
+            // True if the code can be evaluated by blocks
+            bool m_block;
+
+            // Evaluation stack
+            mutable ::std::vector<double> m_stack;
+        };
+
+    } // namespace ExprEval
+
+#endif // __EXPREVAL_PROGRAM_H
@@ -42,7 +42,7 @@
  */
 GnuplotHook::GnuplotHook(SolverBase & solver, const std::string & name, void * file)
     : Hook(solver, name), _input_file((const char *)file),
-    _gnuplot_file(SolverSpecify::out_prefix + ".dat"), _ddm(false), _mixA(false)
+    _gnuplot_file(SolverSpecify::out_prefix + ".dat"), _ddm(false), _mixA(false), _branch(-1)
 {
 
   SolverSpecify::SolverType solver_type = this->get_solver().solver_type();
@@ -142,6 +142,21 @@ void GnuplotHook::post_solve()
         _out << std::setw(25) << SolverSpecify::dt/PhysicalUnit::s;
       }
 
+      // DC sweep repeated for several branch voltages. each branch starts a new
+      // data block (separated by two blank lines, "index" in gnuplot), and every
+      // record leads with the branch voltage
+      if ( SolverSpecify::Type == SolverSpecify::DCSWEEP && !SolverSpecify::Electrode_VBranch.empty() )
+      {
+        const unsigned int b = SolverSpecify::VBranch_Index;
+        if ( _branch != static_cast<int>(b) )
+        {
+          if ( _branch >= 0 ) _out << '\n' << std::endl;
+          _out << "# Branch " << b << std::endl;
+          _branch = b;
+        }
+        _out << std::setw(25) << SolverSpecify::VBranch[b]/PhysicalUnit::V;
+      }
+
 
       if( _mixA )
       {
@@ -267,6 +282,26 @@ void GnuplotHook::post_solve()
           _out << std::setw(25) << bc->current()/PhysicalUnit::A;
         }
       }
+
+      // admittance and impedance matrix of multi-port analysis
+      if( SolverSpecify::ACMultiPort )
+      {
+        const unsigned int n_ports = SolverSpecify::Electrode_ACScan.size();
+        for(unsigned int i=0; i<n_ports; i++)
+          for(unsigned int j=0; j<n_ports; j++)
+          {
+            std::complex<PetscScalar> Y = SolverSpecify::ACPortY[i*n_ports+j]*(PhysicalUnit::V/PhysicalUnit::A);
+            _out << std::setw(25) << Y.real();
+            _out << std::setw(25) << Y.imag();
+          }
+        for(unsigned int i=0; i<n_ports; i++)
+          for(unsigned int j=0; j<n_ports; j++)
+          {
+            std::complex<PetscScalar> Z = SolverSpecify::ACPortZ[i*n_ports+j]*(PhysicalUnit::A/PhysicalUnit::V);
+            _out << std::setw(25) << Z.real();
+            _out << std::setw(25) << Z.imag();
+          }
+      }
     }
 
     _out << std::endl;
@@ -355,6 +390,15 @@ void  GnuplotHook::_write_gnuplot_head()
         _out << '#' <<'\t' << ++n_var <<'\t' << "TimeStep" << " [s]"<< std::endl;
       }
 
+      // voltage of the branch electrode(s)
+      if ( SolverSpecify::Type == SolverSpecify::DCSWEEP && !SolverSpecify::Electrode_VBranch.empty() )
+      {
+        std::string branch_label = SolverSpecify::Electrode_VBranch[0];
+        for ( unsigned int i=1; i<SolverSpecify::Electrode_VBranch.size(); i++ )
+          branch_label += ',' + SolverSpecify::Electrode_VBranch[i];
+        _out << '#' <<'\t' << ++n_var <<'\t' << "Branch(" + branch_label + ")" << " [V]"<< std::endl;
+      }
+
       if( _mixA ) // mix mode
       {
         const SPICE_CKT * spice_ckt = this->get_solver().get_system().get_circuit();
@@ -497,6 +541,23 @@ void  GnuplotHook::_write_gnuplot_head()
           _out << '#' <<'\t' << ++n_var <<'\t' << "Idc(" + bc_label + ")"   << " [A]"<< std::endl;
         }
       }
+
+      if( SolverSpecify::ACMultiPort )
+      {
+        const std::vector<std::string> & ports = SolverSpecify::Electrode_ACScan;
+        for(unsigned int i=0; i<ports.size(); i++)
+          for(unsigned int j=0; j<ports.size(); j++)
+          {
+            _out << '#' <<'\t' << ++n_var <<'\t' << "Y.real(" + ports[i] + ',' + ports[j] << ") [S]"<< std::endl;
+            _out << '#' <<'\t' << ++n_var <<'\t' << "Y.imag(" + ports[i] + ',' + ports[j] << ") [S]"<< std::endl;
+          }
+        for(unsigned int i=0; i<ports.size(); i++)
+          for(unsigned int j=0; j<ports.size(); j++)
+          {
+            _out << '#' <<'\t' << ++n_var <<'\t' << "Z.real(" + ports[i] + ',' + ports[j] << ") [Ohm]"<< std::endl;
+            _out << '#' <<'\t' << ++n_var <<'\t' << "Z.imag(" + ports[i] + ',' + ports[j] << ") [Ohm]"<< std::endl;
+          }
+      }
     }
 
     _out << std::endl;
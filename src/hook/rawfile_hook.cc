@@ -82,6 +82,10 @@ void RawFileHook::on_init()
         _variables.push_back( std::pair<std::string, std::string>("time_step", "time") );
       }
 
+      // voltage of the branch electrode(s), to split a family of curves per branch
+      if ( SolverSpecify::Type == SolverSpecify::DCSWEEP && !SolverSpecify::Electrode_VBranch.empty() )
+        _variables.push_back( std::pair<std::string, std::string>("branch_voltage", "voltage") );
+
       if( !_mixA )
       {
         // record electrode IV information
@@ -163,6 +167,24 @@ void RawFileHook::on_init()
         _variables.push_back( std::pair<std::string, std::string>(bc_label + "_current_magnitude",   "current") );
         _variables.push_back( std::pair<std::string, std::string>(bc_label + "_current_angle",       "") );
       }
+
+      // admittance and impedance matrix of multi-port analysis
+      if( SolverSpecify::ACMultiPort )
+      {
+        const std::vector<std::string> & ports = SolverSpecify::Electrode_ACScan;
+        for(unsigned int i=0; i<ports.size(); i++)
+          for(unsigned int j=0; j<ports.size(); j++)
+          {
+            _variables.push_back( std::pair<std::string, std::string>("Y_" + ports[i] + '_' + ports[j] + "_magnitude", "") );
+            _variables.push_back( std::pair<std::string, std::string>("Y_" + ports[i] + '_' + ports[j] + "_angle",     "") );
+          }
+        for(unsigned int i=0; i<ports.size(); i++)
+          for(unsigned int j=0; j<ports.size(); j++)
+          {
+            _variables.push_back( std::pair<std::string, std::string>("Z_" + ports[i] + '_' + ports[j] + "_magnitude", "") );
+            _variables.push_back( std::pair<std::string, std::string>("Z_" + ports[i] + '_' + ports[j] + "_angle",     "") );
+          }
+      }
     }
 
     _values.resize( _variables.size() );
@@ -205,6 +227,9 @@ void RawFileHook::post_solve()
         _values[i++].push_back( SolverSpecify::dt/PhysicalUnit::s );
       }
 
+      if ( SolverSpecify::Type == SolverSpecify::DCSWEEP && !SolverSpecify::Electrode_VBranch.empty() )
+        _values[i++].push_back( SolverSpecify::VBranch[SolverSpecify::VBranch_Index]/PhysicalUnit::V );
+
       if( !_mixA )
       {
         // search for all the bc
@@ -271,6 +296,22 @@ void RawFileHook::post_solve()
         _values[i++].push_back( std::abs(bc->ext_circuit()->current_ac())/PhysicalUnit::A );
         _values[i++].push_back( std::arg(bc->ext_circuit()->current_ac()) );
       }
+
+      if( SolverSpecify::ACMultiPort )
+      {
+        const std::vector< std::complex<double> > & Y = SolverSpecify::ACPortY;
+        const std::vector< std::complex<double> > & Z = SolverSpecify::ACPortZ;
+        for(unsigned int k=0; k<Y.size(); k++)
+        {
+          _values[i++].push_back( std::abs(Y[k])*PhysicalUnit::V/PhysicalUnit::A );
+          _values[i++].push_back( std::arg(Y[k]) );
+        }
+        for(unsigned int k=0; k<Z.size(); k++)
+        {
+          _values[i++].push_back( std::abs(Z[k])*PhysicalUnit::A/PhysicalUnit::V );
+          _values[i++].push_back( std::arg(Z[k]) );
+        }
+      }
     }
 
     if(i)  _n_values++;
@@ -26,6 +26,8 @@
 #include "vtk_hook.h"
 #include "spice_ckt.h"
 #include "MXMLUtil.h"
+#include "vtk_io.h"
+#include "async_writer.h"
 
 
 /*----------------------------------------------------------------------
@@ -33,7 +35,7 @@
  */
 VTKHook::VTKHook ( SolverBase & solver, const std::string & name, void * param)
     : Hook ( solver, name ), _vtk_prefix ( SolverSpecify::out_prefix ),
-      _ddm ( false ), _mixA ( false ), _ddm_ac ( false )
+      _vtk_io ( 0 ), _writer ( 0 ), _xdmf ( false ), _ddm ( false ), _mixA ( false ), _ddm_ac ( false )
 {
   this->count  =0;
 
@@ -52,6 +54,10 @@ VTKHook::VTKHook ( SolverBase & solver, const std::string & name, void * param)
   this->_t_start=0;
   this->_t_stop =std::numeric_limits<double>::infinity();
 
+  // write file in background thread while the solver goes on
+  bool async = true;
+  // each processor writes its own piece
+  _vtk_suffix = ".vtu";
 
   const std::vector<Parser::Parameter> & parm_list = *((std::vector<Parser::Parameter> *)param);
   for ( std::vector<Parser::Parameter>::const_iterator parm_it = parm_list.begin();
@@ -70,13 +76,28 @@ VTKHook::VTKHook ( SolverBase & solver, const std::string & name, void * param)
       _t_start=parm_it->get_real() * PhysicalUnit::s;
     if ( parm_it->name() == "tstop" && parm_it->type() == Parser::REAL )
       _t_stop=parm_it->get_real() * PhysicalUnit::s;
+
+    if ( parm_it->name() == "async" && parm_it->type() == Parser::BOOL )
+      async=parm_it->get_bool();
+    if ( parm_it->name() == "parallel" && parm_it->type() == Parser::BOOL && parm_it->get_bool() )
+      _vtk_suffix = ".pvtu";
+#ifdef HAVE_VTK
+    // geometry is written once, each output point only has its fields
+    if ( parm_it->name() == "xdmf" && parm_it->type() == Parser::BOOL )
+      _xdmf = parm_it->get_bool();
+#endif
   }
 
+  if ( _xdmf ) _vtk_suffix = ".bin";
+
   const SimulationSystem &system = get_solver().get_system();
 
+  _vtk_io = new VTKIO ( system );
+  if ( async ) _writer = new AsyncWriter();
+
   std::ostringstream vtk_filename;
-  vtk_filename << _vtk_prefix << ( this->count++ ) << ".vtu";
-  system.export_vtk ( vtk_filename.str(), false );
+  vtk_filename << _vtk_prefix << ( this->count++ ) << _vtk_suffix;
+  _export_vtk ( vtk_filename.str(), 0.0 );
 
   SolverSpecify::SolverType solver_type = this->get_solver().solver_type();
 
@@ -99,7 +120,11 @@ VTKHook::VTKHook ( SolverBase & solver, const std::string & name, void * param)
  * destructor, close file
  */
 VTKHook::~VTKHook()
-{}
+{
+  // finish the pending files before the cached grid is freed
+  delete _writer;
+  delete _vtk_io;
+}
 
 
 /*----------------------------------------------------------------------
@@ -135,10 +160,8 @@ void VTKHook::post_solve()
 
     if ( std::fabs ( Vscan - this->_v_last ) >= this->_v_step )
     {
-      const SimulationSystem &system = get_solver().get_system();
-
-      vtk_filename << _vtk_prefix << ( this->count++ ) << ".vtu";
-      system.export_vtk ( vtk_filename.str(),false );
+      vtk_filename << _vtk_prefix << ( this->count++ ) << _vtk_suffix;
+      _export_vtk ( vtk_filename.str(), Vscan/PhysicalUnit::V );
 
       time_sequence.push_back ( std::make_pair ( Vscan/PhysicalUnit::V, vtk_filename.str() ) );
       _v_last = Vscan;
@@ -151,10 +174,8 @@ void VTKHook::post_solve()
 
     if ( std::fabs ( Iscan - this->_i_last ) >= this->_i_step )
     {
-      const SimulationSystem &system = get_solver().get_system();
-
-      vtk_filename << _vtk_prefix << ( this->count++ ) << ".vtu";
-      system.export_vtk ( vtk_filename.str(),false );
+      vtk_filename << _vtk_prefix << ( this->count++ ) << _vtk_suffix;
+      _export_vtk ( vtk_filename.str(), Iscan/PhysicalUnit::A );
 
       time_sequence.push_back ( std::make_pair ( Iscan/PhysicalUnit::A, vtk_filename.str() ) );
       _i_last = Iscan;
@@ -164,18 +185,14 @@ void VTKHook::post_solve()
 
   if ( SolverSpecify::Type==SolverSpecify::OP )
   {
-    const SimulationSystem &system = get_solver().get_system();
-
-    vtk_filename << _vtk_prefix << ( this->count++ ) << ".vtu";
-    system.export_vtk ( vtk_filename.str(), false );
+    vtk_filename << _vtk_prefix << this->count << _vtk_suffix;
+    _export_vtk ( vtk_filename.str(), this->count++ );
   }
 
   if ( SolverSpecify::Type==SolverSpecify::TRACE )
   {
-    const SimulationSystem &system = get_solver().get_system();
-
-    vtk_filename << _vtk_prefix << ( this->count++ ) << ".vtu";
-    system.export_vtk ( vtk_filename.str(), false );
+    vtk_filename << _vtk_prefix << this->count << _vtk_suffix;
+    _export_vtk ( vtk_filename.str(), this->count++ );
   }
 
   if ( SolverSpecify::Type==SolverSpecify::TRANSIENT )
@@ -187,10 +204,8 @@ void VTKHook::post_solve()
     {
       if ( SolverSpecify::clock - this->_t_last >= this->_t_step )
       {
-        const SimulationSystem &system = get_solver().get_system();
-
-        vtk_filename << _vtk_prefix << ( this->count++ ) << ".vtu";
-        system.export_vtk ( vtk_filename.str(), false );
+        vtk_filename << _vtk_prefix << ( this->count++ ) << _vtk_suffix;
+        _export_vtk ( vtk_filename.str(), SolverSpecify::clock/PhysicalUnit::ps );
 
         time_sequence.push_back ( std::make_pair ( SolverSpecify::clock/PhysicalUnit::ps, vtk_filename.str() ) );
         _t_last = SolverSpecify::clock;
@@ -201,10 +216,8 @@ void VTKHook::post_solve()
 
   if ( SolverSpecify::Type==SolverSpecify::ACSWEEP )
   {
-    const SimulationSystem &system = get_solver().get_system();
-
-    vtk_filename << _vtk_prefix << ( this->count++ ) << ".vtu";
-    system.export_vtk ( vtk_filename.str(), false );
+    vtk_filename << _vtk_prefix << ( this->count++ ) << _vtk_suffix;
+    _export_vtk ( vtk_filename.str(), SolverSpecify::Freq*PhysicalUnit::us );
 
     time_sequence.push_back ( std::make_pair ( SolverSpecify::Freq*PhysicalUnit::us, vtk_filename.str() ) );
     _f_last = SolverSpecify::Freq;
@@ -249,7 +262,11 @@ void VTKHook::post_iteration()
  */
 void VTKHook::on_close()
 {
-  if ( time_sequence.size() ==0 ) return;
+  // all the vtk files should be written before the pvd file
+  if ( _writer ) _writer->wait();
+
+  // the .xmf index already has the series
+  if ( time_sequence.size() ==0 || _xdmf ) return;
 
   if ( !Genius::processor_id() )
   {
@@ -273,6 +290,27 @@ void VTKHook::on_close()
 }
 
 
+/*----------------------------------------------------------------------
+ * write current solution, only the solution data are gathered after the first call
+ */
+void VTKHook::_export_vtk(const std::string & filename, double value)
+{
+#ifdef HAVE_VTK
+  if ( _xdmf )
+  {
+    MESSAGE<<"Write System to XDMF file "<< _vtk_prefix << ".xmf ...\n" << std::endl; RECORD();
+    _vtk_io->write_xdmf_series ( _vtk_prefix+".xmf", filename, value, _writer );
+    return;
+  }
+
+  MESSAGE<<"Write System to XML VTK file "<< filename << "...\n" << std::endl; RECORD();
+  _vtk_io->write_series ( filename, _writer );
+#else
+  get_solver().get_system().export_vtk ( filename, false );
+#endif
+}
+
+
 #ifdef DLLHOOK
 
 // dll interface
@@ -121,15 +121,6 @@ int main(int argc, char ** args)
   //show the GENIUS Log
   show_logo();
 
-#ifndef COGENDA_COMMERCIAL_PRODUCT
-  if( Genius::n_processors() > 1 )
-  {
-    PetscPrintf(PETSC_COMM_WORLD,"ERROR: Open Source Version does not support multi-processor.\n");
-    Genius::clean_processors();
-    exit(0);
-  }
-#endif
-
   // record the start time
   PetscLogDouble t_start;
 #if PETSC_VERSION_GE(3,4,0)
@@ -184,6 +175,14 @@ int main(int argc, char ** args)
     if(experiment_code_flg) Genius::set_experiment_code(false);
   }
 
+  // number of shared memory threads for each processor
+  {
+    PetscBool     thread_flg;
+    PetscInt      n_threads=1;
+    PetscOptionsGetInt(PETSC_NULL, "-t", &n_threads, &thread_flg);
+    if(thread_flg) Genius::set_n_threads(n_threads);
+  }
+
   // prepare log system
   std::ofstream logfs;
   if (Genius::processor_id() == 0)
@@ -195,7 +194,10 @@ int main(int argc, char ** args)
     genius_log.addStream("file", logfs.rdbuf());
   }
 
-  MESSAGE<<"Genius boot with " << Genius::n_processors() << " MPI thread.\n\n";  RECORD();
+  MESSAGE<<"Genius boot with " << Genius::n_processors() << " MPI thread";
+  if(Genius::n_threads() > 1)
+    MESSAGE<<" and " << Genius::n_threads() << " shared memory thread per processor";
+  MESSAGE<<".\n\n";  RECORD();
 
   // test if input file can be opened on processor 0 for read
   if ( Genius::processor_id() == 0 )
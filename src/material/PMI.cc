@@ -31,16 +31,26 @@
 
 using namespace adtl;
 
+/**
+ * aux function return current node.
+ */
+const Point * PMI_Server::ReadPoint () const
+{
+  const PMI_Context * c = context();
+  return c ? c->point : 0;
+}
+
 /**
  * aux function return node coordinate.
  */
 void PMI_Server::ReadCoordinate (PetscScalar& x, PetscScalar& y, PetscScalar& z) const
 {
-  if(pp_point)
+  const Point * point = ReadPoint();
+  if(point)
   {
-    x = (*pp_point)->x();
-    y = (*pp_point)->y();
-    z = (*pp_point)->z();
+    x = point->x();
+    y = point->y();
+    z = point->z();
   }
   else
   {
@@ -55,8 +65,9 @@ void PMI_Server::ReadCoordinate (PetscScalar& x, PetscScalar& y, PetscScalar& z)
  */
 PetscScalar PMI_Server::ReadTime () const
 {
-  if( p_clock )
-    return *p_clock;
+  const PMI_Context * c = context();
+  if( c )
+    return c->clock;
   return 0.0;
 }
 
@@ -86,8 +97,9 @@ unsigned int PMI_Server::VariableIndex(const std::string &v) const
  */
 PetscScalar PMI_Server::ReadRealVariable (const unsigned int v) const
 {
-  if( pp_node_data )
-    return (*pp_node_data)->data<Real>(v);
+  const FVM_NodeData * data = node_data();
+  if( data )
+    return data->data<Real>(v);
   return 0.0;
 }
 
@@ -97,8 +109,9 @@ PetscScalar PMI_Server::ReadRealVariable (const unsigned int v) const
  */
 PetscScalar PMI_Server::ReadRealVariable (const std::string & v) const
 {
-  if( pp_node_data )
-    return (*pp_node_data)->data<Real>(v);
+  const FVM_NodeData * data = node_data();
+  if( data )
+    return data->data<Real>(v);
   return 0.0;
 }
 
@@ -242,7 +255,7 @@ const std::string & PMI_Server::get_parameter_string(const int verbosity)
  * also set the physical constants
  */
 PMI_Server::PMI_Server(const PMI_Environment &env)
-  : pp_variables(env.pp_variables), pp_point(env.pp_point), pp_node_data(env.pp_node_data), p_clock(env.p_clock)
+  : pp_variables(env.pp_variables), p_context(env.p_context), n_context(env.n_context)
 {
 
   m  = env.m;
@@ -308,7 +321,8 @@ void PMIS_Server::SetFakeStrainEnvironment(const TensorValue<PetscScalar> &T)
  */
 PetscScalar PMIS_Server::ReadxMoleFraction () const
 {
-  if(pp_node_data) return (*pp_node_data)->mole_x();
+  const FVM_NodeData * data = node_data();
+  if(data) return data->mole_x();
   return _mole_x;
 }
 
@@ -317,9 +331,10 @@ PetscScalar PMIS_Server::ReadxMoleFraction () const
  */
 PetscScalar PMIS_Server::ReadxMoleFraction (const PetscScalar mole_xmin, const PetscScalar mole_xmax) const
 {
-  if(pp_node_data)
+  const FVM_NodeData * data = node_data();
+  if(data)
   {
-    PetscScalar mole_x=(*pp_node_data)->mole_x();
+    PetscScalar mole_x=data->mole_x();
     if( mole_x < mole_xmin ) return mole_xmin;
     if( mole_x > mole_xmax ) return mole_xmax;
     return mole_x;
@@ -332,7 +347,8 @@ PetscScalar PMIS_Server::ReadxMoleFraction (const PetscScalar mole_xmin, const P
  */
 PetscScalar PMIS_Server::ReadyMoleFraction () const
 {
-  if(pp_node_data) return (*pp_node_data)->mole_y();
+  const FVM_NodeData * data = node_data();
+  if(data) return data->mole_y();
   return _mole_y;
 }
 
@@ -341,9 +357,10 @@ PetscScalar PMIS_Server::ReadyMoleFraction () const
  */
 PetscScalar PMIS_Server::ReadyMoleFraction (const PetscScalar mole_ymin, const PetscScalar mole_ymax) const
 {
-  if(pp_node_data)
+  const FVM_NodeData * data = node_data();
+  if(data)
   {
-    PetscScalar mole_y=(*pp_node_data)->mole_y();
+    PetscScalar mole_y=data->mole_y();
     if( mole_y < mole_ymin ) return mole_ymin;
     if( mole_y > mole_ymax ) return mole_ymax;
     return mole_y;
@@ -356,7 +373,8 @@ PetscScalar PMIS_Server::ReadyMoleFraction (const PetscScalar mole_ymin, const P
  */
 PetscScalar PMIS_Server::ReadDopingNa () const
 {
-  if(pp_node_data)  return (*pp_node_data)->Total_Na();
+  const FVM_NodeData * data = node_data();
+  if(data) return data->Total_Na();
   return _Na;
 }
 
@@ -365,7 +383,8 @@ PetscScalar PMIS_Server::ReadDopingNa () const
  */
 PetscScalar PMIS_Server::ReadDopingNd () const
 {
-  if(pp_node_data) return (*pp_node_data)->Total_Nd();
+  const FVM_NodeData * data = node_data();
+  if(data) return data->Total_Nd();
   return _Nd;
 }
 
@@ -374,7 +393,8 @@ PetscScalar PMIS_Server::ReadDopingNd () const
  */
 PetscScalar PMIS_Server::ReadDmin () const
 {
-  if(pp_node_data) return (*pp_node_data)->dmin();
+  const FVM_NodeData * data = node_data();
+  if(data) return data->dmin();
   return _dmin;
 }
 
@@ -384,11 +404,117 @@ PetscScalar PMIS_Server::ReadDmin () const
  */
 TensorValue<PetscScalar> PMIS_Server::ReadStrain() const
 {
-  if(pp_node_data) return (*pp_node_data)->strain();
+  const FVM_NodeData * data = node_data();
+  if(data) return data->strain();
   return _strain;
 }
 
 
+/**
+ * aux function return total Acceptor concentration of the node in given context
+ */
+PetscScalar PMIS_Server::ReadDopingNa (const PMI_Context &c) const
+{
+  if(c.node_data) return c.node_data->Total_Na();
+  return _Na;
+}
+
+/**
+ * aux function return total Donor concentration of the node in given context
+ */
+PetscScalar PMIS_Server::ReadDopingNd (const PMI_Context &c) const
+{
+  if(c.node_data) return c.node_data->Total_Nd();
+  return _Nd;
+}
+
+
+
+/*****************************************************************************
+ *               Batched functions, fall back to scalar version
+ ****************************************************************************/
+
+
+void PMIS_BandStructure::Eg_Batch(unsigned int size, const PMI_Context *context,
+                                  const PetscScalar *Tl, PetscScalar *result)
+{
+  PMI_Context current = bind_context(PMI_Context());
+  for(unsigned int i=0; i<size; ++i)
+  {
+    bind_context(context[i]);
+    result[i] = Eg(Tl[i]);
+  }
+  bind_context(current);
+}
+
+
+void PMIS_BandStructure::EgNarrowToEc_Batch(unsigned int size, const PMI_Context *context,
+                                            const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *result)
+{
+  PMI_Context current = bind_context(PMI_Context());
+  for(unsigned int i=0; i<size; ++i)
+  {
+    bind_context(context[i]);
+    result[i] = EgNarrowToEc(p[i], n[i], Tl[i]);
+  }
+  bind_context(current);
+}
+
+
+void PMIS_BandStructure::EgNarrowToEv_Batch(unsigned int size, const PMI_Context *context,
+                                            const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *result)
+{
+  PMI_Context current = bind_context(PMI_Context());
+  for(unsigned int i=0; i<size; ++i)
+  {
+    bind_context(context[i]);
+    result[i] = EgNarrowToEv(p[i], n[i], Tl[i]);
+  }
+  bind_context(current);
+}
+
+
+void PMIS_BandStructure::Recomb_Batch(unsigned int size, const PMI_Context *context,
+                                      const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *result)
+{
+  PMI_Context current = bind_context(PMI_Context());
+  for(unsigned int i=0; i<size; ++i)
+  {
+    bind_context(context[i]);
+    result[i] = Recomb(p[i], n[i], Tl[i]);
+  }
+  bind_context(current);
+}
+
+
+void PMIS_Mobility::ElecMob_Batch(unsigned int size, const PMI_Context *context,
+                                  const PetscScalar *p,  const PetscScalar *n,  const PetscScalar *Tl,
+                                  const PetscScalar *Ep, const PetscScalar *Et, const PetscScalar *Tn, PetscScalar *result) const
+{
+  PMI_Context current = bind_context(PMI_Context());
+  for(unsigned int i=0; i<size; ++i)
+  {
+    bind_context(context[i]);
+    result[i] = ElecMob(p[i], n[i], Tl[i], Ep[i], Et[i], Tn[i]);
+  }
+  bind_context(current);
+}
+
+
+void PMIS_Mobility::HoleMob_Batch(unsigned int size, const PMI_Context *context,
+                                  const PetscScalar *p,  const PetscScalar *n,  const PetscScalar *Tl,
+                                  const PetscScalar *Ep, const PetscScalar *Et, const PetscScalar *Tp, PetscScalar *result) const
+{
+  PMI_Context current = bind_context(PMI_Context());
+  for(unsigned int i=0; i<size; ++i)
+  {
+    bind_context(context[i]);
+    result[i] = HoleMob(p[i], n[i], Tl[i], Ep[i], Et[i], Tp[i]);
+  }
+  bind_context(current);
+}
+
+
 
 
 /*****************************************************************************
@@ -836,6 +836,79 @@ public:
 
   // End of Recombination
 
+  //---------------------------------------------------------------------------
+  // batched version, the doping of each node is gathered first,
+  // then the models are evaluated in branch free loops over contiguous arrays
+  void Eg_Batch (unsigned int size, const PMI_Context *context, const PetscScalar *Tl, PetscScalar *result)
+  {
+    const PetscScalar Eg300 = EG300+EGALPH*T300*T300/(T300+EGBETA);
+    PMI_SIMD_LOOP
+    for(unsigned int i=0; i<size; ++i)
+      result[i] = Eg300 - EGALPH*Tl[i]*Tl[i]/(Tl[i]+EGBETA);
+  }
+
+  void EgNarrowToEc_Batch (unsigned int size, const PMI_Context *context,
+                           const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *result)
+  {
+    EgNarrow_Batch(size, context, result);
+    PMI_SIMD_LOOP
+    for(unsigned int i=0; i<size; ++i)
+      result[i] *= 0.5;
+  }
+
+  void EgNarrowToEv_Batch (unsigned int size, const PMI_Context *context,
+                           const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *result)
+  {
+    EgNarrow_Batch(size, context, result);
+    PMI_SIMD_LOOP
+    for(unsigned int i=0; i<size; ++i)
+      result[i] *= 0.5;
+  }
+
+  void Recomb_Batch (unsigned int size, const PMI_Context *context,
+                     const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl, PetscScalar *result)
+  {
+    // result holds the band gap narrowing first
+    EgNarrow_Batch(size, context, result);
+
+    std::vector<PetscScalar> N(size);
+    for(unsigned int i=0; i<size; ++i)
+      N[i] = ReadDopingNa(context[i]) + ReadDopingNd(context[i]);
+
+    const PetscScalar Eg300 = EG300+EGALPH*T300*T300/(T300+EGBETA);
+    PMI_SIMD_LOOP
+    for(unsigned int i=0; i<size; ++i)
+    {
+      const PetscScalar T    = Tl[i];
+      const PetscScalar kT2  = 2*kb*T;
+      const PetscScalar Eg   = Eg300 - EGALPH*T*T/(T+EGBETA);
+      const PetscScalar ni   = sqrt(NC300*std::pow(T/T300,NC_F)*NV300*std::pow(T/T300,NV_F))*exp((result[i]-Eg)/kT2);
+      const PetscScalar taun = TAUN0/(1+N[i]/NSRHN)*std::pow(T/T300,EXN_TAU);
+      const PetscScalar taup = TAUP0/(1+N[i]/NSRHP)*std::pow(T/T300,EXP_TAU);
+      const PetscScalar dn   = p[i]*n[i]-ni*ni;
+      const PetscScalar Rshr = dn/(taup*(n[i]+ni)+taun*(p[i]+ni));
+      const PetscScalar Rdir = C_DIRECT*dn;
+      const PetscScalar Raug = (AUGN*n[i]+AUGP*p[i])*dn;
+      result[i] = Rshr+Rdir+Raug;
+    }
+  }
+
+private:
+  // Slotboom's band gap narrowing of each node
+  void EgNarrow_Batch (unsigned int size, const PMI_Context *context, PetscScalar *result)
+  {
+    for(unsigned int i=0; i<size; ++i)
+      result[i] = ReadDopingNa(context[i]) + ReadDopingNd(context[i]);
+
+    const PetscScalar N0 = 1.0*std::pow(cm,-3);
+    PMI_SIMD_LOOP
+    for(unsigned int i=0; i<size; ++i)
+    {
+      const PetscScalar x = log((result[i]+N0)/N0_BGN);
+      result[i] = V0_BGN*(x+sqrt(x*x+CON_BGN));
+    }
+  }
+
 private:
   //[energy relax time]
   PetscScalar  WTN0;
@@ -144,9 +144,11 @@ private:
   // Electron low field mobility
   PetscScalar ElecMobLowField(const PetscScalar &Tl) const
   {
-    PetscScalar Na = ReadDopingNa();
-    PetscScalar Nd = ReadDopingNd();
-    PetscScalar N_total = Na+Nd+1e0*std::pow(cm,-3);
+    return ElecMobLowField(Tl, ReadDopingNa()+ReadDopingNd());
+  }
+  PetscScalar ElecMobLowField(PetscScalar Tl, PetscScalar N) const
+  {
+    PetscScalar N_total = N+1e0*std::pow(cm,-3);
     PetscScalar mu_max = MUN2_LSM*std::pow(Tl/T300,-EXN3_LSM);
     return MUN0_LSM+(mu_max-MUN0_LSM)/(1+std::pow(N_total/CRN_LSM,EXN1_LSM))-MUN1_LSM/(1+std::pow(CSN_LSM/N_total,EXN2_LSM));
   }
@@ -163,9 +165,11 @@ private:
   // Hole low field mobility, Analytic model
   PetscScalar HoleMobLowField(const PetscScalar &Tl) const
   {
-    PetscScalar Na = ReadDopingNa();
-    PetscScalar Nd = ReadDopingNd();
-    PetscScalar N_total = Na+Nd+1e0*std::pow(cm,-3);
+    return HoleMobLowField(Tl, ReadDopingNa()+ReadDopingNd());
+  }
+  PetscScalar HoleMobLowField(PetscScalar Tl, PetscScalar N) const
+  {
+    PetscScalar N_total = N+1e0*std::pow(cm,-3);
     PetscScalar mu_max = MUP2_LSM*std::pow(Tl/T300,-EXP3_LSM);
     return MUP0_LSM*exp(-PC_LSM/N_total)+mu_max/(1+std::pow(N_total/CRP_LSM,EXP1_LSM))-MUP1_LSM/(1+std::pow(CSP_LSM/N_total,EXP2_LSM));
   }
@@ -182,9 +186,11 @@ private:
   // Electron surface mobility, acoustical phono scattering and roughness scattering
   PetscScalar ElecMobSurface(const PetscScalar &Tl,const PetscScalar &Et) const
   {
-    PetscScalar Na = ReadDopingNa();
-    PetscScalar Nd = ReadDopingNd();
-    PetscScalar N_total = Na+Nd+1e0*std::pow(cm,-3);
+    return ElecMobSurface(Tl, Et, ReadDopingNa()+ReadDopingNd());
+  }
+  PetscScalar ElecMobSurface(PetscScalar Tl, PetscScalar Et, PetscScalar N) const
+  {
+    PetscScalar N_total = N+1e0*std::pow(cm,-3);
     PetscScalar ET = Et+1.0*V/cm;
     PetscScalar mu_ac = BN_LSM/ET + CN_LSM*std::pow(N_total,EXN4_LSM)/Tl*std::pow(ET,PetscScalar(-1.0/3.0));
     PetscScalar mu_sr = DN_LSM*std::pow(ET,-EXN8_LSM);
@@ -205,9 +211,11 @@ private:
   // Hole surface mobility, acoustical phono scattering and roughness scattering
   PetscScalar HoleMobSurface(const PetscScalar &Tl,const PetscScalar &Et) const
   {
-    PetscScalar Na = ReadDopingNa();
-    PetscScalar Nd = ReadDopingNd();
-    PetscScalar N_total = Na+Nd+1e0*std::pow(cm,-3);
+    return HoleMobSurface(Tl, Et, ReadDopingNa()+ReadDopingNd());
+  }
+  PetscScalar HoleMobSurface(PetscScalar Tl, PetscScalar Et, PetscScalar N) const
+  {
+    PetscScalar N_total = N+1e0*std::pow(cm,-3);
     PetscScalar ET = Et+1.0*V/cm;
     PetscScalar mu_ac = BP_LSM/ET + CP_LSM*std::pow(N_total,EXP4_LSM)/Tl*std::pow(ET,PetscScalar(-1.0/3.0));
     PetscScalar mu_sr = DP_LSM*std::pow(ET,-EXP8_LSM);
@@ -292,6 +300,43 @@ public:
     return mu0/adtl::pow(1+adtl::pow(mu0*fabs(Ep)/vsat,BETAP),1.0/BETAP);
   }
 
+  //---------------------------------------------------------------------------
+  // batched version, the doping of each node is gathered first,
+  // then the mobility is evaluated in loops over contiguous arrays
+  void ElecMob_Batch(unsigned int size, const PMI_Context *context,
+                     const PetscScalar *p,  const PetscScalar *n,  const PetscScalar *Tl,
+                     const PetscScalar *Ep, const PetscScalar *Et, const PetscScalar *Tn, PetscScalar *result) const
+  {
+    std::vector<PetscScalar> N(size);
+    for(unsigned int i=0; i<size; ++i)
+      N[i] = ReadDopingNa(context[i]) + ReadDopingNd(context[i]);
+
+    PMI_SIMD_LOOP
+    for(unsigned int i=0; i<size; ++i)
+    {
+      PetscScalar vsat = VSATN0/(1+VSATN_A*exp(Tl[i]/(2*T300)));
+      PetscScalar mu0  = 1.0/(1.0/ElecMobLowField(Tl[i], N[i])+1.0/ElecMobSurface(Tl[i], Et[i], N[i]));
+      result[i] = mu0/std::pow(1+std::pow(mu0*fabs(Ep[i])/vsat,BETAN),1.0/BETAN);
+    }
+  }
+
+  void HoleMob_Batch(unsigned int size, const PMI_Context *context,
+                     const PetscScalar *p,  const PetscScalar *n,  const PetscScalar *Tl,
+                     const PetscScalar *Ep, const PetscScalar *Et, const PetscScalar *Tp, PetscScalar *result) const
+  {
+    std::vector<PetscScalar> N(size);
+    for(unsigned int i=0; i<size; ++i)
+      N[i] = ReadDopingNa(context[i]) + ReadDopingNd(context[i]);
+
+    PMI_SIMD_LOOP
+    for(unsigned int i=0; i<size; ++i)
+    {
+      PetscScalar vsat = VSATP0/(1+VSATP_A*exp(Tl[i]/(2*T300)));
+      PetscScalar mu0  = 1.0/(1.0/HoleMobLowField(Tl[i], N[i])+1.0/HoleMobSurface(Tl[i], Et[i], N[i]));
+      result[i] = mu0/std::pow(1+std::pow(mu0*fabs(Ep[i])/vsat,BETAP),1.0/BETAP);
+    }
+  }
+
   // constructor
 public:
   GSS_Si_Mob_Lombardi(const PMIS_Environment &env):PMIS_Mobility(env)
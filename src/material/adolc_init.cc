@@ -23,7 +23,7 @@
 
 #include "adolc.h"
 
-unsigned int adtl::AutoDScalar::numdir = 12;
+ADTL_THREAD_LOCAL unsigned int adtl::AutoDScalar::numdir = 12;
 
 
 extern "C"
@@ -51,7 +51,7 @@ namespace Material
 {
 
   MaterialBase::MaterialBase(const SimulationRegion * reg)
-  : set_ad_num(0),  region(reg) , material(reg->material()), p_point(0), p_node_data(0), dll_file(0)
+  : set_ad_num(0),  region(reg) , material(reg->material()), _contexts(Genius::n_threads()), dll_file(0)
   {
     point_variables = &(region->region_point_variables());
     cell_variables = &(region->region_cell_variables());
@@ -70,7 +70,7 @@ namespace Material
 
   PMI_Environment MaterialBase::build_PMI_Environment()
   {
-     PMI_Environment env(  &p_point, &p_node_data, &clock, &point_variables,
+     PMI_Environment env(  &_contexts[0], _contexts.size(), &point_variables,
                             PhysicalUnit::m, PhysicalUnit::s, PhysicalUnit::V, PhysicalUnit::C, PhysicalUnit::K);
      return env;
   }
@@ -205,7 +205,7 @@ namespace Material
 
   void MaterialSemiconductor::init_node(const std::string &type, const Point* point, FVM_NodeData* node_data)
   {
-    mapping(point, node_data, clock);
+    mapping(point, node_data, context().clock);
     switch ( PMI_Type_string_to_enum(type) )
     {
     case Basic:
@@ -235,7 +235,7 @@ namespace Material
 
   void MaterialSemiconductor::init_bc_node(const std::string &type, const std::string & bc_label, const Point* point, FVM_NodeData* node_data)
   {
-    this->mapping(point,node_data,clock);
+    this->mapping(point, node_data, context().clock);
 
     switch(PMI_Type_string_to_enum(type))
     {
@@ -523,7 +523,7 @@ namespace Material
 
   void MaterialInsulator::init_node(const std::string &type, const Point* point, FVM_NodeData* node_data)
   {
-    mapping(point, node_data, clock);
+    mapping(point, node_data, context().clock);
     switch ( PMI_Type_string_to_enum(type) )
     {
     case Basic:
@@ -545,7 +545,7 @@ namespace Material
   void MaterialInsulator::init_bc_node(const std::string &type, const std::string & bc_label, const Point* point, FVM_NodeData* node_data)
   {
     genius_assert(bc_label.length()); //prevent compiler warning
-    this->mapping(point, node_data, clock);
+    this->mapping(point, node_data, context().clock);
 
     switch(PMI_Type_string_to_enum(type))
     {
@@ -744,7 +744,7 @@ namespace Material
 
   void MaterialConductor::init_node(const std::string &type, const Point* point, FVM_NodeData* node_data)
   {
-    mapping(point, node_data, clock);
+    mapping(point, node_data, context().clock);
     switch ( PMI_Type_string_to_enum(type) )
     {
     case Basic:
@@ -764,7 +764,7 @@ namespace Material
   {
     genius_assert(bc_label.length()); //prevent compiler warning
 
-    this->mapping(point,node_data,clock);
+    this->mapping(point, node_data, context().clock);
 
     switch(PMI_Type_string_to_enum(type))
     {
@@ -941,7 +941,7 @@ namespace Material
 
   void MaterialVacuum::init_node(const std::string &type, const Point* point, FVM_NodeData* node_data)
   {
-    mapping(point, node_data, clock);
+    mapping(point, node_data, context().clock);
     switch ( PMI_Type_string_to_enum(type) )
     {
     case Basic:
@@ -961,7 +961,7 @@ namespace Material
   {
     genius_assert(bc_label.length()); //prevent compiler warning
 
-    this->mapping(point,node_data,clock);
+    this->mapping(point, node_data, context().clock);
 
     switch(PMI_Type_string_to_enum(type))
     {
@@ -1120,7 +1120,7 @@ namespace Material
 
   void MaterialPML::init_node(const std::string &type, const Point* point, FVM_NodeData* node_data)
   {
-    mapping(point, node_data, clock);
+    mapping(point, node_data, context().clock);
     switch ( PMI_Type_string_to_enum(type) )
     {
     case Basic:
@@ -1137,7 +1137,7 @@ namespace Material
   {
     genius_assert(bc_label.length()); //prevent compiler warning
 
-    this->mapping(point,node_data,clock);
+    this->mapping(point, node_data, context().clock);
 
     switch(PMI_Type_string_to_enum(type))
     {
@@ -67,6 +67,11 @@ ExprEvalute::ExprEvalute(const std::string & expr)
   vlist.Add("z");
   vlist.Add("t");
 
+  _x = vlist.GetAddress("x");
+  _y = vlist.GetAddress("y");
+  _z = vlist.GetAddress("z");
+  _t = vlist.GetAddress("t");
+
   // unit and physical conatant
   vlist.Add("cm",   PhysicalUnit::cm, true);
   vlist.Add("s",    PhysicalUnit::s,  true);
@@ -105,11 +110,25 @@ ExprEvalute::ExprEvalute(const std::string & expr)
 double ExprEvalute::eval(double x, double y, double z, double t)
 {
   //assign variable value to the expr
-  *(vlist.GetAddress("x")) = x;
-  *(vlist.GetAddress("y")) = y;
-  *(vlist.GetAddress("z")) = z;
-  *(vlist.GetAddress("t")) = t;
+  *_x = x;
+  *_y = y;
+  *_z = z;
+  *_t = t;
 
   return e.Evaluate();
 }
 
+
+void ExprEvalute::eval(unsigned int n, const double *x, const double *y, const double *z, double t, double *result)
+{
+  *_t = t;
+
+  std::vector<double *> vars(3);
+  vars[0] = _x;  vars[1] = _y;  vars[2] = _z;
+
+  std::vector<const double *> values(3);
+  values[0] = x;  values[1] = y;  values[2] = z;
+
+  e.Evaluate(n, vars, values, result);
+}
+
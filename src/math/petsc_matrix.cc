@@ -40,6 +40,7 @@ PetscMatrix<T>::PetscMatrix(const unsigned int m,   const unsigned int n,
                             const unsigned int m_l, const unsigned int n_l)
   : SparseMatrix<T>(m,n,m_l,n_l), 
     _mat_buf_mode(true), 
+    _mat_frozen_mode(false),
     _add_value_flag(NOT_SET_VALUES), 
     _closed(false), 
     _destroy_mat_on_exit(false)
@@ -91,6 +92,17 @@ void PetscMatrix<T>::set (const unsigned int i, const unsigned int j, const T va
     else 
       _mat_nonlocal[std::make_pair(i,j)] = value;
   }
+  else if(_mat_frozen_mode)
+  {
+    if( SparseMatrix<T>::row_on_processor(i) )
+    {
+      T * slot = frozen_slot(i, j);
+      if(slot) *slot = value;
+      else _mat_extra[std::make_pair(i,j)] = value;
+    }
+    else
+      _mat_nonlocal[std::make_pair(i,j)] = value;
+  }
   else
   {
     int ierr=0, i_val=i, j_val=j;
@@ -117,6 +129,10 @@ void PetscMatrix<T>::add (const unsigned int i, const unsigned int j, const T va
     else 
       _mat_nonlocal[std::make_pair(i,j)] += value;
   }
+  else if(_mat_frozen_mode)
+  {
+    frozen_add(i, j, value);
+  }
   else
   {
     int ierr=0, i_val=i, j_val=j;
@@ -148,6 +164,11 @@ void PetscMatrix<T>::add_row (unsigned int row, const std::vector<unsigned int>
         _mat_nonlocal[std::make_pair(row,cols[j])] += dm[j];
     }
   }
+  else if(_mat_frozen_mode)
+  {
+    for(unsigned int j=0; j<cols.size(); j++)
+      frozen_add(row, cols[j], dm[j]);
+  }
   else
   {
     int ierr=0;
@@ -179,6 +200,11 @@ void PetscMatrix<T>::add_row (unsigned int row, unsigned int n, const unsigned i
         _mat_nonlocal[std::make_pair(row,cols[j])] += dm[j];
     }
   }
+  else if(_mat_frozen_mode)
+  {
+    for(unsigned int j=0; j<n; j++)
+      frozen_add(row, cols[j], dm[j]);
+  }
   else
   {
     int ierr=0;
@@ -211,6 +237,11 @@ void PetscMatrix<T>::add_row (unsigned int row, int n, const int * cols, const T
         _mat_nonlocal[std::make_pair(row,cols[j])] += dm[j];
     }
   }
+  else if(_mat_frozen_mode)
+  {
+    for(int j=0; j<n; j++)
+      frozen_add(row, cols[j], dm[j]);
+  }
   else
   {
     int ierr=0;
@@ -249,6 +280,12 @@ void PetscMatrix<T>::add_matrix(const std::vector<unsigned int>& rows,
           _mat_nonlocal[std::make_pair(rows[i],cols[j])] += dm[i*n+j];
     }
   }
+  else if(_mat_frozen_mode)
+  {
+    for(unsigned int i=0; i<m; i++)
+      for(unsigned int j=0; j<n; j++)
+        frozen_add(rows[i], cols[j], dm[i*n+j]);
+  }
   else
   {
     int ierr=0;
@@ -286,6 +323,12 @@ void PetscMatrix<T>::add_matrix (unsigned int m, unsigned int * rows,
           _mat_nonlocal[std::make_pair(rows[i],cols[j])] += dm[i*n+j];
     }
   }
+  else if(_mat_frozen_mode)
+  {
+    for(unsigned int i=0; i<m; i++)
+      for(unsigned int j=0; j<n; j++)
+        frozen_add(rows[i], cols[j], dm[i*n+j]);
+  }
   else
   {
     int ierr=0;
@@ -306,7 +349,7 @@ bool PetscMatrix<T>::closed() const
 {
   genius_assert (this->initialized());
 
-  if(_mat_buf_mode)
+  if(_mat_buf_mode || _mat_frozen_mode)
   {
     return _closed;
   }
@@ -336,7 +379,7 @@ void PetscMatrix<T>::init ()
 template <typename T>
 void PetscMatrix<T>::close (bool final)
 {
-  if(_mat_buf_mode)
+  if(_mat_buf_mode || _mat_frozen_mode)
   {
     unsigned int nonlocal_entries = _mat_nonlocal.size();
     Parallel::sum(nonlocal_entries);
@@ -366,13 +409,20 @@ void PetscMatrix<T>::close (bool final)
 
         unsigned int col = cols[n];
         T value = values[n];
-        _mat_local[row-SparseMatrix<T>::_global_offset][col] += value;
+        if(_mat_frozen_mode)
+          frozen_add(row, col, value);
+        else
+          _mat_local[row-SparseMatrix<T>::_global_offset][col] += value;
       }
     }
     
     _closed = true;
     
-    if(final) flush_buf();
+    if(final)
+    {
+      if(_mat_frozen_mode) flush_frozen();
+      else flush_buf();
+    }
   }
   else
   {
@@ -401,6 +451,13 @@ void PetscMatrix<T>::zero ()
     for(typename std::map< std::pair<unsigned int, unsigned int>, T >::iterator it= _mat_nonlocal.begin();it!=_mat_nonlocal.end(); it++)
       it->second = 0.0;  
   }
+  else if(_mat_frozen_mode)
+  {
+    // all the values are send to PETSc at final assembly, it is enough to clear the frozen values
+    std::fill(_csr_val.begin(), _csr_val.end(), T(0.0));
+    _mat_extra.clear();
+    _mat_nonlocal.clear();
+  }
   else
   {
     genius_assert (this->initialized());
@@ -418,6 +475,10 @@ void PetscMatrix<T>::clear ()
 {
   _mat_local.clear();
   _mat_nonlocal.clear();
+  _mat_extra.clear();
+  _csr_row_ptr.clear();
+  _csr_col.clear();
+  _csr_val.clear();
   
   int ierr=0;
 
@@ -442,6 +503,11 @@ void PetscMatrix<T>::get_row (unsigned int row, int n, const int * cols, T* dm)
       dm[i] = buf.find(cols[i])->second;
     }
   }
+  else if(_mat_frozen_mode)
+  {
+    for(int i=0; i<n; i++)
+      dm[i] = (*this)(row, cols[i]);
+  }
   else
   {
     MatGetValues(_mat, 1, (int*)&row, n, (int*)cols, (PetscScalar*)dm);
@@ -466,6 +532,17 @@ T PetscMatrix<T>::operator () (const unsigned int i, const unsigned int j) const
     // i.e. it is 0.
     return 0.0;
   }
+
+  if(_mat_frozen_mode)
+  {
+    const T * slot = frozen_slot(i, j);
+    if(slot) return *slot;
+
+    typename std::map< std::pair<unsigned int, unsigned int>, T >::const_iterator ent = _mat_extra.find(std::make_pair(i,j));
+    if(ent != _mat_extra.end() ) return ent->second;
+
+    return 0.0;
+  }
   
   // else 
 
@@ -546,6 +623,39 @@ void PetscMatrix<T>::add_row_to_row(const std::vector<int> &src_rows,
     
     return;
   }
+
+  if(_mat_frozen_mode)
+  {
+    genius_assert(_closed);
+
+    for(unsigned int n=0; n<src_rows.size(); n++)
+    {
+      unsigned int src_row = static_cast<unsigned int>(src_rows[n]);
+      unsigned int dst_row = static_cast<unsigned int>(dst_rows[n]);
+
+      genius_assert(SparseMatrix<T>::row_on_processor(src_row));
+
+      // copy the source row first, since dst_row may be the same as src_row
+      unsigned int local_src_row = src_row - SparseMatrix<T>::_global_offset;
+      std::vector<unsigned int> cols(_csr_col.begin()+_csr_row_ptr[local_src_row], _csr_col.begin()+_csr_row_ptr[local_src_row+1]);
+      std::vector<T> values(_csr_val.begin()+_csr_row_ptr[local_src_row], _csr_val.begin()+_csr_row_ptr[local_src_row+1]);
+
+      typename std::map< std::pair<unsigned int, unsigned int>, T >::const_iterator it = _mat_extra.lower_bound(std::make_pair(src_row, 0u));
+      for(; it!=_mat_extra.end() && it->first.first==src_row; ++it)
+      {
+        cols.push_back(it->first.second);
+        values.push_back(it->second);
+      }
+
+      for(unsigned int c=0; c<cols.size(); c++)
+        add(dst_row, cols[c], values[c]);
+    }
+
+    // sync _mat_nonlocal entries
+    close(false);
+
+    return;
+  }
   
   // test if the matrix is assembled
   // note: the test is not work properly! if it is a bug...
@@ -621,6 +731,21 @@ void PetscMatrix<T>::clear_row(int row, const T diag )
     cols[row] = diag;
     return;
   }
+
+  if(_mat_frozen_mode)
+  {
+    unsigned int local_row = row-SparseMatrix<T>::_global_offset;
+    std::fill(_csr_val.begin()+_csr_row_ptr[local_row], _csr_val.begin()+_csr_row_ptr[local_row+1], T(0.0));
+
+    typename std::map< std::pair<unsigned int, unsigned int>, T >::iterator it = _mat_extra.lower_bound(std::make_pair(static_cast<unsigned int>(row), 0u));
+    for(; it!=_mat_extra.end() && it->first.first==static_cast<unsigned int>(row); ++it)
+      it->second = 0.0;
+
+    T * slot = frozen_slot(row, row);
+    if(slot) *slot = diag;
+    else _mat_extra[std::make_pair(row,row)] = diag;
+    return;
+  }
     
   
 #if PETSC_VERSION_GE(3,2,0)
@@ -649,6 +774,13 @@ void PetscMatrix<T>::clear_row(const std::vector<int> &rows, const T diag)
     }
     return;
   }
+
+  if(_mat_frozen_mode)
+  {
+    for(unsigned int n=0; n<rows.size(); n++)
+      clear_row(rows[n], diag);
+    return;
+  }
     
   
 #if PETSC_VERSION_GE(3,2,0)
@@ -799,6 +931,157 @@ void PetscMatrix<T>::flush_buf()
   
   _mat_local.clear();
   _mat_buf_mode = false;
+
+  // the nonzero pattern is known now, freeze it
+  freeze_pattern();
+}
+
+
+
+template <typename T>
+T * PetscMatrix<T>::frozen_slot(const unsigned int i, const unsigned int j)
+{
+  const unsigned int local_row = i-SparseMatrix<T>::_global_offset;
+  const unsigned int row_begin = _csr_row_ptr[local_row];
+  const unsigned int row_end   = _csr_row_ptr[local_row+1];
+  // empty row, which is also the case when this processor has no local nonzeros at all
+  if( row_begin == row_end ) return NULL;
+
+  const PetscInt * cols  = &_csr_col[0];
+  const PetscInt * begin = cols + row_begin;
+  const PetscInt * end   = cols + row_end;
+  const PetscInt * p = std::lower_bound(begin, end, static_cast<PetscInt>(j));
+  if( p != end && *p == static_cast<PetscInt>(j) )
+    return &_csr_val[p - cols];
+  return NULL;
+}
+
+
+template <typename T>
+const T * PetscMatrix<T>::frozen_slot(const unsigned int i, const unsigned int j) const
+{
+  return const_cast<PetscMatrix<T> *>(this)->frozen_slot(i, j);
+}
+
+
+template <typename T>
+void PetscMatrix<T>::frozen_add(const unsigned int i, const unsigned int j, const T value)
+{
+  if( SparseMatrix<T>::row_on_processor(i) )
+  {
+    T * slot = frozen_slot(i, j);
+    if(slot) *slot += value;
+    else _mat_extra[std::make_pair(i,j)] += value;
+  }
+  else
+    _mat_nonlocal[std::make_pair(i,j)] += value;
+}
+
+
+template <typename T>
+void PetscMatrix<T>::freeze_pattern()
+{
+  genius_assert(!_mat_buf_mode);
+
+  const unsigned int m_local = SparseMatrix<T>::_m_local;
+
+  _csr_row_ptr.resize(m_local+1);
+  _csr_col.clear();
+  _csr_val.clear();
+
+  _csr_row_ptr[0] = 0;
+  for(unsigned int n=0; n<m_local; ++n)
+  {
+    PetscInt row = n+SparseMatrix<T>::_global_offset;
+    PetscInt ncols;
+    const PetscInt * row_cols;
+    const PetscScalar * row_vals;
+
+    // PETSc returns the column index in ascending order
+    int ierr = MatGetRow(_mat, row, &ncols, &row_cols, &row_vals); genius_assert(!ierr);
+    _csr_col.insert(_csr_col.end(), row_cols, row_cols+ncols);
+    for(PetscInt c=0; c<ncols; ++c)
+      _csr_val.push_back(static_cast<T>(row_vals[c]));
+    ierr = MatRestoreRow(_mat, row, &ncols, &row_cols, &row_vals); genius_assert(!ierr);
+
+    _csr_row_ptr[n+1] = _csr_col.size();
+  }
+
+  _mat_extra.clear();
+  _mat_frozen_mode = true;
+}
+
+
+template <typename T>
+void PetscMatrix<T>::flush_frozen()
+{
+  genius_assert(_closed);
+  genius_assert(_mat_frozen_mode);
+
+  int ierr = 0;
+
+  const unsigned int m_local = SparseMatrix<T>::_m_local;
+
+  bool bulk_copy = false;
+
+#if PETSC_VERSION_GE(3,3,0)
+  // on one processor, the frozen pattern is exactly the CSR structure of the SEQAIJ matrix,
+  // copy the values to PETSc in one shot
+  if(Genius::n_processors()==1)
+  {
+    PetscBool is_seqaij;
+    ierr = PetscObjectTypeCompare((PetscObject)_mat, MATSEQAIJ, &is_seqaij); genius_assert(!ierr);
+
+    MatInfo info;
+    ierr = MatGetInfo(_mat, MAT_LOCAL, &info); genius_assert(!ierr);
+
+    if( is_seqaij && static_cast<size_t>(info.nz_used) == _csr_val.size() )
+    {
+      PetscScalar * array;
+      ierr = MatSeqAIJGetArray(_mat, &array); genius_assert(!ierr);
+      for(size_t n=0; n<_csr_val.size(); ++n)
+        array[n] = static_cast<PetscScalar>(_csr_val[n]);
+      ierr = MatSeqAIJRestoreArray(_mat, &array); genius_assert(!ierr);
+      bulk_copy = true;
+    }
+  }
+#endif
+
+  // otherwise, send the values row by row. all the contributions have been summed into local rows,
+  // thus the values are inserted
+  if(!bulk_copy)
+  {
+    for(unsigned int n=0; n<m_local; ++n)
+    {
+      PetscInt row = n+SparseMatrix<T>::_global_offset;
+      PetscInt ncols = _csr_row_ptr[n+1] - _csr_row_ptr[n];
+      // skip empty rows before taking the address, _csr_row_ptr[n] may be the end of the arrays
+      if(!ncols) continue;
+      const PetscInt * row_cols = &_csr_col[0] + _csr_row_ptr[n];
+      const T * row_vals = &_csr_val[0] + _csr_row_ptr[n];
+      ierr = MatSetValues(_mat, 1, &row, ncols, row_cols, (PetscScalar*) row_vals, INSERT_VALUES);
+      genius_assert(!ierr);
+    }
+  }
+
+  // entries out of the frozen pattern, PETSc will allocate new nonzeros for them
+  bool pattern_changed = !_mat_extra.empty();
+  Parallel::max(pattern_changed);
+  for(typename std::map< std::pair<unsigned int, unsigned int>, T >::const_iterator it=_mat_extra.begin(); it!=_mat_extra.end(); ++it)
+  {
+    PetscInt row = it->first.first;
+    PetscInt col = it->first.second;
+    PetscScalar value = static_cast<PetscScalar>(it->second);
+    ierr = MatSetValues(_mat, 1, &row, 1, &col, &value, INSERT_VALUES); genius_assert(!ierr);
+  }
+
+  ierr = MatAssemblyBegin (_mat, MAT_FINAL_ASSEMBLY);
+  ierr = MatAssemblyEnd   (_mat, MAT_FINAL_ASSEMBLY);
+  genius_assert(!ierr);
+
+  // the nonzero pattern grows, freeze it again
+  if(pattern_changed)
+    freeze_pattern();
 }
 
 //------------------------------------------------------------------
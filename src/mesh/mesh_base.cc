@@ -36,6 +36,8 @@
 #include "point_locator_base.h"
 #include "surface_locator_hub.h"
 #include "perf_log.h"
+#include "mesh_tools.h"
+#include "parallel.h"
 
 // ------------------------------------------------------------
 // MeshBase class member functions
@@ -47,6 +49,7 @@ MeshBase::MeshBase (unsigned int d) :
     _dim            (d),
     _mesh_dim       (0),
     _is_prepared    (false),
+    _scatter_on_partition (false),
     _point_locator  (NULL),
     _surface_locator(NULL)
 {
@@ -64,6 +67,7 @@ MeshBase::MeshBase (const MeshBase& other_mesh) :
     _dim            (other_mesh._dim),
     _mesh_dim       (other_mesh._mesh_dim),
     _is_prepared    (other_mesh._is_prepared),
+    _scatter_on_partition (other_mesh._scatter_on_partition),
     _point_locator  (NULL),
     _surface_locator(NULL)
 
@@ -169,6 +173,17 @@ unsigned int MeshBase::n_active_elem () const
 
 
 
+bool MeshBase::scatter_now () const
+{
+  if( !_scatter_on_partition ) return false;
+
+  unsigned int levels = Genius::processor_id() == 0 ? MeshTools::n_levels(*this) : 0;
+  Parallel::broadcast(levels);
+  return levels == 0;
+}
+
+
+
 void MeshBase::clear ()
 {
 
@@ -317,7 +332,7 @@ std::ostream& operator << (std::ostream& os, const MeshBase& m)
 
 
 
-void MeshBase::partition (const unsigned int n_parts)
+void MeshBase::partition (const unsigned int n_parts, bool local)
 {
   START_LOG("partition()", "Mesh");
 
@@ -329,7 +344,7 @@ void MeshBase::partition (const unsigned int n_parts)
 //  partitioner.partition (*this, n_parts);
 //#endif
 
-  MetisPartitioner partitioner;
+  MetisPartitioner partitioner(false, local);
   
   std::vector<std::vector<unsigned int> > cluster;
   bool material_based = this->partition_cluster(cluster);
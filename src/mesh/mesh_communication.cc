@@ -21,6 +21,8 @@
 
 // C++ Includes   -----------------------------------
 #include <cstring>
+#include <algorithm>
+#include <iterator>
 
 // Local Includes -----------------------------------
 #include "genius_env.h"
@@ -128,8 +130,18 @@ void MeshCommunication::broadcast (MeshBase& mesh) const
 
   MESSAGE<<"Synchronize mesh with all the processors..."<<std::endl;  RECORD();
 
-  this->broadcast_mesh (mesh);
-  this->broadcast_bcs  (mesh, *(mesh.boundary_info));
+  // the first processor decides if the mesh should be scattered after partition
+  bool scatter = mesh.scatter_on_partition();
+  Parallel::broadcast (scatter);
+  mesh.set_scatter_on_partition(scatter);
+
+  if (scatter)
+    this->broadcast_mesh_info (mesh);
+  else
+  {
+    this->broadcast_mesh (mesh);
+    this->broadcast_bcs  (mesh, *(mesh.boundary_info));
+  }
 
   MESSAGE<<"Mesh synchronization finished.\n"<<std::endl;  RECORD();
 }
@@ -623,6 +635,437 @@ void MeshCommunication::broadcast_bcs (MeshBase&,
 }
 
 
+#ifdef HAVE_MPI
+void MeshCommunication::broadcast_mesh_info (MeshBase& mesh) const
+#else // avoid spurious gcc warnings
+void MeshCommunication::broadcast_mesh_info (MeshBase&) const
+#endif
+{
+  // Don't need to do anything if there is
+  // only one processor.
+  if (Genius::n_processors() == 1)
+    return;
+
+#ifdef HAVE_MPI
+
+  START_LOG("broadcast_mesh_info()","MeshCommunication");
+
+  // Explicitly clear the mesh on all but processor 0.
+  // this also clears the boundary info
+  if (Genius::processor_id() != 0)
+    mesh.clear();
+
+  // broadcast magic number
+  Parallel::broadcast (mesh.magic_num());
+
+  // distribut subdomain information
+  {
+    unsigned int n_subdomains = mesh.n_subdomains ();
+    Parallel::broadcast (n_subdomains);
+    if (Genius::processor_id() != 0)
+      mesh.set_n_subdomains () = n_subdomains;
+
+    std::vector<std::string> labels;
+    std::vector<std::string> materials;
+
+    for(unsigned int n_sub = 0; n_sub < mesh.n_subdomains (); n_sub++)
+    {
+      if (Genius::processor_id() == 0)
+      {
+        labels.push_back(mesh.subdomain_label_by_id(n_sub));
+        materials.push_back(mesh.subdomain_material(n_sub));
+      }
+    }
+    Parallel::broadcast (labels);
+    Parallel::broadcast (materials);
+
+    for(unsigned int n_sub = 0; n_sub < mesh.n_subdomains (); n_sub++)
+    {
+      if (Genius::processor_id() != 0)
+      {
+        mesh.set_subdomain_label(n_sub, labels[n_sub]);
+        mesh.set_subdomain_material(n_sub, materials[n_sub]);
+      }
+    }
+  } // Done distribut subdomain information
+
+  BoundaryInfo & boundary_info = *(mesh.boundary_info);
+
+  // distribute boundary ids
+  std::set<short int> & boundary_ids = boundary_info.get_boundary_ids();
+  Parallel::broadcast (boundary_ids);
+
+  // distribute boundary labels
+  {
+    std::vector<std::string> labels;
+    std::vector<std::string> descriptions;
+    std::vector<bool> user_defined;
+
+    std::set<short int>::iterator it=boundary_ids.begin();
+    for(; it!=boundary_ids.end(); ++it)
+    {
+      if (Genius::processor_id() == 0)
+      {
+        labels.push_back(boundary_info.get_label_by_id(*it));
+        descriptions.push_back(boundary_info.get_description_by_id(*it));
+        user_defined.push_back(boundary_info.boundary_id_has_user_defined_label(*it));
+      }
+    }
+
+    Parallel::broadcast (labels);
+    Parallel::broadcast (descriptions);
+    Parallel::broadcast (user_defined);
+
+    it=boundary_ids.begin();
+    for(unsigned int n=0; it!=boundary_ids.end(); ++n, ++it)
+    {
+      if (Genius::processor_id() != 0)
+      {
+        boundary_info.set_label_to_id(*it, labels[n], user_defined[n]);
+        boundary_info.set_description_to_id(*it, descriptions[n]);
+      }
+    }
+  }
+
+  // distribute extra boundary descriptions
+  {
+    std::vector<std::string> & extra_descriptions = boundary_info.extra_descriptions();
+    Parallel::broadcast(extra_descriptions);
+  }
+
+  // elements and nodes will be sent by distribute()
+  if (Genius::processor_id() != 0)
+    mesh.set_serial(false);
+
+  STOP_LOG("broadcast_mesh_info()","MeshCommunication");
+
+#else
+
+  // no MPI but multiple processors? Huh??
+  genius_error();
+
+#endif
+}
+
+
+
+#ifdef HAVE_MPI
+void MeshCommunication::distribute (MeshBase& mesh) const
+#else // avoid spurious gcc warnings
+void MeshCommunication::distribute (MeshBase&) const
+#endif
+{
+  // Don't need to do anything if there is
+  // only one processor.
+  if (Genius::n_processors() == 1)
+    return;
+
+#ifdef HAVE_MPI
+
+  START_LOG("distribute()","MeshCommunication");
+
+  // global information of the mesh
+  {
+    std::vector<unsigned int> buf(4);
+    std::vector<Real> box(6);
+    if (Genius::processor_id() == 0)
+    {
+      buf[0] = mesh.n_nodes();
+      buf[1] = mesh.n_elem();
+      buf[2] = mesh._mesh_dim;
+      buf[3] = mesh._n_parts;
+      for(unsigned int i=0; i<3; ++i)
+      {
+        box[i]   = mesh._bounding_box.first(i);
+        box[i+3] = mesh._bounding_box.second(i);
+      }
+    }
+    Parallel::broadcast (buf);
+    Parallel::broadcast (box);
+
+    if (Genius::processor_id() != 0)
+    {
+      assert (mesh.n_elem() == 0);
+      mesh.resize_nodes_and_elems(buf[0], buf[1]);
+      mesh._mesh_dim = buf[2];
+      mesh._n_parts  = buf[3];
+      mesh._bounding_box = std::make_pair(Point(box[0], box[1], box[2]), Point(box[3], box[4], box[5]));
+    }
+  }
+
+  if (Genius::processor_id() == 0)
+  {
+    const unsigned int n_elem = mesh.n_elem();
+    const BoundaryInfo & boundary_info = *(mesh.boundary_info);
+
+    // the processors "touch" each element: the owner of the element and the owners of its nodes
+    std::vector<unsigned int> touch_offset(n_elem+1, 0);
+    std::vector<unsigned int> touch;
+    for (unsigned int e=0; e<n_elem; ++e)
+    {
+      touch_offset[e] = touch.size();
+      const Elem * elem = mesh.elem(e);
+      if (!elem) continue;
+
+      std::vector<unsigned int> procs(1, elem->processor_id());
+      for (unsigned int n=0; n<elem->n_nodes(); ++n)
+        procs.push_back(elem->get_node(n)->processor_id());
+      std::sort(procs.begin(), procs.end());
+      procs.erase(std::unique(procs.begin(), procs.end()), procs.end());
+      touch.insert(touch.end(), procs.begin(), procs.end());
+    }
+    touch_offset[n_elem] = touch.size();
+
+    // the element is on_local to processor p when p touches it or any of its neighbors,
+    // the same rule as Partitioner::_set_node_processor_ids()
+    std::vector< std::vector<unsigned int> > local_elems(Genius::n_processors());
+    // boundary elements are kept by all the processors until boundary conditions are built
+    std::vector<unsigned int> boundary_elems;
+    for (unsigned int e=0; e<n_elem; ++e)
+    {
+      const Elem * elem = mesh.elem(e);
+      if (!elem) continue;
+
+      std::vector<unsigned int> procs(touch.begin()+touch_offset[e], touch.begin()+touch_offset[e+1]);
+      for (unsigned int s=0; s<elem->n_neighbors(); ++s)
+      {
+        const Elem * neighbor = elem->neighbor(s);
+        if (!neighbor) continue;
+        procs.insert(procs.end(), touch.begin()+touch_offset[neighbor->id()], touch.begin()+touch_offset[neighbor->id()+1]);
+      }
+      std::sort(procs.begin(), procs.end());
+      procs.erase(std::unique(procs.begin(), procs.end()), procs.end());
+
+      for (unsigned int i=0; i<procs.size(); ++i)
+        local_elems[procs[i]].push_back(e);
+
+      if (boundary_info.is_boundary_elem(elem))
+        boundary_elems.push_back(e);
+    }
+    touch.clear();
+    touch_offset.clear();
+
+    // the full boundary side and node list
+    std::vector<unsigned int>       bd_el_id;
+    std::vector<unsigned short int> bd_side_id;
+    std::vector<short int>          bd_side_bc_id;
+    boundary_info.build_side_list (bd_el_id, bd_side_id, bd_side_bc_id);
+
+    std::vector<unsigned int> bd_node_id;
+    std::vector<short int>    bd_node_bc_id;
+    boundary_info.build_node_list (bd_node_id, bd_node_bc_id);
+
+    // pack the piece of each processor and send it out
+    for (unsigned int p=1; p<Genius::n_processors(); ++p)
+    {
+      const std::vector<unsigned int> & on_local_elems = local_elems[p];
+
+      std::vector<unsigned int> elems;
+      std::set_union(on_local_elems.begin(), on_local_elems.end(),
+                     boundary_elems.begin(), boundary_elems.end(),
+                     std::back_inserter(elems));
+
+      std::vector<unsigned int> nodes, on_local_nodes;
+      for (unsigned int i=0; i<elems.size(); ++i)
+      {
+        const Elem * elem = mesh.elem(elems[i]);
+        const bool on_local = std::binary_search(on_local_elems.begin(), on_local_elems.end(), elems[i]);
+        for (unsigned int n=0; n<elem->n_nodes(); ++n)
+        {
+          nodes.push_back(elem->node(n));
+          if (on_local) on_local_nodes.push_back(elem->node(n));
+        }
+      }
+      std::sort(nodes.begin(), nodes.end());
+      nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+      std::sort(on_local_nodes.begin(), on_local_nodes.end());
+      on_local_nodes.erase(std::unique(on_local_nodes.begin(), on_local_nodes.end()), on_local_nodes.end());
+
+      // [ id processor_id on_local ] and [ x y z ] for each node
+      std::vector<unsigned int> node_info;
+      std::vector<Real> pts;
+      node_info.reserve(3*nodes.size());
+      pts.reserve(3*nodes.size());
+      for (unsigned int i=0; i<nodes.size(); ++i)
+      {
+        const Node * node = mesh.node_ptr(nodes[i]);
+        node_info.push_back(node->id());
+        node_info.push_back(node->processor_id());
+        node_info.push_back(std::binary_search(on_local_nodes.begin(), on_local_nodes.end(), nodes[i]) ? 1 : 0);
+        pts.push_back((*node)(0));
+        pts.push_back((*node)(1));
+        pts.push_back((*node)(2));
+      }
+
+      // [ on_local packed_element neighbor_0 ... neighbor_n ] for each element
+      std::vector<int> conn;
+      for (unsigned int i=0; i<elems.size(); ++i)
+      {
+        const Elem * elem = mesh.elem(elems[i]);
+        conn.push_back(std::binary_search(on_local_elems.begin(), on_local_elems.end(), elems[i]) ? 1 : 0);
+        pack_element (conn, elem);
+        for (unsigned int s=0; s<elem->n_neighbors(); ++s)
+          conn.push_back(elem->neighbor(s) ? static_cast<int>(elem->neighbor(s)->id()) : -1);
+      }
+
+      // boundary sides and nodes of the piece
+      std::vector<unsigned int>       el_id;
+      std::vector<unsigned short int> side_id;
+      std::vector<short int>          side_bc_id;
+      for (unsigned int i=0; i<bd_el_id.size(); ++i)
+        if (std::binary_search(elems.begin(), elems.end(), bd_el_id[i]))
+        {
+          el_id.push_back(bd_el_id[i]);
+          side_id.push_back(bd_side_id[i]);
+          side_bc_id.push_back(bd_side_bc_id[i]);
+        }
+
+      std::vector<unsigned int> node_id;
+      std::vector<short int>    node_bc_id;
+      for (unsigned int i=0; i<bd_node_id.size(); ++i)
+        if (std::binary_search(nodes.begin(), nodes.end(), bd_node_id[i]))
+        {
+          node_id.push_back(bd_node_id[i]);
+          node_bc_id.push_back(bd_node_bc_id[i]);
+        }
+
+      std::vector<unsigned int> sizes(4);
+      sizes[0] = nodes.size();
+      sizes[1] = conn.size();
+      sizes[2] = el_id.size();
+      sizes[3] = node_id.size();
+
+      Parallel::send (p, sizes);
+      Parallel::send (p, node_info);
+      Parallel::send (p, pts);
+      Parallel::send (p, conn);
+      Parallel::send (p, el_id);
+      Parallel::send (p, side_id);
+      Parallel::send (p, side_bc_id);
+      Parallel::send (p, node_id);
+      Parallel::send (p, node_bc_id);
+
+      // free memory as soon as possible
+      std::vector<unsigned int>().swap(local_elems[p]);
+    }
+  }
+  else
+  {
+    std::vector<unsigned int> sizes(4);
+    Parallel::recv (0, sizes);
+
+    std::vector<unsigned int>       node_info(3*sizes[0]);
+    std::vector<Real>               pts(3*sizes[0]);
+    std::vector<int>                conn(sizes[1]);
+    std::vector<unsigned int>       el_id(sizes[2]);
+    std::vector<unsigned short int> side_id(sizes[2]);
+    std::vector<short int>          side_bc_id(sizes[2]);
+    std::vector<unsigned int>       node_id(sizes[3]);
+    std::vector<short int>          node_bc_id(sizes[3]);
+
+    Parallel::recv (0, node_info);
+    Parallel::recv (0, pts);
+    Parallel::recv (0, conn);
+    Parallel::recv (0, el_id);
+    Parallel::recv (0, side_id);
+    Parallel::recv (0, side_bc_id);
+    Parallel::recv (0, node_id);
+    Parallel::recv (0, node_bc_id);
+
+    // build the nodes
+    for (unsigned int i=0; i<sizes[0]; ++i)
+    {
+      Node * node = mesh.add_point (Point(pts[3*i+0], pts[3*i+1], pts[3*i+2]), node_info[3*i+0], node_info[3*i+1]);
+      node->on_local() = (node_info[3*i+2] != 0);
+    }
+
+    // build the elements, neighbor ids are saved until all the elements exist
+    std::vector< std::pair<Elem *, unsigned int> > elem_neighbors;
+    unsigned int cnt = 0;
+    while (cnt < conn.size())
+    {
+      const bool on_local         = (conn[cnt++] != 0);
+
+      // Unpack the element header
+#ifdef ENABLE_AMR
+      const int level             = conn[cnt++];
+      const int p_level           = conn[cnt++];
+      const Elem::RefinementState refinement_flag =
+        static_cast<Elem::RefinementState>(conn[cnt++]);
+      const Elem::RefinementState p_refinement_flag =
+        static_cast<Elem::RefinementState>(conn[cnt++]);
+#endif
+      const ElemType elem_type    = static_cast<ElemType>(conn[cnt++]);
+      const unsigned int elem_PID = conn[cnt++];
+      const int subdomain_ID      = conn[cnt++];
+      const int self_ID           = conn[cnt++];
+#ifdef ENABLE_AMR
+      const int parent_ID         = conn[cnt++];
+      cnt++; // which_child
+
+      // only the level 0 mesh can be scattered
+      genius_assert (level == 0 && parent_ID == -1);
+#endif
+
+      Elem * elem = Elem::build(elem_type).release();
+#ifdef ENABLE_AMR
+      elem->set_refinement_flag(refinement_flag);
+      elem->set_p_refinement_flag(p_refinement_flag);
+      elem->set_p_level(p_level);
+#endif
+      elem->processor_id() = elem_PID;
+      elem->subdomain_id() = subdomain_ID;
+      elem->set_id() = self_ID;
+      elem->on_local() = on_local;
+
+      // Assign the connectivity
+      for (unsigned int n=0; n<elem->n_nodes(); n++)
+      {
+        assert (cnt < conn.size());
+        elem->set_node(n) = mesh.node_ptr (conn[cnt++]);
+      }
+      elem->prepare_for_fvm();
+
+      mesh.insert_elem(elem);
+
+      elem_neighbors.push_back(std::make_pair(elem, cnt));
+      cnt += elem->n_neighbors();
+    }
+
+    // neighbors not in this piece are set to NULL, the same as delete_remote_elements()
+    for (unsigned int i=0; i<elem_neighbors.size(); ++i)
+    {
+      Elem * elem = elem_neighbors[i].first;
+      const unsigned int offset = elem_neighbors[i].second;
+      for (unsigned int s=0; s<elem->n_neighbors(); ++s)
+      {
+        const int neighbor_id = conn[offset+s];
+        elem->set_neighbor(s, neighbor_id == -1 ? NULL : mesh.elem(neighbor_id));
+      }
+    }
+
+    // boundary information of the piece
+    BoundaryInfo & boundary_info = *(mesh.boundary_info);
+    for (unsigned int i=0; i<el_id.size(); ++i)
+      boundary_info.add_side (mesh.elem(el_id[i]), side_id[i], side_bc_id[i]);
+    for (unsigned int i=0; i<node_id.size(); ++i)
+      boundary_info.add_node (mesh.node_ptr(node_id[i]), node_bc_id[i]);
+
+    mesh.set_serial(false);
+  }
+
+  STOP_LOG("distribute()","MeshCommunication");
+
+#else
+
+  // no MPI but multiple processors? Huh??
+  genius_error();
+
+#endif
+}
+
+
+
 // Pack all this information into one communication to avoid two latency hits
 // For each element it is of the form
 // [ level p_level r_flag p_flag etype subdomain_id
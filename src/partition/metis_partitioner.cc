@@ -20,6 +20,7 @@
 
 
 // C++ Includes   -----------------------------------
+#include <algorithm>
 
 // Local Includes -----------------------------------
 #include "elem.h"
@@ -39,6 +40,12 @@ namespace Metis
   }
 }
 
+// the weight of element used in partition
+static int elem_weight(const MeshBase& mesh, const Elem * elem)
+{
+  return mesh.subdomain_weight( elem->subdomain_id () ) * elem->n_nodes();
+}
+
 #endif
 
 #include "linear_partitioner.h"
@@ -63,16 +70,37 @@ void MetisPartitioner::_do_partition (MeshBase& mesh,
 
   START_LOG("partition()", "MetisPartitioner");
 
+  // the weight of each cluster
+  std::vector<std::pair<double, unsigned int> > cluster_weight;
   for(unsigned int c=0; c<_clusters.size(); ++c)
   {
-    Cluster * cluster = _clusters[c];
+    double weight = 0.0;
+    for (unsigned int n=0; n<_clusters[c]->elems.size(); ++n)
+      weight += elem_weight(mesh, _clusters[c]->elems[n]);
+    cluster_weight.push_back(std::make_pair(-weight, c));
+  }
+  // heavy cluster first
+  std::sort(cluster_weight.begin(), cluster_weight.end());
+
+  // the load of each processor, accumulated over all the clusters.
+  // each cluster is partitioned alone, then its parts are assigned to processors
+  // such that the total load is balanced
+  std::vector<std::pair<double, unsigned int> > processor_load;
+  for(unsigned int p=0; p<n_pieces; ++p)
+    processor_load.push_back(std::make_pair(0.0, p));
+
+  for(unsigned int i=0; i<cluster_weight.size(); ++i)
+  {
+    Cluster * cluster = _clusters[cluster_weight[i].second];
 
     const unsigned int n_elem        = cluster->elems.size();
-    std::vector<int> part(n_elem);  // here stores the partition vector of the graph
+    // small cluster can not be partitioned into too many parts
+    const unsigned int n_parts       = std::max(1u, std::min(n_pieces, n_elem));
+    std::vector<int> part(n_elem, 0);  // here stores the partition vector of the graph
     int metis_error=0;
 
     // only the first process do the partition
-    if(_serial_partition || Genius::is_first_processor())
+    if(n_parts > 1 && (_serial_partition || _local_partition || Genius::is_first_processor()))
     {
       // build the graph
       std::vector<int> xadj;          // the adjacency structure of the graph
@@ -86,7 +114,7 @@ void MetisPartitioner::_do_partition (MeshBase& mesh,
       int ncon    = 1;                          // The number of balancing constraints. It should be at least 1.
       int wgtflag = 2;                          // weights on vertices only, none on edges
       int numflag = 0;                          // C-style 0-based numbering
-      int nparts  = static_cast<int>(n_pieces); // number of subdomains to create
+      int nparts  = static_cast<int>(n_parts);  // number of subdomains to create
       int edgecut = 0;                          // the numbers of edges cut by the resulting partition
 
       // Set the options
@@ -104,7 +132,7 @@ void MetisPartitioner::_do_partition (MeshBase& mesh,
           const Elem * elem = cluster->elems[n];
 
           // The weight is used to define what a balanced graph is
-          vwgt[n] = mesh.subdomain_weight( elem->subdomain_id () ) * elem->n_nodes();
+          vwgt[n] = elem_weight(mesh, elem);
 
           // The beginning of the adjacency array for this elem
           xadj.push_back(adjncy.size());
@@ -132,7 +160,7 @@ void MetisPartitioner::_do_partition (MeshBase& mesh,
 
 #if PETSC_VERSION_GE(3,3,0)
       // METIS-5 interface
-      if (n_pieces <= 8)
+      if (n_parts <= 8)
         metis_error = Metis::METIS_PartGraphRecursive(&n, &ncon, &xadj[0], &adjncy[0], &vwgt[0], NULL/*vsize*/, NULL/*adjwgt*/,
                                              &nparts, NULL, NULL, NULL, &edgecut, &part[0]);
       else
@@ -148,49 +176,61 @@ void MetisPartitioner::_do_partition (MeshBase& mesh,
     }
 
     // broadcast partition info to all the processores
-    if(!_serial_partition)
+    // (local partition has nobody to talk with)
+    if(n_parts > 1 && !_local_partition)
     {
-      Parallel::broadcast(metis_error, 0);
-    }
-    else
-    {
-      Parallel::sum(metis_error);
+      if(!_serial_partition)
+        Parallel::broadcast(metis_error, 0);
+      else
+        Parallel::sum(metis_error);
     }
 
-    // Assign the returned processor ids.  The part array contains
-    // the processor id for each active element, but in terms of
-    // the contiguous indexing we defined above
+    // The part array contains the part id for each active element,
+    // but in terms of the contiguous indexing we defined above
 
     if( !metis_error )
     {
-      if(!_serial_partition)
+      if(n_parts > 1 && !_serial_partition && !_local_partition)
         Parallel::broadcast(part, 0);
-
-      for (unsigned int n=0; n<n_elem; ++n)
-      {
-        Elem * elem = const_cast<Elem *>(cluster->elems[n]);
-        short int processor_id = static_cast<short int>(part[n]);
-        elem->processor_id() = processor_id;
-      }
     }
     else // linear partition
     {
-      const unsigned int n_elem     = cluster->elems.size();
-      const unsigned int blksize    = n_elem/n_pieces;
+      const unsigned int blksize    = n_elem/n_parts;
 
       for (unsigned int n=0; n<n_elem; ++n)
       {
-        short int processor_id;
-        if ((n/blksize) < n_pieces)
-          processor_id = n/blksize;
+        if ((n/blksize) < n_parts)
+          part[n] = n/blksize;
         else
-          processor_id = 0;
-
-        Elem * elem = const_cast<Elem *>(cluster->elems[n]);
-        elem->processor_id() = processor_id;
+          part[n] = 0;
       }
     }
 
+    // the weight of each part
+    std::vector<std::pair<double, unsigned int> > part_weight;
+    for(unsigned int p=0; p<n_parts; ++p)
+      part_weight.push_back(std::make_pair(0.0, p));
+    for (unsigned int n=0; n<n_elem; ++n)
+      part_weight[part[n]].first -= elem_weight(mesh, cluster->elems[n]);
+
+    // the heaviest part goes to the processor with least load
+    std::sort(part_weight.begin(), part_weight.end());
+    std::sort(processor_load.begin(), processor_load.end());
+
+    std::vector<short int> part_to_processor(n_parts);
+    for(unsigned int p=0; p<n_parts; ++p)
+    {
+      part_to_processor[part_weight[p].second] = static_cast<short int>(processor_load[p].second);
+      processor_load[p].first -= part_weight[p].first;
+    }
+
+    // Assign the processor ids.
+    for (unsigned int n=0; n<n_elem; ++n)
+    {
+      Elem * elem = const_cast<Elem *>(cluster->elems[n]);
+      elem->processor_id() = part_to_processor[part[n]];
+    }
+
   }
 
   STOP_LOG("partition()", "MetisPartitioner");
@@ -21,6 +21,8 @@
 
 //  $Id: control.cc,v 1.54 2008/07/09 12:56:23 gdiso Exp $
 
+#include <algorithm>
+
 #include "genius_common.h"
 
 #ifdef WINDOWS
@@ -48,6 +50,7 @@
 #include "mesh_tools.h"
 #include "mesh_communication.h"
 #include "mesh_refinement.h"
+#include "refinement_transfer.h"
 #include "mesh_modification.h"
 #include "boundary_info.h"
 #include "electrical_source.h"
@@ -421,6 +424,18 @@ int SolverControl::set_method ( const Parser::Card & c )
   SolverSpecify::NSLagPCLU                  = c.get_int("pclu.lag", 5);
   // set jacobian lag
   SolverSpecify::NSLagJacobian              = c.get_int("jacobian.lag", 1);
+  // reuse jacobian across Newton iterations and time steps
+  SolverSpecify::JacobianReuse              = c.get_bool("jacobian.reuse", false);
+  SolverSpecify::JacobianReuseMax           = c.get_int("jacobian.reuse.max", 10);
+  SolverSpecify::JacobianReuseRatio         = c.get_real("jacobian.reuse.ratio", 0.5);
+  // Jacobian-free Newton-Krylov
+  SolverSpecify::JacobianMatrixFree         = c.get_bool("jacobian.mf", false);
+  // evaluate residual and jacobian in one pass
+  SolverSpecify::FusedAssembly              = c.get_bool("fused.assembly", false);
+  // eliminate electrode/circuit dofs by Schur complement
+  SolverSpecify::BorderSchur                = c.get_bool("border.schur", false);
+  // repartition the mesh by measured cost when load is not balanced
+  SolverSpecify::RepartitionThreshold       = c.get_real("repartition.threshold", 0.0);
 
   // set Newton damping type
   if(c.is_parameter_exist("damping"))
@@ -885,6 +900,46 @@ int SolverControl::do_solve( const Parser::Card & c )
           }
         }
 
+        // repeat the sweep for each branch voltage of other electrode(s), i.e. Id-Vg at several Vd
+        SolverSpecify::Electrode_VBranch.clear();
+        SolverSpecify::VBranch.clear();
+        if(c.is_parameter_exist("vbranch"))
+        {
+          if(system().get_circuit()!=NULL)
+          {
+            MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: Branch sweep is not supported in mixed-mode simulation." << std::endl; RECORD();
+            genius_error();
+          }
+
+          unsigned int elec_num = c.parameter_count("vbranch");
+          for(unsigned int n=0; n<elec_num; n++)
+          {
+            std::string electrode = c.get_n_string("vbranch", "", n, 0);
+            if( !system().get_bcs()->is_electrode(electrode) )
+            {
+              MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: Electrode " << electrode << " can't be found in device structure." << std::endl; RECORD();
+              genius_error();
+            }
+            if( std::find(SolverSpecify::Electrode_VScan.begin(), SolverSpecify::Electrode_VScan.end(), electrode) != SolverSpecify::Electrode_VScan.end() ||
+                std::find(SolverSpecify::Electrode_IScan.begin(), SolverSpecify::Electrode_IScan.end(), electrode) != SolverSpecify::Electrode_IScan.end() )
+            {
+              MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: Electrode " << electrode << " can't be both sweep and branch electrode." << std::endl; RECORD();
+              genius_error();
+            }
+            SolverSpecify::Electrode_VBranch.push_back(electrode);
+          }
+
+          std::vector<double> branch = c.get_array<double>("vbranch.list");
+          for(unsigned int n=0; n<branch.size(); n++)
+            SolverSpecify::VBranch.push_back(branch[n]*V);
+
+          if( SolverSpecify::VBranch.empty() )
+          {
+            MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: You must specify at least one branch voltage by vbranch.list."<<std::endl; RECORD();
+            genius_error();
+          }
+        }
+
         SolverSpecify::Predict       = c.get_bool("predict", true);
 
         SolverSpecify::OptG          = c.get_bool("optical.gen", false);
@@ -996,12 +1051,44 @@ int SolverControl::do_solve( const Parser::Card & c )
           SolverSpecify::Electrode_ACScan.push_back(electrode);
         }
 
-        if( SolverSpecify::Electrode_ACScan.size() != 1 )
+        // each acscan electrode is a port of the admittance matrix
+        SolverSpecify::ACMultiPort = c.get_bool("ac.multiport", false);
+
+        if( SolverSpecify::ACMultiPort )
+        {
+          if( SolverSpecify::Electrode_ACScan.empty() )
+          {
+            MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: You must specify at least one electrode as AC port."<<std::endl; RECORD();
+            genius_error();
+          }
+        }
+        else if( SolverSpecify::Electrode_ACScan.size() != 1 )
         {
           MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: You must specify one electrode for AC scan."<<std::endl; RECORD();
           genius_error();
         }
 
+        // fast sweep by reduced order model
+        SolverSpecify::ACMOR      = c.get_bool("ac.mor", false);
+        SolverSpecify::ACMORTol   = c.get_real("ac.mor.tol", 1e-6);
+        int mor_order = c.get_int("ac.mor.order", 4);
+        if( mor_order < 1 )
+        {
+          MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: ac.mor.order should be at least 1."<<std::endl; RECORD();
+          genius_error();
+        }
+        SolverSpecify::ACMOROrder = mor_order;
+        int mor_max_basis = c.get_int("ac.mor.maxbasis", 40);
+        if( mor_max_basis < 2*mor_order )
+        {
+          MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: ac.mor.maxbasis should be at least twice of ac.mor.order."<<std::endl; RECORD();
+          genius_error();
+        }
+        SolverSpecify::ACMORMaxBasis = mor_max_basis;
+
+        // distribute the frequencies to processors
+        SolverSpecify::ACFreqParallel = c.get_bool("ac.freq.parallel", false);
+
         SolverSpecify::Type = SolverSpecify::ACSWEEP;
 
         break;
@@ -1098,6 +1185,54 @@ int SolverControl::do_solve( const Parser::Card & c )
   SolverSpecify::out_prefix = c.get_string("out.prefix", "result");
   SolverSpecify::out_append = c.get_bool("out.append", false);
 
+  // adaptive mesh refinement during DC sweep and transient
+  SolverSpecify::AdaptInterval = 0;
+  SolverSpecify::AdaptPending  = false;
+  if( SolverSpecify::Type == SolverSpecify::DCSWEEP || SolverSpecify::Type == SolverSpecify::TRANSIENT )
+  {
+    int interval = c.get_int("adapt.interval", 0);
+    if( interval > 0 )
+    {
+      if( !c.is_parameter_exist("error.refine.fraction") && !c.is_parameter_exist("cell.refine.fraction") && !c.is_parameter_exist("error.refine.threshold") )
+      {
+        MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: adapt.interval requires one of error.refine.threshold, error.refine.fraction and cell.refine.fraction."<<std::endl; RECORD();
+        genius_error();
+      }
+      SolverSpecify::AdaptInterval = interval;
+    }
+  }
+
+  this->run_solver();
+
+  // the solver stops every adapt.interval steps, refine the mesh and continue from the transferred solution
+  while( SolverSpecify::AdaptPending )
+  {
+    SolverSpecify::AdaptPending = false;
+
+    std::vector<SolverSpecify::SolverType> solve_history = system().solve_history();
+    this->do_refine_hierarchical(c);
+    for(unsigned int n=0; n<solve_history.size(); n++)
+      system().record_active_solver(solve_history[n]);
+
+    // the continued solve writes to the same output, the transient keeps its history
+    SolverSpecify::out_append = true;
+    SolverSpecify::AdaptContinue = true;
+    if( SolverSpecify::Type == SolverSpecify::TRANSIENT )
+      SolverSpecify::tran_histroy = true;
+    this->run_solver();
+    SolverSpecify::AdaptContinue = false;
+  }
+
+  return 0;
+}
+
+
+
+/*--------------------------------------------------------------------
+ * create the solver selected by SolverSpecify, load hooks and do the solve
+ */
+int SolverControl::run_solver()
+{
   SolverBase * solver = NULL;
 
   // call each solver here
@@ -1282,6 +1417,18 @@ int SolverControl::do_solve( const Parser::Card & c )
 
     delete solver;
 
+    // rebuild the system on a new partition when assembly load is not balanced
+    if( SolverSpecify::RepartitionThreshold > 1.0 && Genius::n_processors() > 1 )
+    {
+      double imbalance = system().load_imbalance();
+      if( imbalance > SolverSpecify::RepartitionThreshold )
+      {
+        MESSAGE<<"Load imbalance "<< imbalance <<" exceeds threshold, repartition the mesh by measured cost..."<<std::endl; RECORD();
+        system().repartition();
+        system().sync_print_info();
+      }
+    }
+
   }
 
   return 0;
@@ -1787,7 +1934,6 @@ int  SolverControl::set_initial_node_voltage  ( const Parser::Card & c )
 
 int SolverControl::do_refine_conform(const Parser::Card & c)
 {
-  // TODO can we refine during the solver solution processing?
 
   // save previous solution
   AutoPtr<InterpolationBase> interpolator;
@@ -1917,35 +2063,23 @@ int SolverControl::do_refine_hierarchical(const Parser::Card & c)
 
   MESSAGE<<"Hierarchical mesh refinement...\n"<<std::endl; RECORD();
 
-  // save previous solution
-  AutoPtr<InterpolationBase> interpolator;
-  if( mesh().mesh_dimension() == 2 )
-    interpolator = AutoPtr<InterpolationBase>(new Interpolation2D_CSA);
-  else
-    interpolator = AutoPtr<InterpolationBase>(new Interpolation3D_nbtet);
-
-  if( DopingSolver.get() == NULL )
-  {
-    system().fill_interpolator(interpolator.get(), "doping.na", InterpolationBase::Asinh);
-    system().fill_interpolator(interpolator.get(), "doping.nd", InterpolationBase::Asinh);
-  }
-
-  if(system().has_single_compound_semiconductor_region()  && MoleSolver.get() == NULL )
-  {
-    system().fill_interpolator(interpolator.get(), "mole.x", InterpolationBase::Linear);
-  }
-  if(system().has_complex_compound_semiconductor_region()  && MoleSolver.get() == NULL )
-  {
-    system().fill_interpolator(interpolator.get(), "mole.y", InterpolationBase::Linear);
-  }
-
   // fill error vector from system level
   ErrorVector error_per_cell;
   system().estimate_error(c, error_per_cell);
 
-  if (Genius::processor_id() == 0)
-  {
+  // every processor refines the whole mesh by the same flags,
+  // then the element hierarchy is available on all the processors.
+  // the first processor always keeps the whole mesh, allgather is collective
+  Parallel::broadcast(error_per_cell);
+  unsigned int serial = mesh().is_serial();
+  Parallel::min(serial);
+  if( !serial )
+    mesh().allgather();
 
+  // save previous solution by mesh node
+  RefinementTransfer transfer(system());
+
+  {
     MeshRefinement mesh_refinement(mesh());
 
     // at least one refine criterion should be exist!
@@ -1964,45 +2098,40 @@ int SolverControl::do_refine_hierarchical(const Parser::Card & c)
     mesh_refinement.refine_and_coarsen_elements ();
   }
 
+  // new nodes get value from parent element
+  transfer.prolong();
+
+  // node id is fixed here, later preparation of the mesh keeps it
+  mesh().renumber_nodes_and_elements();
+  transfer.update_node_id();
+
   // clear the system(). however we should reserve mesh information
   system().clear(false);
 
-  // call mesh generator again to make new mesh consistence with FVM request.
-
-  // rebuild the system
-  // since we only build mesh on processor 0,
-  // sync mesh to other processors.
-  // this procedure also prepare the mesh for using
-  MeshCommunication mesh_comm;
-  mesh_comm.broadcast(mesh());
+  // scattered mesh is distributed from the first processor again,
+  // node id is kept by the distribution. the mesh with element hierarchy is kept by
+  // all the processors (which refined it the same way) and is not scattered
+  if( mesh().scatter_now() )
+  {
+    MeshCommunication mesh_comm;
+    mesh_comm.broadcast(mesh());
+  }
 
   // now we can build solution system again
   system().build_simulation_system();
   system().sync_print_info();
 
-  // set doping profile to semiconductor region
+  // init region data structure, then fill the transferred data
+  system().init_region();
+  transfer.restore();
+
+  // analytic doping profile and mole fraction are evaluated at the new nodes
   if( DopingSolver.get() != NULL )
     DopingSolver->solve();
-  else
-  {
-    // no doping information?
-    system().do_interpolation(interpolator.get(), "doping.na");
-    system().do_interpolation(interpolator.get(), "doping.nd");
-  }
 
-  // set mole fraction to semiconductor region
   if( MoleSolver.get() != NULL )
     MoleSolver->solve();
-  else
-  {
-    if(system().has_single_compound_semiconductor_region())
-      system().do_interpolation(interpolator.get(), "mole.x");
-    if(system().has_complex_compound_semiconductor_region())
-      system().do_interpolation(interpolator.get(), "mole.y");
-  }
 
-  // after doping profile is set, we can init system data.
-  system().init_region();
   system().init_region_post_process();
   return 0;
 
@@ -2015,27 +2144,45 @@ int SolverControl::do_refine_hierarchical(const Parser::Card & c)
 int SolverControl::do_refine_uniform(const Parser::Card & c)
 {
 
-  if (Genius::processor_id() == 0)
+  // the first processor always keeps the whole mesh, allgather is collective
+  unsigned int serial = mesh().is_serial();
+  Parallel::min(serial);
+  if( !serial )
+    mesh().allgather();
+
+  // save previous solution by mesh node
+  RefinementTransfer transfer(system());
+
   {
     int step =  c.get_int("step", 1);
     MeshRefinement mesh_refinement(mesh());
     mesh_refinement.uniformly_refine(step);
+    transfer.prolong();
     MeshTools::Modification::flatten(mesh());
   }
 
+  mesh().renumber_nodes_and_elements();
+  transfer.update_node_id();
+
   // clear the system. however we should reserve mesh information
   system().clear(false);
 
-  // since we only build mesh on processor 0,
-  // sync mesh to other processors.
-  // this procedure also prepare the mesh for using
-  MeshCommunication mesh_comm;
-  mesh_comm.broadcast(mesh());
+  // scattered mesh is distributed from the first processor again,
+  // node id is kept by the distribution
+  if( mesh().scatter_on_partition() )
+  {
+    MeshCommunication mesh_comm;
+    mesh_comm.broadcast(mesh());
+  }
 
   // now we can build solution system again
   system().build_simulation_system();
   system().sync_print_info();
 
+  // init region data structure, then fill the transferred data
+  system().init_region();
+  transfer.restore();
+
   // set doping profile to semiconductor region
   if( DopingSolver.get() != NULL )
     DopingSolver->solve();
@@ -2044,8 +2191,6 @@ int SolverControl::do_refine_uniform(const Parser::Card & c)
   if( MoleSolver.get() != NULL )
     MoleSolver->solve();
 
-  // after doping profile is set, we can init system data.
-  system().init_region();
   system().init_region_post_process();
   return 0;
 }
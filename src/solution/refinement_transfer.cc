@@ -0,0 +1,180 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+
+#include "refinement_transfer.h"
+#include "simulation_system.h"
+#include "mesh_base.h"
+#include "elem.h"
+#include "perf_log.h"
+
+
+RefinementTransfer::RefinementTransfer(SimulationSystem & system)
+  : _system(system), _mesh(system.mesh())
+{
+  START_LOG("RefinementTransfer()", "RefinementTransfer");
+
+  _region_data.resize(_system.n_regions());
+  for(unsigned int r=0; r<_system.n_regions(); ++r)
+  {
+    SimulationRegion::DataBackup backup;
+    _system.region(r)->backup_data(backup);
+
+    RegionData & data = _region_data[r];
+    data.width = backup.node_ids.empty() ? 0 : backup.node_values.size()/backup.node_ids.size();
+    data.values.swap(backup.node_values);
+    for(unsigned int n=0; n<backup.node_ids.size(); ++n)
+      data.node_record.insert(std::make_pair(backup.node_ids[n], n));
+  }
+
+  _system.backup_circuit_state(_circuit_state);
+
+  STOP_LOG("RefinementTransfer()", "RefinementTransfer");
+}
+
+
+
+void RefinementTransfer::prolong()
+{
+  START_LOG("prolong()", "RefinementTransfer");
+
+  for(unsigned int r=0; r<_region_data.size(); ++r)
+  {
+    RegionData & data = _region_data[r];
+    if( !data.width ) continue;
+
+    const unsigned int subdomain = _system.region(r)->subdomain_id();
+
+    // element refined more than one level gets its data after its parent
+    bool progress = true;
+    while(progress)
+    {
+      progress = false;
+
+      MeshBase::element_iterator       el  = _mesh.elements_begin();
+      const MeshBase::element_iterator end = _mesh.elements_end();
+      for(; el != end; ++el)
+      {
+        const Elem * elem = *el;
+        const Elem * parent = elem->parent();
+        if( !parent || elem->subdomain_id() != subdomain ) continue;
+
+        // children keep the processor of parent. a node shared with the element of
+        // other processor is prolonged there as well, restore() keeps one of them
+        if( elem->processor_id() != Genius::processor_id() ) continue;
+
+        const unsigned int c = parent->which_child_am_i(elem);
+        for(unsigned int nc=0; nc<elem->n_nodes(); ++nc)
+        {
+          const unsigned int node = elem->node(nc);
+          if( data.node_record.find(node) != data.node_record.end() ) continue;
+
+          // all the parent nodes contribute to this node should have data
+          bool ready = true;
+          for(unsigned int n=0; n<parent->n_nodes(); ++n)
+            if( parent->embedding_matrix(c, nc, n) != 0. &&
+                data.node_record.find(parent->node(n)) == data.node_record.end() )
+            { ready = false; break; }
+          if( !ready ) continue;
+
+          const unsigned int record = data.values.size()/data.width;
+          data.values.resize(data.values.size() + data.width, 0.0);
+          for(unsigned int n=0; n<parent->n_nodes(); ++n)
+          {
+            const float em = parent->embedding_matrix(c, nc, n);
+            if( em == 0. ) continue;
+
+            const unsigned int parent_record = data.node_record.find(parent->node(n))->second;
+            for(unsigned int k=0; k<data.width; ++k)
+              data.values[record*data.width + k] += em*data.values[parent_record*data.width + k];
+          }
+
+          data.node_record.insert(std::make_pair(node, record));
+          progress = true;
+        }
+      }
+    }
+
+    // node id changes by renumbering, keep the record of nodes still in the mesh by
+    // pointer. records of nodes deleted by coarsening are dropped here
+    data.live_record.clear();
+    MeshBase::node_iterator       it  = _mesh.nodes_begin();
+    const MeshBase::node_iterator end = _mesh.nodes_end();
+    for(; it != end; ++it)
+    {
+      const Node * node = *it;
+      std::map<unsigned int, unsigned int>::const_iterator record = data.node_record.find(node->id());
+      if( record != data.node_record.end() )
+        data.live_record.insert(std::make_pair(node, record->second));
+    }
+    data.node_record.clear();
+  }
+
+  STOP_LOG("prolong()", "RefinementTransfer");
+}
+
+
+
+void RefinementTransfer::update_node_id()
+{
+  for(unsigned int r=0; r<_region_data.size(); ++r)
+  {
+    RegionData & data = _region_data[r];
+    SimulationRegion::DataBackup & backup = data.backup;
+
+    backup.node_ids.clear();
+    backup.node_values.clear();
+    backup.cell_ids.clear();
+    backup.cell_values.clear();
+
+    // renumbering may delete unused nodes, only search nodes still in the mesh.
+    // no node is created after prolong(), the address of a deleted node is not reused
+    MeshBase::node_iterator       it  = _mesh.nodes_begin();
+    const MeshBase::node_iterator end = _mesh.nodes_end();
+    for(; it != end; ++it)
+    {
+      const Node * node = *it;
+      std::map<const Node *, unsigned int>::const_iterator record = data.live_record.find(node);
+      if( record == data.live_record.end() ) continue;
+
+      backup.node_ids.push_back(node->id());
+      backup.node_values.insert(backup.node_values.end(),
+                                data.values.begin() + record->second*data.width,
+                                data.values.begin() + (record->second+1)*data.width);
+    }
+
+    data.live_record.clear();
+    data.values.clear();
+  }
+}
+
+
+
+void RefinementTransfer::restore()
+{
+  genius_assert(_region_data.size() == _system.n_regions());
+
+  for(unsigned int r=0; r<_region_data.size(); ++r)
+    _system.region(r)->restore_data(_region_data[r].backup);
+
+  _system.restore_circuit_state(_circuit_state);
+}
@@ -19,14 +19,18 @@
 /*                                                                              */
 /********************************************************************************/
 
+#include <algorithm>
+
 #include "elem.h"
 #include "simulation_region.h"
 #include "boundary_condition.h"
 #include "material.h"
 #include "parallel.h"
+#include "graph_ordering.h"
 
 // static member
 std::map<unsigned int,  SimulationRegion *>  SimulationRegion::_subdomain_id_to_region_map;
+SimulationRegion::NodeOrdering SimulationRegion::_node_ordering = SimulationRegion::OrderByID;
 
 
 
@@ -172,6 +176,7 @@ void SimulationRegion::clear()
   _node_data_storage.clear();
 
   _region_edges.clear();
+  _region_edge_local_node_index.clear();
   _region_elem_edge_in_edges_index.clear();
   _region_neighbors.clear();
   _region_boundaries.clear();
@@ -228,6 +233,187 @@ void SimulationRegion::rebuild_region_fvm_node_list()
       _region_image_node.push_back(fvm_node);
   }
 
+  // renumber the nodes and edges for locality
+  if( _node_ordering != OrderByID )
+    this->reorder_region_fvm_node_list();
+
+  // the on local index of edge nodes
+  _region_edge_local_node_index.clear();
+  {
+    std::map<const FVM_Node *, unsigned int> local_node_index;
+    for(unsigned int n=0; n<_region_local_node.size(); ++n)
+      local_node_index.insert( std::make_pair(_region_local_node[n], n) );
+
+    _region_edge_local_node_index.reserve(_region_edges.size());
+    for(unsigned int n=0; n<_region_edges.size(); ++n)
+    {
+      genius_assert( local_node_index.find(_region_edges[n].first)  != local_node_index.end() );
+      genius_assert( local_node_index.find(_region_edges[n].second) != local_node_index.end() );
+      unsigned int n1 = local_node_index.find(_region_edges[n].first)->second;
+      unsigned int n2 = local_node_index.find(_region_edges[n].second)->second;
+      _region_edge_local_node_index.push_back( std::make_pair(n1, n2) );
+    }
+  }
+
+  this->build_cell_edge_table();
+}
+
+
+void SimulationRegion::build_cell_edge_table()
+{
+  CellEdgeTable & table = _cell_edge_table;
+
+  table.cell_begin.clear();
+  table.cell_begin.reserve(_region_cell.size()+1);
+  table.cell_begin.push_back(0);
+  for(unsigned int n=0; n<_region_cell.size(); ++n)
+    table.cell_begin.push_back(table.cell_begin.back() + _region_cell[n]->n_edges());
+
+  const unsigned int n_edges = table.cell_begin.back();
+  table.node1.resize(n_edges);
+  table.node2.resize(n_edges);
+  table.fvm_node1.resize(n_edges);
+  table.fvm_node2.resize(n_edges);
+  table.edge_index.resize(n_edges);
+  table.inverse.resize(n_edges);
+  table.length.resize(n_edges);
+  table.partial_area.resize(n_edges);
+  table.partial_volume.resize(n_edges);
+  table.truncated_partial_area.resize(n_edges);
+  table.truncated_partial_volume.resize(n_edges);
+
+  for(unsigned int n=0; n<_region_cell.size(); ++n)
+  {
+    const Elem * elem = _region_cell[n];
+    for(unsigned int ne=0; ne<elem->n_edges(); ++ne)
+    {
+      const unsigned int i = table.cell_begin[n] + ne;
+
+      std::pair<unsigned int, unsigned int> edge_nodes;
+      elem->nodes_on_edge(ne, edge_nodes);
+
+      table.node1[i]      = edge_nodes.first;
+      table.node2[i]      = edge_nodes.second;
+      table.fvm_node1[i]  = elem->get_fvm_node(edge_nodes.first);
+      table.fvm_node2[i]  = elem->get_fvm_node(edge_nodes.second);
+      table.edge_index[i] = this->elem_edge_index(elem, ne);
+      table.inverse[i]    = elem->get_node(edge_nodes.first)->id() > elem->get_node(edge_nodes.second)->id();
+
+      table.length[i]                   = elem->edge_length(ne);
+      table.partial_area[i]             = elem->partial_area_with_edge(ne);
+      table.partial_volume[i]           = elem->partial_volume_with_edge(ne);
+      table.truncated_partial_area[i]   = this->truncated_partial_area(elem, ne);
+      table.truncated_partial_volume[i] = elem->partial_volume_with_edge_truncated(ne);
+    }
+  }
+}
+
+
+Real SimulationRegion::truncated_partial_area(const Elem * elem, unsigned int ne) const
+{
+  return elem->partial_area_with_edge_truncated(ne);
+}
+
+
+void SimulationRegion::reorder_region_fvm_node_list()
+{
+  const unsigned int n_local = _region_local_node.size();
+  if( n_local == 0 ) return;
+
+  std::map<const FVM_Node *, unsigned int> local_node_index;
+  for(unsigned int n=0; n<n_local; ++n)
+    local_node_index.insert( std::make_pair(_region_local_node[n], n) );
+
+  // order[k] is the old index of the node at k-th position
+  std::vector<unsigned int> order;
+  switch(_node_ordering)
+  {
+    case OrderRCM :
+    {
+      // node graph from region edges in CSR format
+      std::vector< std::vector<unsigned int> > adj(n_local);
+      for(unsigned int n=0; n<_region_edges.size(); ++n)
+      {
+        unsigned int n1 = local_node_index.find(_region_edges[n].first)->second;
+        unsigned int n2 = local_node_index.find(_region_edges[n].second)->second;
+        adj[n1].push_back(n2);
+        adj[n2].push_back(n1);
+      }
+      std::vector<unsigned int> xadj(1, 0), adjncy;
+      adjncy.reserve(2*_region_edges.size());
+      for(unsigned int n=0; n<n_local; ++n)
+      {
+        std::sort(adj[n].begin(), adj[n].end());
+        adjncy.insert(adjncy.end(), adj[n].begin(), adj[n].end());
+        xadj.push_back(adjncy.size());
+      }
+      GraphOrdering::reverse_cuthill_mckee(xadj, adjncy, order);
+      break;
+    }
+    case OrderHilbert :
+    {
+      std::vector<Point> pts(n_local);
+      for(unsigned int n=0; n<n_local; ++n)
+        pts[n] = *(_region_local_node[n]->root_node());
+      GraphOrdering::hilbert(pts, order);
+      break;
+    }
+    default : return;
+  }
+
+  std::vector<unsigned int> new_index(n_local);
+  std::vector<FVM_Node *> local_nodes(n_local);
+  for(unsigned int k=0; k<n_local; ++k)
+  {
+    new_index[order[k]] = k;
+    local_nodes[k] = _region_local_node[order[k]];
+  }
+  _region_local_node.swap(local_nodes);
+
+  // on processor nodes and ghost nodes keep the same relative order as on local nodes
+  {
+    std::vector<FVM_Node *> processor_nodes, ghost_nodes;
+    for(unsigned int k=0; k<n_local; ++k)
+    {
+      FVM_Node * fvm_node = _region_local_node[k];
+      if( fvm_node->on_processor() ) processor_nodes.push_back(fvm_node);
+      else                           ghost_nodes.push_back(fvm_node);
+    }
+    genius_assert( processor_nodes.size() == _region_processor_node.size() );
+    genius_assert( ghost_nodes.size() == _region_ghost_node.size() );
+    _region_processor_node.swap(processor_nodes);
+    _region_ghost_node.swap(ghost_nodes);
+  }
+
+  // edges are sorted by the new index of their nodes
+  {
+    std::vector< std::pair< std::pair<unsigned int, unsigned int>, unsigned int> > edge_keys(_region_edges.size());
+    for(unsigned int n=0; n<_region_edges.size(); ++n)
+    {
+      unsigned int n1 = new_index[local_node_index.find(_region_edges[n].first)->second];
+      unsigned int n2 = new_index[local_node_index.find(_region_edges[n].second)->second];
+      edge_keys[n] = std::make_pair(std::make_pair(std::min(n1, n2), std::max(n1, n2)), n);
+    }
+    std::sort(edge_keys.begin(), edge_keys.end());
+
+    std::vector< std::pair<FVM_Node *, FVM_Node *> > edges(_region_edges.size());
+    std::vector<unsigned int> new_edge_index(_region_edges.size());
+    for(unsigned int n=0; n<edge_keys.size(); ++n)
+    {
+      edges[n] = _region_edges[edge_keys[n].second];
+      new_edge_index[edge_keys[n].second] = n;
+    }
+    _region_edges.swap(edges);
+
+    // update the edge index of elements
+    for(element_iterator elem_it = elements_begin(); elem_it != elements_end(); elem_it++)
+    {
+      if( _region_elem_edge_in_edges_index.find(*elem_it) == _region_elem_edge_in_edges_index.end() ) continue;
+      std::vector<unsigned int> & elem_edges = _region_elem_edge_in_edges_index.find(*elem_it)->second;
+      for(unsigned int e=0; e<elem_edges.size(); ++e)
+        elem_edges[e] = new_edge_index[elem_edges[e]];
+    }
+  }
 }
 
 
@@ -425,6 +611,86 @@ void SimulationRegion::sync_fvm_node_volume()
 
 
 
+void SimulationRegion::sync_fvm_node_global_offset()
+{
+  parallel_only();
+
+  const unsigned int n_procs = Genius::n_processors();
+  const int tag = 1733;
+
+  // ask the owner of each ghost node for its offset, only neighbor processors talk to each other
+  std::vector< std::vector<unsigned int> > request_ids(n_procs);
+  std::vector< std::vector<FVM_Node *> > request_nodes(n_procs);
+  for(unsigned int n=0; n<_region_ghost_node.size(); ++n)
+  {
+    FVM_Node * fvm_node = _region_ghost_node[n];
+    const unsigned int owner = fvm_node->root_node()->processor_id();
+    request_ids[owner].push_back(fvm_node->root_node()->id());
+    request_nodes[owner].push_back(fvm_node);
+  }
+
+  std::vector<unsigned int> reply_size(n_procs);
+  for(unsigned int p=0; p<n_procs; ++p)
+    reply_size[p] = request_ids[p].size();
+  Parallel::alltoall(reply_size);
+
+  std::vector<unsigned int> request_procs, reply_procs;
+  for(unsigned int p=0; p<n_procs; ++p)
+  {
+    if( !request_ids[p].empty() ) request_procs.push_back(p);
+    if( reply_size[p] ) reply_procs.push_back(p);
+  }
+
+  // the ids of ghost nodes to their owners
+  std::vector< std::vector<unsigned int> > reply_ids(reply_procs.size());
+  {
+    std::vector<Parallel::request> requests(request_procs.size() + reply_procs.size());
+    for(unsigned int n=0; n<reply_procs.size(); ++n)
+    {
+      reply_ids[n].resize(reply_size[reply_procs[n]]);
+      Parallel::irecv(reply_procs[n], reply_ids[n], requests[n], tag);
+    }
+    for(unsigned int n=0; n<request_procs.size(); ++n)
+      Parallel::isend(request_procs[n], request_ids[request_procs[n]], requests[reply_procs.size()+n], tag);
+    Parallel::wait(requests);
+  }
+
+  // the offsets of image nodes back, in the order of the ids
+  {
+    std::vector<Parallel::request> requests(request_procs.size() + reply_procs.size());
+
+    std::vector< std::vector<unsigned int> > request_offsets(request_procs.size());
+    for(unsigned int n=0; n<request_procs.size(); ++n)
+    {
+      request_offsets[n].resize(request_ids[request_procs[n]].size());
+      Parallel::irecv(request_procs[n], request_offsets[n], requests[n], tag+1);
+    }
+
+    std::vector< std::vector<unsigned int> > reply_offsets(reply_procs.size());
+    for(unsigned int n=0; n<reply_procs.size(); ++n)
+    {
+      for(unsigned int k=0; k<reply_ids[n].size(); ++k)
+      {
+        std::map<unsigned int, FVM_Node *>::const_iterator it = _region_node.find(reply_ids[n][k]);
+        genius_assert( it != _region_node.end() && it->second->on_processor() );
+        reply_offsets[n].push_back(it->second->global_offset());
+      }
+      Parallel::isend(reply_procs[n], reply_offsets[n], requests[request_procs.size()+n], tag+1);
+    }
+
+    Parallel::wait(requests);
+
+    for(unsigned int n=0; n<request_procs.size(); ++n)
+    {
+      const std::vector<FVM_Node *> & nodes = request_nodes[request_procs[n]];
+      for(unsigned int k=0; k<nodes.size(); ++k)
+        nodes[k]->set_global_offset( request_offsets[n][k] );
+    }
+  }
+}
+
+
+
 Real SimulationRegion::fvm_cell_quality() const
 {
 #if 0
@@ -915,11 +1181,192 @@ size_t SimulationRegion::memory_size() const
   counter += _region_image_node.capacity()*sizeof(FVM_Node *);
   counter +=  _node_data_storage.memory_size();
   counter += _region_edges.capacity()*sizeof(std::pair<FVM_Node *, FVM_Node *>);
+  counter += _cell_edge_table.cell_begin.capacity()*sizeof(unsigned int);
+  counter += _cell_edge_table.length.capacity()*(3*sizeof(unsigned int) + 2*sizeof(FVM_Node *) + sizeof(unsigned char) + 5*sizeof(Real));
 
   return counter;
 }
 
 
+void SimulationRegion::backup_data(DataBackup & backup) const
+{
+  backup.node_ids.clear();
+  backup.node_values.clear();
+  backup.cell_ids.clear();
+  backup.cell_values.clear();
+
+  // ghost nodes are kept as well, then all the nodes of local cells have data
+  for(unsigned int n=0; n<_region_local_node.size(); ++n)
+  {
+    const FVM_Node * fvm_node = _region_local_node[n];
+    backup.node_ids.push_back(fvm_node->root_node()->id());
+    _node_data_storage.pack(fvm_node->node_data()->offset(), backup.node_values);
+  }
+
+  for(unsigned int n=0; n<_region_cell.size(); ++n)
+  {
+    const Elem * elem = _region_cell[n];
+    if( elem->on_processor() )
+    {
+      backup.cell_ids.push_back(elem->id());
+      _cell_data_storage.pack(_region_cell_data[n]->offset(), backup.cell_values);
+    }
+  }
+}
+
+
+
+/**
+ * send send[p] to processor p and receive recv[p] from it, the sizes are exchanged first.
+ * the message to this processor is copied. must executed in parallel
+ */
+template <typename T>
+static void exchange_records(std::vector< std::vector<T> > & send, std::vector< std::vector<T> > & recv, const int tag)
+{
+  const unsigned int n_procs = Genius::n_processors();
+  const unsigned int me = Genius::processor_id();
+
+  std::vector<unsigned int> recv_size(n_procs);
+  for(unsigned int p=0; p<n_procs; ++p)
+    recv_size[p] = send[p].size();
+  Parallel::alltoall(recv_size);
+
+  recv.assign(n_procs, std::vector<T>());
+  recv[me] = send[me];
+
+  std::vector<Parallel::request> requests(2*n_procs);
+  unsigned int n_requests = 0;
+  for(unsigned int p=0; p<n_procs; ++p)
+  {
+    if( p == me || !recv_size[p] ) continue;
+    recv[p].resize(recv_size[p]);
+    Parallel::irecv(p, recv[p], requests[n_requests++], tag);
+  }
+  for(unsigned int p=0; p<n_procs; ++p)
+  {
+    if( p == me || send[p].empty() ) continue;
+    Parallel::isend(p, send[p], requests[n_requests++], tag);
+  }
+  requests.resize(n_requests);
+  Parallel::wait(requests);
+}
+
+
+/**
+ * fetch the records of \p want_ids from the processors which hold them.
+ * the records are first sent to processor id%n_processors, then each processor asks
+ * there for the records it wants. no processor holds more than its share of the records.
+ * an id held by several processors (i.e. ghost node) has the same record, the first one is kept.
+ * must executed in parallel
+ */
+static void fetch_records(const std::vector<unsigned int> & ids, const std::vector<PetscScalar> & values, const unsigned int width,
+                          const std::vector<unsigned int> & want_ids, std::vector<PetscScalar> & want_values, std::vector<unsigned int> & found)
+{
+  const unsigned int n_procs = Genius::n_processors();
+  const int tag = 1735;
+
+  // records to their home processor
+  std::map<unsigned int, std::pair<unsigned int, unsigned int> > home;
+  std::vector< std::vector<unsigned int> > home_ids;
+  std::vector< std::vector<PetscScalar> >  home_values;
+  {
+    std::vector< std::vector<unsigned int> > send_ids(n_procs);
+    std::vector< std::vector<PetscScalar> >  send_values(n_procs);
+    for(unsigned int n=0; n<ids.size(); ++n)
+    {
+      const unsigned int p = ids[n]%n_procs;
+      send_ids[p].push_back(ids[n]);
+      send_values[p].insert(send_values[p].end(), values.begin()+n*width, values.begin()+(n+1)*width);
+    }
+    exchange_records(send_ids, home_ids, tag);
+    exchange_records(send_values, home_values, tag+1);
+  }
+  for(unsigned int p=0; p<n_procs; ++p)
+    for(unsigned int n=0; n<home_ids[p].size(); ++n)
+      home.insert(std::make_pair(home_ids[p][n], std::make_pair(p, n)));
+
+  // ask the home processors for the wanted ids
+  std::vector< std::vector<unsigned int> > ask_ids(n_procs);
+  std::vector< std::vector<unsigned int> > ask_index(n_procs);
+  for(unsigned int n=0; n<want_ids.size(); ++n)
+  {
+    const unsigned int p = want_ids[n]%n_procs;
+    ask_ids[p].push_back(want_ids[n]);
+    ask_index[p].push_back(n);
+  }
+
+  std::vector< std::vector<unsigned int> > asked_ids;
+  exchange_records(ask_ids, asked_ids, tag+2);
+
+  // reply a flag for each asked id, and the records found
+  std::vector< std::vector<unsigned int> > reply_found(n_procs);
+  std::vector< std::vector<PetscScalar> >  reply_values(n_procs);
+  for(unsigned int p=0; p<n_procs; ++p)
+    for(unsigned int n=0; n<asked_ids[p].size(); ++n)
+    {
+      std::map<unsigned int, std::pair<unsigned int, unsigned int> >::const_iterator it = home.find(asked_ids[p][n]);
+      reply_found[p].push_back( it != home.end() );
+      if( it == home.end() ) continue;
+      const std::vector<PetscScalar> & record = home_values[it->second.first];
+      reply_values[p].insert(reply_values[p].end(), record.begin()+it->second.second*width, record.begin()+(it->second.second+1)*width);
+    }
+
+  std::vector< std::vector<unsigned int> > got_found;
+  std::vector< std::vector<PetscScalar> >  got_values;
+  exchange_records(reply_found, got_found, tag+3);
+  exchange_records(reply_values, got_values, tag+4);
+
+  found.assign(want_ids.size(), 0);
+  want_values.assign(want_ids.size()*width, 0.0);
+  for(unsigned int p=0; p<n_procs; ++p)
+  {
+    unsigned int pos = 0;
+    for(unsigned int n=0; n<got_found[p].size(); ++n)
+    {
+      if( !got_found[p][n] ) continue;
+      const unsigned int index = ask_index[p][n];
+      found[index] = 1;
+      std::copy(got_values[p].begin()+pos, got_values[p].begin()+pos+width, want_values.begin()+index*width);
+      pos += width;
+    }
+  }
+}
+
+
+void SimulationRegion::restore_data(const DataBackup & backup)
+{
+  parallel_only();
+
+  // length of each record, the backup of this processor may be empty
+  unsigned int node_width = backup.node_ids.empty() ? 0 : backup.node_values.size()/backup.node_ids.size();
+  unsigned int cell_width = backup.cell_ids.empty() ? 0 : backup.cell_values.size()/backup.cell_ids.size();
+  Parallel::max(node_width);
+  Parallel::max(cell_width);
+
+  // ghost nodes and cells are restored as well
+  std::vector<unsigned int> node_ids;
+  for(unsigned int n=0; n<_region_local_node.size(); ++n)
+    node_ids.push_back(_region_local_node[n]->root_node()->id());
+
+  std::vector<unsigned int> cell_ids;
+  for(unsigned int n=0; n<_region_cell.size(); ++n)
+    cell_ids.push_back(_region_cell[n]->id());
+
+  std::vector<PetscScalar>  node_values, cell_values;
+  std::vector<unsigned int> node_found, cell_found;
+  fetch_records(backup.node_ids, backup.node_values, node_width, node_ids, node_values, node_found);
+  fetch_records(backup.cell_ids, backup.cell_values, cell_width, cell_ids, cell_values, cell_found);
+
+  for(unsigned int n=0; n<_region_local_node.size(); ++n)
+    if( node_found[n] )
+      _node_data_storage.unpack(_region_local_node[n]->node_data()->offset(), node_values, n*node_width);
+
+  for(unsigned int n=0; n<_region_cell.size(); ++n)
+    if( cell_found[n] )
+      _cell_data_storage.unpack(_region_cell_data[n]->offset(), cell_values, n*cell_width);
+}
+
+
 
 
 //explicit instantiation
@@ -38,6 +38,7 @@
 #include "pml_region.h"
 #include "parallel.h"
 #include "boundary_info.h"
+#include "mesh_communication.h"
 #include "boundary_condition_collector.h"
 #include "surface_locator_hub.h"
 #include "electrical_source.h"
@@ -162,6 +163,14 @@ SimulationSystem::SimulationSystem(MeshBase & mesh, Parser::InputParser & _decks
       _resistive_metal_mode = c.get_bool("resistivemetal", false);
       _block_partition = c.get_bool("blockpartition", true);
 
+      std::string node_order = c.get_string("nodeorder", "id");
+      if( node_order == "rcm" )
+        SimulationRegion::set_node_ordering(SimulationRegion::OrderRCM);
+      else if( node_order == "hilbert" )
+        SimulationRegion::set_node_ordering(SimulationRegion::OrderHilbert);
+      else
+        SimulationRegion::set_node_ordering(SimulationRegion::OrderByID);
+
       double res = c.get_real("leakage.res", 1e100)*PhysicalUnit::V/PhysicalUnit::A;
       double cap = c.get_real("leakage.cap", 0.0)*PhysicalUnit::C/PhysicalUnit::V;
       MetalSimulationRegion::set_aux_parasitic_parameter(std::max(res, 1e-3*PhysicalUnit::V/PhysicalUnit::A), cap);
@@ -179,6 +188,10 @@ SimulationSystem::SimulationSystem(MeshBase & mesh, Parser::InputParser & _decks
   // field sources
   _field_source = new FieldSource(*this, _decks);
 
+  // distributed mesh is scattered from the first processor after partition,
+  // other processors never hold the whole mesh
+  _mesh.set_scatter_on_partition(_distributed_mesh && !_field_source->request_serial_mesh());
+
   // set magnetic field
   for( _decks.begin(); !_decks.end(); _decks.next() )
   {
@@ -484,47 +497,66 @@ void SimulationSystem::build_region_fvm_mesh()
 
     UnstructuredMesh & mesh = dynamic_cast<UnstructuredMesh &>(_mesh);
 
-    MESSAGE<<"  Create mesh topological information...";  RECORD();
-    // 2d or 3d mesh?
-    mesh.count_mesh_dimension();
+    // for scattered mesh, only the first processor holds the mesh now.
+    // it builds the topological information and partitions the mesh alone,
+    // then sends each processor its local elements with one ghost layer
+    const bool scatter = Genius::n_processors() > 1 && _mesh.scatter_now();
 
-    mesh.build_mesh_bounding_box();
+    if( !scatter || Genius::is_first_processor() )
+    {
+      MESSAGE<<"  Create mesh topological information...";  RECORD();
+      // 2d or 3d mesh?
+      mesh.count_mesh_dimension();
+
+      mesh.build_mesh_bounding_box();
 
-    // this function will renumber the the node/elem
-    mesh.all_first_order();
+      // this function will renumber the the node/elem
+      mesh.all_first_order();
 
-    // *** let all the elements find their neighbors
-    mesh.find_neighbors();
+      // *** let all the elements find their neighbors
+      mesh.find_neighbors();
 
 #if 0
-    // reorder the elem/node index by Reverse Cuthill-McKee Algorithm
-    std::string err;
-    if(!mesh.reorder_elems(err))
-    {
-      MESSAGE<<err;RECORD();
-      genius_error();
-    }
+      // reorder the elem/node index by Reverse Cuthill-McKee Algorithm
+      std::string err;
+      if(!mesh.reorder_elems(err))
+      {
+        MESSAGE<<err;RECORD();
+        genius_error();
+      }
 #endif
-    MESSAGE<<std::endl;  RECORD();
+      MESSAGE<<std::endl;  RECORD();
+
+
+      MESSAGE<<"  Partition mesh...";  RECORD();
 
+      // prepare for partition
+      // Subdomains which are neighbors and have the same material
+      // will be clustered together for parallelization.
+      if(_block_partition)
+        mesh.subdomain_cluster(this->build_subdomain_cluster());
 
-    MESSAGE<<"  Partition mesh...";  RECORD();
+      // the cost of each subdomain
+      this->set_partition_weight();
 
-    // prepare for partition
-    // Subdomains which are neighbors and have the same material 
-    // will be clustered together for parallelization.
-    if(_block_partition)
-      mesh.subdomain_cluster(this->build_subdomain_cluster());
+      // partition the mesh.
+      mesh.partition(Genius::n_processors(), scatter);
+    }
 
-    // partition the mesh.
-    mesh.partition(Genius::n_processors());
+    // send each processor its piece of the mesh
+    if( scatter )
+    {
+      MeshCommunication mesh_comm;
+      mesh_comm.distribute(mesh);
+    }
 
     // ok, mesh is prepared
     mesh.set_prepared();
 
     // remove remote mesh elements when processor_id > 1
     // however, keep boundary elems for later bc setup
-    if(_distributed_mesh && !_field_source->request_serial_mesh() && Genius::processor_id() !=0 )
+    // (scattered mesh only has local elems and boundary elems already)
+    if(!scatter && _distributed_mesh && !_field_source->request_serial_mesh() && Genius::processor_id() !=0 )
       _mesh.delete_remote_elements(true, false);
 
     MESSAGE<<std::endl;  RECORD();
@@ -624,9 +656,6 @@ void SimulationSystem::build_region_fvm_mesh()
     //
     _simulation_regions[r]->set_subdomain_id(r);
     subdomain_id_to_region_map[r] = _simulation_regions[r];
-
-    //set partition weight for each region (we don't need it, right?)
-    _mesh.set_subdomain_weight(r, Material::material_weight(_mesh.subdomain_material(r)));
   }
 
   // each region should hold subdomain_id_to_region_map
@@ -1463,6 +1492,148 @@ std::vector< std::vector<unsigned int > > SimulationSystem::build_subdomain_clus
 
 
 
+void SimulationSystem::set_partition_weight()
+{
+  // the cheapest region has weight 10, leave some resolution for integer weight
+  double min_cost = 0.0;
+  std::map<unsigned int, double>::const_iterator it = _subdomain_cost.begin();
+  for( ; it != _subdomain_cost.end(); ++it)
+    if( min_cost == 0.0 || it->second < min_cost ) min_cost = it->second;
+
+  for(unsigned int s=0; s<_mesh.n_subdomains(); s++)
+  {
+    int weight = Material::material_weight(_mesh.subdomain_material(s));
+    if( min_cost > 0.0 )
+    {
+      // region without measurement is considered as the cheapest one
+      double cost = _subdomain_cost.find(s) != _subdomain_cost.end() ? _subdomain_cost.find(s)->second : min_cost;
+      weight = std::max(1, static_cast<int>(10*cost/min_cost + 0.5));
+    }
+    _mesh.set_subdomain_weight(s, weight);
+  }
+}
+
+
+
+double SimulationSystem::load_imbalance()
+{
+  std::vector<double> region_time(n_regions(), 0.0);
+  std::vector<double> region_node(n_regions(), 0.0);
+
+  double local_time = 0.0;
+  for(unsigned int r=0; r<n_regions(); r++)
+  {
+    SimulationRegion * region = _simulation_regions[r];
+    region_time[r] = region->assembly_perf().tot_time;
+    region_node[r] = region->n_on_processor_node();
+    local_time += region_time[r];
+  }
+
+  Parallel::sum(region_time);
+  Parallel::sum(region_node);
+
+  double max_time = local_time;
+  double total_time = local_time;
+  Parallel::max(max_time);
+  Parallel::sum(total_time);
+
+  _subdomain_cost.clear();
+
+  // the assembly of current solver is not timed, no measurement for repartition
+  if( total_time <= 0.0 )
+  {
+    MESSAGE<<"Warning: assembly time is not measured by this solver, repartition.threshold is ignored."<<std::endl; RECORD();
+    return 1.0;
+  }
+
+  for(unsigned int r=0; r<n_regions(); r++)
+    if( region_time[r] > 0.0 && region_node[r] > 0.0 )
+      _subdomain_cost[_simulation_regions[r]->subdomain_id()] = region_time[r]/region_node[r];
+
+  return max_time/(total_time/Genius::n_processors());
+}
+
+
+
+void SimulationSystem::repartition()
+{
+  START_LOG("repartition()", "SimulationSystem");
+
+  // region data are indexed by node/cell id, which does not change with partition
+  std::vector<SimulationRegion::DataBackup> region_data(n_regions());
+  for(unsigned int r=0; r<n_regions(); r++)
+    _simulation_regions[r]->backup_data(region_data[r]);
+
+  // state of external circuit, the same on all the processors
+  std::map<std::string, std::vector<Real> > circuit_state;
+  this->backup_circuit_state(circuit_state);
+
+  std::vector<SolverSpecify::SolverType> solve_history = _solver_active_history;
+
+  // keep the mesh, rebuild regions and bcs with new partition
+  this->clear(false);
+
+  // the first processor always holds the whole mesh. a scattered mesh is cleared on the other
+  // processors here, and build_simulation_system() partitions it on the first processor by
+  // the measured cost then scatters the new pieces. a distributed mesh which is not scattered
+  // is gathered to all the processors again, remote elements are deleted after partition
+  if( _mesh.scatter_now() )
+  {
+    MeshCommunication mesh_comm;
+    mesh_comm.broadcast(_mesh);
+  }
+  else
+  {
+    unsigned int serial = _mesh.is_serial() ? 1 : 0;
+    Parallel::min(serial);
+    if( !serial )
+      _mesh.allgather();
+  }
+
+  this->build_simulation_system();
+  this->init_region();
+
+  for(unsigned int r=0; r<n_regions(); r++)
+    _simulation_regions[r]->restore_data(region_data[r]);
+
+  this->restore_circuit_state(circuit_state);
+
+  this->init_region_post_process();
+
+  _solver_active_history = solve_history;
+
+  STOP_LOG("repartition()", "SimulationSystem");
+}
+
+
+
+void SimulationSystem::backup_circuit_state(std::map<std::string, std::vector<Real> > & circuit_state) const
+{
+  circuit_state.clear();
+  for(unsigned int b=0; b<_bcs->n_bcs(); b++)
+  {
+    const BoundaryCondition * bc = _bcs->get_bc(b);
+    if( !bc->is_electrode() ) continue;
+    bc->ext_circuit()->save_state(circuit_state[bc->label()]);
+  }
+}
+
+
+
+void SimulationSystem::restore_circuit_state(const std::map<std::string, std::vector<Real> > & circuit_state)
+{
+  for(unsigned int b=0; b<_bcs->n_bcs(); b++)
+  {
+    BoundaryCondition * bc = _bcs->get_bc(b);
+    if( !bc->is_electrode() ) continue;
+    if( circuit_state.find(bc->label()) == circuit_state.end() ) continue;
+    unsigned int pos = 0;
+    bc->ext_circuit()->load_state(circuit_state.find(bc->label())->second, pos);
+  }
+}
+
+
+
 void SimulationSystem::print_info (std::ostream& os) const
 {
   os << "Simulation System Information on processor " << Genius::processor_id() << " :" << '\n'
@@ -1553,8 +1724,8 @@ void SimulationSystem::export_vtk(const std::string& filename, bool ascii) const
   {
 #ifdef HAVE_VTK
     std::string file_name = filename;
-    // preprocess vtk file extension to make sure it has a ".vtu" format
-    if (file_name.rfind(".vtu") > file_name.size())
+    // preprocess vtk file extension to make sure it has a ".vtu" format, ".pvtu" for parallel output
+    if (file_name.rfind(".vtu") > file_name.size() && file_name.rfind(".pvtu") > file_name.size())
     {
       // file name has a vtk extension, change it to vtu
       if (file_name.rfind(".vtk") < file_name.size())
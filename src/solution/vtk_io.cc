@@ -23,6 +23,7 @@
 // C++ includes
 #include <fstream>
 #include <sstream>
+#include <list>
 
 // Local includes
 #include "vtk_io.h"
@@ -40,6 +41,7 @@
 #include "spice_ckt.h"
 #include "material.h"
 #include "solver_specify.h"
+#include "async_writer.h"
 
 #ifdef HAVE_VTK
 
@@ -52,6 +54,8 @@
 #include "vtkIntArray.h"
 #include "vtkFloatArray.h"
 #include "vtkPointData.h"
+#include "vtkDataArray.h"
+#include "vtkIdList.h"
 
 #endif //HAVE_VTK
 
@@ -93,6 +97,73 @@ public:
 private:
   std::string _header;
 };
+
+
+/**
+ * write a grid snapshot to .vtu file by the background thread of AsyncWriter.
+ * the grid is deleted by the destructor, which runs in the main thread since
+ * the grid shares points and cells with the cached geometry of VTKIO.
+ * the writer registers/unregisters these shared arrays, and VTK reference counts
+ * are not thread safe, so write_series() waits for the job before it touches the
+ * cached geometry again
+ */
+class VTKIO::GridWriteJob : public AsyncWriter::Job
+{
+public:
+  GridWriteJob(vtkUnstructuredGrid* grid, const std::string &header, const std::string &name)
+    : _grid(grid), _header(header), _name(name)
+  {}
+
+  virtual ~GridWriteJob()
+  { _grid->Delete(); }
+
+  virtual void run()
+  {
+    XMLUnstructuredGridWriter* writer = XMLUnstructuredGridWriter::New();
+    writer->SetInput(_grid);
+    writer->setExtraHeader(_header);
+    writer->SetFileName(_name.c_str());
+    writer->Write();
+    writer->Delete();
+  }
+
+private:
+  vtkUnstructuredGrid* _grid;
+  std::string _header;
+  std::string _name;
+};
+
+
+/**
+ * write binary and text files of XDMF series by the background thread of AsyncWriter.
+ * the files are written in the order they are added
+ */
+class VTKIO::RawWriteJob : public AsyncWriter::Job
+{
+public:
+  /**
+   * @return the buffer of a new file, it keeps valid when more files are added
+   */
+  std::vector<char> & add_file(const std::string &name)
+  {
+    _files.push_back(std::make_pair(name, std::vector<char>()));
+    return _files.back().second;
+  }
+
+  virtual void run()
+  {
+    std::list< std::pair<std::string, std::vector<char> > >::const_iterator it = _files.begin();
+    for( ; it != _files.end(); ++it)
+    {
+      std::ofstream out(it->first.c_str(), std::ios::binary);
+      if(!it->second.empty())
+        out.write(&it->second[0], it->second.size());
+    }
+  }
+
+private:
+  std::list< std::pair<std::string, std::vector<char> > > _files;
+};
 #endif
 
 // private functions
@@ -880,6 +951,10 @@ void VTKIO::solution_to_vtk(const MeshBase& mesh, vtkUnstructuredGrid* grid)
     //write_node_scaler_solution(region_node_ids, Taun,   "Taun", grid);
     //write_node_scaler_solution(region_node_ids, Taup,   "Taup", grid);
 
+    // all the node fields of the piece in one exchange
+    if(_piece_mode)
+      piece_write_node_fields(grid);
+
   }
 
   // write cell based data
@@ -902,7 +977,7 @@ void VTKIO::solution_to_vtk(const MeshBase& mesh, vtkUnstructuredGrid* grid)
         if( elem->processor_id() != Genius::processor_id() ) continue;
         const FVM_CellData * elem_data = region->get_region_elem_data(n);
         elem_to_elem_data_map.insert( std::make_pair(elem, elem_data) );
-        order.push_back(elem->id());
+        order.push_back(_piece_mode ? _piece_elem_index.find(elem->id())->second : elem->id());
         /*
         if( region->type()==SemiconductorRegion)
         {
@@ -930,22 +1005,25 @@ void VTKIO::solution_to_vtk(const MeshBase& mesh, vtkUnstructuredGrid* grid)
 
     // write solution for boundary elements, just keep the same as mesh elems
     {
-      std::vector<unsigned int> boundary_elem_ids(_el);
-      std::vector<unsigned short int> boundary_elem_sides(_sl);
-      Parallel::gather(0, boundary_elem_ids);
-      Parallel::gather(0, boundary_elem_sides);
-
       typedef std::pair<unsigned int, unsigned short int> boundary_elem_key;
       std::map<boundary_elem_key, unsigned int> boundary_face_order;
-      for(unsigned int n=0; n<boundary_elem_ids.size(); ++n)
+      if(!_piece_mode)
       {
-        boundary_elem_key key = std::make_pair(boundary_elem_ids[n], boundary_elem_sides[n]);
-        boundary_face_order.insert(std::make_pair(key, 0));
-      }
-      std::map< boundary_elem_key, unsigned int >::iterator boundary_face_it=boundary_face_order.begin();
-      for(unsigned int i=0;boundary_face_it != boundary_face_order.end(); ++boundary_face_it, ++i)
-      {
-        boundary_face_it->second = i;
+        std::vector<unsigned int> boundary_elem_ids(_el);
+        std::vector<unsigned short int> boundary_elem_sides(_sl);
+        Parallel::gather(0, boundary_elem_ids);
+        Parallel::gather(0, boundary_elem_sides);
+
+        for(unsigned int n=0; n<boundary_elem_ids.size(); ++n)
+        {
+          boundary_elem_key key = std::make_pair(boundary_elem_ids[n], boundary_elem_sides[n]);
+          boundary_face_order.insert(std::make_pair(key, 0));
+        }
+        std::map< boundary_elem_key, unsigned int >::iterator boundary_face_it=boundary_face_order.begin();
+        for(unsigned int i=0;boundary_face_it != boundary_face_order.end(); ++boundary_face_it, ++i)
+        {
+          boundary_face_it->second = i;
+        }
       }
 
       unsigned int id_offset = mesh.n_elem();
@@ -957,7 +1035,10 @@ void VTKIO::solution_to_vtk(const MeshBase& mesh, vtkUnstructuredGrid* grid)
         const FVM_CellData * elem_data = elem_to_elem_data_map.find(elem)->second;
 
         boundary_elem_key key = std::make_pair(_el[n], _sl[n]);
-        order.push_back(id_offset + boundary_face_order.find(key)->second);
+        if(_piece_mode)
+          order.push_back(_piece_face_index.find(key)->second);
+        else
+          order.push_back(id_offset + boundary_face_order.find(key)->second);
 
         //std::cout<<id_offset + boundary_face_order.find(key)->second<<std::endl;
         //mos_channel_flag.push_back(0.5);
@@ -979,7 +1060,8 @@ void VTKIO::solution_to_vtk(const MeshBase& mesh, vtkUnstructuredGrid* grid)
       }
     }
 
-    Parallel::gather(0, order);
+    if(!_piece_mode)
+      Parallel::gather(0, order);
     //write_cell_scaler_solution(order, mos_channel_flag,  "mos channel", grid);
     write_cell_vector_solution(order, Ex,  Ey,  Ez,  "electrical_field[V/cm]", grid);
     write_cell_vector_solution(order, Jnx, Jny, Jnz, "elec_current[A/cm^2]", grid);
@@ -997,6 +1079,18 @@ void VTKIO::write_node_scaler_solution(const std::vector< std::vector<unsigned i
                                        const std::vector< std::vector<float> > &region_sol,
                                        const std::string & sol_name, vtkUnstructuredGrid* grid)
 {
+  // in piece mode, the field is exchanged and written by piece_write_node_fields() together with others
+  if(_piece_mode)
+  {
+    PieceNodeField field;
+    field.kind    = PieceNodeField::SCALAR;
+    field.name    = sol_name;
+    field.channel = _piece_channels.size();
+    _piece_fields.push_back(field);
+    piece_queue_channel(region_order, region_sol);
+    return;
+  }
+
   // this should run on parallel for all the processor
   std::vector<float> solution;
 
@@ -1046,6 +1140,26 @@ void VTKIO::write_node_complex_solution(const std::vector< std::vector<unsigned
                                         const std::vector< std::vector<std::complex<float> > > & region_sol,
                                         const std::string & sol_name, vtkUnstructuredGrid* grid)
 {
+  // in piece mode, the field is exchanged and written by piece_write_node_fields() together with others
+  if(_piece_mode)
+  {
+    std::vector< std::vector<float> > region_real(region_sol.size()), region_imag(region_sol.size());
+    for(unsigned int r=0; r<region_sol.size(); ++r)
+      for(unsigned int i=0; i<region_sol[r].size(); ++i)
+      {
+        region_real[r].push_back(region_sol[r][i].real());
+        region_imag[r].push_back(region_sol[r][i].imag());
+      }
+    PieceNodeField field;
+    field.kind    = PieceNodeField::COMPLEX;
+    field.name    = sol_name;
+    field.channel = _piece_channels.size();
+    _piece_fields.push_back(field);
+    piece_queue_channel(region_order, region_real);
+    piece_queue_channel(region_order, region_imag);
+    return;
+  }
+
   // this should run on parallel for all the processor
   std::vector<float> solution_real;
   std::vector<float> solution_imag;
@@ -1117,6 +1231,20 @@ void VTKIO::write_node_vector_solution(const std::vector< std::vector<unsigned i
                                        const std::vector< std::vector<float> > & region_z,
                                        const std::string & sol_name, vtkUnstructuredGrid* grid)
 {
+  // in piece mode, the field is exchanged and written by piece_write_node_fields() together with others
+  if(_piece_mode)
+  {
+    PieceNodeField field;
+    field.kind    = PieceNodeField::VECTOR;
+    field.name    = sol_name;
+    field.channel = _piece_channels.size();
+    _piece_fields.push_back(field);
+    piece_queue_channel(region_order, region_x);
+    piece_queue_channel(region_order, region_y);
+    piece_queue_channel(region_order, region_z);
+    return;
+  }
+
   // this should run on parallel for all the processor
   std::vector<float> solution_x;
   std::vector<float> solution_y;
@@ -1187,10 +1315,11 @@ void VTKIO::write_node_vector_solution(const std::vector< std::vector<unsigned i
 void VTKIO::write_cell_scaler_solution(const std::vector<unsigned int> & order, std::vector<float> &sol,
                                        const std::string & sol_name, vtkUnstructuredGrid* grid)
 {
-  // this should run on parallel for all the processor
-  Parallel::gather(0, sol);
+  // this should run on parallel for all the processor, piece cell index is given by order
+  if(!_piece_mode)
+    Parallel::gather(0, sol);
 
-  if (Genius::processor_id() == 0)
+  if (_piece_mode || Genius::processor_id() == 0)
   {
     //create vtk data array
     vtkFloatArray *vtk_sol_array = vtkFloatArray::New();
@@ -1224,12 +1353,15 @@ void VTKIO::write_cell_vector_solution(const std::vector<unsigned int> & order,
                                        std::vector<float > & sol_z,
                                        const std::string & sol_name, vtkUnstructuredGrid* grid)
 {
-  // this should run on parallel for all the processor
-  Parallel::gather(0, sol_x);
-  Parallel::gather(0, sol_y);
-  Parallel::gather(0, sol_z);
+  // this should run on parallel for all the processor, piece cell index is given by order
+  if(!_piece_mode)
+  {
+    Parallel::gather(0, sol_x);
+    Parallel::gather(0, sol_y);
+    Parallel::gather(0, sol_z);
+  }
 
-  if ( Genius::processor_id() == 0)
+  if ( _piece_mode || Genius::processor_id() == 0)
   {
     //create vtk data array
     vtkFloatArray *vtk_sol_array = vtkFloatArray::New();
@@ -1265,6 +1397,421 @@ void VTKIO::write_cell_vector_solution(const std::vector<unsigned int> & order,
 }
 
 
+
+void VTKIO::piece_to_vtk(const MeshBase& mesh, vtkUnstructuredGrid* grid)
+{
+  const SimulationSystem & system = FieldOutput<SimulationSystem>::system();
+  const unsigned int nr = system.n_regions();
+
+  // elements of this processor, ordered by id
+  std::map<unsigned int, const Elem *> piece_elems;
+  std::vector< std::set<unsigned int> > region_nodes(nr);
+  {
+    MeshBase::const_element_iterator       it  = mesh.active_this_pid_elements_begin();
+    const MeshBase::const_element_iterator end = mesh.active_this_pid_elements_end();
+    for ( ; it != end; ++it)
+    {
+      const Elem *elem  = (*it);
+      piece_elems.insert(std::make_pair(elem->id(), elem));
+      for(unsigned int n=0; n<elem->n_nodes(); ++n)
+        region_nodes[elem->subdomain_id()].insert(elem->node(n));
+    }
+  }
+
+  // piece points, each region keeps its own copy of interface nodes
+  _region_node_id_map.clear();
+  std::vector< std::vector< std::pair<unsigned int, unsigned int> > > required(Genius::n_processors());
+
+  vtkPoints* points = vtkPoints::New();
+  vtkIntArray *node_id_info = vtkIntArray::New();
+  vtkIntArray *node_region_info = vtkIntArray::New();
+  node_id_info->SetName("node_id");
+  node_region_info->SetName("node_region");
+  {
+    unsigned int cnt = 0;
+    for(unsigned int r=0; r<nr; ++r)
+    {
+      std::set<unsigned int>::const_iterator it = region_nodes[r].begin();
+      for(; it != region_nodes[r].end(); ++it, ++cnt)
+      {
+        const unsigned int node_id = *it;
+        _region_node_id_map.insert( std::make_pair(std::make_pair(r, node_id), cnt) );
+
+        const Point & p = mesh.point(node_id);
+        float tuple[3] = { static_cast<float>(p[0]/um), static_cast<float>(p[1]/um), static_cast<float>(p[2]/um) };
+        points->InsertPoint(cnt, tuple);
+        node_id_info->InsertNextValue(node_id);
+        node_region_info->InsertNextValue(r);
+
+        const unsigned int owner = mesh.node(node_id).processor_id();
+        if( owner != Genius::processor_id() )
+          required[owner].push_back(std::make_pair(r, node_id));
+      }
+    }
+    _piece_n_points = cnt;
+  }
+  grid->SetPoints(points);
+  grid->GetPointData()->AddArray(node_id_info);
+  grid->GetPointData()->AddArray(node_region_info);
+  points->Delete();
+  node_id_info->Delete();
+  node_region_info->Delete();
+
+  // boundary faces of this processor, ordered by (elem id, side)
+  typedef std::pair<unsigned int, unsigned short int> boundary_elem_key;
+  std::map<boundary_elem_key, short int> piece_faces;
+  for(unsigned int n=0; n<_il.size(); ++n)
+    piece_faces.insert(std::make_pair(std::make_pair(_el[n], _sl[n]), _il[n]));
+
+  vtkIntArray *region_info    = vtkIntArray::New();
+  vtkIntArray *boundary_info  = vtkIntArray::New();
+  vtkIntArray *partition_info = vtkIntArray::New();
+  region_info->SetName("region");
+  boundary_info->SetName("boundary");
+  partition_info->SetName("partition");
+
+  _piece_elem_index.clear();
+  _piece_face_index.clear();
+  grid->Allocate(piece_elems.size() + piece_faces.size());
+
+  unsigned int cell_index = 0;
+  std::map<unsigned int, const Elem *>::const_iterator elem_it = piece_elems.begin();
+  for(; elem_it != piece_elems.end(); ++elem_it, ++cell_index)
+  {
+    const Elem * elem = elem_it->second;
+    const unsigned int region = elem->subdomain_id();
+
+    std::vector<unsigned int> conn;
+    elem->connectivity(0,VTK,conn);
+
+    vtkIdList *pts = vtkIdList::New();
+    pts->SetNumberOfIds(conn.size());
+    for(unsigned int i=0;i<conn.size();++i)
+      pts->SetId(i, _region_node_id_map.find(std::make_pair(region, conn[i]))->second);
+    grid->InsertNextCell(elem_type_vtk(elem), pts);
+    pts->Delete();
+
+    region_info->InsertNextValue(region);
+    boundary_info->InsertNextValue(0);
+    partition_info->InsertNextValue(elem->processor_id());
+    _piece_elem_index.insert(std::make_pair(elem->id(), cell_index));
+  }
+
+  std::map<boundary_elem_key, short int>::const_iterator face_it = piece_faces.begin();
+  for(; face_it != piece_faces.end(); ++face_it, ++cell_index)
+  {
+    const Elem * elem = mesh.elem(face_it->first.first);
+    const unsigned int region = elem->subdomain_id();
+    AutoPtr<Elem> boundary_elem =  elem->build_side(face_it->first.second);
+
+    std::vector<unsigned int> conn;
+    boundary_elem->connectivity(0,VTK,conn);
+
+    vtkIdList *pts = vtkIdList::New();
+    pts->SetNumberOfIds(conn.size());
+    for(unsigned int i=0;i<conn.size();++i)
+      pts->SetId(i, _region_node_id_map.find(std::make_pair(region, conn[i]))->second);
+    grid->InsertNextCell(elem_type_vtk(boundary_elem.get()), pts);
+    pts->Delete();
+
+    region_info->InsertNextValue(region);
+    boundary_info->InsertNextValue(face_it->second);
+    partition_info->InsertNextValue(elem->processor_id());
+    _piece_face_index.insert(std::make_pair(face_it->first, cell_index));
+  }
+
+  grid->GetCellData()->AddArray(region_info);
+  grid->GetCellData()->AddArray(boundary_info);
+  grid->GetCellData()->AddArray(partition_info);
+  region_info->Delete();
+  boundary_info->Delete();
+  partition_info->Delete();
+
+  // piece point of the on processor nodes, in the order solution_to_vtk() visits them
+  std::map< std::pair<unsigned int, unsigned int>, unsigned int > local_index;
+  _piece_local_point.clear();
+  for(unsigned int r=0; r<nr; ++r)
+  {
+    SimulationRegion::const_processor_node_iterator node_it = system.region(r)->on_processor_nodes_begin();
+    SimulationRegion::const_processor_node_iterator node_it_end = system.region(r)->on_processor_nodes_end();
+    for(; node_it!=node_it_end; ++node_it)
+    {
+      const std::pair<unsigned int, unsigned int> key(r, (*node_it)->root_node()->id());
+      std::map< std::pair<unsigned int, unsigned int>, unsigned int >::const_iterator point_it = _region_node_id_map.find(key);
+      local_index.insert(std::make_pair(key, _piece_local_point.size()));
+      _piece_local_point.push_back(point_it != _region_node_id_map.end() ? point_it->second : invalid_uint);
+    }
+  }
+
+  // piece nodes received from their owners
+  _piece_recv_procs.clear();
+  _piece_recv_point.clear();
+  for(unsigned int p=0; p<Genius::n_processors(); ++p)
+  {
+    if(required[p].empty()) continue;
+    _piece_recv_procs.push_back(p);
+    _piece_recv_point.push_back(std::vector<unsigned int>());
+    for(unsigned int n=0; n<required[p].size(); ++n)
+      _piece_recv_point.back().push_back(_region_node_id_map.find(required[p][n])->second);
+  }
+
+  // tell the owners which nodes are required by this piece. it is done once for the geometry,
+  // the solution is only exchanged between the processors found here
+  _piece_send_procs.clear();
+  _piece_send_index.clear();
+  for(unsigned int p=1; p<Genius::n_processors(); ++p)
+  {
+    const unsigned int dest = (Genius::processor_id() + p) % Genius::n_processors();
+    const unsigned int src  = (Genius::processor_id() + Genius::n_processors() - p) % Genius::n_processors();
+
+    std::vector<unsigned int> send, recv;
+    for(unsigned int n=0; n<required[dest].size(); ++n)
+    {
+      send.push_back(required[dest][n].first);
+      send.push_back(required[dest][n].second);
+    }
+    Parallel::send_receive(dest, send, src, recv);
+
+    if(recv.empty()) continue;
+    _piece_send_procs.push_back(src);
+    _piece_send_index.push_back(std::vector<unsigned int>());
+    for(unsigned int n=0; n<recv.size(); n+=2)
+      _piece_send_index.back().push_back(local_index.find(std::make_pair(recv[n], recv[n+1]))->second);
+  }
+}
+
+
+
+void VTKIO::piece_queue_channel(const std::vector< std::vector<unsigned int> >& region_order,
+                                const std::vector< std::vector<float> > & region_sol)
+{
+  _piece_channels.push_back(std::vector<float>());
+  std::vector<float> & channel = _piece_channels.back();
+  channel.reserve(_piece_local_point.size());
+  for(unsigned int r=0; r<region_order.size(); ++r)
+    channel.insert(channel.end(), region_sol[r].begin(), region_sol[r].end());
+  genius_assert(channel.size() == _piece_local_point.size());
+}
+
+
+
+void VTKIO::piece_write_node_fields(vtkUnstructuredGrid* grid)
+{
+  const unsigned int n_channels = _piece_channels.size();
+  const int tag = 1729;
+
+  // all the channels go to a neighbor piece in one message
+  std::vector<Parallel::request> requests(_piece_send_procs.size() + _piece_recv_procs.size());
+
+  std::vector< std::vector<float> > recv_buffers(_piece_recv_procs.size());
+  for(unsigned int n=0; n<_piece_recv_procs.size(); ++n)
+  {
+    recv_buffers[n].resize(_piece_recv_point[n].size()*n_channels);
+    Parallel::irecv(_piece_recv_procs[n], recv_buffers[n], requests[n], tag);
+  }
+
+  std::vector< std::vector<float> > send_buffers(_piece_send_procs.size());
+  for(unsigned int n=0; n<_piece_send_procs.size(); ++n)
+  {
+    const std::vector<unsigned int> & index = _piece_send_index[n];
+    send_buffers[n].reserve(index.size()*n_channels);
+    for(unsigned int k=0; k<index.size(); ++k)
+      for(unsigned int c=0; c<n_channels; ++c)
+        send_buffers[n].push_back(_piece_channels[c][index[k]]);
+    Parallel::isend(_piece_send_procs[n], send_buffers[n], requests[_piece_recv_procs.size()+n], tag);
+  }
+
+  // on processor values in the order of piece points, while the messages are on the way
+  std::vector< std::vector<float> > values(n_channels, std::vector<float>(_piece_n_points, 0.0f));
+  for(unsigned int c=0; c<n_channels; ++c)
+    for(unsigned int i=0; i<_piece_local_point.size(); ++i)
+      if(_piece_local_point[i] != invalid_uint)
+        values[c][_piece_local_point[i]] = _piece_channels[c][i];
+
+  Parallel::wait(requests);
+
+  for(unsigned int n=0; n<_piece_recv_procs.size(); ++n)
+  {
+    const std::vector<unsigned int> & point = _piece_recv_point[n];
+    for(unsigned int k=0; k<point.size(); ++k)
+      for(unsigned int c=0; c<n_channels; ++c)
+        values[c][point[k]] = recv_buffers[n][k*n_channels+c];
+  }
+
+  for(unsigned int f=0; f<_piece_fields.size(); ++f)
+  {
+    const PieceNodeField & field = _piece_fields[f];
+    switch(field.kind)
+    {
+      case PieceNodeField::SCALAR :
+      {
+        const std::vector<float> & sol = values[field.channel];
+        vtkFloatArray *vtk_sol_array = vtkFloatArray::New();
+        vtk_sol_array->SetName(field.name.c_str());
+        vtk_sol_array->SetNumberOfValues(sol.size());
+        for(unsigned int n=0; n<sol.size(); ++n)
+          vtk_sol_array->InsertValue(n, sol[n]);
+        grid->GetPointData()->AddArray(vtk_sol_array);
+        vtk_sol_array->Delete();
+        break;
+      }
+      case PieceNodeField::COMPLEX :
+      {
+        const std::vector<float> & sol_real = values[field.channel];
+        const std::vector<float> & sol_imag = values[field.channel+1];
+        vtkFloatArray *vtk_sol_array_magnitude = vtkFloatArray::New();
+        vtkFloatArray *vtk_sol_array_angle     = vtkFloatArray::New();
+        vtk_sol_array_magnitude->SetName((field.name+" abs").c_str());
+        vtk_sol_array_magnitude->SetNumberOfValues(sol_real.size());
+        vtk_sol_array_angle->SetName((field.name+" angle").c_str());
+        vtk_sol_array_angle->SetNumberOfValues(sol_real.size());
+        for(unsigned int n=0; n<sol_real.size(); ++n)
+        {
+          std::complex<float> data(sol_real[n], sol_imag[n]);
+          vtk_sol_array_magnitude->InsertValue(n, std::abs(data));
+          vtk_sol_array_angle->InsertValue(n, std::arg(data));
+        }
+        grid->GetPointData()->AddArray(vtk_sol_array_magnitude);
+        grid->GetPointData()->AddArray(vtk_sol_array_angle);
+        vtk_sol_array_magnitude->Delete();
+        vtk_sol_array_angle->Delete();
+        break;
+      }
+      case PieceNodeField::VECTOR :
+      {
+        const std::vector<float> & sol_x = values[field.channel];
+        const std::vector<float> & sol_y = values[field.channel+1];
+        const std::vector<float> & sol_z = values[field.channel+2];
+        vtkFloatArray *vtk_sol_array = vtkFloatArray::New();
+        vtk_sol_array->SetNumberOfComponents(3);
+        vtk_sol_array->SetNumberOfTuples(sol_x.size());
+        vtk_sol_array->SetName(field.name.c_str());
+        for(unsigned int n=0; n<sol_x.size(); ++n)
+        {
+          float sol[3]={sol_x[n], sol_y[n], sol_z[n]};
+          vtk_sol_array->InsertTuple(n, &sol[0] );
+        }
+        grid->GetPointData()->AddArray(vtk_sol_array);
+        vtk_sol_array->Delete();
+        break;
+      }
+    }
+  }
+
+  _piece_fields.clear();
+  _piece_channels.clear();
+}
+
+
+
+std::string VTKIO::piece_file_name(const std::string& name, unsigned int p)
+{
+  std::ostringstream piece;
+  piece << name.substr(0, name.rfind(".pvtu")) << "_" << p << ".vtu";
+  return piece.str();
+}
+
+
+
+void VTKIO::write_pvtu_index(const std::string& name, vtkUnstructuredGrid* grid)
+{
+  std::ofstream out(name.c_str());
+
+  out << "<?xml version=\"1.0\"?>" << std::endl;
+  out << "<VTKFile type=\"PUnstructuredGrid\" version=\"0.1\" byte_order=\"LittleEndian\">" << std::endl;
+  out << "  <PUnstructuredGrid GhostLevel=\"0\">" << std::endl;
+
+  out << "    <PPointData>" << std::endl;
+  for(int n=0; n<grid->GetPointData()->GetNumberOfArrays(); ++n)
+  {
+    vtkDataArray * array = grid->GetPointData()->GetArray(n);
+    out << "      <PDataArray type=\"" << (array->IsA("vtkIntArray") ? "Int32" : "Float32") << "\" Name=\"" << array->GetName()
+        << "\" NumberOfComponents=\"" << array->GetNumberOfComponents() << "\"/>" << std::endl;
+  }
+  out << "    </PPointData>" << std::endl;
+
+  out << "    <PCellData>" << std::endl;
+  for(int n=0; n<grid->GetCellData()->GetNumberOfArrays(); ++n)
+  {
+    vtkDataArray * array = grid->GetCellData()->GetArray(n);
+    out << "      <PDataArray type=\"" << (array->IsA("vtkIntArray") ? "Int32" : "Float32") << "\" Name=\"" << array->GetName()
+        << "\" NumberOfComponents=\"" << array->GetNumberOfComponents() << "\"/>" << std::endl;
+  }
+  out << "    </PCellData>" << std::endl;
+
+  out << "    <PPoints>" << std::endl;
+  out << "      <PDataArray type=\"Float32\" NumberOfComponents=\"3\"/>" << std::endl;
+  out << "    </PPoints>" << std::endl;
+
+  // piece file is relative to the index file
+  for(unsigned int p=0; p<Genius::n_processors(); ++p)
+  {
+    std::string piece = piece_file_name(name, p);
+    if(piece.rfind('/') < piece.size())
+      piece = piece.substr(piece.rfind('/')+1);
+    out << "    <Piece Source=\"" << piece << "\"/>" << std::endl;
+  }
+
+  out << "  </PUnstructuredGrid>" << std::endl;
+  out << "</VTKFile>" << std::endl;
+
+  out.close();
+}
+
+
+
+unsigned int VTKIO::read_piece(const std::string& name, std::vector< std::set<unsigned int> > & read_nodes)
+{
+  SimulationSystem & system = FieldInput<SimulationSystem>::system();
+
+  vtkXMLUnstructuredGridReader * reader = vtkXMLUnstructuredGridReader::New();
+  reader->SetFileName(name.c_str());
+  reader->Update();
+
+  vtkPointData * point_data = reader->GetOutput()->GetPointData();
+  vtkDataArray * node_id     = point_data->GetArray("node_id");
+  vtkDataArray * node_region = point_data->GetArray("node_region");
+  if( !node_id || !node_region )
+  {
+    MESSAGE<<"ERROR: VTK file " << name << " is not a piece written by Genius." << std::endl; RECORD();
+    genius_error();
+  }
+
+  vtkDataArray * psi = point_data->GetArray("potential[V]");
+  vtkDataArray * n   = point_data->GetArray("elec_density[cm-3]");
+  vtkDataArray * p   = point_data->GetArray("hole_density[cm-3]");
+  vtkDataArray * T   = point_data->GetArray("temperature[K]");
+  vtkDataArray * Tn  = point_data->GetArray("elec_temperature[K]");
+  vtkDataArray * Tp  = point_data->GetArray("hole_temperature[K]");
+
+  double concentration_scale = std::pow(cm, -3);
+
+  unsigned int n_read = 0;
+  for(vtkIdType i=0; i<node_id->GetNumberOfTuples(); ++i)
+  {
+    const unsigned int r  = static_cast<unsigned int>(node_region->GetTuple1(i));
+    const unsigned int id = static_cast<unsigned int>(node_id->GetTuple1(i));
+    if( r >= system.n_regions() ) continue;
+
+    FVM_Node * fvm_node = system.region(r)->region_fvm_node(id);
+    if( !fvm_node || !fvm_node->on_local() ) continue;
+    if( !read_nodes[r].insert(id).second ) continue;
+
+    FVM_NodeData * node_data = fvm_node->node_data();  genius_assert(node_data);
+    if(psi) node_data->psi() = psi->GetTuple1(i)*V;
+    if(n)   node_data->n()   = n->GetTuple1(i)*concentration_scale;
+    if(p)   node_data->p()   = p->GetTuple1(i)*concentration_scale;
+    if(T)   node_data->T()   = T->GetTuple1(i)*K;
+    if(Tn)  node_data->Tn()  = Tn->GetTuple1(i)*K;
+    if(Tp)  node_data->Tp()  = Tp->GetTuple1(i)*K;
+    ++n_read;
+  }
+
+  reader->Delete();
+
+  return n_read;
+}
+
 #endif
 
 
@@ -1296,6 +1843,66 @@ void VTKIO::_smooth_numerical_error(std::map<unsigned int, float> &dataset, floa
 // vtkIO class members
 //
 
+void VTKIO::read (const std::string& name)
+{
+  // only parallel vtk file written by VTKIO can be read now
+  if(name.rfind(".pvtu") > name.size()) return;
+
+#ifdef HAVE_VTK
+  SimulationSystem & system = FieldInput<SimulationSystem>::system();
+  if( system.empty() )
+  {
+    MESSAGE<<"ERROR: VTK import requires the simulation system built on the same mesh." << std::endl; RECORD();
+    genius_error();
+  }
+
+  // piece files listed in the index, relative to it
+  std::vector<std::string> pieces;
+  {
+    std::string dir;
+    if(name.rfind('/') < name.size())
+      dir = name.substr(0, name.rfind('/')+1);
+
+    std::ifstream in(name.c_str());
+    std::string line;
+    while(std::getline(in, line))
+    {
+      std::string::size_type pos = line.find("Source=\"");
+      if(pos == std::string::npos) continue;
+      pos += 8;
+      pieces.push_back(dir + line.substr(pos, line.find('"', pos)-pos));
+    }
+  }
+
+  unsigned int n_local_nodes = 0;
+  for(unsigned int r=0; r<system.n_regions(); ++r)
+    n_local_nodes += system.region(r)->n_on_local_node();
+
+  // with the same partition, the own piece holds all the on local nodes except ghost ones.
+  // read other pieces until every on local node is found
+  std::vector< std::set<unsigned int> > read_nodes(system.n_regions());
+  unsigned int n_read = 0;
+  for(unsigned int n=0; n<pieces.size() && n_read<n_local_nodes; ++n)
+  {
+    const unsigned int piece = (Genius::processor_id() + n) % pieces.size();
+    n_read += read_piece(pieces[piece], read_nodes);
+  }
+
+  // after import previous solutions, we re-init region here
+  for(unsigned int r=0; r<system.n_regions(); ++r)
+    system.region(r)->reinit_after_import();
+#endif
+}
+
+
+VTKIO::~VTKIO ()
+{
+#ifdef HAVE_VTK
+  if(_vtk_grid) _vtk_grid->Delete();
+#endif
+}
+
+
 /**
  * This method implements writing to a .vtu (VTK Unstructured Grid) file.
  * This is one of the new style XML dataformats, binary output is used to keep
@@ -1303,6 +1910,12 @@ void VTKIO::_smooth_numerical_error(std::map<unsigned int, float> &dataset, floa
  */
 void VTKIO::write (const std::string& name)
 {
+  // parallel vtk file, each processor writes its own piece
+  if(name.rfind(".pvtu") < name.size())
+  {
+    write_series(name);
+    return;
+  }
 
   const MeshBase& mesh = FieldOutput<SimulationSystem>::system().mesh();
   mesh.boundary_info->build_on_processor_side_list (_el, _sl, _il);
@@ -1334,6 +1947,7 @@ void VTKIO::write (const std::string& name)
     }
     //clean up
     _vtk_grid->Delete();
+    _vtk_grid = NULL;
 #endif
 
   }
@@ -1348,6 +1962,316 @@ void VTKIO::write (const std::string& name)
 
 
 
+void VTKIO::write_series (const std::string& name, AsyncWriter * writer)
+{
+  // vtk file extension have a ".vtu" or ".pvtu" format?
+  const bool piece_mode = name.rfind(".pvtu") < name.size();
+  if(!piece_mode && name.rfind(".vtu") > name.size()) return;
+
+#ifdef HAVE_VTK
+  const MeshBase& mesh = FieldOutput<SimulationSystem>::system().mesh();
+
+  update_cached_grid(piece_mode, writer);
+
+  // points, cells and mesh info are shared with the cached grid,
+  // solution arrays are new objects owned by this grid
+  vtkUnstructuredGrid* grid = vtkUnstructuredGrid::New();
+  if(_piece_mode || Genius::processor_id() == 0)
+    grid->ShallowCopy(_vtk_grid);
+  solution_to_vtk(mesh, grid);
+
+  if(_piece_mode)
+  {
+    // the index is small, write it here
+    if(Genius::processor_id() == 0)
+      write_pvtu_index(name, grid);
+
+    GridWriteJob * job = new GridWriteJob(grid, this->export_extra_info(), piece_file_name(name, Genius::processor_id()));
+    if(writer)
+      writer->submit(job);
+    else
+    {
+      job->run();
+      delete job;
+    }
+  }
+  // only processor 0 write VTK file
+  else if(Genius::processor_id() == 0)
+  {
+    GridWriteJob * job = new GridWriteJob(grid, this->export_extra_info(), name);
+    if(writer)
+      writer->submit(job);
+    else
+    {
+      job->run();
+      delete job;
+    }
+  }
+  else
+    grid->Delete();
+#endif
+
+#if defined(HAVE_FENV_H) && defined(DEBUG)
+  // it seems vtk may generate FE_INVALID flag. clear it here
+  feclearexcept(FE_INVALID);
+#endif
+}
+
+
+
+#ifdef HAVE_VTK
+bool VTKIO::update_cached_grid(bool piece_mode, AsyncWriter * writer)
+{
+  const MeshBase& mesh = FieldOutput<SimulationSystem>::system().mesh();
 
+  // the side list depends on mesh partition, rebuild the cached grid if it changed
+  std::vector<unsigned int>       el;
+  std::vector<unsigned short int> sl;
+  std::vector<short int>          il;
+  mesh.boundary_info->build_on_processor_side_list (el, sl, il);
 
+  bool geometry_changed = (_vtk_grid == NULL) || piece_mode != _piece_mode;
+  geometry_changed = geometry_changed || mesh.n_nodes() != _geometry_n_nodes || mesh.n_elem() != _geometry_n_elem;
+  geometry_changed = geometry_changed || el != _el || sl != _sl || il != _il;
+  Parallel::max(geometry_changed);
 
+  // the last job still references the cached geometry. the file is written
+  // while the solver computes the next output point, only one job is in flight
+  if(writer) writer->wait();
+
+  if(geometry_changed)
+  {
+    if(_vtk_grid) _vtk_grid->Delete();
+
+    _el = el;
+    _sl = sl;
+    _il = il;
+
+    _piece_mode = piece_mode;
+    _vtk_grid = vtkUnstructuredGrid::New();
+    if(_piece_mode)
+      piece_to_vtk(mesh, _vtk_grid);
+    else
+    {
+      nodes_to_vtk(mesh, _vtk_grid);
+      cells_to_vtk(mesh, _vtk_grid);
+      meshinfo_to_vtk(mesh, _vtk_grid);
+    }
+
+    _geometry_n_nodes = mesh.n_nodes();
+    _geometry_n_elem  = mesh.n_elem();
+  }
+
+  return geometry_changed;
+}
+
+
+
+/**
+ * append the raw bytes of values to buffer
+ */
+template <typename T>
+static void append_raw(const std::vector<T> & values, std::vector<char> & buffer)
+{
+  if(values.empty()) return;
+  const char * begin = reinterpret_cast<const char *>(&values[0]);
+  buffer.insert(buffer.end(), begin, begin + values.size()*sizeof(T));
+}
+
+
+/**
+ * @return the file name without directory, XDMF finds data files relative to the .xmf file
+ */
+static std::string xdmf_file_name(const std::string & name)
+{
+  const std::string::size_type pos = name.rfind('/');
+  return pos == std::string::npos ? name : name.substr(pos+1);
+}
+
+
+/**
+ * XDMF topology type of VTK cell, 1 (polyvertex) for the ones without XDMF equivalent
+ */
+static int xdmf_cell_type(int vtk_type)
+{
+  switch(vtk_type)
+  {
+    case VTK_VERTEX               : return 1;
+    case VTK_LINE                 : return 2;
+    case VTK_TRIANGLE             : return 4;
+    case VTK_QUAD                 : return 5;
+    case VTK_TETRA                : return 6;
+    case VTK_PYRAMID              : return 7;
+    case VTK_WEDGE                : return 8;
+    case VTK_HEXAHEDRON           : return 9;
+    case VTK_QUADRATIC_EDGE       : return 34;
+    case VTK_QUADRATIC_TRIANGLE   : return 36;
+    case VTK_QUADRATIC_QUAD       : return 37;
+    case VTK_QUADRATIC_TETRA      : return 38;
+    case VTK_QUADRATIC_PYRAMID    : return 39;
+    case VTK_QUADRATIC_WEDGE      : return 40;
+    case VTK_QUADRATIC_HEXAHEDRON : return 48;
+    default                       : return 1;
+  }
+}
+
+
+static void xdmf_data_item(std::ostringstream & xml, const std::string & dims, const std::string & type,
+                           unsigned int precision, std::size_t seek, const std::string & file)
+{
+  xml << "          <DataItem Dimensions=\"" << dims << "\" NumberType=\"" << type << "\" Precision=\"" << precision
+      << "\" Format=\"Binary\" Endian=\"Native\" Seek=\"" << seek << "\">" << file << "</DataItem>\n";
+}
+
+
+std::string VTKIO::xdmf_geometry(vtkUnstructuredGrid* grid, const std::string & file, std::vector<char> & buffer)
+{
+  std::ostringstream xml;
+
+  // mixed topology, polyvertex and polyline have the number of nodes after the type
+  const vtkIdType n_cells = grid->GetNumberOfCells();
+  std::vector<int> topology;
+  vtkIdList * ids = vtkIdList::New();
+  for(vtkIdType c=0; c<n_cells; ++c)
+  {
+    const int type = xdmf_cell_type(grid->GetCellType(c));
+    grid->GetCellPoints(c, ids);
+    topology.push_back(type);
+    if(type == 1 || type == 2)
+      topology.push_back(ids->GetNumberOfIds());
+    for(vtkIdType i=0; i<ids->GetNumberOfIds(); ++i)
+      topology.push_back(ids->GetId(i));
+  }
+  ids->Delete();
+
+  std::ostringstream dims;
+  dims << topology.size();
+  xml << "        <Topology TopologyType=\"Mixed\" NumberOfElements=\"" << n_cells << "\">\n";
+  xdmf_data_item(xml, dims.str(), "Int", sizeof(int), buffer.size(), file);
+  xml << "        </Topology>\n";
+  append_raw(topology, buffer);
+
+  const vtkIdType n_points = grid->GetNumberOfPoints();
+  std::vector<double> points;
+  points.reserve(3*n_points);
+  for(vtkIdType i=0; i<n_points; ++i)
+  {
+    const double * p = grid->GetPoint(i);
+    points.insert(points.end(), p, p+3);
+  }
+
+  dims.str("");
+  dims << n_points << " 3";
+  xml << "        <Geometry GeometryType=\"XYZ\">\n";
+  xdmf_data_item(xml, dims.str(), "Float", sizeof(double), buffer.size(), file);
+  xml << "        </Geometry>\n";
+  append_raw(points, buffer);
+
+  // mesh info, i.e. region and partition of cells
+  xdmf_arrays(grid->GetPointData(), 0, "Node", file, buffer, xml);
+  xdmf_arrays(grid->GetCellData(), 0, "Cell", file, buffer, xml);
+
+  return xml.str();
+}
+
+
+
+void VTKIO::xdmf_arrays(vtkDataSetAttributes * data, vtkDataSetAttributes * skip, const std::string & center,
+                        const std::string & file, std::vector<char> & buffer, std::ostringstream & xml)
+{
+  for(int a=0; a<data->GetNumberOfArrays(); ++a)
+  {
+    vtkDataArray * array = data->GetArray(a);
+    if(!array || !array->GetName()) continue;
+    if(skip && skip->GetArray(array->GetName())) continue;
+
+    const vtkIdType n_tuples = array->GetNumberOfTuples();
+    const int n_components = array->GetNumberOfComponents();
+
+    std::vector<double> values;
+    values.reserve(n_tuples*n_components);
+    for(vtkIdType i=0; i<n_tuples; ++i)
+      for(int c=0; c<n_components; ++c)
+        values.push_back(array->GetComponent(i, c));
+
+    std::ostringstream dims;
+    dims << n_tuples;
+    if(n_components > 1) dims << " " << n_components;
+
+    const char * type = n_components == 1 ? "Scalar" : (n_components == 3 ? "Vector" : "Matrix");
+    xml << "        <Attribute Name=\"" << array->GetName() << "\" AttributeType=\"" << type << "\" Center=\"" << center << "\">\n";
+    xdmf_data_item(xml, dims.str(), "Float", sizeof(double), buffer.size(), file);
+    xml << "        </Attribute>\n";
+    append_raw(values, buffer);
+  }
+}
+#endif
+
+
+
+void VTKIO::write_xdmf_series (const std::string& index_name, const std::string& name, double value, AsyncWriter * writer)
+{
+#ifdef HAVE_VTK
+  const MeshBase& mesh = FieldOutput<SimulationSystem>::system().mesh();
+
+  // XDMF grid is the whole mesh on processor 0
+  const bool geometry_changed = update_cached_grid(false, writer);
+
+  vtkUnstructuredGrid* grid = vtkUnstructuredGrid::New();
+  if(Genius::processor_id() == 0)
+    grid->ShallowCopy(_vtk_grid);
+  solution_to_vtk(mesh, grid);
+
+  // the data are copied to the job, the grid is not used by the background thread
+  if(Genius::processor_id() == 0)
+  {
+    RawWriteJob * job = new RawWriteJob;
+
+    if(geometry_changed)
+    {
+      std::ostringstream geometry_name;
+      geometry_name << index_name.substr(0, index_name.rfind(".xmf")) << ".geometry" << _xdmf_n_geometry++ << ".bin";
+      std::vector<char> & buffer = job->add_file(geometry_name.str());
+      _xdmf_geometry_xml = xdmf_geometry(_vtk_grid, xdmf_file_name(geometry_name.str()), buffer);
+    }
+
+    // only the field arrays of this point
+    std::ostringstream step;
+    step << "      <Grid Name=\"" << xdmf_file_name(name) << "\" GridType=\"Uniform\">\n"
+         << "        <Time Value=\"" << value << "\"/>\n"
+         << _xdmf_geometry_xml;
+    std::vector<char> & buffer = job->add_file(name);
+    xdmf_arrays(grid->GetPointData(), _vtk_grid->GetPointData(), "Node", xdmf_file_name(name), buffer, step);
+    xdmf_arrays(grid->GetCellData(), _vtk_grid->GetCellData(), "Cell", xdmf_file_name(name), buffer, step);
+    step << "      </Grid>\n";
+    _xdmf_steps.push_back(step.str());
+
+    std::ostringstream index;
+    index << "<?xml version=\"1.0\" ?>\n"
+          << "<Xdmf Version=\"2.0\">\n"
+          << "  <Domain>\n"
+          << "    <Grid Name=\"series\" GridType=\"Collection\" CollectionType=\"Temporal\">\n";
+    for(unsigned int n=0; n<_xdmf_steps.size(); ++n)
+      index << _xdmf_steps[n];
+    index << "    </Grid>\n"
+          << "  </Domain>\n"
+          << "</Xdmf>\n";
+    const std::string text = index.str();
+    job->add_file(index_name).assign(text.begin(), text.end());
+
+    if(writer)
+      writer->submit(job);
+    else
+    {
+      job->run();
+      delete job;
+    }
+  }
+  grid->Delete();
+#endif
+
+#if defined(HAVE_FENV_H) && defined(DEBUG)
+  // it seems vtk may generate FE_INVALID flag. clear it here
+  feclearexcept(FE_INVALID);
+#endif
+}
@@ -0,0 +1,280 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include <algorithm>
+
+#include "genius_env.h"
+#include "genius_petsc.h"
+#include "parallel.h"
+#include "dense_vector.h"
+#include "bordered_schur_pc.h"
+
+
+/*------------------------------------------------------------------
+ * PETSc shell preconditioner interface
+ */
+static PetscErrorCode __genius_bordered_pc_setup(PC pc)
+{
+  void * ctx;
+  PCShellGetContext(pc, &ctx);
+  return static_cast<BorderedSchurPC *>(ctx)->setup();
+}
+
+
+static PetscErrorCode __genius_bordered_pc_apply(PC pc, Vec r, Vec z)
+{
+  void * ctx;
+  PCShellGetContext(pc, &ctx);
+  return static_cast<BorderedSchurPC *>(ctx)->apply(r, z);
+}
+
+
+
+/*------------------------------------------------------------------
+ * constructor
+ */
+BorderedSchurPC::BorderedSchurPC(PC inner, Mat J, PetscInt border_begin)
+  : _inner(inner), _J(J), _border_begin(border_begin), _setup(false)
+{
+  // we hold the inner preconditioner after it is replaced by the shell
+  PetscObjectReference((PetscObject)_inner);
+
+  PetscInt M, N;
+  MatGetSize(_J, &M, &N);
+  _n_border = M - _border_begin;
+
+  PetscInt row_begin, row_end;
+  MatGetOwnershipRange(_J, &row_begin, &row_end);
+  _n_local_pde = std::max(std::min(row_end, _border_begin) - row_begin, static_cast<PetscInt>(0));
+  const PetscInt n_local_border = (row_end - row_begin) - _n_local_pde;
+
+  // all the border dofs belong to the last processor
+  genius_assert( n_local_border == 0 || n_local_border == _n_border );
+  genius_assert( n_local_border == 0 || Genius::is_last_processor() );
+
+  ISCreateStride(PETSC_COMM_WORLD, _n_local_pde, row_begin, 1, &_is_pde);
+  ISCreateStride(PETSC_COMM_WORLD, n_local_border, _border_begin, 1, &_is_border);
+
+  VecCreateMPI(PETSC_COMM_WORLD, _n_local_pde, PETSC_DETERMINE, &_f);
+  VecDuplicate(_f, &_y);
+  VecDuplicate(_f, &_t);
+
+  VecCreateMPI(PETSC_COMM_WORLD, n_local_border, _n_border, &_e);
+  VecDuplicate(_e, &_g);
+
+  _X.resize(_n_border);
+  for(PetscInt j=0; j<_n_border; ++j)
+    VecDuplicate(_f, &_X[j]);
+}
+
+
+
+/*------------------------------------------------------------------
+ * destructor
+ */
+BorderedSchurPC::~BorderedSchurPC()
+{
+  if(_setup)
+  {
+    MatDestroy(PetscDestroyObject(_A));
+    MatDestroy(PetscDestroyObject(_B));
+    MatDestroy(PetscDestroyObject(_C));
+    MatDestroy(PetscDestroyObject(_D));
+  }
+
+  for(unsigned int j=0; j<_X.size(); ++j)
+    VecDestroy(PetscDestroyObject(_X[j]));
+
+  VecDestroy(PetscDestroyObject(_f));
+  VecDestroy(PetscDestroyObject(_y));
+  VecDestroy(PetscDestroyObject(_t));
+  VecDestroy(PetscDestroyObject(_e));
+  VecDestroy(PetscDestroyObject(_g));
+
+  ISDestroy(PetscDestroyObject(_is_pde));
+  ISDestroy(PetscDestroyObject(_is_border));
+
+  PCDestroy(PetscDestroyObject(_inner));
+}
+
+
+
+/*------------------------------------------------------------------
+ * set pc as shell of this preconditioner
+ */
+void BorderedSchurPC::attach(PC pc)
+{
+  PetscErrorCode ierr;
+  ierr = PCSetType(pc, (char*) PCSHELL);                       genius_assert(!ierr);
+  ierr = PCShellSetContext(pc, this);                          genius_assert(!ierr);
+  ierr = PCShellSetSetUp(pc, __genius_bordered_pc_setup);      genius_assert(!ierr);
+  ierr = PCShellSetApply(pc, __genius_bordered_pc_apply);      genius_assert(!ierr);
+  ierr = PCShellSetName(pc, "Bordered Schur");                 genius_assert(!ierr);
+}
+
+
+
+/*------------------------------------------------------------------
+ * extract the blocks and build the Schur complement
+ */
+PetscErrorCode BorderedSchurPC::setup()
+{
+  START_LOG("setup()", "BorderedSchurPC");
+
+  // the nonzero pattern of jacobian does not change
+  MatReuse reuse = _setup ? MAT_REUSE_MATRIX : MAT_INITIAL_MATRIX;
+#if PETSC_VERSION_GE(3,8,0)
+  MatCreateSubMatrix(_J, _is_pde,    _is_pde,    reuse, &_A);
+  MatCreateSubMatrix(_J, _is_pde,    _is_border, reuse, &_B);
+  MatCreateSubMatrix(_J, _is_border, _is_pde,    reuse, &_C);
+  MatCreateSubMatrix(_J, _is_border, _is_border, reuse, &_D);
+#else
+  MatGetSubMatrix(_J, _is_pde,    _is_pde,    reuse, &_A);
+  MatGetSubMatrix(_J, _is_pde,    _is_border, reuse, &_B);
+  MatGetSubMatrix(_J, _is_border, _is_pde,    reuse, &_C);
+  MatGetSubMatrix(_J, _is_border, _is_border, reuse, &_D);
+#endif
+
+  // the options of inner preconditioner are set with the prefix of nonlinear solver
+  if(!_setup) PCSetFromOptions(_inner);
+  _setup = true;
+
+  // the inner preconditioner only sees the sparse PDE block
+#if PETSC_VERSION_GE(3,5,0)
+  PCSetOperators(_inner, _A, _A);
+#else
+  PCSetOperators(_inner, _A, _A, SAME_NONZERO_PATTERN);
+#endif
+  PCSetUp(_inner);
+
+  const bool last = Genius::is_last_processor();
+  if(last) _S.resize(_n_border, _n_border);
+
+  // X = A^-1*B column by column, and S = -C*X
+  for(PetscInt j=0; j<_n_border; ++j)
+  {
+    VecZeroEntries(_e);
+    if(last) VecSetValue(_e, j, 1.0, INSERT_VALUES);
+    VecAssemblyBegin(_e);
+    VecAssemblyEnd(_e);
+
+    MatMult(_B, _e, _t);
+    PCApply(_inner, _t, _X[j]);
+    MatMult(_C, _X[j], _g);
+
+    if(last)
+    {
+      PetscScalar *gg;
+      VecGetArray(_g, &gg);
+      for(PetscInt i=0; i<_n_border; ++i)
+        _S(i, j) = -gg[i];
+      VecRestoreArray(_g, &gg);
+    }
+  }
+
+  // S += D
+  if(last)
+  {
+    for(PetscInt i=0; i<_n_border; ++i)
+    {
+      PetscInt ncols;
+      const PetscInt    * cols;
+      const PetscScalar * vals;
+      MatGetRow(_D, i, &ncols, &cols, &vals);
+      for(PetscInt k=0; k<ncols; ++k)
+        _S(i, cols[k]) += vals[k];
+      MatRestoreRow(_D, i, &ncols, &cols, &vals);
+    }
+  }
+
+  STOP_LOG("setup()", "BorderedSchurPC");
+
+  return 0;
+}
+
+
+
+/*------------------------------------------------------------------
+ * block elimination with the inner preconditioner as A^-1
+ */
+PetscErrorCode BorderedSchurPC::apply(Vec r, Vec z)
+{
+  START_LOG("apply()", "BorderedSchurPC");
+
+  const bool last = Genius::is_last_processor();
+
+  // split r into f and g, the local PDE dofs are followed by border dofs
+  std::vector<PetscScalar> g(last ? _n_border : 0);
+  {
+    PetscScalar *rr, *ff;
+    VecGetArray(r, &rr);
+    VecGetArray(_f, &ff);
+    std::copy(rr, rr+_n_local_pde, ff);
+    std::copy(rr+_n_local_pde, rr+_n_local_pde+g.size(), g.begin());
+    VecRestoreArray(_f, &ff);
+    VecRestoreArray(r, &rr);
+  }
+
+  // y = A^-1*f
+  PCApply(_inner, _f, _y);
+
+  // x2 = S^-1*(g - C*y)
+  MatMult(_C, _y, _g);
+
+  std::vector<PetscScalar> x2;
+  if(last)
+  {
+    DenseVector<PetscScalar> rhs(_n_border), sol(_n_border);
+    PetscScalar *gg;
+    VecGetArray(_g, &gg);
+    for(PetscInt i=0; i<_n_border; ++i)
+      rhs(i) = g[i] - gg[i];
+    VecRestoreArray(_g, &gg);
+
+    // the LU factorization is kept after the first solve
+    _S.lu_solve(rhs, sol, true);
+
+    x2.resize(_n_border);
+    for(PetscInt i=0; i<_n_border; ++i)
+      x2[i] = sol(i);
+  }
+  Parallel::broadcast(x2, Genius::n_processors()-1);
+
+  // x1 = y - X*x2
+  for(PetscInt j=0; j<_n_border; ++j)
+    VecAXPY(_y, -x2[j], _X[j]);
+
+  // z = [x1, x2]
+  {
+    PetscScalar *zz, *yy;
+    VecGetArray(z, &zz);
+    VecGetArray(_y, &yy);
+    std::copy(yy, yy+_n_local_pde, zz);
+    if(last) std::copy(x2.begin(), x2.end(), zz+_n_local_pde);
+    VecRestoreArray(_y, &yy);
+    VecRestoreArray(z, &zz);
+  }
+
+  STOP_LOG("apply()", "BorderedSchurPC");
+
+  return 0;
+}
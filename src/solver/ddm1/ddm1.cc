@@ -865,7 +865,9 @@ void DDM1Solver::build_petsc_sens_residual(Vec x, Vec r)
   for(unsigned int n=0; n<_system.n_regions(); n++)
   {
     SimulationRegion * region = _system.region(n);
+    region->assembly_perf().start();
     region->DDM1_Function(lxx, r, add_value_flag);
+    region->assembly_perf().stopit();
   }
 
 #if defined(HAVE_FENV_H) && defined(DEBUG)
@@ -966,7 +968,9 @@ void DDM1Solver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
   for(unsigned int n=0; n<_system.n_regions(); n++)
   {
     SimulationRegion * region = _system.region(n);
+    region->assembly_perf().start();
     region->DDM1_Jacobian(lxx, Jac, add_value_flag);
+    region->assembly_perf().stopit();
   }
 
 
@@ -1044,6 +1048,132 @@ void DDM1Solver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
 
 }
 
+
+
+/*------------------------------------------------------------------
+ * evaluate the function f and its Jacobian J at x together.
+ * regions share the physical model evaluation of f and J
+ */
+void DDM1Solver::build_petsc_sens_residual_jacobian(Vec x, Vec r)
+{
+
+  START_LOG("DDM1Solver_Residual_Jacobian()", "DDM1Solver");
+
+  // scatte global solution vector x to local vector lx
+  VecScatterBegin(scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
+  VecScatterEnd  (scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
+
+  PetscScalar *lxx;
+  // get PetscScalar array contains solution from local solution vector lx
+  VecGetArray(lx, &lxx);
+
+  // clear old data
+  VecZeroEntries (r);
+  Jac->zero();
+
+  // flag for indicate ADD_VALUES operator.
+  InsertMode add_value_flag = NOT_SET_VALUES;
+
+  // evaluate governing equations of DDML1 and its jacobian in all the regions
+  for(unsigned int n=0; n<_system.n_regions(); n++)
+  {
+    SimulationRegion * region = _system.region(n);
+    region->assembly_perf().start();
+    region->DDM1_Function_Jacobian(lxx, r, Jac, add_value_flag);
+    region->assembly_perf().stopit();
+  }
+
+#if defined(HAVE_FENV_H) && defined(DEBUG)
+  genius_assert( !fetestexcept(FE_INVALID) );
+#endif
+
+  // evaluate time derivative if necessary
+  if(SolverSpecify::TimeDependent == true)
+    for(unsigned int n=0; n<_system.n_regions(); n++)
+    {
+      SimulationRegion * region = _system.region(n);
+      region->DDM1_Time_Dependent_Function(lxx, r, add_value_flag);
+      region->DDM1_Time_Dependent_Jacobian(lxx, Jac, add_value_flag);
+    }
+
+  // evaluate pseudo time step if necessary
+  if(SolverSpecify::Type == SolverSpecify::OP && SolverSpecify::PseudoTimeMethod == true)
+    for(unsigned int n=0; n<_system.n_regions(); n++)
+    {
+      SimulationRegion * region = _system.region(n);
+      region->DDM1_Pseudo_Time_Step_Function(lxx, r, add_value_flag);
+      region->DDM1_Pseudo_Time_Step_Jacobian(lxx, Jac, add_value_flag);
+    }
+
+#if defined(HAVE_FENV_H) && defined(DEBUG)
+  genius_assert( !fetestexcept(FE_INVALID) );
+#endif
+
+  // preprocess each bc
+  VecAssemblyBegin(r);
+  VecAssemblyEnd(r);
+  Jac->close(false);
+
+  {
+    std::vector<PetscInt> src_row,  dst_row,  clear_row;
+    for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
+    {
+      BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
+      bc->DDM1_Function_Preprocess(lxx, r, src_row, dst_row, clear_row);
+    }
+    //add source rows to destination rows, and clear rows
+    PetscUtils::VecAddClearRow(r, src_row, dst_row, clear_row);
+  }
+
+  {
+    std::vector<PetscInt> src_row,  dst_row,  clear_row;
+    for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
+    {
+      BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
+      bc->DDM1_Jacobian_Preprocess(lxx, Jac, src_row, dst_row, clear_row);
+    }
+    //add source rows to destination rows
+    Jac->add_row_to_row(src_row, dst_row);
+    // clear row
+    Jac->clear_row(clear_row);
+  }
+
+  // evaluate governing equations of DDML1 and its jacobian for all the boundaries
+  add_value_flag = NOT_SET_VALUES;
+  for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
+  {
+    BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
+    bc->DDM1_Function(lxx, r, add_value_flag);
+  }
+
+  add_value_flag = NOT_SET_VALUES;
+  for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
+  {
+    BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
+    bc->DDM1_Jacobian(lxx, Jac, add_value_flag);
+  }
+
+#if defined(HAVE_FENV_H) && defined(DEBUG)
+  genius_assert( !fetestexcept(FE_INVALID) );
+#endif
+
+  // restore array back to Vec
+  VecRestoreArray(lx, &lxx);
+
+  // assembly the function Vec and matrix
+  VecAssemblyBegin(r);
+  VecAssemblyEnd(r);
+  Jac->close(true);
+
+  // scale the function vec and the matrix
+  VecPointwiseMult(r, r, L);
+  MatDiagonalScale(J, L, PETSC_NULL);
+
+  STOP_LOG("DDM1Solver_Residual_Jacobian()", "DDM1Solver");
+
+}
+
+
 void DDM1Solver::set_trace_electrode(BoundaryCondition *bc)
 {
   // we needn't scatter again
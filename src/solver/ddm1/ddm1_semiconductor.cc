@@ -28,6 +28,7 @@
 #include "log.h"
 
 #include "jflux1.h"
+#include "sparse_matrix_buffer.h"
 
 using PhysicalUnit::kb;
 using PhysicalUnit::e;
@@ -152,27 +153,124 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
   bool  highfield_mob   = highfield_mobility() && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM;
 
   // precompute S-G current on each edge
-  std::vector<PetscScalar> Jn_edge_buffer;
-  std::vector<PetscScalar> Jp_edge_buffer;
+  std::vector<PetscScalar> Jn_edge_buffer(n_edge());
+  std::vector<PetscScalar> Jp_edge_buffer(n_edge());
+  // low field mobility of each on local node, it only depends on the node
+  std::vector<PetscScalar> mun_node;
+  std::vector<PetscScalar> mup_node;
   {
-    Jn_edge_buffer.reserve(n_edge());
-    Jp_edge_buffer.reserve(n_edge());
+    const int n_threads = Genius::n_threads();
+
+    // evaluate band edge and permittivity of each on local node first.
+    // each node is shared by several edges, so evaluate them once here
+    const int n_local_node = n_on_local_node();
+    std::vector<PetscScalar> Ec_node(n_local_node);
+    std::vector<PetscScalar> Ev_node(n_local_node);
+    std::vector<PetscScalar> eps_node(n_local_node);
+
+    // gather the node variables, the band models are called in batch
+    std::vector<PMI_Context> context(n_local_node);
+    std::vector<PetscScalar> n_node(n_local_node);
+    std::vector<PetscScalar> p_node(n_local_node);
+    std::vector<PetscScalar> T_node(n_local_node, T);
+    for(int i=0; i<n_local_node; ++i)
+    {
+      const FVM_Node * fvm_node = get_on_local_node(i);
+      context[i] = PMI_Context(fvm_node->root_node(), fvm_node->node_data(), SolverSpecify::clock);
+      n_node[i]  = x[fvm_node->local_offset()+1];                  // electron density
+      p_node[i]  = x[fvm_node->local_offset()+2];                  // hole density
+    }
+
+    std::vector<PetscScalar> EgNarrowToEc(n_local_node);
+    std::vector<PetscScalar> EgNarrowToEv(n_local_node);
+    std::vector<PetscScalar> Eg(n_local_node);
+    std::vector<PetscScalar> E_node;
+    if(!highfield_mob)
+    {
+      mun_node.resize(n_local_node);
+      mup_node.resize(n_local_node);
+      E_node.resize(n_local_node, 0.0);
+    }
+#ifdef HAVE_OPENMP
+#pragma omp parallel num_threads(n_threads)
+#endif
+    {
+      // each thread evaluates a contiguous block of nodes
+#ifdef HAVE_OPENMP
+      const int nt    = omp_get_num_threads();
+#else
+      const int nt    = 1;
+#endif
+      const int t     = Genius::thread_id();
+      const int begin = static_cast<int>((static_cast<long>(n_local_node)*t)/nt);
+      const int end   = static_cast<int>((static_cast<long>(n_local_node)*(t+1))/nt);
+      if(end > begin)
+      {
+        mt->band->EgNarrowToEc_Batch(end-begin, &context[begin], &p_node[begin], &n_node[begin], &T_node[begin], &EgNarrowToEc[begin]);
+        mt->band->EgNarrowToEv_Batch(end-begin, &context[begin], &p_node[begin], &n_node[begin], &T_node[begin], &EgNarrowToEv[begin]);
+        mt->band->Eg_Batch(end-begin, &context[begin], &T_node[begin], &Eg[begin]);
+        if(!highfield_mob)
+        {
+          mt->mob->ElecMob_Batch(end-begin, &context[begin], &p_node[begin], &n_node[begin], &T_node[begin],
+                                 &E_node[begin], &E_node[begin], &T_node[begin], &mun_node[begin]);
+          mt->mob->HoleMob_Batch(end-begin, &context[begin], &p_node[begin], &n_node[begin], &T_node[begin],
+                                 &E_node[begin], &E_node[begin], &T_node[begin], &mup_node[begin]);
+        }
+      }
+    }
 
-    // search all the edges of this region
-    const_edge_iterator it = edges_begin();
-    const_edge_iterator it_end = edges_end();
-    for(; it!=it_end; ++it)
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+#endif
+    for(int i=0; i<n_local_node; ++i)
     {
+      const FVM_Node * fvm_node = get_on_local_node(i);
+      const FVM_NodeData * node_data = fvm_node->node_data();
+
+      const PetscScalar V   =  x[fvm_node->local_offset()+0];                  // electrostatic potential
+      const PetscScalar n   =  n_node[i];                                      // electron density
+      const PetscScalar p   =  p_node[i];                                      // hole density
+
+      // NOTE: Here Ec, Ev are not the conduction/valence band energy.
+      // They are here for the calculation of effective driving field for electrons and holes
+      // They differ from the conduction/valence band energy by the term with kb*T*log(Nc or Nv), which
+      // takes care of the change effective DOS.
+      // Ec/Ev should not be used except when its difference between two nodes.
+      PetscScalar Ec =  -(e*V + node_data->affinity() - node_data->dEcStrain() + EgNarrowToEc[i] + kb*T*log(node_data->Nc()));
+      PetscScalar Ev =  -(e*V + node_data->affinity() - node_data->dEvStrain() - EgNarrowToEv[i] - kb*T*log(node_data->Nv()) + Eg[i]);
+      if(get_advanced_model()->Fermi)
+      {
+        Ec = Ec - kb*T*log(gamma_f(fabs(n)/node_data->Nc()));
+        Ev = Ev + kb*T*log(gamma_f(fabs(p)/node_data->Nv()));
+      }
+
+      Ec_node[i]  = Ec;
+      Ev_node[i]  = Ev;
+      eps_node[i] = node_data->eps();
+    }
+
+    // the edges are independent now, process them by threads.
+    // each thread owns a flux buffer, they are merged by thread order, which keeps the serial order of edges
+    std::vector< std::vector<PetscInt> >    iflux_thread(n_threads);
+    std::vector< std::vector<PetscScalar> > flux_thread(n_threads);
+
+    const int n_edges = n_edge();
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+#endif
+    for(int ne=0; ne<n_edges; ++ne)
+    {
+      std::vector<PetscInt>    & iflux_buffer = iflux_thread[Genius::thread_id()];
+      std::vector<PetscScalar> & flux_buffer  = flux_thread[Genius::thread_id()];
+
+      const_edge_iterator it = edges_begin() + ne;
+      const std::pair<unsigned int, unsigned int> & edge_index = edge_local_node_index(ne);
+
       // fvm_node of node1
       const FVM_Node * fvm_n1 = (*it).first;
       // fvm_node of node2
       const FVM_Node * fvm_n2 = (*it).second;
 
-      // fvm_node_data of node1
-      const FVM_NodeData * n1_data =  fvm_n1->node_data();
-      // fvm_node_data of node2
-      const FVM_NodeData * n2_data =  fvm_n2->node_data();
-
       const unsigned int n1_local_offset = fvm_n1->local_offset();
       const unsigned int n2_local_offset = fvm_n2->local_offset();
 
@@ -181,46 +279,26 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
       // build S-G current along edge
 
       //for node 1 of the edge
-      mt->mapping(fvm_n1->root_node(), n1_data, SolverSpecify::clock);
-
       const PetscScalar V1   =  x[n1_local_offset+0];                  // electrostatic potential
       const PetscScalar n1   =  x[n1_local_offset+1];                  // electron density
       const PetscScalar p1   =  x[n1_local_offset+2];                  // hole density
 
-      // NOTE: Here Ec1, Ev1 are not the conduction/valence band energy.
-      // They are here for the calculation of effective driving field for electrons and holes
-      // They differ from the conduction/valence band energy by the term with kb*T*log(Nc or Nv), which
-      // takes care of the change effective DOS.
-      // Ec/Ev should not be used except when its difference between two nodes.
-      // The same comment applies to Ec2/Ev2.
-      PetscScalar Ec1 =  -(e*V1 + n1_data->affinity() - n1_data->dEcStrain() + mt->band->EgNarrowToEc(p1, n1, T) + kb*T*log(n1_data->Nc()));
-      PetscScalar Ev1 =  -(e*V1 + n1_data->affinity() - n1_data->dEvStrain() - mt->band->EgNarrowToEv(p1, n1, T) - kb*T*log(n1_data->Nv()) + mt->band->Eg(T));
-      if(get_advanced_model()->Fermi)
-      {
-        Ec1 = Ec1 - kb*T*log(gamma_f(fabs(n1)/n1_data->Nc()));
-        Ev1 = Ev1 + kb*T*log(gamma_f(fabs(p1)/n1_data->Nv()));
-      }
-      const PetscScalar eps1 =  n1_data->eps();
+      const PetscScalar Ec1  =  Ec_node[edge_index.first];
+      const PetscScalar Ev1  =  Ev_node[edge_index.first];
+      const PetscScalar eps1 =  eps_node[edge_index.first];
 
       //for node 2 of the edge
-      mt->mapping(fvm_n2->root_node(), n2_data, SolverSpecify::clock);
-
       const PetscScalar V2   =  x[n2_local_offset+0];                   // electrostatic potential
       const PetscScalar n2   =  x[n2_local_offset+1];                   // electron density
       const PetscScalar p2   =  x[n2_local_offset+2];                   // hole density
 
-      PetscScalar Ec2 =  -(e*V2 + n2_data->affinity() - n2_data->dEcStrain() + mt->band->EgNarrowToEc(p2, n2, T) + kb*T*log(n2_data->Nc()));
-      PetscScalar Ev2 =  -(e*V2 + n2_data->affinity() - n2_data->dEvStrain() - mt->band->EgNarrowToEv(p2, n2, T) - kb*T*log(n2_data->Nv()) + mt->band->Eg(T));
-      if(get_advanced_model()->Fermi)
-      {
-        Ec2 = Ec2 - kb*T*log(gamma_f(fabs(n2)/n2_data->Nc()));
-        Ev2 = Ev2 + kb*T*log(gamma_f(fabs(p2)/n2_data->Nv()));
-      }
-      const PetscScalar eps2 =  n2_data->eps();
+      const PetscScalar Ec2  =  Ec_node[edge_index.second];
+      const PetscScalar Ev2  =  Ev_node[edge_index.second];
+      const PetscScalar eps2 =  eps_node[edge_index.second];
 
       // S-G current along the edge
-      Jn_edge_buffer.push_back( In_dd(Vt,(Ec2-Ec1)/e,n1,n2,length) );
-      Jp_edge_buffer.push_back( Ip_dd(Vt,(Ev2-Ev1)/e,p1,p2,length) );
+      Jn_edge_buffer[ne] = In_dd(Vt,(Ec2-Ec1)/e,n1,n2,length);
+      Jp_edge_buffer[ne] = Ip_dd(Vt,(Ev2-Ev1)/e,p1,p2,length);
 
 
       // poisson's equation
@@ -233,27 +311,55 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
       // ignore thoese ghost nodes
       if( fvm_n1->on_processor() )
       {
-        iflux.push_back(fvm_n1->global_offset());
-        flux.push_back(f);
+        iflux_buffer.push_back(fvm_n1->global_offset());
+        flux_buffer.push_back(f);
       }
 
       if( fvm_n2->on_processor() )
       {
-        iflux.push_back(fvm_n2->global_offset());
-        flux.push_back(-f);
+        iflux_buffer.push_back(fvm_n2->global_offset());
+        flux_buffer.push_back(-f);
       }
     }
+
+    for(int t=0; t<n_threads; ++t)
+    {
+      iflux.insert(iflux.end(), iflux_thread[t].begin(), iflux_thread[t].end());
+      flux.insert(flux.end(), flux_thread[t].begin(), flux_thread[t].end());
+    }
   }
 
   // then, search all the element in this region and process "cell" related terms
   // note, they are all local element, thus must be processed
 
-
-  const_element_iterator it = elements_begin();
-  const_element_iterator it_end = elements_end();
-  for(unsigned int nelem=0 ; it!=it_end; ++it, ++nelem)
+  // the elements are processed by threads. each thread owns the flux, band band tunneling and
+  // impact ionization buffers, they are merged by thread order, which keeps the serial order of elements.
+  // the impact ionization rate of a node is shared by elements, it is accumulated after the loop
+  const int n_threads = Genius::n_threads();
+  std::vector< std::vector<PetscInt> >    iflux_thread(n_threads);
+  std::vector< std::vector<PetscScalar> > flux_thread(n_threads);
+  std::vector< std::vector<PetscInt> >    ibbt_thread(n_threads);
+  std::vector< std::vector<PetscScalar> > bbt_thread(n_threads);
+  std::vector< std::vector<PetscInt> >    iii_thread(n_threads);
+  std::vector< std::vector<PetscScalar> > ii_thread(n_threads);
+  std::vector< std::vector< std::pair<FVM_NodeData *, PetscScalar> > > impact_ionization_thread(n_threads);
+
+  const CellEdgeTable & edge_table = this->cell_edge_table();
+  const int n_elems = n_cell();
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+#endif
+  for(int nelem=0; nelem<n_elems; ++nelem)
   {
-    const Elem * elem = *it;
+    const Elem * elem = get_region_elem(nelem);
+
+    std::vector<PetscInt>    & iflux_buffer = iflux_thread[Genius::thread_id()];
+    std::vector<PetscScalar> & flux_buffer  = flux_thread[Genius::thread_id()];
+    std::vector<PetscInt>    & ibbt_buffer  = ibbt_thread[Genius::thread_id()];
+    std::vector<PetscScalar> & bbt_buffer   = bbt_thread[Genius::thread_id()];
+    std::vector<PetscInt>    & iii_buffer   = iii_thread[Genius::thread_id()];
+    std::vector<PetscScalar> & ii_buffer    = ii_thread[Genius::thread_id()];
+    std::vector< std::pair<FVM_NodeData *, PetscScalar> > & impact_ionization_buffer = impact_ionization_thread[Genius::thread_id()];
 
     FVM_CellData * elem_data = this->get_region_elem_data(nelem);
     bool insulator_interface_elem = is_elem_on_insulator_interface(elem);
@@ -408,29 +514,29 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
     // search for all the edges this cell own
     for(unsigned int ne=0; ne<elem->n_edges(); ++ne )
     {
-      std::pair<unsigned int, unsigned int> edge_nodes;
-      elem->nodes_on_edge(ne, edge_nodes);
+      const unsigned int edge = edge_table.cell_begin[nelem] + ne;
+      const std::pair<unsigned int, unsigned int> edge_nodes(edge_table.node1[edge], edge_table.node2[edge]);
 
-      const unsigned int edge_index = this->elem_edge_index(elem, ne);
+      const unsigned int edge_index = edge_table.edge_index[edge];
 
-      const double length = elem->edge_length(ne);                         // the length of this edge
+      const double length = edge_table.length[edge];                         // the length of this edge
 
-      FVM_Node * fvm_n1 = elem->get_fvm_node(edge_nodes.first);   // fvm_node of node1
-      FVM_Node * fvm_n2 = elem->get_fvm_node(edge_nodes.second);  // fvm_node of node2
+      FVM_Node * fvm_n1 = edge_table.fvm_node1[edge];  // fvm_node of node1
+      FVM_Node * fvm_n2 = edge_table.fvm_node2[edge];  // fvm_node of node2
 
-      double partial_area = elem->partial_area_with_edge(ne);        // partial area associated with this edge
-      double partial_volume = elem->partial_volume_with_edge(ne);    // partial volume associated with this edge
+      double partial_area = edge_table.partial_area[edge];        // partial area associated with this edge
+      double partial_volume = edge_table.partial_volume[edge];    // partial volume associated with this edge
       double truncated_partial_area =  partial_area;
       double truncated_partial_volume =  partial_volume;
       if(truncation)
       {
         // use truncated partial area to avoid negative area due to bad mesh elem
-        truncated_partial_area =  this->truncated_partial_area(elem, ne);
-        truncated_partial_volume =  elem->partial_volume_with_edge_truncated(ne);
+        truncated_partial_area =  edge_table.truncated_partial_area[edge];
+        truncated_partial_volume =  edge_table.truncated_partial_volume[edge];
       }
 
 
-      bool inverse = fvm_n1->root_node()->id() > fvm_n2->root_node()->id();
+      bool inverse = edge_table.inverse[edge];
 
       FVM_NodeData * n1_data = fvm_n1->node_data();            // fvm_node_data of node1
       FVM_NodeData * n2_data = fvm_n2->node_data();            // fvm_node_data of node2
@@ -507,15 +613,20 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
             }
           }
         }
-        else // low field mobility
+        else // low field mobility, evaluated in batch before
         {
-          mt->mapping(fvm_n1->root_node(), n1_data, SolverSpecify::clock);
-          mun1 = mt->mob->ElecMob(p1, n1, T, 0, 0, T);
-          mup1 = mt->mob->HoleMob(p1, n1, T, 0, 0, T);
+          const std::pair<unsigned int, unsigned int> & local_index = edge_local_node_index(edge_index);
+          const unsigned int n1_local_index = inverse ? local_index.second : local_index.first;
+          const unsigned int n2_local_index = inverse ? local_index.first  : local_index.second;
 
+          mun1 = mun_node[n1_local_index];
+          mup1 = mup_node[n1_local_index];
+
+          mun2 = mun_node[n2_local_index];
+          mup2 = mup_node[n2_local_index];
+
+          // the generation models below are evaluated at node 2
           mt->mapping(fvm_n2->root_node(), n2_data, SolverSpecify::clock);
-          mun2 = mt->mob->ElecMob(p2, n2, T, 0, 0, T);
-          mup2 = mt->mob->HoleMob(p2, n2, T, 0, 0, T);
         }
 
 
@@ -540,12 +651,12 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
           //flux.push_back ( eps*(V2 - V1)/length*partial_area );
 
           // continuity equation of electron
-          iflux.push_back( n1_global_offset+1 );
-          flux.push_back ( Jn*truncated_partial_area );
+          iflux_buffer.push_back( n1_global_offset+1 );
+          flux_buffer.push_back ( Jn*truncated_partial_area );
 
           // continuity equation of hole
-          iflux.push_back( n1_global_offset+2 );
-          flux.push_back ( - Jp*truncated_partial_area );
+          iflux_buffer.push_back( n1_global_offset+2 );
+          flux_buffer.push_back ( - Jp*truncated_partial_area );
         }
 
         // for node 2.
@@ -556,12 +667,12 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
           //flux.push_back ( -eps*(V2 - V1)/length*partial_area );
 
           // continuity equation of electron
-          iflux.push_back( n2_global_offset+1);
-          flux.push_back ( -Jn*truncated_partial_area );
+          iflux_buffer.push_back( n2_global_offset+1);
+          flux_buffer.push_back ( -Jn*truncated_partial_area );
 
           // continuity equation of hole
-          iflux.push_back( n2_global_offset+2);
-          flux.push_back ( Jp*truncated_partial_area );
+          iflux_buffer.push_back( n2_global_offset+2);
+          flux_buffer.push_back ( Jp*truncated_partial_area );
         }
 
         if (get_advanced_model()->BandBandTunneling && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM)
@@ -573,21 +684,21 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
           if( fvm_n1->on_processor() )
           {
             // continuity equation
-            ibbt.push_back( n1_global_offset + 1);
-            bbt.push_back ( 0.5*GBTBT1*truncated_partial_volume );
+            ibbt_buffer.push_back( n1_global_offset + 1);
+            bbt_buffer.push_back ( 0.5*GBTBT1*truncated_partial_volume );
 
-            ibbt.push_back( n1_global_offset + 2);
-            bbt.push_back ( 0.5*GBTBT1*truncated_partial_volume );
+            ibbt_buffer.push_back( n1_global_offset + 2);
+            bbt_buffer.push_back ( 0.5*GBTBT1*truncated_partial_volume );
           }
 
           if( fvm_n2->on_processor() )
           {
             // continuity equation
-            ibbt.push_back( n2_global_offset + 1);
-            bbt.push_back ( 0.5*GBTBT2*truncated_partial_volume );
+            ibbt_buffer.push_back( n2_global_offset + 1);
+            bbt_buffer.push_back ( 0.5*GBTBT2*truncated_partial_volume );
 
-            ibbt.push_back( n2_global_offset + 2);
-            bbt.push_back ( 0.5*GBTBT2*truncated_partial_volume );
+            ibbt_buffer.push_back( n2_global_offset + 2);
+            bbt_buffer.push_back ( 0.5*GBTBT2*truncated_partial_volume );
           }
         }
 
@@ -636,25 +747,25 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
           if( fvm_n1->on_processor() )
           {
             // continuity equation
-            iii.push_back( n1_global_offset + 1);
-            ii.push_back ( (riin1*GIIn+riip1*GIIp)*truncated_partial_volume );
+            iii_buffer.push_back( n1_global_offset + 1);
+            ii_buffer.push_back ( (riin1*GIIn+riip1*GIIp)*truncated_partial_volume );
 
-            iii.push_back( n1_global_offset + 2);
-            ii.push_back ( (riin1*GIIn+riip1*GIIp)*truncated_partial_volume );
+            iii_buffer.push_back( n1_global_offset + 2);
+            ii_buffer.push_back ( (riin1*GIIn+riip1*GIIp)*truncated_partial_volume );
 
-            n1_data->ImpactIonization() += (riin1*GIIn+riip1*GIIp)*truncated_partial_volume/fvm_n1->volume();
+            impact_ionization_buffer.push_back( std::make_pair(n1_data, (riin1*GIIn+riip1*GIIp)*truncated_partial_volume/fvm_n1->volume()) );
           }
 
           if( fvm_n2->on_processor() )
           {
             // continuity equation
-            iii.push_back( n2_global_offset + 1);
-            ii.push_back ( (riin2*GIIn+riip2*GIIp)*truncated_partial_volume );
+            iii_buffer.push_back( n2_global_offset + 1);
+            ii_buffer.push_back ( (riin2*GIIn+riip2*GIIp)*truncated_partial_volume );
 
-            iii.push_back( n2_global_offset + 2);
-            ii.push_back ( (riin2*GIIn+riip2*GIIp)*truncated_partial_volume );
+            iii_buffer.push_back( n2_global_offset + 2);
+            ii_buffer.push_back ( (riin2*GIIn+riip2*GIIp)*truncated_partial_volume );
 
-            n2_data->ImpactIonization() += (riin2*GIIn+riip2*GIIp)*truncated_partial_volume/fvm_n2->volume();
+            impact_ionization_buffer.push_back( std::make_pair(n2_data, (riin2*GIIn+riip2*GIIp)*truncated_partial_volume/fvm_n2->volume()) );
           }
         }
       }
@@ -665,6 +776,18 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
 
   }
 
+  for(int t=0; t<n_threads; ++t)
+  {
+    iflux.insert(iflux.end(), iflux_thread[t].begin(), iflux_thread[t].end());
+    flux.insert(flux.end(), flux_thread[t].begin(), flux_thread[t].end());
+    ibbt.insert(ibbt.end(), ibbt_thread[t].begin(), ibbt_thread[t].end());
+    bbt.insert(bbt.end(), bbt_thread[t].begin(), bbt_thread[t].end());
+    iii.insert(iii.end(), iii_thread[t].begin(), iii_thread[t].end());
+    ii.insert(ii.end(), ii_thread[t].begin(), ii_thread[t].end());
+    for(unsigned int k=0; k<impact_ionization_thread[t].size(); ++k)
+      impact_ionization_thread[t][k].first->ImpactIonization() += impact_ionization_thread[t][k].second;
+  }
+
   // add into petsc vector, we should prevent zero length vector add here.
   if(iflux.size())    VecSetValues(f, iflux.size(), &iflux[0], &flux[0], ADD_VALUES);
   if(ibbt.size())     VecSetValues(f, ibbt.size(), &ibbt[0], &bbt[0], ADD_VALUES);
@@ -676,11 +799,54 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
 
   // process node related terms
   // including \rho of poisson's equation and recombination term of continuation equation
-  const_processor_node_iterator node_it = on_processor_nodes_begin();
-  const_processor_node_iterator node_it_end = on_processor_nodes_end();
-  for(; node_it!=node_it_end; ++node_it)
+  // the nodes are processed by threads, each thread owns a source buffer
+  std::vector< std::vector<PetscInt> >    isource_thread(n_threads);
+  std::vector< std::vector<PetscScalar> > source_thread(n_threads);
+
+  // the recombination rate of each on processor node, the band model is called in batch
+  const int n_nodes = n_on_processor_node();
+  std::vector<PetscScalar> R_node(n_nodes);
   {
-    const FVM_Node * fvm_node = *node_it;
+    std::vector<PMI_Context> context(n_nodes);
+    std::vector<PetscScalar> n_node(n_nodes);
+    std::vector<PetscScalar> p_node(n_nodes);
+    std::vector<PetscScalar> T_node(n_nodes, T);
+    for(int i=0; i<n_nodes; ++i)
+    {
+      const FVM_Node * fvm_node = *(on_processor_nodes_begin() + i);
+      context[i] = PMI_Context(fvm_node->root_node(), fvm_node->node_data(), SolverSpecify::clock);
+      n_node[i]  = x[fvm_node->local_offset()+1];                  // electron density
+      p_node[i]  = x[fvm_node->local_offset()+2];                  // hole density
+    }
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel num_threads(n_threads)
+#endif
+    {
+      // each thread evaluates a contiguous block of nodes
+#ifdef HAVE_OPENMP
+      const int nt    = omp_get_num_threads();
+#else
+      const int nt    = 1;
+#endif
+      const int t     = Genius::thread_id();
+      const int begin = static_cast<int>((static_cast<long>(n_nodes)*t)/nt);
+      const int end   = static_cast<int>((static_cast<long>(n_nodes)*(t+1))/nt);
+      if(end > begin)
+        mt->band->Recomb_Batch(end-begin, &context[begin], &p_node[begin], &n_node[begin], &T_node[begin], &R_node[begin]);
+    }
+  }
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+#endif
+  for(int i=0; i<n_nodes; ++i)
+  {
+    const FVM_Node * fvm_node = *(on_processor_nodes_begin() + i);
+
+    std::vector<PetscInt>    & isource_buffer = isource_thread[Genius::thread_id()];
+    std::vector<PetscScalar> & source_buffer  = source_thread[Genius::thread_id()];
+
     const FVM_NodeData * node_data = fvm_node->node_data();
 
     const unsigned int local_offset  = fvm_node->local_offset();
@@ -692,7 +858,7 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
 
     mt->mapping(fvm_node->root_node(), node_data, SolverSpecify::clock);      // map this node and its data to material database
 
-    PetscScalar R   = - mt->band->Recomb(p, n, T)*fvm_node->volume();         // the recombination term
+    PetscScalar R   = - R_node[i]*fvm_node->volume();                         // the recombination term
 
     PetscScalar doping = node_data->Net_doping();
     if(get_advanced_model()->IncompleteIonization)
@@ -703,12 +869,12 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
     // consider carrier generation
     PetscScalar Field_G = node_data->Field_G()*fvm_node->volume();
 
-    isource.push_back(global_offset+0);                                // save index in the buffer
-    isource.push_back(global_offset+1);
-    isource.push_back(global_offset+2);
-    source.push_back( rho );                                                       // save value in the buffer
-    source.push_back( R + Field_G + node_data->EIn());
-    source.push_back( R + Field_G + node_data->HIn());
+    isource_buffer.push_back(global_offset+0);                                // save index in the buffer
+    isource_buffer.push_back(global_offset+1);
+    isource_buffer.push_back(global_offset+2);
+    source_buffer.push_back( rho );                                                       // save value in the buffer
+    source_buffer.push_back( R + Field_G + node_data->EIn());
+    source_buffer.push_back( R + Field_G + node_data->HIn());
 
 
     if (get_advanced_model()->Trap)
@@ -723,8 +889,8 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
       PetscScalar TrappedC = mt->trap->Charge(true) * fvm_node->volume();
       if (TrappedC !=0)
       {
-        isource.push_back(fvm_node->global_offset());
-        source.push_back(TrappedC);
+        isource_buffer.push_back(fvm_node->global_offset());
+        source_buffer.push_back(TrappedC);
       }
 
       // calculate the rates of electron and hole capture
@@ -733,19 +899,25 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
       // contribution to the contribution to continuity equations
       if (TrapElec != 0)
       {
-        isource.push_back(global_offset+1);
+        isource_buffer.push_back(global_offset+1);
         // we lose carrier when electron get trapped, therefore negative contribution
-        source.push_back(-TrapElec);
+        source_buffer.push_back(-TrapElec);
       }
       if (TrapHole != 0)
       {
-        isource.push_back(global_offset+2);
-        source.push_back(-TrapHole);
+        isource_buffer.push_back(global_offset+2);
+        source_buffer.push_back(-TrapHole);
       }
     }
   }
 
 
+  for(int t=0; t<n_threads; ++t)
+  {
+    isource.insert(isource.end(), isource_thread[t].begin(), isource_thread[t].end());
+    source.insert(source.end(), source_thread[t].begin(), source_thread[t].end());
+  }
+
   // add into petsc vector, we should prevent zero length vector add here.
   if(isource.size())  VecSetValues(f, isource.size(), &isource[0], &source[0], ADD_VALUES);
 
@@ -772,6 +944,44 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
  */
 void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<PetscScalar> *jac, InsertMode &add_value_flag)
 {
+  DDM1_Function_Jacobian(x, PETSC_NULL, jac, add_value_flag);
+}
+
+
+
+/*---------------------------------------------------------------------
+ * build jacobian for DDML1 solver, and the function from the AD values
+ * when f is given. mobility, band edge and flux are evaluated only once
+ */
+void SemiconductorSimulationRegion::DDM1_Function_Jacobian(PetscScalar * x, Vec f, SparseMatrix<PetscScalar> *jac, InsertMode &add_value_flag)
+{
+  // also build the function
+  const bool residual = (f != PETSC_NULL);
+
+  // note, we will use ADD_VALUES to set values of vec f
+  // if the previous operator is not ADD_VALUES, we should assembly the vec first!
+  if( residual && (add_value_flag != ADD_VALUES) && (add_value_flag != NOT_SET_VALUES) )
+  {
+    VecAssemblyBegin(f);
+    VecAssemblyEnd(f);
+  }
+
+  // buffer for function
+  std::vector<PetscInt>          ires;
+  std::vector<PetscScalar>       res;
+  if( residual )
+  {
+    ires.reserve(3*(24*this->n_cell()) + 3*this->n_node());
+    res.reserve(3*(24*this->n_cell()) + 3*this->n_node());
+  }
+
+  if( residual && get_advanced_model()->ImpactIonization && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM)
+  {
+    processor_node_iterator node_it = on_processor_nodes_begin();
+    processor_node_iterator node_it_end = on_processor_nodes_end();
+    for(; node_it!=node_it_end; ++node_it)
+      (*node_it)->node_data()->ImpactIonization() = 0.0;
+  }
 
   //common used variable
   const PetscScalar T   = T_external();
@@ -779,33 +989,86 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
   bool  highfield_mob   = highfield_mobility() && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM;
 
   // precompute S-G current on each edge
-  std::vector<AutoDScalar> Jn_edge_buffer;
-  std::vector<AutoDScalar> Jp_edge_buffer;
+  std::vector<AutoDScalar6> Jn_edge_buffer(n_edge());
+  std::vector<AutoDScalar6> Jp_edge_buffer(n_edge());
   {
-    Jn_edge_buffer.reserve(n_edge());
-    Jp_edge_buffer.reserve(n_edge());
-
     //the indepedent variable number, 2 nodes * 3 variables per edge
     adtl::AutoDScalar::numdir = 6;
 
     //synchronize with material database
     mt->set_ad_num(adtl::AutoDScalar::numdir);
 
-    // search all the edges of this region
-    const_edge_iterator it = edges_begin();
-    const_edge_iterator it_end = edges_end();
-    for(; it!=it_end; ++it)
+    const int n_threads = Genius::n_threads();
+
+    // evaluate band edge and permittivity of each on local node first.
+    // each node is shared by several edges, so evaluate them once here.
+    // the node variables take the AD direction 0-2
+    const int n_local_node = n_on_local_node();
+    std::vector<AutoDScalar> Ec_node(n_local_node);
+    std::vector<AutoDScalar> Ev_node(n_local_node);
+    std::vector<PetscScalar> eps_node(n_local_node);
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+#endif
+    for(int i=0; i<n_local_node; ++i)
+    {
+      const FVM_Node * fvm_node = get_on_local_node(i);
+      const FVM_NodeData * node_data = fvm_node->node_data();
+
+      // the AD independent variable number is thread local, set it for each thread
+      adtl::AutoDScalar::numdir = 6;
+
+      // each thread maps its own node to material database, also synchronize the AD number
+      mt->mapping(PMI_Context(fvm_node->root_node(), node_data, SolverSpecify::clock, adtl::AutoDScalar::numdir));
+
+      AutoDScalar V   =  x[fvm_node->local_offset()+0];   V.setADValue(0, 1.0);               // electrostatic potential
+      AutoDScalar n   =  x[fvm_node->local_offset()+1];   n.setADValue(1, 1.0);               // electron density
+      AutoDScalar p   =  x[fvm_node->local_offset()+2];   p.setADValue(2, 1.0);               // hole density
+
+      // NOTE: Here Ec, Ev are not the conduction/valence band energy.
+      // They are here for the calculation of effective driving field for electrons and holes
+      // They differ from the conduction/valence band energy by the term with kb*T*log(Nc or Nv), which
+      // takes care of the change effective DOS.
+      // Ec/Ev should not be used except when its difference between two nodes.
+      AutoDScalar Ec =  -(e*V + node_data->affinity() - node_data->dEcStrain() + mt->band->EgNarrowToEc(p, n, T) + kb*T*log(node_data->Nc()));
+      AutoDScalar Ev =  -(e*V + node_data->affinity() - node_data->dEvStrain() - mt->band->EgNarrowToEv(p, n, T) - kb*T*log(node_data->Nv()) + mt->band->Eg(T));
+      if(get_advanced_model()->Fermi)
+      {
+        Ec = Ec - kb*T*log(gamma_f(fabs(n)/node_data->Nc()));
+        Ev = Ev + kb*T*log(gamma_f(fabs(p)/node_data->Nv()));
+      }
+
+      Ec_node[i]  = Ec;
+      Ev_node[i]  = Ev;
+      eps_node[i] = node_data->eps();
+    }
+
+    // the edges are independent now, process them by threads.
+    // each thread owns a buffer of jacobian entries, they are added to jac by thread order
+    std::vector< std::vector<PetscInt> >    jac_row_thread(n_threads);
+    std::vector< std::vector<PetscInt> >    jac_col_thread(n_threads);
+    std::vector< std::vector<PetscScalar> > jac_value_thread(n_threads);
+    std::vector< std::vector<PetscInt> >    res_row_thread(n_threads);
+    std::vector< std::vector<PetscScalar> > res_value_thread(n_threads);
+
+    const int n_edges = n_edge();
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+#endif
+    for(int ne=0; ne<n_edges; ++ne)
     {
+      std::vector<PetscInt>    & jac_row   = jac_row_thread[Genius::thread_id()];
+      std::vector<PetscInt>    & jac_col   = jac_col_thread[Genius::thread_id()];
+      std::vector<PetscScalar> & jac_value = jac_value_thread[Genius::thread_id()];
+
+      const_edge_iterator it = edges_begin() + ne;
+      const std::pair<unsigned int, unsigned int> & edge_index = edge_local_node_index(ne);
+
       // fvm_node of node1
       const FVM_Node * fvm_n1 = (*it).first;
       // fvm_node of node2
       const FVM_Node * fvm_n2 = (*it).second;
 
-      // fvm_node_data of node1
-      const FVM_NodeData * n1_data =  fvm_n1->node_data();
-      // fvm_node_data of node2
-      const FVM_NodeData * n2_data =  fvm_n2->node_data();
-
       const unsigned int n1_local_offset = fvm_n1->local_offset();
       const unsigned int n2_local_offset = fvm_n2->local_offset();
 
@@ -813,53 +1076,35 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
 
       // build S-G current along edge
 
+      // the edge stencil has exactly 6 independent variables, use the fixed size AD scalar here
 
       //for node 1 of the edge
-      mt->mapping(fvm_n1->root_node(), n1_data, SolverSpecify::clock);
+      AutoDScalar6 V1   =  x[n1_local_offset+0];   V1.setADValue(0, 1.0);               // electrostatic potential
+      AutoDScalar6 n1   =  x[n1_local_offset+1];   n1.setADValue(1, 1.0);               // electron density
+      AutoDScalar6 p1   =  x[n1_local_offset+2];   p1.setADValue(2, 1.0);               // hole density
 
-      AutoDScalar V1   =  x[n1_local_offset+0];   V1.setADValue(0, 1.0);               // electrostatic potential
-      AutoDScalar n1   =  x[n1_local_offset+1];   n1.setADValue(1, 1.0);               // electron density
-      AutoDScalar p1   =  x[n1_local_offset+2];   p1.setADValue(2, 1.0);               // hole density
-
-      // NOTE: Here Ec1, Ev1 are not the conduction/valence band energy.
-      // They are here for the calculation of effective driving field for electrons and holes
-      // They differ from the conduction/valence band energy by the term with kb*T*log(Nc or Nv), which
-      // takes care of the change effective DOS.
-      // Ec/Ev should not be used except when its difference between two nodes.
-      // The same comment applies to Ec2/Ev2.
-      AutoDScalar Ec1 =  -(e*V1 + n1_data->affinity() - n1_data->dEcStrain() + mt->band->EgNarrowToEc(p1, n1, T) + kb*T*log(n1_data->Nc()));
-      AutoDScalar Ev1 =  -(e*V1 + n1_data->affinity() - n1_data->dEvStrain() - mt->band->EgNarrowToEv(p1, n1, T) - kb*T*log(n1_data->Nv()) + mt->band->Eg(T));
-      if(get_advanced_model()->Fermi)
-      {
-        Ec1 = Ec1 - kb*T*log(gamma_f(fabs(n1)/n1_data->Nc()));
-        Ev1 = Ev1 + kb*T*log(gamma_f(fabs(p1)/n1_data->Nv()));
-      }
-      const PetscScalar eps1 =  n1_data->eps();
+      const AutoDScalar6 Ec1(Ec_node[edge_index.first], 0, 3);
+      const AutoDScalar6 Ev1(Ev_node[edge_index.first], 0, 3);
+      const PetscScalar eps1  = eps_node[edge_index.first];
 
       //for node 2 of the edge
-      mt->mapping(fvm_n2->root_node(), n2_data, SolverSpecify::clock);
-
-      AutoDScalar V2   =  x[n2_local_offset+0];   V2.setADValue(3, 1.0);                // electrostatic potential
-      AutoDScalar n2   =  x[n2_local_offset+1];   n2.setADValue(4, 1.0);                // electron density
-      AutoDScalar p2   =  x[n2_local_offset+2];   p2.setADValue(5, 1.0);                // hole density
+      AutoDScalar6 V2   =  x[n2_local_offset+0];   V2.setADValue(3, 1.0);                // electrostatic potential
+      AutoDScalar6 n2   =  x[n2_local_offset+1];   n2.setADValue(4, 1.0);                // electron density
+      AutoDScalar6 p2   =  x[n2_local_offset+2];   p2.setADValue(5, 1.0);                // hole density
 
-      AutoDScalar Ec2 =  -(e*V2 + n2_data->affinity() - n2_data->dEcStrain() + mt->band->EgNarrowToEc(p2, n2, T) + kb*T*log(n2_data->Nc()));
-      AutoDScalar Ev2 =  -(e*V2 + n2_data->affinity() - n2_data->dEvStrain() - mt->band->EgNarrowToEv(p2, n2, T) - kb*T*log(n2_data->Nv()) + mt->band->Eg(T));
-      if(get_advanced_model()->Fermi)
-      {
-        Ec2 = Ec2 - kb*T*log(gamma_f(fabs(n2)/n2_data->Nc()));
-        Ev2 = Ev2 + kb*T*log(gamma_f(fabs(p2)/n2_data->Nv()));
-      }
-      const PetscScalar eps2 =  n2_data->eps();
+      // move the AD direction of node 2 from 0-2 to 3-5
+      const AutoDScalar6 Ec2(Ec_node[edge_index.second], 3, 3);
+      const AutoDScalar6 Ev2(Ev_node[edge_index.second], 3, 3);
+      const PetscScalar eps2  = eps_node[edge_index.second];
 
       // S-G current along the edge
-      Jn_edge_buffer.push_back( In_dd(Vt,(Ec2-Ec1)/e,n1,n2,length) );
-      Jp_edge_buffer.push_back( Ip_dd(Vt,(Ev2-Ev1)/e,p1,p2,length) );
+      Jn_edge_buffer[ne] = In_dd(Vt,(Ec2-Ec1)/e,n1,n2,length);
+      Jp_edge_buffer[ne] = Ip_dd(Vt,(Ev2-Ev1)/e,p1,p2,length);
 
       // poisson's equation
 
       const PetscScalar eps = 0.5*(eps1+eps2);
-      AutoDScalar f_phi =  eps*fvm_n1->cv_surface_area(fvm_n2)*(V2 - V1)/length ;
+      AutoDScalar6 f_phi =  eps*fvm_n1->cv_surface_area(fvm_n2)*(V2 - V1)/length ;
 
       PetscInt row[2],col[2];
       row[0] = col[0] = fvm_n1->global_offset();
@@ -868,27 +1113,66 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
       // ignore thoese ghost nodes
       if( fvm_n1->on_processor() )
       {
-        jac->add( row[0],  col[0],  f_phi.getADValue(0) );
-        jac->add( row[0],  col[1],  f_phi.getADValue(3) );
+        jac_row.push_back(row[0]);  jac_col.push_back(col[0]);  jac_value.push_back( f_phi.getADValue(0) );
+        jac_row.push_back(row[0]);  jac_col.push_back(col[1]);  jac_value.push_back( f_phi.getADValue(3) );
+        if( residual )
+        {
+          res_row_thread[Genius::thread_id()].push_back(row[0]);
+          res_value_thread[Genius::thread_id()].push_back( f_phi.getValue() );
+        }
       }
 
       if( fvm_n2->on_processor() )
       {
-        jac->add( row[1],  col[0],  -f_phi.getADValue(0) );
-        jac->add( row[1],  col[1],  -f_phi.getADValue(3) );
+        jac_row.push_back(row[1]);  jac_col.push_back(col[0]);  jac_value.push_back( -f_phi.getADValue(0) );
+        jac_row.push_back(row[1]);  jac_col.push_back(col[1]);  jac_value.push_back( -f_phi.getADValue(3) );
+        if( residual )
+        {
+          res_row_thread[Genius::thread_id()].push_back(row[1]);
+          res_value_thread[Genius::thread_id()].push_back( -f_phi.getValue() );
+        }
       }
 
     }
+
+    for(int t=0; t<n_threads; ++t)
+      for(unsigned int k=0; k<jac_value_thread[t].size(); ++k)
+        jac->add( jac_row_thread[t][k],  jac_col_thread[t][k],  jac_value_thread[t][k] );
+
+    for(int t=0; t<n_threads; ++t)
+    {
+      ires.insert(ires.end(), res_row_thread[t].begin(), res_row_thread[t].end());
+      res.insert(res.end(), res_value_thread[t].begin(), res_value_thread[t].end());
+    }
   }
 
   // search all the element in this region.
   // note, they are all local element, thus must be processed
 
-  const_element_iterator it = elements_begin();
-  const_element_iterator it_end = elements_end();
-  for(; it!=it_end; ++it)
+  // the elements are processed by threads. each thread owns the jacobian and function buffers,
+  // they are merged by thread order, which keeps the serial order of elements.
+  // the impact ionization rate of a node is shared by elements, it is accumulated after the loop
+  const int n_threads = Genius::n_threads();
+  std::vector< SparseMatrixBuffer<PetscScalar> >  jac_thread(n_threads);
+  std::vector< std::vector<PetscInt> >    ires_thread(n_threads);
+  std::vector< std::vector<PetscScalar> > res_thread(n_threads);
+  std::vector< std::vector< std::pair<FVM_NodeData *, PetscScalar> > > impact_ionization_thread(n_threads);
+
+  const CellEdgeTable & edge_table = this->cell_edge_table();
+  const int n_elems = n_cell();
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+#endif
+  for(int nelem=0; nelem<n_elems; ++nelem)
   {
-    const Elem * elem = *it;
+    const Elem * elem = get_region_elem(nelem);
+
+    SparseMatrixBuffer<PetscScalar> & jac_buffer = jac_thread[Genius::thread_id()];
+    std::vector<PetscInt>    & ires_buffer = ires_thread[Genius::thread_id()];
+    std::vector<PetscScalar> & res_buffer  = res_thread[Genius::thread_id()];
+    std::vector< std::pair<FVM_NodeData *, PetscScalar> > & impact_ionization_buffer = impact_ionization_thread[Genius::thread_id()];
+
+    FVM_CellData * elem_data = this->get_region_elem_data(nelem);
     bool insulator_interface_elem = is_elem_on_insulator_interface(elem);
     bool mos_channel_elem = is_elem_in_mos_channel(elem);
     bool truncation =  SolverSpecify::VoronoiTruncation == SolverSpecify::VoronoiTruncationAlways ||
@@ -914,6 +1198,9 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
     }
 
 
+    std::vector<PetscScalar> Jn_edge_cell; //store all the edge Jn
+    std::vector<PetscScalar> Jp_edge_cell; //store all the edge Jp
+
     // first, we build the gradient of psi and fermi potential in this cell.
     VectorValue<AutoDScalar> E;
     VectorValue<AutoDScalar> Jnv;
@@ -1075,29 +1362,29 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
     // search for all the Edge this cell own
     for(unsigned int ne=0; ne<elem->n_edges(); ++ne )
     {
-      std::pair<unsigned int, unsigned int> edge_nodes;
-      elem->nodes_on_edge(ne, edge_nodes);
+      const unsigned int edge = edge_table.cell_begin[nelem] + ne;
+      const std::pair<unsigned int, unsigned int> edge_nodes(edge_table.node1[edge], edge_table.node2[edge]);
 
-      const unsigned int edge_index = this->elem_edge_index(elem, ne);
+      const unsigned int edge_index = edge_table.edge_index[edge];
 
       // the length of this edge
-      const double length = elem->edge_length(ne);
+      const double length = edge_table.length[edge];
 
-      const FVM_Node * fvm_n1 = elem->get_fvm_node(edge_nodes.first);   // fvm_node of node1
-      const FVM_Node * fvm_n2 = elem->get_fvm_node(edge_nodes.second);  // fvm_node of node2
+      const FVM_Node * fvm_n1 = edge_table.fvm_node1[edge];  // fvm_node of node1
+      const FVM_Node * fvm_n2 = edge_table.fvm_node2[edge];  // fvm_node of node2
 
-      double partial_area = elem->partial_area_with_edge(ne);        // partial area associated with this edge
-      double partial_volume = elem->partial_volume_with_edge(ne);    // partial volume associated with this edge
+      double partial_area = edge_table.partial_area[edge];        // partial area associated with this edge
+      double partial_volume = edge_table.partial_volume[edge];    // partial volume associated with this edge
       double truncated_partial_area =  partial_area;
       double truncated_partial_volume =  partial_volume;
       if(truncation)
       {
         // use truncated partial area to avoid negative area due to bad mesh elem
-        truncated_partial_area =  this->truncated_partial_area(elem, ne);
-        truncated_partial_volume =  elem->partial_volume_with_edge_truncated(ne);
+        truncated_partial_area =  edge_table.truncated_partial_area[edge];
+        truncated_partial_volume =  edge_table.truncated_partial_volume[edge];
       }
 
-      bool inverse = fvm_n1->root_node()->id() > fvm_n2->root_node()->id();       // find the correct order
+      bool inverse = edge_table.inverse[edge];       // find the correct order
 
 
       // fvm_node_data of node1
@@ -1195,8 +1482,8 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
         AutoDScalar mup = 0.5*(mup1+mup2);  // the hole mobility at the mid point of the edge, use linear interpolation
 
         // S-G current along the edge
-        const AutoDScalar & Jn_edge = Jn_edge_buffer[edge_index];
-        const AutoDScalar & Jp_edge = Jp_edge_buffer[edge_index];
+        const AutoDScalar6 & Jn_edge = Jn_edge_buffer[edge_index];
+        const AutoDScalar6 & Jp_edge = Jp_edge_buffer[edge_index];
 
         // shift AD value since they have different location
         unsigned int order[6];
@@ -1219,8 +1506,11 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
           order[5]= 3*edge_nodes.second+2;
         }
 
-        AutoDScalar Jn = (inverse ? -1.0 : 1.0)*mun*AutoDScalar(Jn_edge, order, 6);
-        AutoDScalar Jp = (inverse ? -1.0 : 1.0)*mup*AutoDScalar(Jp_edge, order, 6);
+        AutoDScalar Jn = (inverse ? -1.0 : 1.0)*mun*Jn_edge.expand(order);
+        AutoDScalar Jp = (inverse ? -1.0 : 1.0)*mup*Jp_edge.expand(order);
+
+        Jn_edge_cell.push_back(Jn.getValue());
+        Jp_edge_cell.push_back(Jp.getValue());
 
         // ignore thoese ghost nodes (ghost nodes is local but with different processor_id())
         if( fvm_n1->on_processor() )
@@ -1229,8 +1519,13 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
           AutoDScalar f_Jn  =  Jn*truncated_partial_area ;
           AutoDScalar f_Jp  = -Jp*truncated_partial_area;
           // general coding always has some overkill... bypass it.
-          jac->add_row(  row[1],  cell_col.size(),  &cell_col[0],  f_Jn.getADValue() );
-          jac->add_row(  row[2],  cell_col.size(),  &cell_col[0],  f_Jp.getADValue() );
+          jac_buffer.add_row(  row[1],  cell_col.size(),  &cell_col[0],  f_Jn.getADValue() );
+          jac_buffer.add_row(  row[2],  cell_col.size(),  &cell_col[0],  f_Jp.getADValue() );
+          if( residual )
+          {
+            ires_buffer.push_back(row[1]);  res_buffer.push_back(f_Jn.getValue());
+            ires_buffer.push_back(row[2]);  res_buffer.push_back(f_Jp.getValue());
+          }
         }
 
         if( fvm_n2->on_processor() )
@@ -1238,8 +1533,13 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
           // flux on edge
           AutoDScalar f_Jn  = -Jn*truncated_partial_area ;
           AutoDScalar f_Jp  =  Jp*truncated_partial_area;
-          jac->add_row(  row[4],  cell_col.size(),  &cell_col[0],  f_Jn.getADValue() );
-          jac->add_row(  row[5],  cell_col.size(),  &cell_col[0],  f_Jp.getADValue() );
+          jac_buffer.add_row(  row[4],  cell_col.size(),  &cell_col[0],  f_Jn.getADValue() );
+          jac_buffer.add_row(  row[5],  cell_col.size(),  &cell_col[0],  f_Jp.getADValue() );
+          if( residual )
+          {
+            ires_buffer.push_back(row[4]);  res_buffer.push_back(f_Jn.getValue());
+            ires_buffer.push_back(row[5]);  res_buffer.push_back(f_Jp.getValue());
+          }
         }
 
         // BandBandTunneling && ImpactIonization
@@ -1253,16 +1553,26 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
           {
             // continuity equation
             AutoDScalar continuity = 0.5*GBTBT1*truncated_partial_volume;
-            jac->add_row(  row[1],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
-            jac->add_row(  row[2],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
+            jac_buffer.add_row(  row[1],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
+            jac_buffer.add_row(  row[2],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
+            if( residual )
+            {
+              ires_buffer.push_back(row[1]);  res_buffer.push_back(continuity.getValue());
+              ires_buffer.push_back(row[2]);  res_buffer.push_back(continuity.getValue());
+            }
           }
 
           if( fvm_n2->on_processor() )
           {
             // continuity equation
             AutoDScalar continuity = 0.5*GBTBT2*truncated_partial_volume;
-            jac->add_row(  row[4],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
-            jac->add_row(  row[5],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
+            jac_buffer.add_row(  row[4],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
+            jac_buffer.add_row(  row[5],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
+            if( residual )
+            {
+              ires_buffer.push_back(row[4]);  res_buffer.push_back(continuity.getValue());
+              ires_buffer.push_back(row[5]);  res_buffer.push_back(continuity.getValue());
+            }
           }
         }
 
@@ -1316,8 +1626,14 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
             // continuity equation
             AutoDScalar electron_continuity = (riin1*GIIn+riip1*GIIp)*truncated_partial_volume ;
             AutoDScalar hole_continuity     = (riin1*GIIn+riip1*GIIp)*truncated_partial_volume ;
-            jac->add_row(  row[1],  cell_col.size(),  &cell_col[0],  electron_continuity.getADValue() );
-            jac->add_row(  row[2],  cell_col.size(),  &cell_col[0],  hole_continuity.getADValue() );
+            jac_buffer.add_row(  row[1],  cell_col.size(),  &cell_col[0],  electron_continuity.getADValue() );
+            jac_buffer.add_row(  row[2],  cell_col.size(),  &cell_col[0],  hole_continuity.getADValue() );
+            if( residual )
+            {
+              ires_buffer.push_back(row[1]);  res_buffer.push_back(electron_continuity.getValue());
+              ires_buffer.push_back(row[2]);  res_buffer.push_back(hole_continuity.getValue());
+              impact_ionization_buffer.push_back( std::make_pair(edge_table.fvm_node1[edge]->node_data(), electron_continuity.getValue()/fvm_n1->volume()) );
+            }
           }
 
           if( fvm_n2->on_processor() )
@@ -1325,16 +1641,38 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
             // continuity equation
             AutoDScalar electron_continuity = (riin2*GIIn+riip2*GIIp)*truncated_partial_volume ;
             AutoDScalar hole_continuity     = (riin2*GIIn+riip2*GIIp)*truncated_partial_volume ;
-            jac->add_row(  row[4],  cell_col.size(),  &cell_col[0],  electron_continuity.getADValue() );
-            jac->add_row(  row[5],  cell_col.size(),  &cell_col[0],  hole_continuity.getADValue() );
+            jac_buffer.add_row(  row[4],  cell_col.size(),  &cell_col[0],  electron_continuity.getADValue() );
+            jac_buffer.add_row(  row[5],  cell_col.size(),  &cell_col[0],  hole_continuity.getADValue() );
+            if( residual )
+            {
+              ires_buffer.push_back(row[4]);  res_buffer.push_back(electron_continuity.getValue());
+              ires_buffer.push_back(row[5]);  res_buffer.push_back(hole_continuity.getValue());
+              impact_ionization_buffer.push_back( std::make_pair(edge_table.fvm_node2[edge]->node_data(), electron_continuity.getValue()/fvm_n2->volume()) );
+            }
           }
         }
 
       }
     }// end of scan all edges of the cell
 
+    // the average cell electron/hole current density vector
+    if( residual )
+    {
+      elem_data->Jn() = -elem->reconstruct_vector(Jn_edge_cell);
+      elem_data->Jp() =  elem->reconstruct_vector(Jp_edge_cell);
+    }
+
   }// end of scan all the cell
 
+  for(int t=0; t<n_threads; ++t)
+  {
+    jac_thread[t].add_to(jac);
+    ires.insert(ires.end(), ires_thread[t].begin(), ires_thread[t].end());
+    res.insert(res.end(), res_thread[t].begin(), res_thread[t].end());
+    for(unsigned int k=0; k<impact_ionization_thread[t].size(); ++k)
+      impact_ionization_thread[t][k].first->ImpactIonization() += impact_ionization_thread[t][k].second;
+  }
+
 
 #if defined(HAVE_FENV_H) && defined(DEBUG)
   genius_assert( !fetestexcept(FE_INVALID) );
@@ -1342,18 +1680,28 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
 
   // process node related terms
   // including \rho of poisson's equation and recombination term of continuation equation
+  // the nodes are processed by threads with their own jacobian and function buffers
+  for(int t=0; t<n_threads; ++t)
+  {
+    jac_thread[t].clear();
+    ires_thread[t].clear();
+    res_thread[t].clear();
+  }
 
-  //the indepedent variable number, 3 for each node
-  adtl::AutoDScalar::numdir = 3;
+  const int n_nodes = n_on_processor_node();
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+#endif
+  for(int i=0; i<n_nodes; ++i)
+  {
+    const FVM_Node * fvm_node = *(on_processor_nodes_begin() + i);
 
-  //synchronize with material database
-  mt->set_ad_num(adtl::AutoDScalar::numdir);
+    SparseMatrixBuffer<PetscScalar> & jac_buffer = jac_thread[Genius::thread_id()];
+    std::vector<PetscInt>    & ires_buffer = ires_thread[Genius::thread_id()];
+    std::vector<PetscScalar> & res_buffer  = res_thread[Genius::thread_id()];
 
-  const_processor_node_iterator node_it = on_processor_nodes_begin();
-  const_processor_node_iterator node_it_end = on_processor_nodes_end();
-  for(; node_it!=node_it_end; ++node_it)
-  {
-    const FVM_Node * fvm_node = *node_it;
+    //the indepedent variable number, 3 for each node. it is thread local, set it for each thread
+    adtl::AutoDScalar::numdir = 3;
 
     const unsigned int local_offset = fvm_node->local_offset();
     const unsigned int global_offset = fvm_node->global_offset();
@@ -1365,7 +1713,8 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
     AutoDScalar n(x[local_offset+1]);   n.setADValue(1, 1.0);              // electron density
     AutoDScalar p(x[local_offset+2]);   p.setADValue(2, 1.0);              // hole density
 
-    mt->mapping(fvm_node->root_node(), node_data, SolverSpecify::clock);                   // map this node and its data to material database
+    // map this node and its data to material database, also synchronize the AD number
+    mt->mapping(PMI_Context(fvm_node->root_node(), node_data, SolverSpecify::clock, adtl::AutoDScalar::numdir));
 
     AutoDScalar R   = - mt->band->Recomb(p, n, T)*fvm_node->volume();                      // the recombination term
 
@@ -1377,9 +1726,18 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
 
 
     // ADD to Jacobian matrix,
-    jac->add_row(  index[0],  3,  &index[0],  rho.getADValue() );
-    jac->add_row(  index[1],  3,  &index[0],  R.getADValue() );
-    jac->add_row(  index[2],  3,  &index[0],  R.getADValue() );
+    jac_buffer.add_row(  index[0],  3,  &index[0],  rho.getADValue() );
+    jac_buffer.add_row(  index[1],  3,  &index[0],  R.getADValue() );
+    jac_buffer.add_row(  index[2],  3,  &index[0],  R.getADValue() );
+
+    if( residual )
+    {
+      // consider carrier generation, which is independent of solution
+      PetscScalar Field_G = node_data->Field_G()*fvm_node->volume();
+      ires_buffer.push_back(index[0]);  res_buffer.push_back(rho.getValue());
+      ires_buffer.push_back(index[1]);  res_buffer.push_back(R.getValue() + Field_G + node_data->EIn());
+      ires_buffer.push_back(index[2]);  res_buffer.push_back(R.getValue() + Field_G + node_data->HIn());
+    }
 
     if (get_advanced_model()->Trap)
     {
@@ -1387,17 +1745,34 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
       mt->trap->Calculate(true,p,n,ni,T);
 
       AutoDScalar TrappedC = mt->trap->ChargeAD(true) * fvm_node->volume();
-      jac->add_row(  index[0],  3,  &index[0],  TrappedC.getADValue() );
+      jac_buffer.add_row(  index[0],  3,  &index[0],  TrappedC.getADValue() );
 
       AutoDScalar GElec = - mt->trap->ElectronTrapRate(true,n,ni,T) * fvm_node->volume();
       AutoDScalar GHole = - mt->trap->HoleTrapRate    (true,p,ni,T) * fvm_node->volume();
 
-      jac->add_row(  index[1],  3,  &index[0],  GElec.getADValue() );
-      jac->add_row(  index[2],  3,  &index[0],  GHole.getADValue() );
+      jac_buffer.add_row(  index[1],  3,  &index[0],  GElec.getADValue() );
+      jac_buffer.add_row(  index[2],  3,  &index[0],  GHole.getADValue() );
+
+      if( residual )
+      {
+        ires_buffer.push_back(index[0]);  res_buffer.push_back(TrappedC.getValue());
+        ires_buffer.push_back(index[1]);  res_buffer.push_back(GElec.getValue());
+        ires_buffer.push_back(index[2]);  res_buffer.push_back(GHole.getValue());
+      }
     }
   }
 
 
+  for(int t=0; t<n_threads; ++t)
+  {
+    jac_thread[t].add_to(jac);
+    ires.insert(ires.end(), ires_thread[t].begin(), ires_thread[t].end());
+    res.insert(res.end(), res_thread[t].begin(), res_thread[t].end());
+  }
+
+  // add into petsc vector, we should prevent zero length vector add here.
+  if(ires.size())  VecSetValues(f, ires.size(), &ires[0], &res[0], ADD_VALUES);
+
   // boundary condition should be processed later!
 
   // the last operator is ADD_VALUES
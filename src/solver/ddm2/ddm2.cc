@@ -906,7 +906,9 @@ void DDM2Solver::build_petsc_sens_residual(Vec x, Vec r)
   for(unsigned int n=0; n<_system.n_regions(); n++)
   {
     SimulationRegion * region = _system.region(n);
+    region->assembly_perf().start();
     region->DDM2_Function(lxx, r, add_value_flag);
+    region->assembly_perf().stopit();
   }
 
 #if defined(HAVE_FENV_H) && defined(DEBUG)
@@ -999,7 +1001,9 @@ void DDM2Solver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
   for(unsigned int n=0; n<_system.n_regions(); n++)
   {
     SimulationRegion * region = _system.region(n);
+    region->assembly_perf().start();
     region->DDM2_Jacobian(lxx, Jac, add_value_flag);
+    region->assembly_perf().stopit();
   }
 
 #if defined(HAVE_FENV_H) && defined(DEBUG)
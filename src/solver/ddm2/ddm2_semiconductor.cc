@@ -26,6 +26,7 @@
 
 #include "log.h"
 #include "jflux2.h"
+#include "sparse_matrix_buffer.h"
 
 
 using PhysicalUnit::kb;
@@ -118,11 +119,26 @@ void SemiconductorSimulationRegion::DDM2_Function(PetscScalar * x, Vec f, Insert
   // first, search all the element in this region and process "cell" related terms
   // note, they are all local element, thus must be processed
 
-  const_element_iterator it = elements_begin();
-  const_element_iterator it_end = elements_end();
-  for(unsigned int nelem=0 ; it!=it_end; ++it, ++nelem)
+  // the elements are processed by threads. each thread owns a function buffer, they are merged
+  // by thread order, which keeps the serial order of elements.
+  // the impact ionization rate of a node is shared by elements, it is accumulated after the loop
+  const int n_threads = Genius::n_threads();
+  std::vector< std::vector<int> >         iy_thread(n_threads);
+  std::vector< std::vector<PetscScalar> > y_thread(n_threads);
+  std::vector< std::vector< std::pair<FVM_NodeData *, PetscScalar> > > impact_ionization_thread(n_threads);
+
+  const CellEdgeTable & edge_table = this->cell_edge_table();
+  const int n_elems = n_cell();
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+#endif
+  for(int nelem=0; nelem<n_elems; ++nelem)
   {
-    const Elem * elem = *it;
+    const Elem * elem = get_region_elem(nelem);
+
+    std::vector<int>         & iy_buffer = iy_thread[Genius::thread_id()];
+    std::vector<PetscScalar> & y_buffer  = y_thread[Genius::thread_id()];
+    std::vector< std::pair<FVM_NodeData *, PetscScalar> > & impact_ionization_buffer = impact_ionization_thread[Genius::thread_id()];
 
     FVM_CellData * elem_data = this->get_region_elem_data(nelem);
 
@@ -286,16 +302,16 @@ void SemiconductorSimulationRegion::DDM2_Function(PetscScalar * x, Vec f, Insert
     // search for all the edges this cell own
     for(unsigned int ne=0; ne<elem->n_edges(); ++ne )
     {
-      std::pair<unsigned int, unsigned int> edge_nodes;
-      elem->nodes_on_edge(ne, edge_nodes);
+      const unsigned int edge = edge_table.cell_begin[nelem] + ne;
+      const std::pair<unsigned int, unsigned int> edge_nodes(edge_table.node1[edge], edge_table.node2[edge]);
 
       // the length of this edge
-      const double length = elem->edge_length(ne);
+      const double length = edge_table.length[edge];
 
       // fvm_node of node1
-      FVM_Node * fvm_n1 = elem->get_fvm_node(edge_nodes.first);
+      FVM_Node * fvm_n1 = edge_table.fvm_node1[edge];
       // fvm_node of node2
-      FVM_Node * fvm_n2 = elem->get_fvm_node(edge_nodes.second);
+      FVM_Node * fvm_n2 = edge_table.fvm_node2[edge];
 
       // fvm_node_data of node1
       FVM_NodeData * n1_data =  fvm_n1->node_data();
@@ -303,16 +319,16 @@ void SemiconductorSimulationRegion::DDM2_Function(PetscScalar * x, Vec f, Insert
       FVM_NodeData * n2_data =  fvm_n2->node_data();
 
       // partial area associated with this edge
-      double partial_area = elem->partial_area_with_edge(ne);
-      double partial_volume = elem->partial_volume_with_edge(ne);
+      double partial_area = edge_table.partial_area[edge];
+      double partial_volume = edge_table.partial_volume[edge];
 
       double truncated_partial_area =  partial_area;
       double truncated_partial_volume =  partial_volume;
       if(truncation)
       {
         // use truncated partial area to avoid negative area due to bad mesh elem
-        truncated_partial_area =  this->truncated_partial_area(elem, ne);
-        truncated_partial_volume =  elem->partial_volume_with_edge_truncated(ne);
+        truncated_partial_area =  edge_table.truncated_partial_area[edge];
+        truncated_partial_volume =  edge_table.truncated_partial_volume[edge];
       }
 
       const unsigned int n1_local_offset = fvm_n1->local_offset();
@@ -436,20 +452,20 @@ void SemiconductorSimulationRegion::DDM2_Function(PetscScalar * x, Vec f, Insert
         if( fvm_n1->root_node()->processor_id()==Genius::processor_id() )
         {
           // poisson's equation
-          iy.push_back( fvm_n1->global_offset()+0 );
-          y.push_back ( eps*(V2 - V1)/length*partial_area );
+          iy_buffer.push_back( fvm_n1->global_offset()+0 );
+          y_buffer.push_back ( eps*(V2 - V1)/length*partial_area );
 
           // continuity equation of electron
-          iy.push_back( fvm_n1->global_offset()+1 );
-          y.push_back ( Jn*truncated_partial_area );
+          iy_buffer.push_back( fvm_n1->global_offset()+1 );
+          y_buffer.push_back ( Jn*truncated_partial_area );
 
           // continuity equation of hole
-          iy.push_back( fvm_n1->global_offset()+2 );
-          y.push_back ( - Jp*truncated_partial_area );
+          iy_buffer.push_back( fvm_n1->global_offset()+2 );
+          y_buffer.push_back ( - Jp*truncated_partial_area );
 
           // heat transport equation
-          iy.push_back( fvm_n1->global_offset()+3 );
-          y.push_back ( kap*(T2 - T1)/length*partial_area + H*truncated_partial_area);
+          iy_buffer.push_back( fvm_n1->global_offset()+3 );
+          y_buffer.push_back ( kap*(T2 - T1)/length*partial_area + H*truncated_partial_area);
 
         }
 
@@ -457,20 +473,20 @@ void SemiconductorSimulationRegion::DDM2_Function(PetscScalar * x, Vec f, Insert
         if( fvm_n2->root_node()->processor_id()==Genius::processor_id() )
         {
           // poisson's equation
-          iy.push_back( fvm_n2->global_offset()+0 );
-          y.push_back ( eps*(V1 - V2)/length*partial_area );
+          iy_buffer.push_back( fvm_n2->global_offset()+0 );
+          y_buffer.push_back ( eps*(V1 - V2)/length*partial_area );
 
           // continuity equation of electron
-          iy.push_back( fvm_n2->global_offset()+1 );
-          y.push_back ( - Jn*truncated_partial_area );
+          iy_buffer.push_back( fvm_n2->global_offset()+1 );
+          y_buffer.push_back ( - Jn*truncated_partial_area );
 
           // continuity equation of hole
-          iy.push_back( fvm_n2->global_offset()+2 );
-          y.push_back ( Jp*truncated_partial_area );
+          iy_buffer.push_back( fvm_n2->global_offset()+2 );
+          y_buffer.push_back ( Jp*truncated_partial_area );
 
           // heat transport equation
-          iy.push_back( fvm_n2->global_offset()+3 );
-          y.push_back ( kap*(T1 - T2)/length*partial_area + H*truncated_partial_area);
+          iy_buffer.push_back( fvm_n2->global_offset()+3 );
+          y_buffer.push_back ( kap*(T1 - T2)/length*partial_area + H*truncated_partial_area);
         }
 
         if (get_advanced_model()->BandBandTunneling && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM)
@@ -481,21 +497,21 @@ void SemiconductorSimulationRegion::DDM2_Function(PetscScalar * x, Vec f, Insert
           if( fvm_n1->root_node()->processor_id()==Genius::processor_id() )
           {
             // continuity equation
-            iy.push_back( fvm_n1->global_offset() + 1);
-            y.push_back ( 0.5*GBTBT1*truncated_partial_volume );
+            iy_buffer.push_back( fvm_n1->global_offset() + 1);
+            y_buffer.push_back ( 0.5*GBTBT1*truncated_partial_volume );
 
-            iy.push_back( fvm_n1->global_offset() + 2);
-            y.push_back ( 0.5*GBTBT1*truncated_partial_volume );
+            iy_buffer.push_back( fvm_n1->global_offset() + 2);
+            y_buffer.push_back ( 0.5*GBTBT1*truncated_partial_volume );
           }
 
           if( fvm_n2->root_node()->processor_id()==Genius::processor_id() )
           {
             // continuity equation
-            iy.push_back( fvm_n2->global_offset() + 1);
-            y.push_back ( 0.5*GBTBT2*truncated_partial_volume );
+            iy_buffer.push_back( fvm_n2->global_offset() + 1);
+            y_buffer.push_back ( 0.5*GBTBT2*truncated_partial_volume );
 
-            iy.push_back( fvm_n2->global_offset() + 2);
-            y.push_back ( 0.5*GBTBT2*truncated_partial_volume );
+            iy_buffer.push_back( fvm_n2->global_offset() + 2);
+            y_buffer.push_back ( 0.5*GBTBT2*truncated_partial_volume );
           }
         }
 
@@ -546,25 +562,25 @@ void SemiconductorSimulationRegion::DDM2_Function(PetscScalar * x, Vec f, Insert
           if( fvm_n1->root_node()->processor_id()==Genius::processor_id() )
           {
             // continuity equation
-            iy.push_back( fvm_n1->global_offset() + 1);
-            y.push_back ( (riin1*GIIn+riip1*GIIp)*truncated_partial_volume );
+            iy_buffer.push_back( fvm_n1->global_offset() + 1);
+            y_buffer.push_back ( (riin1*GIIn+riip1*GIIp)*truncated_partial_volume );
 
-            iy.push_back( fvm_n1->global_offset() + 2);
-            y.push_back ( (riin1*GIIn+riip1*GIIp)*truncated_partial_volume );
+            iy_buffer.push_back( fvm_n1->global_offset() + 2);
+            y_buffer.push_back ( (riin1*GIIn+riip1*GIIp)*truncated_partial_volume );
 
-            n1_data->ImpactIonization() += (riin1*GIIn+riip1*GIIp)*truncated_partial_volume/fvm_n1->volume();
+            impact_ionization_buffer.push_back( std::make_pair(n1_data, (riin1*GIIn+riip1*GIIp)*truncated_partial_volume/fvm_n1->volume()) );
           }
 
           if( fvm_n2->root_node()->processor_id()==Genius::processor_id() )
           {
             // continuity equation
-            iy.push_back( fvm_n2->global_offset() + 1);
-            y.push_back ( (riin2*GIIn+riip2*GIIp)*truncated_partial_volume );
+            iy_buffer.push_back( fvm_n2->global_offset() + 1);
+            y_buffer.push_back ( (riin2*GIIn+riip2*GIIp)*truncated_partial_volume );
 
-            iy.push_back( fvm_n2->global_offset() + 2);
-            y.push_back ( (riin2*GIIn+riip2*GIIp)*truncated_partial_volume );
+            iy_buffer.push_back( fvm_n2->global_offset() + 2);
+            y_buffer.push_back ( (riin2*GIIn+riip2*GIIp)*truncated_partial_volume );
 
-            n2_data->ImpactIonization() += (riin2*GIIn+riip2*GIIp)*truncated_partial_volume/fvm_n2->volume();
+            impact_ionization_buffer.push_back( std::make_pair(n2_data, (riin2*GIIn+riip2*GIIp)*truncated_partial_volume/fvm_n2->volume()) );
           }
         }
 
@@ -578,17 +594,34 @@ void SemiconductorSimulationRegion::DDM2_Function(PetscScalar * x, Vec f, Insert
 
   }
 
+  for(int t=0; t<n_threads; ++t)
+  {
+    iy.insert(iy.end(), iy_thread[t].begin(), iy_thread[t].end());
+    y.insert(y.end(), y_thread[t].begin(), y_thread[t].end());
+    for(unsigned int k=0; k<impact_ionization_thread[t].size(); ++k)
+      impact_ionization_thread[t][k].first->ImpactIonization() += impact_ionization_thread[t][k].second;
+    iy_thread[t].clear();
+    y_thread[t].clear();
+  }
+
 #if defined(HAVE_FENV_H) && defined(DEBUG)
   genius_assert( !fetestexcept(FE_INVALID) );
 #endif
 
   // process node related terms
   // including \rho of poisson's equation and recombination term of continuation equation
-  const_processor_node_iterator node_it = on_processor_nodes_begin();
-  const_processor_node_iterator node_it_end = on_processor_nodes_end();
-  for(; node_it!=node_it_end; ++node_it)
+  // the nodes are processed by threads with their own function buffers
+  const int n_nodes = n_on_processor_node();
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+#endif
+  for(int i=0; i<n_nodes; ++i)
   {
-    const FVM_Node * fvm_node = *node_it;
+    const FVM_Node * fvm_node = *(on_processor_nodes_begin() + i);
+
+    std::vector<int>         & iy_buffer = iy_thread[Genius::thread_id()];
+    std::vector<PetscScalar> & y_buffer  = y_thread[Genius::thread_id()];
+
     const FVM_NodeData * node_data = fvm_node->node_data();
 
     const unsigned int local_offset  = fvm_node->local_offset();
@@ -609,15 +642,15 @@ void SemiconductorSimulationRegion::DDM2_Function(PetscScalar * x, Vec f, Insert
     PetscScalar Field_G = node_data->Field_G()*fvm_node->volume();
     PetscScalar OptQ = node_data->OptQ()*fvm_node->volume();
 
-    iy.push_back(global_offset+0);                                // save index in the buffer
-    iy.push_back(global_offset+1);
-    iy.push_back(global_offset+2);
-    iy.push_back(global_offset+3);
+    iy_buffer.push_back(global_offset+0);                                // save index in the buffer
+    iy_buffer.push_back(global_offset+1);
+    iy_buffer.push_back(global_offset+2);
+    iy_buffer.push_back(global_offset+3);
 
-    y.push_back( rho );                                                       // save value in the buffer
-    y.push_back( Field_G - R  + node_data->EIn());
-    y.push_back( Field_G - R  + node_data->HIn());
-    y.push_back( HR + OptQ );
+    y_buffer.push_back( rho );                                                       // save value in the buffer
+    y_buffer.push_back( Field_G - R  + node_data->EIn());
+    y_buffer.push_back( Field_G - R  + node_data->HIn());
+    y_buffer.push_back( HR + OptQ );
 
     if (get_advanced_model()->Trap)
     {
@@ -631,8 +664,8 @@ void SemiconductorSimulationRegion::DDM2_Function(PetscScalar * x, Vec f, Insert
       PetscScalar TrappedC = mt->trap->Charge(true) * fvm_node->volume();
       if (TrappedC !=0)
       {
-        iy.push_back(fvm_node->global_offset());
-        y.push_back(TrappedC);
+        iy_buffer.push_back(fvm_node->global_offset());
+        y_buffer.push_back(TrappedC);
       }
 
       // calculate the rates of electron and hole capture
@@ -641,26 +674,32 @@ void SemiconductorSimulationRegion::DDM2_Function(PetscScalar * x, Vec f, Insert
       // contribution to the contribution to continuity equations
       if (TrapElec != 0)
       {
-        iy.push_back(fvm_node->global_offset()+1);
+        iy_buffer.push_back(fvm_node->global_offset()+1);
         // we lose carrier when electron get trapped, therefore negative contribution
-        y.push_back(-TrapElec);
+        y_buffer.push_back(-TrapElec);
       }
       if (TrapHole != 0)
       {
-        iy.push_back(fvm_node->global_offset()+2);
-        y.push_back(-TrapHole);
+        iy_buffer.push_back(fvm_node->global_offset()+2);
+        y_buffer.push_back(-TrapHole);
       }
 
       PetscScalar EcEi = 0.5*node_data->Eg() - kb*T*log(node_data->Nc()/node_data->Nv());
       PetscScalar EiEv = 0.5*node_data->Eg() + kb*T*log(node_data->Nc()/node_data->Nv());
       PetscScalar H = mt->trap->TrapHeat(true,p,n,ni,T,T,T,EcEi,EiEv);
-      iy.push_back(fvm_node->global_offset()+3);
-      y.push_back( H*fvm_node->volume() );
+      iy_buffer.push_back(fvm_node->global_offset()+3);
+      y_buffer.push_back( H*fvm_node->volume() );
 
     }
   }
 
 
+  for(int t=0; t<n_threads; ++t)
+  {
+    iy.insert(iy.end(), iy_thread[t].begin(), iy_thread[t].end());
+    y.insert(y.end(), y_thread[t].begin(), y_thread[t].end());
+  }
+
   // add into petsc vector, we should prevent zero length vector add here.
   if(iy.size())  VecSetValues(f, iy.size(), &iy[0], &y[0], ADD_VALUES);
 
@@ -691,11 +730,22 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, SparseMatrix<
   // search all the element in this region.
   // note, they are all local element, thus must be processed
 
-  const_element_iterator it = elements_begin();
-  const_element_iterator it_end = elements_end();
-  for(; it!=it_end; ++it)
+  // the elements are processed by threads. each thread owns a jacobian buffer, they are added to
+  // jac by thread order, which keeps the serial order of elements.
+  const int n_threads = Genius::n_threads();
+  std::vector< SparseMatrixBuffer<PetscScalar> > jac_thread(n_threads);
+
+  const CellEdgeTable & edge_table = this->cell_edge_table();
+  const int n_elems = n_cell();
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+#endif
+  for(int nelem=0; nelem<n_elems; ++nelem)
   {
-    const Elem * elem = *it;
+    const Elem * elem = get_region_elem(nelem);
+
+    SparseMatrixBuffer<PetscScalar> & jac_buffer = jac_thread[Genius::thread_id()];
+
     bool insulator_interface_elem = is_elem_on_insulator_interface(elem);
     bool mos_channel_elem = is_elem_in_mos_channel(elem);
     bool truncation =  SolverSpecify::VoronoiTruncation == SolverSpecify::VoronoiTruncationAlways ||
@@ -894,16 +944,16 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, SparseMatrix<
     // search for all the Edge this cell own
     for(unsigned int ne=0; ne<elem->n_edges(); ++ne )
     {
-      std::pair<unsigned int, unsigned int> edge_nodes;
-      elem->nodes_on_edge(ne, edge_nodes);
+      const unsigned int edge = edge_table.cell_begin[nelem] + ne;
+      const std::pair<unsigned int, unsigned int> edge_nodes(edge_table.node1[edge], edge_table.node2[edge]);
 
       // the length of this edge
-      const double length = elem->edge_length(ne);
+      const double length = edge_table.length[edge];
 
       // fvm_node of node1
-      const FVM_Node * fvm_n1 = elem->get_fvm_node(edge_nodes.first);
+      const FVM_Node * fvm_n1 = edge_table.fvm_node1[edge];
       // fvm_node of node2
-      const FVM_Node * fvm_n2 = elem->get_fvm_node(edge_nodes.second);
+      const FVM_Node * fvm_n2 = edge_table.fvm_node2[edge];
 
       // fvm_node_data of node1
       const FVM_NodeData * n1_data =  fvm_n1->node_data();
@@ -911,16 +961,16 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, SparseMatrix<
       const FVM_NodeData * n2_data =  fvm_n2->node_data();
 
       // partial area associated with this edge
-      double partial_area = elem->partial_area_with_edge(ne);
-      double partial_volume = elem->partial_volume_with_edge(ne);
+      double partial_area = edge_table.partial_area[edge];
+      double partial_volume = edge_table.partial_volume[edge];
 
       double truncated_partial_area =  partial_area;
       double truncated_partial_volume =  partial_volume;
       if(truncation)
       {
         // use truncated partial area to avoid negative area due to bad mesh elem
-        truncated_partial_area =  this->truncated_partial_area(elem, ne);
-        truncated_partial_volume =  elem->partial_volume_with_edge_truncated(ne);
+        truncated_partial_area =  edge_table.truncated_partial_area[edge];
+        truncated_partial_volume =  edge_table.truncated_partial_volume[edge];
       }
 
       const unsigned int n1_local_offset = fvm_n1->local_offset();
@@ -1028,9 +1078,34 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, SparseMatrix<
         PetscScalar eps = 0.5*(eps1+eps2); // eps at mid point of the edge
         AutoDScalar kap = 0.5*(kap1+kap2); // kapa at mid point of the edge
 
+        // the S-G flux and the poisson flux only depend on the 2*4 variables of the edge,
+        // evaluate them with the fixed size AD scalar and expand to the element directions.
+        // the band edges come from the material models, they are gathered at this boundary
+        unsigned int order[8];
+        for(unsigned int i=0; i<4; ++i)
+        {
+          order[i]   = 4*edge_nodes.first+i;
+          order[4+i] = 4*edge_nodes.second+i;
+        }
+
+        AutoDScalar8 V1_e = V1.getValue();    V1_e.setADValue(0, 1.0);
+        AutoDScalar8 n1_e = n1.getValue();    n1_e.setADValue(1, 1.0);
+        AutoDScalar8 p1_e = p1.getValue();    p1_e.setADValue(2, 1.0);
+        AutoDScalar8 T1_e = T1.getValue();    T1_e.setADValue(3, 1.0);
+        AutoDScalar8 V2_e = V2.getValue();    V2_e.setADValue(4, 1.0);
+        AutoDScalar8 n2_e = n2.getValue();    n2_e.setADValue(5, 1.0);
+        AutoDScalar8 p2_e = p2.getValue();    p2_e.setADValue(6, 1.0);
+        AutoDScalar8 T2_e = T2.getValue();    T2_e.setADValue(7, 1.0);
+
+        const AutoDScalar8 dEc_e = AutoDScalar8::gather((Ec1-Ec2)/e, order);
+        const AutoDScalar8 dEv_e = AutoDScalar8::gather((Ev1-Ev2)/e, order);
+
         // S-G current along the edge
-        AutoDScalar Jn =  mun*In_lt(kb,e,(Ec1-Ec2)/e,n1,n2,0.5*(T1+T2),T2-T1,length);
-        AutoDScalar Jp =  mup*Ip_lt(kb,e,(Ev1-Ev2)/e,p1,p2,0.5*(T1+T2),T2-T1,length);
+        AutoDScalar Jn =  mun*In_lt(kb,e,dEc_e,n1_e,n2_e,0.5*(T1_e+T2_e),T2_e-T1_e,length).expand(order);
+        AutoDScalar Jp =  mup*Ip_lt(kb,e,dEv_e,p1_e,p2_e,0.5*(T1_e+T2_e),T2_e-T1_e,length).expand(order);
+
+        // poisson flux from node 1 to node 2
+        const AutoDScalar8 f_phi = eps*(V2_e - V1_e)/length*partial_area;
 
         // joule heating
         AutoDScalar H = 0.5*(V1-V2)*(Jn + Jp);
@@ -1042,7 +1117,7 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, SparseMatrix<
         // ignore thoese ghost nodes (ghost nodes is local but with different processor_id())
         if( fvm_n1->root_node()->processor_id()==Genius::processor_id() )
         {
-          AutoDScalar ff1 = ( eps*(V2 - V1)/length*partial_area );
+          AutoDScalar ff1 = f_phi.expand(order);
 
           AutoDScalar ff2 = ( Jn*truncated_partial_area );
 
@@ -1051,15 +1126,15 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, SparseMatrix<
           AutoDScalar ff4 = ( kap*(T2 - T1)/length*partial_area + H*truncated_partial_area);
 
           // general coding always has some overkill... bypass it.
-          jac->add_row(  row[0],  cell_col.size(),  &cell_col[0],  ff1.getADValue() );
-          jac->add_row(  row[1],  cell_col.size(),  &cell_col[0],  ff2.getADValue() );
-          jac->add_row(  row[2],  cell_col.size(),  &cell_col[0],  ff3.getADValue() );
-          jac->add_row(  row[3],  cell_col.size(),  &cell_col[0],  ff4.getADValue() );
+          jac_buffer.add_row(  row[0],  cell_col.size(),  &cell_col[0],  ff1.getADValue() );
+          jac_buffer.add_row(  row[1],  cell_col.size(),  &cell_col[0],  ff2.getADValue() );
+          jac_buffer.add_row(  row[2],  cell_col.size(),  &cell_col[0],  ff3.getADValue() );
+          jac_buffer.add_row(  row[3],  cell_col.size(),  &cell_col[0],  ff4.getADValue() );
         }
 
         if( fvm_n2->root_node()->processor_id()==Genius::processor_id() )
         {
-          AutoDScalar ff1 = ( eps*(V1 - V2)/length*partial_area );
+          AutoDScalar ff1 = (-f_phi).expand(order);
 
           AutoDScalar ff2 = ( - Jn*truncated_partial_area );
 
@@ -1067,10 +1142,10 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, SparseMatrix<
 
           AutoDScalar ff4 = ( kap*(T1 - T2)/length*partial_area + H*truncated_partial_area);
 
-          jac->add_row(  row[4],  cell_col.size(),  &cell_col[0],  ff1.getADValue() );
-          jac->add_row(  row[5],  cell_col.size(),  &cell_col[0],  ff2.getADValue() );
-          jac->add_row(  row[6],  cell_col.size(),  &cell_col[0],  ff3.getADValue() );
-          jac->add_row(  row[7],  cell_col.size(),  &cell_col[0],  ff4.getADValue() );
+          jac_buffer.add_row(  row[4],  cell_col.size(),  &cell_col[0],  ff1.getADValue() );
+          jac_buffer.add_row(  row[5],  cell_col.size(),  &cell_col[0],  ff2.getADValue() );
+          jac_buffer.add_row(  row[6],  cell_col.size(),  &cell_col[0],  ff3.getADValue() );
+          jac_buffer.add_row(  row[7],  cell_col.size(),  &cell_col[0],  ff4.getADValue() );
         }
 
         if (get_advanced_model()->BandBandTunneling && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM)
@@ -1082,16 +1157,16 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, SparseMatrix<
           {
             // continuity equation
             AutoDScalar continuity = 0.5*GBTBT1*truncated_partial_volume;
-            jac->add_row(  row[1],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
-            jac->add_row(  row[2],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
+            jac_buffer.add_row(  row[1],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
+            jac_buffer.add_row(  row[2],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
           }
 
           if( fvm_n2->root_node()->processor_id()==Genius::processor_id() )
           {
             // continuity equation
             AutoDScalar continuity = 0.5*GBTBT2*truncated_partial_volume;
-            jac->add_row(  row[5],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
-            jac->add_row(  row[6],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
+            jac_buffer.add_row(  row[5],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
+            jac_buffer.add_row(  row[6],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
           }
         }
 
@@ -1147,8 +1222,8 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, SparseMatrix<
             // continuity equation
             AutoDScalar electron_continuity = (riin1*GIIn+riip1*GIIp)*truncated_partial_volume ;
             AutoDScalar hole_continuity     = (riin1*GIIn+riip1*GIIp)*truncated_partial_volume ;
-            jac->add_row(  row[1],  cell_col.size(),  &cell_col[0],  electron_continuity.getADValue() );
-            jac->add_row(  row[2],  cell_col.size(),  &cell_col[0],  hole_continuity.getADValue() );
+            jac_buffer.add_row(  row[1],  cell_col.size(),  &cell_col[0],  electron_continuity.getADValue() );
+            jac_buffer.add_row(  row[2],  cell_col.size(),  &cell_col[0],  hole_continuity.getADValue() );
           }
 
           if( fvm_n2->root_node()->processor_id()==Genius::processor_id() )
@@ -1156,8 +1231,8 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, SparseMatrix<
             // continuity equation
             AutoDScalar electron_continuity = (riin2*GIIn+riip2*GIIp)*truncated_partial_volume ;
             AutoDScalar hole_continuity     = (riin2*GIIn+riip2*GIIp)*truncated_partial_volume ;
-            jac->add_row(  row[5],  cell_col.size(),  &cell_col[0],  electron_continuity.getADValue() );
-            jac->add_row(  row[6],  cell_col.size(),  &cell_col[0],  hole_continuity.getADValue() );
+            jac_buffer.add_row(  row[5],  cell_col.size(),  &cell_col[0],  electron_continuity.getADValue() );
+            jac_buffer.add_row(  row[6],  cell_col.size(),  &cell_col[0],  hole_continuity.getADValue() );
           }
         }
 
@@ -1166,6 +1241,12 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, SparseMatrix<
 
   }// end of scan all the cell
 
+  for(int t=0; t<n_threads; ++t)
+  {
+    jac_thread[t].add_to(jac);
+    jac_thread[t].clear();
+  }
+
 #if defined(HAVE_FENV_H) && defined(DEBUG)
   genius_assert( !fetestexcept(FE_INVALID) );
 #endif
@@ -1173,17 +1254,20 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, SparseMatrix<
   // process node related terms
   // including \rho of poisson's equation and recombination term of continuation equation
 
-  //the indepedent variable number, 4 for each node
-  adtl::AutoDScalar::numdir = 4;
+  // the nodes are processed by threads with their own jacobian buffers
+  const int n_nodes = n_on_processor_node();
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+#endif
+  for(int i=0; i<n_nodes; ++i)
+  {
+    const FVM_Node * fvm_node = *(on_processor_nodes_begin() + i);
 
-  //synchronize with material database
-  mt->set_ad_num(adtl::AutoDScalar::numdir);
+    SparseMatrixBuffer<PetscScalar> & jac_buffer = jac_thread[Genius::thread_id()];
+
+    //the indepedent variable number, 4 for each node. it is thread local, set it for each thread
+    adtl::AutoDScalar::numdir = 4;
 
-  const_processor_node_iterator node_it = on_processor_nodes_begin();
-  const_processor_node_iterator node_it_end = on_processor_nodes_end();
-  for(; node_it!=node_it_end; ++node_it)
-  {
-    const FVM_Node * fvm_node = *node_it;
     const FVM_NodeData * node_data = fvm_node->node_data();
 
     PetscInt index[4] = {fvm_node->global_offset()+0, fvm_node->global_offset()+1,
@@ -1194,16 +1278,17 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, SparseMatrix<
     AutoDScalar p   =  x[fvm_node->local_offset()+2];   p.setADValue(2, 1.0);              // hole density
     AutoDScalar T   =  x[fvm_node->local_offset()+3];   T.setADValue(3, 1.0);              // hole density
 
-    mt->mapping(fvm_node->root_node(), node_data, SolverSpecify::clock);                   // map this node and its data to material database
+    // map this node and its data to material database, also synchronize the AD number
+    mt->mapping(PMI_Context(fvm_node->root_node(), node_data, SolverSpecify::clock, adtl::AutoDScalar::numdir));
     AutoDScalar R   = mt->band->Recomb(p, n, T)*fvm_node->volume();                      // the recombination term
     AutoDScalar rho = e*(node_data->Net_doping() + p - n)*fvm_node->volume();              // the charge density
     AutoDScalar HR  = R*(node_data->Eg()+3*kb*T);                                          // heat due to carrier recombination
 
     // ADD to Jacobian matrix,
-    jac->add_row(  index[0],  4,  &index[0],  rho.getADValue() );
-    jac->add_row(  index[1],  4,  &index[0],  (-R).getADValue() );
-    jac->add_row(  index[2],  4,  &index[0],  (-R).getADValue() );
-    jac->add_row(  index[3],  4,  &index[0],  HR.getADValue() );
+    jac_buffer.add_row(  index[0],  4,  &index[0],  rho.getADValue() );
+    jac_buffer.add_row(  index[1],  4,  &index[0],  (-R).getADValue() );
+    jac_buffer.add_row(  index[2],  4,  &index[0],  (-R).getADValue() );
+    jac_buffer.add_row(  index[3],  4,  &index[0],  HR.getADValue() );
 
     if (get_advanced_model()->Trap)
     {
@@ -1211,24 +1296,27 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, SparseMatrix<
       mt->trap->Calculate(true,p,n,ni,T);
 
       AutoDScalar TrappedC = mt->trap->ChargeAD(true) * fvm_node->volume();
-      jac->add_row(  index[0],  4,  &index[0],  TrappedC.getADValue() );
+      jac_buffer.add_row(  index[0],  4,  &index[0],  TrappedC.getADValue() );
 
       AutoDScalar GElec = - mt->trap->ElectronTrapRate(true,n,ni,T) * fvm_node->volume();
       AutoDScalar GHole = - mt->trap->HoleTrapRate    (true,p,ni,T) * fvm_node->volume();
 
-      jac->add_row(  index[1],  4,  &index[0],  GElec.getADValue() );
-      jac->add_row(  index[2],  4,  &index[0],  GHole.getADValue() );
+      jac_buffer.add_row(  index[1],  4,  &index[0],  GElec.getADValue() );
+      jac_buffer.add_row(  index[2],  4,  &index[0],  GHole.getADValue() );
 
       AutoDScalar EcEi = 0.5*node_data->Eg() - kb*T*log(node_data->Nc()/node_data->Nv());
       AutoDScalar EiEv = 0.5*node_data->Eg() + kb*T*log(node_data->Nc()/node_data->Nv());
       AutoDScalar H = mt->trap->TrapHeat(true,p,n,ni,T,T,T,EcEi,EiEv);
-      jac->add_row(  index[3],  4,  &index[0],  (H*fvm_node->volume()).getADValue() );
+      jac_buffer.add_row(  index[3],  4,  &index[0],  (H*fvm_node->volume()).getADValue() );
 
     }
 
   }
 
 
+  for(int t=0; t<n_threads; ++t)
+    jac_thread[t].add_to(jac);
+
   // boundary condition should be processed later!
 
   // the last operator is ADD_VALUES
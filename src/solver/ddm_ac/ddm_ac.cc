@@ -20,10 +20,14 @@
 /********************************************************************************/
 
 #include <iomanip>
+#include <set>
+#include <algorithm>
 #include "petsc_matrix.h"
 #include "ddm_ac/ddm_ac.h"
 #include "parallel.h"
 #include "mathfunc.h"  // for PI
+#include "dense_matrix.h"
+#include "dense_vector.h"
 
 
 using PhysicalUnit::kb;
@@ -83,60 +87,59 @@ int DDMACSolver::create_solver()
   ierr = VecDuplicate ( lx, &ls );  genius_assert ( !ierr );
 
   // extra matrix for store Jacobian
-  ierr = MatCreate ( PETSC_COMM_WORLD, &J_ );  genius_assert ( !ierr );
-  ierr = MatSetSizes ( J_, n_local_dofs, n_local_dofs, n_global_dofs, n_global_dofs );genius_assert ( !ierr );
-  if ( Genius::n_processors() >1 )
-  {
-    ierr = MatSetType ( J_, MATMPIAIJ );  genius_assert ( !ierr );
-    ierr = MatMPIAIJSetPreallocation ( J_, 0, &n_nz[0], 0, &n_oz[0] );  genius_assert ( !ierr );
-  }
-  else
-  {
-    ierr = MatSetType ( J_, MATSEQAIJ );    genius_assert ( !ierr );
-    // alloc memory for sequence matrix here
-    ierr = MatSeqAIJSetPreallocation ( J_, 0, &n_nz[0] );    genius_assert ( !ierr );
-  }
-  // we have to set this flag since preallocation is not exact
-  ierr = MatSetOption(J_, MAT_NEW_NONZERO_LOCATIONS, PETSC_TRUE); genius_assert(!ierr);
-
+  create_ac_matrix ( J_, false );
 
   // extra matrix for store A
-  ierr = MatCreate ( PETSC_COMM_WORLD, &A_ );  genius_assert ( !ierr );
-  ierr = MatSetSizes ( A_, n_local_dofs, n_local_dofs, n_global_dofs, n_global_dofs );genius_assert ( !ierr );
-  if ( Genius::n_processors() >1 )
-  {
-    ierr = MatSetType ( A_, MATMPIAIJ );  genius_assert ( !ierr );
-    ierr = MatMPIAIJSetPreallocation ( A_, 0, &n_nz[0], 0, &n_oz[0] );  genius_assert ( !ierr );
-  }
-  else
-  {
-    ierr = MatSetType ( A_, MATSEQAIJ );    genius_assert ( !ierr );
-    // alloc memory for sequence matrix here
-    ierr = MatSeqAIJSetPreallocation ( A_, 0, &n_nz[0] );    genius_assert ( !ierr );
-  }
-  // we have to set this flag since preallocation is not exact
-  ierr = MatSetOption(A_, MAT_NEW_NONZERO_LOCATIONS, PETSC_TRUE); genius_assert(!ierr);
+  create_ac_matrix ( A_, false );
+
+  // region part of A at omega = 0 and omega = 1, A is linear to omega in the regions
+  create_ac_matrix ( K0_, false );
+  create_ac_matrix ( K1_, false );
 
+  // boundary part of A, filled by the boundary conditions at each frequency
+  create_ac_matrix ( B_, false );
 
   // extra matrix for transformation matrix, each row has only 2 entry
-  ierr = MatCreate ( PETSC_COMM_WORLD, &T_ );  genius_assert ( !ierr );
-  ierr = MatSetSizes ( T_, n_local_dofs, n_local_dofs, n_global_dofs, n_global_dofs );  genius_assert ( !ierr );
-  if ( Genius::n_processors() >1 )
-  {
-    ierr = MatSetType ( T_, MATMPIAIJ );    genius_assert ( !ierr );
-    ierr = MatMPIAIJSetPreallocation ( T_, 2, PETSC_NULL, 0, PETSC_NULL );    genius_assert ( !ierr );
-  }
-  else
-  {
-    ierr = MatSetType ( T_, MATSEQAIJ );    genius_assert ( !ierr );
-    // alloc memory for sequence matrix here
-    ierr = MatSeqAIJSetPreallocation ( T_, 2, PETSC_NULL );    genius_assert ( !ierr );
-  }
+  create_ac_matrix ( T_, true );
 
+  // transformation matrix at omega = 0 and omega = 1, it is linear to omega
+  create_ac_matrix ( T0_, true );
+  create_ac_matrix ( T1_, true );
 
   // extra vector for store T*b
   VecDuplicate ( b, &b_ );
 
+  // the real and imaginary parts of each complex dof, the basis of fast sweep is closed under rotation
+  _mor_re_index.clear();
+  _mor_im_index.clear();
+  for ( unsigned int n=0; n<_system.n_regions(); n++ )
+  {
+    const SimulationRegion * region = _system.region ( n );
+    const unsigned int n_complex = this->node_dofs ( region ) /2;
+
+    SimulationRegion::const_processor_node_iterator node_it = region->on_processor_nodes_begin();
+    SimulationRegion::const_processor_node_iterator node_it_end = region->on_processor_nodes_end();
+    for(; node_it!=node_it_end; ++node_it)
+    {
+      const FVM_Node * fvm_node = *node_it;
+      for ( unsigned int i=0; i<n_complex; ++i )
+      {
+        _mor_re_index.push_back ( fvm_node->local_offset() + i );
+        _mor_im_index.push_back ( fvm_node->local_offset() + n_complex + i );
+      }
+    }
+  }
+  if ( Genius::is_last_processor() )
+  {
+    for ( unsigned int n=0; n<_system.get_bcs()->n_bcs(); ++n )
+    {
+      const BoundaryCondition * bc = _system.get_bcs()->get_bc ( n );
+      if ( !this->bc_dofs ( bc ) ) continue;
+      _mor_re_index.push_back ( bc->array_offset() );
+      _mor_im_index.push_back ( bc->array_offset() +1 );
+    }
+  }
+
   MESSAGE<< "AC Small Signal Solver init finished." << std::endl;
   RECORD();
 
@@ -239,6 +242,8 @@ int DDMACSolver::pre_solve_process ( bool /*load_solution*/ )
   // restore array back to Vec
   VecRestoreArray ( ls, &lss );
 
+  // the frequency independent part of AC matrix
+  assemble_ddm_ac();
 
 
   /*
@@ -283,6 +288,19 @@ int DDMACSolver::solve()
 
   this->pre_solve_process();
 
+  // the reduced order model is only valid for current DC solution
+  mor_clear();
+  const bool fast_sweep = SolverSpecify::ACMOR && !SolverSpecify::ACMultiPort;
+  unsigned int n_freq = 0;
+
+  // the frequencies are distributed to processors, each one solves the whole AC system
+  if ( SolverSpecify::ACFreqParallel && Genius::n_processors() > 1 && !SolverSpecify::ACMultiPort && !fast_sweep )
+  {
+    solve_freq_parallel();
+    STOP_LOG ( "solve()", "DDMACSolver" );
+    return 0;
+  }
+
   for ( SolverSpecify::Freq = SolverSpecify::FStart; SolverSpecify::Freq <= SolverSpecify::FStop;  )
   {
 
@@ -294,23 +312,22 @@ int DDMACSolver::solve()
     <<SolverSpecify::Freq*PhysicalUnit::s/1e6<<" MHz "<<"\n";
     RECORD();
 
-    build_ddm_ac ( omega );
-
-    KSPSolve ( ksp, b, x );
-
-    KSPConvergedReason reason;
-    KSPGetConvergedReason ( ksp, &reason );
-
-    PetscInt   its;
-    KSPGetIterationNumber ( ksp, &its );
-
-    PetscReal  rnorm;
-    KSPGetResidualNorm ( ksp, &rnorm );
+    // the fast sweep forms the whole system only when the reduced model is not accepted
+    if ( fast_sweep )
+      build_ddm_ac_boundary ( omega );
+    else
+      build_ddm_ac ( omega );
 
-    MESSAGE<<"------> residual norm = "<<rnorm<<" its = "<<its<<" with "<<KSPConvergedReasons[reason]<<"\n\n";
-    RECORD();
+    // all the ports share the matrix, only the right hand side is changed
+    if ( SolverSpecify::ACMultiPort )
+      solve_ports ( omega );
+    else if ( fast_sweep )
+      solve_mor();
+    else
+      solve_ac();
 
     this->post_solve_process();
+    n_freq++;
 
     if( SolverSpecify::Freq  < SolverSpecify::FStop && SolverSpecify::Freq*SolverSpecify::FMultiple > SolverSpecify::FStop)
       SolverSpecify::Freq  = SolverSpecify::FStop;
@@ -318,6 +335,13 @@ int DDMACSolver::solve()
       SolverSpecify::Freq*=SolverSpecify::FMultiple;
   }
 
+  if ( fast_sweep )
+  {
+    MESSAGE<<"AC fast sweep: "<<_mor_expansions<<" expansion frequencies for "<<n_freq<<" frequencies, "
+           <<_mor_basis.size()<<" basis vectors."<<"\n\n";
+    RECORD();
+  }
+
 
   STOP_LOG ( "solve()", "DDMACSolver" );
 
@@ -327,6 +351,878 @@ int DDMACSolver::solve()
 
 
 
+/*------------------------------------------------------------------
+ * frequency parallel AC sweep.
+ * the frequencies are processed in rounds of n_processors. in each round, the AC
+ * system of each frequency is assembled by all the processors and the whole system
+ * is gathered to the processor owns this frequency. then each processor solves its
+ * system by sequential LU at the same time. at last, the solutions are scattered back
+ * in the order of frequency, and post_solve_process (with hooks) is called for each one
+ */
+void DDMACSolver::solve_freq_parallel()
+{
+  START_LOG ( "solve_freq_parallel()", "DDMACSolver" );
+
+  const unsigned int n_group = Genius::n_processors();
+  const unsigned int rank    = Genius::processor_id();
+
+  // the frequencies to be scanned
+  std::vector<double> freqs;
+  for ( double f = SolverSpecify::FStart; f <= SolverSpecify::FStop;  )
+  {
+    freqs.push_back ( f );
+    if( f < SolverSpecify::FStop && f*SolverSpecify::FMultiple > SolverSpecify::FStop )
+      f = SolverSpecify::FStop;
+    else
+      f *= SolverSpecify::FMultiple;
+  }
+
+  MESSAGE<<"AC Scan: "<<freqs.size()<<" frequencies are solved in parallel by "<<n_group<<" processors."<<"\n\n";
+  RECORD();
+
+  // the whole AC system of the frequency owned by this processor
+  Vec freq_b, freq_x, freq_r, empty;
+  VecCreateSeq ( PETSC_COMM_SELF, n_global_dofs, &freq_b );
+  VecDuplicate ( freq_b, &freq_x );
+  VecDuplicate ( freq_b, &freq_r );
+  VecCreateSeq ( PETSC_COMM_SELF, 0, &empty );
+
+  // the index set of the whole system on the owner of the r-th frequency in a round, empty on others.
+  // it is used for both gathering the matrix and scattering the vectors
+  std::vector<IS>         is ( n_group );
+  std::vector<VecScatter> scatters ( n_group );
+  std::vector<Mat *>      submat ( n_group, static_cast<Mat *> ( PETSC_NULL ) );
+  for ( unsigned int r=0; r<n_group; ++r )
+  {
+    ISCreateStride ( PETSC_COMM_SELF, r==rank ? n_global_dofs : 0, 0, 1, &is[r] );
+    VecScatterCreate ( b, is[r], r==rank ? freq_b : empty, is[r], &scatters[r] );
+  }
+
+  // sequential direct solver, can be changed by -ddm_ac_freq_ options
+  KSP freq_ksp;
+  PC  freq_pc;
+  KSPCreate ( PETSC_COMM_SELF, &freq_ksp );
+  KSPGetPC ( freq_ksp, &freq_pc );
+  KSPSetType ( freq_ksp, ( char* ) KSPPREONLY );
+  PCSetType ( freq_pc, ( char* ) PCLU );
+  KSPSetOptionsPrefix ( freq_ksp, "ddm_ac_freq_" );
+  KSPSetFromOptions ( freq_ksp );
+
+  for ( unsigned int first=0; first<freqs.size(); first+=n_group )
+  {
+    const unsigned int n_slot = std::min ( n_group, static_cast<unsigned int> ( freqs.size()-first ) );
+
+    // assemble the AC system of each frequency and send it to its owner
+    for ( unsigned int r=0; r<n_slot; ++r )
+    {
+      build_ddm_ac ( 2*PI*freqs[first+r] );
+      MatGetSubMatrices ( A, 1, &is[r], &is[r], submat[r] ? MAT_REUSE_MATRIX : MAT_INITIAL_MATRIX, &submat[r] );
+      VecScatterBegin ( scatters[r], b, r==rank ? freq_b : empty, INSERT_VALUES, SCATTER_FORWARD );
+      VecScatterEnd   ( scatters[r], b, r==rank ? freq_b : empty, INSERT_VALUES, SCATTER_FORWARD );
+    }
+
+    // each processor solves its own frequency
+    int       reason = 0;
+    PetscReal rnorm  = 0.0;
+    if ( rank < n_slot )
+    {
+      Mat freq_A = submat[rank][0];
+#if PETSC_VERSION_GE(3,5,0)
+      KSPSetOperators ( freq_ksp, freq_A, freq_A );
+#else
+      KSPSetOperators ( freq_ksp, freq_A, freq_A, SAME_NONZERO_PATTERN );
+#endif
+      KSPSolve ( freq_ksp, freq_b, freq_x );
+
+      KSPConvergedReason ksp_reason;
+      KSPGetConvergedReason ( freq_ksp, &ksp_reason );
+      reason = static_cast<int> ( ksp_reason );
+
+      // true residual, direct solver does not compute it
+      MatMult ( freq_A, freq_x, freq_r );
+      VecAYPX ( freq_r, -1.0, freq_b );
+      VecNorm ( freq_r, NORM_2, &rnorm );
+    }
+
+    // bring back the solutions in the order of frequency
+    for ( unsigned int r=0; r<n_slot; ++r )
+    {
+      VecScatterBegin ( scatters[r], r==rank ? freq_x : empty, x, INSERT_VALUES, SCATTER_REVERSE );
+      VecScatterEnd   ( scatters[r], r==rank ? freq_x : empty, x, INSERT_VALUES, SCATTER_REVERSE );
+
+      int       slot_reason = reason;
+      PetscReal slot_rnorm  = rnorm;
+      Parallel::broadcast ( slot_reason, r );
+      Parallel::broadcast ( slot_rnorm, r );
+
+      SolverSpecify::Freq = freqs[first+r];
+
+      MESSAGE
+      <<"AC Scan: f("<<SolverSpecify::Electrode_ACScan[0]<<") = "
+      << std::scientific
+      <<SolverSpecify::Freq*PhysicalUnit::s/1e6<<" MHz "<<"\n";
+      MESSAGE<<"------> residual norm = "<<slot_rnorm<<" on processor "<<r<<" with "
+             <<KSPConvergedReasons[static_cast<KSPConvergedReason> ( slot_reason )]<<"\n\n";
+      RECORD();
+
+      this->post_solve_process();
+    }
+  }
+
+  KSPDestroy ( PetscDestroyObject(freq_ksp) );
+  for ( unsigned int r=0; r<n_group; ++r )
+  {
+    if ( submat[r] ) MatDestroyMatrices ( 1, &submat[r] );
+    VecScatterDestroy ( PetscDestroyObject(scatters[r]) );
+    ISDestroy ( PetscDestroyObject(is[r]) );
+  }
+  VecDestroy ( PetscDestroyObject(freq_b) );
+  VecDestroy ( PetscDestroyObject(freq_x) );
+  VecDestroy ( PetscDestroyObject(freq_r) );
+  VecDestroy ( PetscDestroyObject(empty) );
+
+  STOP_LOG ( "solve_freq_parallel()", "DDMACSolver" );
+}
+
+
+
+/*------------------------------------------------------------------
+ * solve A x = b and report the convergence
+ */
+void DDMACSolver::solve_ac()
+{
+  KSPSolve ( ksp, b, x );
+
+  KSPConvergedReason reason;
+  KSPGetConvergedReason ( ksp, &reason );
+
+  PetscInt   its;
+  KSPGetIterationNumber ( ksp, &its );
+
+  PetscReal  rnorm;
+  KSPGetResidualNorm ( ksp, &rnorm );
+
+  MESSAGE<<"------> residual norm = "<<rnorm<<" its = "<<its<<" with "<<KSPConvergedReasons[reason]<<"\n\n";
+  RECORD();
+}
+
+
+
+/*------------------------------------------------------------------
+ * excite each port in turn and fill the admittance and impedance matrix.
+ * the preconditioner (i.e. LU factorization) built for the first port
+ * is reused by the others since the matrix is not changed.
+ * the solution vector x keeps the response of the last port
+ */
+void DDMACSolver::solve_ports ( PetscScalar omega )
+{
+  START_LOG ( "solve_ports()", "DDMACSolver" );
+
+  const unsigned int n_ports = SolverSpecify::Electrode_ACScan.size();
+
+  // the bcs of each port
+  std::vector< std::vector<BoundaryCondition *> > port_bcs(n_ports);
+  for ( unsigned int i=0; i<n_ports; ++i )
+    port_bcs[i] = _system.get_bcs()->get_bcs_by_electrode_label ( SolverSpecify::Electrode_ACScan[i] );
+
+  SolverSpecify::ACPortY.assign ( n_ports*n_ports, std::complex<double>(0.0, 0.0) );
+
+  for ( unsigned int k=0; k<n_ports; ++k )
+  {
+    MESSAGE<<"  port "<<SolverSpecify::Electrode_ACScan[k]<<": ";
+    RECORD();
+
+    // only the electrodes of port k are excited.
+    // Vac only appears in the external circuit equation of electrode, which is the rhs
+    VecZeroEntries ( b_ );
+    for ( unsigned int n=0; n<_system.get_bcs()->n_bcs(); ++n )
+    {
+      BoundaryCondition * bc = _system.get_bcs()->get_bc ( n );
+      if ( bc->is_electrode() )
+        bc->ext_circuit()->Vac() = 0.0;
+    }
+    for ( unsigned int b=0; b<port_bcs[k].size(); ++b )
+    {
+      BoundaryCondition * bc = port_bcs[k][b];
+      bc->ext_circuit()->Vac() = SolverSpecify::VAC;
+      if ( Genius::is_last_processor() )
+        VecSetValue ( b_, bc->global_offset(), SolverSpecify::VAC, ADD_VALUES );
+    }
+    VecAssemblyBegin ( b_ );
+    VecAssemblyEnd ( b_ );
+
+    MatMult ( T_, b_, b );
+
+    solve_ac();
+
+    // the electrode current of each port
+    VecScatterBegin ( scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD );
+    VecScatterEnd ( scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD );
+
+    PetscScalar *lxx;
+    VecGetArray ( lx, &lxx );
+    for ( unsigned int n=0; n<_system.get_bcs()->n_bcs(); ++n )
+    {
+      BoundaryCondition * bc = _system.get_bcs()->get_bc ( n );
+      if ( bc->is_electrode() )
+        bc->DDMAC_Update_Solution ( lxx, J_, omega );
+    }
+    VecRestoreArray ( lx, &lxx );
+
+    for ( unsigned int i=0; i<n_ports; ++i )
+      for ( unsigned int b=0; b<port_bcs[i].size(); ++b )
+        SolverSpecify::ACPortY[i*n_ports+k] += port_bcs[i][b]->ext_circuit()->current_ac()/SolverSpecify::VAC;
+  }
+
+  // impedance matrix, Z = Y^-1
+  SolverSpecify::ACPortZ.assign ( n_ports*n_ports, std::complex<double>(0.0, 0.0) );
+  {
+    ComplexDenseMatrix Y ( n_ports, n_ports );
+    for ( unsigned int i=0; i<n_ports; ++i )
+      for ( unsigned int j=0; j<n_ports; ++j )
+        Y ( i, j ) = SolverSpecify::ACPortY[i*n_ports+j];
+
+    for ( unsigned int k=0; k<n_ports; ++k )
+    {
+      DenseVector<Complex> e ( n_ports ), z ( n_ports );
+      e ( k ) = 1.0;
+      Y.lu_solve ( e, z, true );
+      for ( unsigned int i=0; i<n_ports; ++i )
+        SolverSpecify::ACPortZ[i*n_ports+k] = z ( i );
+    }
+  }
+
+  STOP_LOG ( "solve_ports()", "DDMACSolver" );
+}
+
+
+
+/*------------------------------------------------------------------
+ * fast AC sweep. the solution is searched in the basis V by minimizing
+ * the residual of A x = b. when the residual is too large, the full system is
+ * solved at this frequency and the basis is expanded by the solution moments.
+ * as a result, only a few factorizations are required for the whole sweep
+ */
+void DDMACSolver::solve_mor()
+{
+  START_LOG ( "solve_mor()", "DDMACSolver" );
+
+  const PetscScalar omega = 2*PI*SolverSpecify::Freq;
+
+  // the boundary rows are fixed in the reduced model, restart it when they are changed
+  if ( !_mor_boundary_flag.empty() && mor_boundary_changed() )
+  {
+    MESSAGE<<"------> boundary rows changed, restart the reduced model"<<"\n";
+    RECORD();
+    mor_reset();
+  }
+
+  PetscReal error;
+  if ( mor_reduced_solve ( error ) )
+  {
+    MESSAGE<<"------> reduced model of "<<_mor_basis.size()<<" vectors, relative residual = "<<error<<"\n\n";
+    RECORD();
+  }
+  else
+  {
+    if ( !_mor_basis.empty() )
+    {
+      MESSAGE<<"------> reduced model residual "<<error<<" exceeds tolerance, expand at this frequency"<<"\n";
+      RECORD();
+    }
+
+    build_ddm_ac_system ( omega );
+    solve_ac();
+
+    // an expansion adds at most 2*SolverSpecify::ACMOROrder vectors, restart the model when it is full
+    if ( _mor_basis.size() + 2*SolverSpecify::ACMOROrder > SolverSpecify::ACMORMaxBasis )
+    {
+      MESSAGE<<"------> reduced model is full, restart it at this frequency"<<"\n";
+      RECORD();
+      mor_reset();
+    }
+
+    mor_expand();
+  }
+
+  STOP_LOG ( "solve_mor()", "DDMACSolver" );
+}
+
+
+
+/*------------------------------------------------------------------
+ * least square solution of the dense system M y = c by Householder QR.
+ * M is column major with rows >= cols, M and c are overwritten
+ * @return false if M is rank deficient
+ */
+static bool dense_least_square ( unsigned int rows, unsigned int cols, std::vector<PetscScalar> & M,
+                                 std::vector<PetscScalar> & c, std::vector<PetscScalar> & y, PetscReal & r_norm )
+{
+  std::vector<PetscScalar> diag ( cols );
+  for ( unsigned int j=0; j<cols; ++j )
+  {
+    PetscScalar * v = &M[j*rows];
+
+    PetscReal norm = 0.0;
+    for ( unsigned int i=j; i<rows; ++i )
+      norm += v[i]*v[i];
+    norm = std::sqrt ( norm );
+    if ( norm == 0.0 ) return false;
+
+    // the Householder vector v = a - diag e_j, reflect the remaining columns and c
+    diag[j] = v[j] > 0.0 ? -norm : norm;
+    v[j] -= diag[j];
+
+    PetscReal v_norm2 = 0.0;
+    for ( unsigned int i=j; i<rows; ++i )
+      v_norm2 += v[i]*v[i];
+
+    for ( unsigned int l=j+1; l<=cols; ++l )
+    {
+      PetscScalar * u = l<cols ? &M[l*rows] : &c[0];
+      PetscScalar d = 0.0;
+      for ( unsigned int i=j; i<rows; ++i )
+        d += v[i]*u[i];
+      d *= 2.0/v_norm2;
+      for ( unsigned int i=j; i<rows; ++i )
+        u[i] -= d*v[i];
+    }
+  }
+
+  PetscReal diag_max = 0.0;
+  for ( unsigned int j=0; j<cols; ++j )
+    diag_max = std::max ( diag_max, std::abs ( diag[j] ) );
+  for ( unsigned int j=0; j<cols; ++j )
+    if ( std::abs ( diag[j] ) < 1e-14*diag_max ) return false;
+
+  // back substitution R y = Q^T c
+  for ( int j=cols-1; j>=0; --j )
+  {
+    PetscScalar s = c[j];
+    for ( unsigned int l=j+1; l<cols; ++l )
+      s -= M[l*rows+j]*y[l];
+    y[j] = s/diag[j];
+  }
+
+  r_norm = 0.0;
+  for ( unsigned int i=cols; i<rows; ++i )
+    r_norm += c[i]*c[i];
+  r_norm = std::sqrt ( r_norm );
+
+  return true;
+}
+
+
+
+/*------------------------------------------------------------------
+ * position of value in the sorted index
+ */
+static unsigned int sorted_position ( const std::vector<PetscInt> & index, PetscInt value )
+{
+  std::vector<PetscInt>::const_iterator it = std::lower_bound ( index.begin(), index.end(), value );
+  genius_assert ( it != index.end() && *it == value );
+  return it - index.begin();
+}
+
+
+
+/*------------------------------------------------------------------
+ * least square solution of A V y = b. out of the boundary rows, A V = Q R M(omega)
+ * where Q R is factorized once when the basis is added. the boundary rows of A V and b
+ * are evaluated at this frequency from the rows of B_, T0_ and T1_ only,
+ * so the cost does not grow with the size of the system.
+ * the residual norm |b - A V y| is exact, not an estimation
+ */
+bool DDMACSolver::mor_reduced_solve ( PetscReal & error )
+{
+  error = 1.0;
+
+  const unsigned int k = _mor_basis.size();
+  if ( !k ) return false;
+
+  START_LOG ( "mor_reduced_solve()", "DDMACSolver" );
+
+  const PetscScalar omega = 2*PI*SolverSpecify::Freq;
+  const PetscScalar omega_power[3] = {1.0, omega, omega*omega};
+
+  PetscInt row_begin, row_end;
+  VecGetOwnershipRange ( x, &row_begin, &row_end );
+
+  const unsigned int n_rows = _mor_boundary_rows.size();
+
+  // B_ V and b_ on the boundary rows, by the values of the basis vectors on the columns of B_
+  std::vector<PetscScalar> bv ( n_rows* ( k+1 ), 0.0 );
+  PetscReal b_boundary_norm2 = 0.0;
+  {
+    PetscScalar * bb;
+    VecGetArray ( b_, &bb );
+    for ( unsigned int i=0; i<n_rows; ++i )
+    {
+      const PetscInt row = row_begin + _mor_boundary_rows[i];
+
+      PetscInt ncols;
+      const PetscInt    * cols;
+      const PetscScalar * vals;
+      MatGetRow ( B_, row, &ncols, &cols, &vals );
+      for ( PetscInt n=0; n<ncols; ++n )
+      {
+        const unsigned int c = sorted_position ( _mor_boundary_cols, cols[n] );
+        for ( unsigned int j=0; j<k; ++j )
+          bv[i* ( k+1 ) +j] += vals[n]*_mor_vc[j][c];
+      }
+      MatRestoreRow ( B_, row, &ncols, &cols, &vals );
+
+      bv[i* ( k+1 ) +k] = bb[_mor_boundary_rows[i]];
+      b_boundary_norm2 += bb[_mor_boundary_rows[i]]*bb[_mor_boundary_rows[i]];
+    }
+    VecRestoreArray ( b_, &bb );
+  }
+
+  // b_ comes from the boundaries, the model can not measure the residual of others
+  {
+    PetscReal b_norm_;
+    VecNorm ( b_, NORM_2, &b_norm_ );
+    Parallel::sum ( b_boundary_norm2 );
+    if ( b_norm_ == 0.0 ||
+         std::sqrt ( std::max ( 0.0, b_norm_*b_norm_ - b_boundary_norm2 ) ) > 0.1*SolverSpecify::ACMORTol*b_norm_ )
+    {
+      STOP_LOG ( "mor_reduced_solve()", "DDMACSolver" );
+      return false;
+    }
+  }
+
+  // the boundary rows of A V and b, each row holds k entries of A V and one of b.
+  // on these rows, A v = P0 v + omega P1 v + omega^2 P2 v + T B_ v, where T = (1-omega) T0 + omega T1
+  // only combines the boundary rows
+  std::vector<PetscScalar> boundary ( n_rows* ( k+1 ), 0.0 );
+  PetscReal b_norm = 0.0;
+  for ( unsigned int i=0; i<n_rows; ++i )
+  {
+    const PetscInt row = row_begin + _mor_boundary_rows[i];
+    PetscScalar * value = &boundary[i* ( k+1 )];
+
+    for ( unsigned int a=0; a<2; ++a )
+    {
+      const Mat T = a ? T1_ : T0_;
+      const PetscScalar weight = a ? omega : 1.0-omega;
+
+      PetscInt ncols;
+      const PetscInt    * cols;
+      const PetscScalar * vals;
+      MatGetRow ( T, row, &ncols, &cols, &vals );
+      for ( PetscInt n=0; n<ncols; ++n )
+      {
+        const unsigned int l = sorted_position ( _mor_boundary_rows, cols[n]-row_begin );
+        for ( unsigned int j=0; j<=k; ++j )
+          value[j] += weight*vals[n]*bv[l* ( k+1 ) +j];
+      }
+      MatRestoreRow ( T, row, &ncols, &cols, &vals );
+    }
+
+    for ( unsigned int j=0; j<k; ++j )
+      for ( unsigned int a=0; a<3; ++a )
+        value[j] += omega_power[a]*_mor_z[3*j+a][i];
+
+    b_norm += value[k]*value[k];
+  }
+  Parallel::sum ( b_norm );
+  b_norm = std::sqrt ( b_norm );
+
+  Parallel::allgather ( boundary );
+  const unsigned int n_boundary = boundary.size() / ( k+1 );
+
+  // the small dense problem, the rows of R M(omega) followed by the boundary rows
+  const unsigned int m = _mor_q.size();
+  const unsigned int rows = m + n_boundary;
+
+  std::vector<PetscScalar> M ( rows*k, 0.0 );
+  std::vector<PetscScalar> c ( rows, 0.0 );
+  for ( unsigned int j=0; j<k; ++j )
+  {
+    for ( unsigned int a=0; a<3; ++a )
+    {
+      const std::vector<PetscScalar> & r = _mor_r[3*j+a];
+      for ( unsigned int i=0; i<r.size(); ++i )
+        M[j*rows+i] += omega_power[a]*r[i];
+    }
+    for ( unsigned int i=0; i<n_boundary; ++i )
+      M[j*rows+m+i] = boundary[i* ( k+1 ) +j];
+  }
+  for ( unsigned int i=0; i<n_boundary; ++i )
+    c[m+i] = boundary[i* ( k+1 ) +k];
+
+  std::vector<PetscScalar> y ( k, 0.0 );
+  PetscReal r_norm;
+  bool accepted = b_norm > 0.0 && rows >= k && dense_least_square ( rows, k, M, c, y, r_norm );
+  if ( accepted )
+  {
+    error = r_norm/b_norm;
+    accepted = error <= SolverSpecify::ACMORTol;
+  }
+
+  // x = V y
+  if ( accepted )
+  {
+    VecZeroEntries ( x );
+    for ( unsigned int j=0; j<k; ++j )
+      VecAXPY ( x, y[j], _mor_basis[j] );
+  }
+
+  STOP_LOG ( "mor_reduced_solve()", "DDMACSolver" );
+
+  return accepted;
+}
+
+
+
+/*------------------------------------------------------------------
+ * Arnoldi process at current frequency. the moments are
+ *   v_{j+1} = A^-1 dA/domega v_j
+ * where the factorization of A is reused by each moment.
+ * A = T*A_, the region part of T and A_ are linear to omega, and their derivatives
+ * are T1-T0 and K1-K0. the derivative of external circuit on the boundaries is omitted,
+ * since the moments only enrich the basis and the accuracy is checked by the residual
+ */
+void DDMACSolver::mor_expand()
+{
+  START_LOG ( "mor_expand()", "DDMACSolver" );
+
+  _mor_expansions++;
+
+  // the boundary rows of a new model
+  if ( _mor_boundary_flag.empty() )
+    mor_set_boundary_rows();
+
+  Vec v, w1, w2, w3;
+  VecDuplicate ( x, &v );
+  VecDuplicate ( x, &w1 );
+  VecDuplicate ( x, &w2 );
+  VecDuplicate ( x, &w3 );
+
+  VecCopy ( x, v );
+  for ( unsigned int j=0; mor_add_basis ( v ) && j+1<SolverSpecify::ACMOROrder; ++j )
+  {
+    // w2 = (T1-T0) A_ v + T (K1-K0) v
+    MatMult ( A_, v, w1 );
+    MatMult ( T1_, w1, w2 );
+    MatMult ( T0_, w1, w3 );
+    VecAXPY ( w2, -1.0, w3 );
+
+    MatMult ( K1_, v, w1 );
+    MatMult ( K0_, v, w3 );
+    VecAXPY ( w1, -1.0, w3 );
+    MatMult ( T_, w1, w3 );
+    VecAXPY ( w2, 1.0, w3 );
+
+    KSPSolve ( ksp, w2, v );
+    VecNormalize ( v, PETSC_NULL );
+  }
+
+  VecDestroy ( PetscDestroyObject(v) );
+  VecDestroy ( PetscDestroyObject(w1) );
+  VecDestroy ( PetscDestroyObject(w2) );
+  VecDestroy ( PetscDestroyObject(w3) );
+
+  STOP_LOG ( "mor_expand()", "DDMACSolver" );
+}
+
+
+
+/*------------------------------------------------------------------
+ * the AC system is the real form of a complex system, i*v is a solution direction
+ * as well as v. append v with its rotated companion, then complex combinations
+ * of the basis vectors are reachable by the real reduced model
+ */
+bool DDMACSolver::mor_add_basis ( Vec v )
+{
+  if ( !mor_append_basis ( v ) ) return false;
+
+  Vec u;
+  VecDuplicate ( v, &u );
+  mor_rotate ( _mor_basis.back(), u );
+  mor_append_basis ( u );
+  VecDestroy ( PetscDestroyObject(u) );
+
+  return true;
+}
+
+
+
+/*------------------------------------------------------------------
+ * Gram-Schmidt with reorthogonalization
+ */
+bool DDMACSolver::mor_append_basis ( Vec v )
+{
+  PetscReal norm0;
+  VecNorm ( v, NORM_2, &norm0 );
+  if ( norm0 == 0.0 ) return false;
+
+  Vec u;
+  VecDuplicate ( v, &u );
+  VecCopy ( v, u );
+
+  // twice is enough
+  for ( unsigned int pass=0; pass<2; ++pass )
+    for ( unsigned int i=0; i<_mor_basis.size(); ++i )
+    {
+      PetscScalar d;
+      VecDot ( u, _mor_basis[i], &d );
+      VecAXPY ( u, -d, _mor_basis[i] );
+    }
+
+  PetscReal norm;
+  VecNorm ( u, NORM_2, &norm );
+  if ( norm < 1e-10*norm0 )
+  {
+    VecDestroy ( PetscDestroyObject(u) );
+    return false;
+  }
+
+  VecScale ( u, 1.0/norm );
+  _mor_basis.push_back ( u );
+
+  // the values on the columns of B_, for the boundary rows of B_ u at each frequency
+  {
+    VecScatterBegin ( _mor_col_scatter, u, _mor_col_vec, INSERT_VALUES, SCATTER_FORWARD );
+    VecScatterEnd ( _mor_col_scatter, u, _mor_col_vec, INSERT_VALUES, SCATTER_FORWARD );
+
+    PetscScalar * cc;
+    VecGetArray ( _mor_col_vec, &cc );
+    _mor_vc.push_back ( std::vector<PetscScalar> ( cc, cc+_mor_boundary_cols.size() ) );
+    VecRestoreArray ( _mor_col_vec, &cc );
+  }
+
+  // the frequency independent columns of A u,
+  // P0 u = T0 K0 u, P1 u = (T1-T0) K0 u + T0 (K1-K0) u and P2 u = (T1-T0) (K1-K0) u
+  Vec k0, dk, w, p[3];
+  VecDuplicate ( u, &k0 );
+  VecDuplicate ( u, &dk );
+  VecDuplicate ( u, &w );
+  for ( unsigned int a=0; a<3; ++a )
+    VecDuplicate ( u, &p[a] );
+
+  MatMult ( K0_, u, k0 );
+  MatMult ( K1_, u, dk );
+  VecAXPY ( dk, -1.0, k0 );
+
+  MatMult ( T0_, k0, p[0] );
+
+  MatMult ( T1_, k0, p[1] );
+  MatMult ( T0_, k0, w );
+  VecAXPY ( p[1], -1.0, w );
+  MatMult ( T0_, dk, w );
+  VecAXPY ( p[1], 1.0, w );
+
+  MatMult ( T1_, dk, p[2] );
+  MatMult ( T0_, dk, w );
+  VecAXPY ( p[2], -1.0, w );
+
+  VecDestroy ( PetscDestroyObject(k0) );
+  VecDestroy ( PetscDestroyObject(dk) );
+  VecDestroy ( PetscDestroyObject(w) );
+
+  for ( unsigned int a=0; a<3; ++a )
+    mor_append_column ( p[a] );
+
+  return true;
+}
+
+
+
+/*------------------------------------------------------------------
+ * the boundary rows of p are saved in _mor_z, the others are
+ * orthonormalized against _mor_q, the coefficients are the column of R
+ */
+void DDMACSolver::mor_append_column ( Vec p )
+{
+  std::vector<PetscScalar> z ( _mor_boundary_rows.size() );
+  {
+    PetscScalar * pp;
+    VecGetArray ( p, &pp );
+    for ( unsigned int i=0; i<_mor_boundary_rows.size(); ++i )
+    {
+      z[i] = pp[_mor_boundary_rows[i]];
+      pp[_mor_boundary_rows[i]] = 0.0;
+    }
+    VecRestoreArray ( p, &pp );
+  }
+  _mor_z.push_back ( z );
+
+  std::vector<PetscScalar> r ( _mor_q.size(), 0.0 );
+
+  PetscReal norm0, norm = 0.0;
+  VecNorm ( p, NORM_2, &norm0 );
+  if ( norm0 > 0.0 )
+  {
+    // twice is enough
+    for ( unsigned int pass=0; pass<2; ++pass )
+      for ( unsigned int i=0; i<_mor_q.size(); ++i )
+      {
+        PetscScalar d;
+        VecDot ( p, _mor_q[i], &d );
+        VecAXPY ( p, -d, _mor_q[i] );
+        r[i] += d;
+      }
+    VecNorm ( p, NORM_2, &norm );
+  }
+
+  if ( norm > 1e-12*norm0 )
+  {
+    VecScale ( p, 1.0/norm );
+    _mor_q.push_back ( p );
+    r.push_back ( norm );
+  }
+  else
+    VecDestroy ( PetscDestroyObject(p) );
+
+  _mor_r.push_back ( r );
+}
+
+
+
+/*------------------------------------------------------------------
+ * u = i*v, the real and imaginary parts of each complex dof are on the same processor
+ */
+void DDMACSolver::mor_rotate ( Vec v, Vec u ) const
+{
+  PetscScalar * vv, * uu;
+  VecGetArray ( v, &vv );
+  VecGetArray ( u, &uu );
+  for ( unsigned int i=0; i<_mor_re_index.size(); ++i )
+  {
+    uu[_mor_re_index[i]] = -vv[_mor_im_index[i]];
+    uu[_mor_im_index[i]] =  vv[_mor_re_index[i]];
+  }
+  VecRestoreArray ( u, &uu );
+  VecRestoreArray ( v, &vv );
+}
+
+
+
+/*------------------------------------------------------------------
+ * the boundary rows are the rows of B_ at current frequency. T combines the
+ * real and imaginary rows of a complex dof, so both of them are taken
+ */
+void DDMACSolver::mor_set_boundary_rows()
+{
+  PetscInt row_begin, row_end;
+  VecGetOwnershipRange ( x, &row_begin, &row_end );
+
+  _mor_boundary_flag.assign ( row_end-row_begin, 0 );
+  for ( unsigned int i=0; i<_bc_rows.size(); ++i )
+    _mor_boundary_flag[_bc_rows[i]-row_begin] = 1;
+
+  for ( unsigned int i=0; i<_mor_re_index.size(); ++i )
+    if ( _mor_boundary_flag[_mor_re_index[i]] || _mor_boundary_flag[_mor_im_index[i]] )
+    {
+      _mor_boundary_flag[_mor_re_index[i]] = 1;
+      _mor_boundary_flag[_mor_im_index[i]] = 1;
+    }
+
+  _mor_boundary_rows.clear();
+  for ( PetscInt i=0; i<row_end-row_begin; ++i )
+    if ( _mor_boundary_flag[i] )
+      _mor_boundary_rows.push_back ( i );
+
+  // the columns of B_ on these rows, the basis vectors are kept on them
+  std::set<PetscInt> boundary_cols;
+  for ( unsigned int i=0; i<_bc_rows.size(); ++i )
+  {
+    PetscInt ncols;
+    const PetscInt * cols;
+    MatGetRow ( B_, _bc_rows[i], &ncols, &cols, PETSC_NULL );
+    boundary_cols.insert ( cols, cols+ncols );
+    MatRestoreRow ( B_, _bc_rows[i], &ncols, &cols, PETSC_NULL );
+  }
+  _mor_boundary_cols.assign ( boundary_cols.begin(), boundary_cols.end() );
+
+  IS is;
+#if PETSC_VERSION_GE(3,2,0)
+  ISCreateGeneral ( PETSC_COMM_SELF, _mor_boundary_cols.size(), _mor_boundary_cols.empty() ? PETSC_NULL : &_mor_boundary_cols[0], PETSC_COPY_VALUES, &is );
+#else
+  ISCreateGeneral ( PETSC_COMM_SELF, _mor_boundary_cols.size(), _mor_boundary_cols.empty() ? PETSC_NULL : &_mor_boundary_cols[0], &is );
+#endif
+  VecCreateSeq ( PETSC_COMM_SELF, _mor_boundary_cols.size(), &_mor_col_vec );
+  VecScatterCreate ( x, is, _mor_col_vec, PETSC_NULL, &_mor_col_scatter );
+  ISDestroy ( PetscDestroyObject(is) );
+}
+
+
+
+/*------------------------------------------------------------------
+ * check the rows of B_ at current frequency with the boundary rows of the model
+ */
+bool DDMACSolver::mor_boundary_changed() const
+{
+  PetscInt row_begin, row_end;
+  VecGetOwnershipRange ( x, &row_begin, &row_end );
+
+  unsigned int changed = 0;
+  for ( unsigned int i=0; i<_bc_rows.size(); ++i )
+  {
+    if ( !_mor_boundary_flag[_bc_rows[i]-row_begin] )
+    {
+      changed = 1;
+      break;
+    }
+
+    // the basis vectors are only kept on the columns of the model
+    PetscInt ncols;
+    const PetscInt * cols;
+    MatGetRow ( B_, _bc_rows[i], &ncols, &cols, PETSC_NULL );
+    for ( PetscInt n=0; n<ncols; ++n )
+      if ( !std::binary_search ( _mor_boundary_cols.begin(), _mor_boundary_cols.end(), cols[n] ) )
+        changed = 1;
+    MatRestoreRow ( B_, _bc_rows[i], &ncols, &cols, PETSC_NULL );
+  }
+  Parallel::max ( changed );
+
+  return changed != 0;
+}
+
+
+
+/*------------------------------------------------------------------
+ * free the basis and the factorization of the reduced model
+ */
+void DDMACSolver::mor_reset()
+{
+  for ( unsigned int i=0; i<_mor_basis.size(); ++i )
+    VecDestroy ( PetscDestroyObject(_mor_basis[i]) );
+  _mor_basis.clear();
+
+  for ( unsigned int i=0; i<_mor_q.size(); ++i )
+    VecDestroy ( PetscDestroyObject(_mor_q[i]) );
+  _mor_q.clear();
+
+  // the scatter is created with the boundary rows
+  if ( !_mor_boundary_flag.empty() )
+  {
+    VecScatterDestroy ( PetscDestroyObject(_mor_col_scatter) );
+    VecDestroy ( PetscDestroyObject(_mor_col_vec) );
+  }
+
+  _mor_r.clear();
+  _mor_z.clear();
+  _mor_vc.clear();
+  _mor_boundary_rows.clear();
+  _mor_boundary_flag.clear();
+  _mor_boundary_cols.clear();
+}
+
+
+
+/*------------------------------------------------------------------
+ * free the reduced model and the statistic of the sweep
+ */
+void DDMACSolver::mor_clear()
+{
+  mor_reset();
+  _mor_expansions = 0;
+}
+
+
+
 /*------------------------------------------------------------------
  * call this function after each solution process
  */
@@ -388,11 +1284,23 @@ int DDMACSolver::destroy_solver()
   genius_assert ( !ierr );
   ierr = MatDestroy ( PetscDestroyObject(T_) );
   genius_assert ( !ierr );
+  ierr = MatDestroy ( PetscDestroyObject(K0_) );
+  genius_assert ( !ierr );
+  ierr = MatDestroy ( PetscDestroyObject(K1_) );
+  genius_assert ( !ierr );
+  ierr = MatDestroy ( PetscDestroyObject(T0_) );
+  genius_assert ( !ierr );
+  ierr = MatDestroy ( PetscDestroyObject(T1_) );
+  genius_assert ( !ierr );
+  ierr = MatDestroy ( PetscDestroyObject(B_) );
+  genius_assert ( !ierr );
   ierr = VecDestroy ( PetscDestroyObject(b_) );
   genius_assert ( !ierr );
 
   if ( !_first_create ) MatDestroy ( PetscDestroyObject(C_) );
 
+  mor_clear();
+
   return FVM_LinearSolver::destroy_solver();
 }
 
@@ -412,50 +1320,152 @@ int DDMACSolver::destroy_solver()
 
 
 /*------------------------------------------------------------------
- * build the matrix and right hand side vector b with certain freq omega
+ * create matrix with the size of AC system.
+ * the transformation matrix has 2 entries each row, others have the pattern of Jacobian
  */
-void DDMACSolver::build_ddm_ac ( PetscScalar omega )
+void DDMACSolver::create_ac_matrix ( Mat & mat, bool transformation )
+{
+  int ierr = 0;
+
+  ierr = MatCreate ( PETSC_COMM_WORLD, &mat );  genius_assert ( !ierr );
+  ierr = MatSetSizes ( mat, n_local_dofs, n_local_dofs, n_global_dofs, n_global_dofs );  genius_assert ( !ierr );
+  if ( Genius::n_processors() >1 )
+  {
+    ierr = MatSetType ( mat, MATMPIAIJ );  genius_assert ( !ierr );
+    if ( transformation )
+      ierr = MatMPIAIJSetPreallocation ( mat, 2, PETSC_NULL, 0, PETSC_NULL );
+    else
+      ierr = MatMPIAIJSetPreallocation ( mat, 0, &n_nz[0], 0, &n_oz[0] );
+    genius_assert ( !ierr );
+  }
+  else
+  {
+    ierr = MatSetType ( mat, MATSEQAIJ );  genius_assert ( !ierr );
+    // alloc memory for sequence matrix here
+    if ( transformation )
+      ierr = MatSeqAIJSetPreallocation ( mat, 2, PETSC_NULL );
+    else
+      ierr = MatSeqAIJSetPreallocation ( mat, 0, &n_nz[0] );
+    genius_assert ( !ierr );
+  }
+
+  // we have to set this flag since preallocation is not exact
+  if ( !transformation )
+  {
+    ierr = MatSetOption ( mat, MAT_NEW_NONZERO_LOCATIONS, PETSC_TRUE );  genius_assert ( !ierr );
+  }
+}
+
+
+
+/*------------------------------------------------------------------
+ * add X0 + omega*(X1-X0) to Y. X0 and X1 should have the same nonzero pattern
+ */
+static void add_omega_combination ( Mat Y, const Mat X0, const Mat X1, PetscScalar omega )
 {
+  PetscInt row_begin, row_end;
+  MatGetOwnershipRange ( X0, &row_begin, &row_end );
+
+  std::vector<PetscScalar> values;
+  for ( PetscInt row=row_begin; row<row_end; ++row )
+  {
+    PetscInt ncols0, ncols1;
+    const PetscInt    * cols0, * cols1;
+    const PetscScalar * vals0, * vals1;
+    MatGetRow ( X0, row, &ncols0, &cols0, &vals0 );
+    MatGetRow ( X1, row, &ncols1, &cols1, &vals1 );
+    genius_assert ( ncols0 == ncols1 );
+
+    if ( ncols0 )
+    {
+      values.resize ( ncols0 );
+      for ( PetscInt n=0; n<ncols0; ++n )
+        values[n] = vals0[n] + omega* ( vals1[n]-vals0[n] );
+      MatSetValues ( Y, 1, &row, ncols0, cols0, &values[0], ADD_VALUES );
+    }
 
-  START_LOG ( "build_ddm_ac()", "DDMACSolver" );
+    MatRestoreRow ( X1, row, &ncols1, &cols1, &vals1 );
+    MatRestoreRow ( X0, row, &ncols0, &cols0, &vals0 );
+  }
+}
 
-  // flag for indicate ADD_VALUES operator.
-  InsertMode add_value_flag = NOT_SET_VALUES;
 
-  MatZeroEntries ( A_ );
-  VecZeroEntries ( b_ );
 
-  // evaluate Jacobian matrix of governing equations of EBM for all the regions
-  for ( unsigned int n=0; n<_system.n_regions(); n++ )
+/*------------------------------------------------------------------
+ * the on processor rows of X which have entries
+ */
+static void nonempty_rows ( const Mat X, std::vector<PetscInt> & rows )
+{
+  rows.clear();
+
+  PetscInt row_begin, row_end;
+  MatGetOwnershipRange ( X, &row_begin, &row_end );
+
+  for ( PetscInt row=row_begin; row<row_end; ++row )
   {
-    SimulationRegion * region = _system.region ( n );
-    region->DDMAC_Fill_Matrix_Vector ( A_, b_, J_, omega, add_value_flag );
+    PetscInt ncols;
+    MatGetRow ( X, row, &ncols, PETSC_NULL, PETSC_NULL );
+    if ( ncols ) rows.push_back ( row );
+    MatRestoreRow ( X, row, &ncols, PETSC_NULL, PETSC_NULL );
   }
+}
 
-  // evaluate Jacobian matrix of governing equations of EBM for all the boundaries
-  for ( unsigned int n=0; n<_system.get_bcs()->n_bcs(); ++n )
+
+
+/*------------------------------------------------------------------
+ * add the rows of X to Y
+ */
+static void add_matrix_rows ( Mat Y, const Mat X, const std::vector<PetscInt> & rows )
+{
+  for ( unsigned int i=0; i<rows.size(); ++i )
   {
-    BoundaryCondition * bc = _system.get_bcs()->get_bc ( n );
-    bc->DDMAC_Fill_Matrix_Vector ( A_, b_, J_, omega, add_value_flag );
+    const PetscInt row = rows[i];
+    PetscInt ncols;
+    const PetscInt    * cols;
+    const PetscScalar * vals;
+    MatGetRow ( X, row, &ncols, &cols, &vals );
+    MatSetValues ( Y, 1, &row, ncols, cols, vals, ADD_VALUES );
+    MatRestoreRow ( X, row, &ncols, &cols, &vals );
   }
+}
 
-  // assembly the matrix A
-  MatAssemblyBegin ( A_, MAT_FINAL_ASSEMBLY );
-  MatAssemblyEnd ( A_, MAT_FINAL_ASSEMBLY );
 
-  // assembly the vec b
-  VecAssemblyBegin ( b_ );
-  VecAssemblyEnd ( b_ );
 
+/*------------------------------------------------------------------
+ * the regions (except boundary nodes) and the transformation matrix are linear to omega.
+ * evaluate them at omega = 0 and omega = 1 once, each frequency only combines them.
+ * the same positions are filled for both omega, so the nonzero patterns are the same
+ */
+void DDMACSolver::assemble_ddm_ac()
+{
+  START_LOG ( "assemble_ddm_ac()", "DDMACSolver" );
+
+  // b is not used by the regions
+  VecZeroEntries ( b_ );
+
+  const PetscScalar omega[2] = {0.0, 1.0};
+  Mat K[2] = {K0_, K1_};
+  Mat T[2] = {T0_, T1_};
 
-  // process transformation matrix
+  for ( unsigned int i=0; i<2; ++i )
   {
-    MatZeroEntries ( T_ );
+    InsertMode add_value_flag = NOT_SET_VALUES;
+
+    MatZeroEntries ( K[i] );
+    for ( unsigned int n=0; n<_system.n_regions(); n++ )
+    {
+      SimulationRegion * region = _system.region ( n );
+      region->DDMAC_Fill_Matrix_Vector ( K[i], b_, J_, omega[i], add_value_flag );
+    }
+    MatAssemblyBegin ( K[i], MAT_FINAL_ASSEMBLY );
+    MatAssemblyEnd ( K[i], MAT_FINAL_ASSEMBLY );
+
     add_value_flag = NOT_SET_VALUES;
+    MatZeroEntries ( T[i] );
     for ( unsigned int n=0; n<_system.n_regions(); n++ )
     {
       SimulationRegion * region = _system.region ( n );
-      region->DDMAC_Fill_Transformation_Matrix ( T_, J_, omega, add_value_flag );
+      region->DDMAC_Fill_Transformation_Matrix ( T[i], J_, omega[i], add_value_flag );
     }
 
     if(Genius::processor_id() == Genius::n_processors() -1)
@@ -464,25 +1474,108 @@ void DDMACSolver::build_ddm_ac ( PetscScalar omega )
       {
         BoundaryCondition * bc = _system.get_bcs()->get_bc ( n );
         if ( !bc->is_electrode() ) continue;
-        MatSetValue ( T_, bc->global_offset(), bc->global_offset(), 1.0, ADD_VALUES );
-        MatSetValue ( T_, bc->global_offset() +1, bc->global_offset() +1, 1.0, ADD_VALUES );
+        MatSetValue ( T[i], bc->global_offset(), bc->global_offset(), 1.0, ADD_VALUES );
+        MatSetValue ( T[i], bc->global_offset() +1, bc->global_offset() +1, 1.0, ADD_VALUES );
       }
     }
 
+    MatAssemblyBegin ( T[i], MAT_FINAL_ASSEMBLY );
+    MatAssemblyEnd ( T[i], MAT_FINAL_ASSEMBLY );
+  }
+
+  STOP_LOG ( "assemble_ddm_ac()", "DDMACSolver" );
+}
+
+
+
+/*------------------------------------------------------------------
+ * build the matrix and right hand side vector b with certain freq omega
+ */
+void DDMACSolver::build_ddm_ac ( PetscScalar omega )
+{
+  build_ddm_ac_boundary ( omega );
+  build_ddm_ac_system ( omega );
+}
+
+
+
+/*------------------------------------------------------------------
+ * the boundary part of the matrix and right hand side vector with certain freq omega
+ */
+void DDMACSolver::build_ddm_ac_boundary ( PetscScalar omega )
+{
+
+  START_LOG ( "build_ddm_ac_boundary()", "DDMACSolver" );
+
+  MatZeroEntries ( B_ );
+  VecZeroEntries ( b_ );
+
+  InsertMode add_value_flag = NOT_SET_VALUES;
+
+  // evaluate Jacobian matrix of governing equations of EBM for all the boundaries.
+  // they are kept apart in B_, the reduced model of fast sweep only evaluates these rows again
+  for ( unsigned int n=0; n<_system.get_bcs()->n_bcs(); ++n )
+  {
+    BoundaryCondition * bc = _system.get_bcs()->get_bc ( n );
+    bc->DDMAC_Fill_Matrix_Vector ( B_, b_, J_, omega, add_value_flag );
+  }
+
+  MatAssemblyBegin ( B_, MAT_FINAL_ASSEMBLY );
+  MatAssemblyEnd ( B_, MAT_FINAL_ASSEMBLY );
+
+  nonempty_rows ( B_, _bc_rows );
+
+  // assembly the vec b
+  VecAssemblyBegin ( b_ );
+  VecAssemblyEnd ( b_ );
+
+  STOP_LOG ( "build_ddm_ac_boundary()", "DDMACSolver" );
+
+}
+
+
+
+/*------------------------------------------------------------------
+ * the whole system with certain freq omega, B_ and b_ should be filled before
+ */
+void DDMACSolver::build_ddm_ac_system ( PetscScalar omega )
+{
+
+  START_LOG ( "build_ddm_ac_system()", "DDMACSolver" );
+
+  // A_ = the regions part of the matrix, from the pre-assembled matrices, plus the boundary part
+  MatZeroEntries ( A_ );
+  add_omega_combination ( A_, K0_, K1_, omega );
+  add_matrix_rows ( A_, B_, _bc_rows );
+
+  // assembly the matrix A
+  MatAssemblyBegin ( A_, MAT_FINAL_ASSEMBLY );
+  MatAssemblyEnd ( A_, MAT_FINAL_ASSEMBLY );
+
+
+  // process transformation matrix
+  {
+    MatZeroEntries ( T_ );
+    add_omega_combination ( T_, T0_, T1_, omega );
+
     // assembly the transformation matrix
     MatAssemblyBegin ( T_, MAT_FINAL_ASSEMBLY );
     MatAssemblyEnd ( T_, MAT_FINAL_ASSEMBLY );
 
 
     // do transport
+    // the pattern of T*A does not change with omega, only numeric factorization is redone for A
     if ( _first_create )
     {
       MatMatMult ( T_, A_, MAT_INITIAL_MATRIX, PETSC_DEFAULT, &C_ );
+      MatCopy(C_, A, DIFFERENT_NONZERO_PATTERN);
       _first_create = false;
     }
     else
+    {
       MatMatMult ( T_, A_, MAT_REUSE_MATRIX , PETSC_DEFAULT, &C_ );
-    MatCopy(C_, A, DIFFERENT_NONZERO_PATTERN);
+      MatCopy(C_, A, SAME_NONZERO_PATTERN);
+    }
 
     MatMult ( T_, b_, b );
   }
@@ -491,8 +1584,6 @@ void DDMACSolver::build_ddm_ac ( PetscScalar omega )
   //MatView(A, PETSC_VIEWER_DRAW_WORLD);
   //getchar();
 
-  STOP_LOG ( "build_ddm_ac()", "DDMACSolver" );
+  STOP_LOG ( "build_ddm_ac_system()", "DDMACSolver" );
 
 }
-
-
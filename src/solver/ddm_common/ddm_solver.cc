@@ -271,6 +271,10 @@ void DDMSolverBase::snes_solve()
   SNESConvergedReason reason;
   SNESGetConvergedReason ( snes,&reason );
 
+  // a reused jacobian may be the cause of divergence, never carry it to the next try
+  if ( reason < 0 )
+    this->jacobian_invalidate();
+
   // if Line search failed, disable Line search
   if ( reason == SNES_DIVERGED_LINE_SEARCH || reason == SNES_DIVERGED_LOCAL_MIN )
   {
@@ -449,6 +453,67 @@ int DDMSolverBase::solve_dcsweep()
 
   PetscInt total_lits = 0;
 
+  // single sweep
+  if ( SolverSpecify::Electrode_VBranch.empty() )
+  {
+    ierr = solve_dcsweep_branch ( total_lits );
+  }
+  // a sequential family of sweeps, one for each branch voltage. the mesh, solver and matrix
+  // are set up once for the whole family. the branches run one after another since the
+  // FVM data, the nonlinear solver and SolverSpecify are shared by the process, so each
+  // branch starts from the same system state as if it was solved alone
+  else
+  {
+    std::vector<SimulationRegion::DataBackup> region_data(_system.n_regions());
+    for ( unsigned int r=0; r<_system.n_regions(); r++ )
+      _system.region(r)->backup_data ( region_data[r] );
+
+    std::map<std::string, std::vector<Real> > circuit_state;
+    _system.backup_circuit_state ( circuit_state );
+
+    for ( unsigned int b=0; b<SolverSpecify::VBranch.size(); b++ )
+    {
+      // show current branch value
+      MESSAGE << "DC Branch: V("  << SolverSpecify::Electrode_VBranch[0];
+      for ( unsigned int i=1; i<SolverSpecify::Electrode_VBranch.size(); i++ )
+        MESSAGE << ", "  << SolverSpecify::Electrode_VBranch[i];
+      MESSAGE << ") = "  << SolverSpecify::VBranch[b]/PhysicalUnit::V  <<" V" << '\n'
+      <<"================================================================================\n";
+      RECORD();
+
+      // drop the state left by previous branch
+      if ( b )
+      {
+        for ( unsigned int r=0; r<_system.n_regions(); r++ )
+          _system.region(r)->restore_data ( region_data[r] );
+        _system.restore_circuit_state ( circuit_state );
+      }
+
+      _system.get_electrical_source()->assign_voltage_to ( SolverSpecify::Electrode_VBranch, SolverSpecify::VBranch[b] );
+      SolverSpecify::VBranch_Index = b;
+
+      // a failed branch does not stop the remaining ones
+      if ( solve_dcsweep_branch ( total_lits ) )
+        ierr = 1;
+    }
+  }
+
+  SolverSpecify::tran_histroy = false;
+
+  return ierr;
+}
+
+
+
+/* ----------------------------------------------------------------------------
+ * one V or I sweep of solve_dcsweep() with the branch electrode(s) fixed.
+ * the initial guess is loaded from the FVM data of the system
+ */
+int DDMSolverBase::solve_dcsweep_branch ( PetscInt & total_lits )
+{
+  int ierr = 0;
+
+
   // voltage scan
   if ( SolverSpecify::Electrode_VScan.size() )
   {
@@ -547,6 +612,16 @@ int DDMSolverBase::solve_dcsweep()
         <<"--------------------------------------------------------------------------------\n"
         <<"      "<<SNESConvergedReasons[reason]<<", total linear iteration " << lits << "\n\n\n";
         RECORD();
+
+        // stop here for mesh adaptation, the sweep continues from Vscan on the refined mesh
+        if ( SolverSpecify::AdaptInterval && SolverSpecify::DC_Cycles == static_cast<int>(SolverSpecify::AdaptInterval) &&
+             SolverSpecify::Electrode_VBranch.empty() && V_retry.empty() &&
+             (Vscan*SolverSpecify::VStep) <= SolverSpecify::VStop*SolverSpecify::VStep* ( 1.0+1e-7 ) )
+        {
+          SolverSpecify::VStart = Vscan;
+          SolverSpecify::AdaptPending = true;
+          break;
+        }
       }
       else // oh, diverged... reduce step and try again
       {
@@ -719,6 +794,16 @@ int DDMSolverBase::solve_dcsweep()
         <<"--------------------------------------------------------------------------------\n"
         <<"      "<<SNESConvergedReasons[reason]<<", total linear iteration " << lits << "\n\n\n";
         RECORD();
+
+        // stop here for mesh adaptation, the sweep continues from Iscan on the refined mesh
+        if ( SolverSpecify::AdaptInterval && SolverSpecify::DC_Cycles == static_cast<int>(SolverSpecify::AdaptInterval) &&
+             SolverSpecify::Electrode_VBranch.empty() && I_retry.empty() &&
+             (Iscan*SolverSpecify::IStep) <= SolverSpecify::IStop*SolverSpecify::IStep* ( 1.0+1e-7 ) )
+        {
+          SolverSpecify::IStart = Iscan;
+          SolverSpecify::AdaptPending = true;
+          break;
+        }
       }
       else // oh, diverged... reduce step and try again
       {
@@ -791,9 +876,6 @@ int DDMSolverBase::solve_dcsweep()
     VecDestroy ( PetscDestroyObject(xs3) );
   }
 
-
-  SolverSpecify::tran_histroy = false;
-
   return ierr;
 }
 
@@ -1360,8 +1442,9 @@ int DDMSolverBase::solve_transient()
   // time dependent
   SolverSpecify::TimeDependent = true;
 
-  // if BDF2 scheme is used, we should set SolverSpecify::BDF2_LowerOrder flag to true
-  if ( SolverSpecify::TS_type==SolverSpecify::BDF2 )
+  // if BDF2 scheme is used, we should set SolverSpecify::BDF2_LowerOrder flag to true.
+  // a transient continued after mesh adaptation keeps the flag of its last step
+  if ( SolverSpecify::TS_type==SolverSpecify::BDF2 && !SolverSpecify::AdaptContinue )
     SolverSpecify::BDF2_LowerOrder = true;
 
   // we have a previous dc solution
@@ -1376,11 +1459,13 @@ int DDMSolverBase::solve_transient()
     }
   }
 
-  // transient simulation clock
-  SolverSpecify::clock = SolverSpecify::TStart + SolverSpecify::TStep;
+  // for the first step, dt equals TStep.
+  // a transient continued after mesh adaptation takes the next step of the last segment
+  if ( !SolverSpecify::AdaptContinue )
+    SolverSpecify::dt = SolverSpecify::TStep;
 
-  // for the first step, dt equals TStep
-  SolverSpecify::dt = SolverSpecify::TStep;
+  // transient simulation clock
+  SolverSpecify::clock = SolverSpecify::TStart + SolverSpecify::dt;
 
   MESSAGE<<"Transient compute from "<<SolverSpecify::TStart/s*1e12
       <<" ps step "<<SolverSpecify::TStep/s*1e12
@@ -1594,11 +1679,21 @@ int DDMSolverBase::solve_transient()
       SolverSpecify::clock = SolverSpecify::TStop;
     }
 
-
     //check if BDF2 can be used?
     if ( SolverSpecify::TS_type==SolverSpecify::BDF2 )
       SolverSpecify::BDF2_LowerOrder = this->BDF2_positive_defined();
 
+    // stop here for mesh adaptation, the transient continues from the last time step on the refined mesh
+    // with the time step dt, dt_last and the BDF2 flag above
+    if ( SolverSpecify::AdaptInterval && SolverSpecify::T_Cycles == static_cast<int>(SolverSpecify::AdaptInterval) &&
+         SolverSpecify::clock < SolverSpecify::TStop+0.5*SolverSpecify::dt &&
+         SolverSpecify::clock - SolverSpecify::dt + SolverSpecify::TStep < SolverSpecify::TStop )
+    {
+      SolverSpecify::TStart = SolverSpecify::clock - SolverSpecify::dt;
+      SolverSpecify::AdaptPending = true;
+      break;
+    }
+
     // use by auto step control and predict
     if( SolverSpecify::AutoStep  || SolverSpecify::Predict )
     {
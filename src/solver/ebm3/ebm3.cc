@@ -990,7 +990,9 @@ void EBM3Solver::build_petsc_sens_residual(Vec x, Vec r)
   for(unsigned int n=0; n<_system.n_regions(); n++)
   {
     SimulationRegion * region = _system.region(n);
+    region->assembly_perf().start();
     region->EBM3_Function(lxx, r, add_value_flag);
+    region->assembly_perf().stopit();
   }
 
 #if defined(HAVE_FENV_H) && defined(DEBUG)
@@ -1075,7 +1077,9 @@ void EBM3Solver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
   for(unsigned int n=0; n<_system.n_regions(); n++)
   {
     SimulationRegion * region = _system.region(n);
+    region->assembly_perf().start();
     region->EBM3_Jacobian(lxx, Jac, add_value_flag);
+    region->assembly_perf().stopit();
   }
 
 #if defined(HAVE_FENV_H) && defined(DEBUG)
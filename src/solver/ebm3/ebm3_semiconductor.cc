@@ -244,11 +244,27 @@ void SemiconductorSimulationRegion::EBM3_Function(PetscScalar * x, Vec f, Insert
   // first, search all the element in this region and process "cell" related terms
   // note, they are all local element, thus must be processed
 
-  const_element_iterator it = elements_begin();
-  const_element_iterator it_end = elements_end();
-  for(unsigned int nelem=0 ; it!=it_end; ++it, ++nelem)
+  // the elements are processed by threads. each thread owns a function buffer, they are merged
+  // by thread order, which keeps the serial order of elements.
+  // the impact ionization rate of a node is shared by elements, it is accumulated after the loop
+  const int n_threads = Genius::n_threads();
+  std::vector< std::vector<int> >         iy_thread(n_threads);
+  std::vector< std::vector<PetscScalar> > y_thread(n_threads);
+  std::vector< std::vector< std::pair<FVM_NodeData *, PetscScalar> > > impact_ionization_thread(n_threads);
+
+  const CellEdgeTable & edge_table = this->cell_edge_table();
+  const int n_elems = n_cell();
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+#endif
+  for(int nelem=0; nelem<n_elems; ++nelem)
   {
-    const Elem * elem = *it;
+    const Elem * elem = get_region_elem(nelem);
+
+    std::vector<int>         & iy_buffer = iy_thread[Genius::thread_id()];
+    std::vector<PetscScalar> & y_buffer  = y_thread[Genius::thread_id()];
+    std::vector< std::pair<FVM_NodeData *, PetscScalar> > & impact_ionization_buffer = impact_ionization_thread[Genius::thread_id()];
+
     FVM_CellData * elem_data = this->get_region_elem_data(nelem);
 
     bool insulator_interface_elem = is_elem_on_insulator_interface(elem);
@@ -413,29 +429,29 @@ void SemiconductorSimulationRegion::EBM3_Function(PetscScalar * x, Vec f, Insert
     // search for all the edges this cell own
     for(unsigned int ne=0; ne<elem->n_edges(); ++ne )
     {
-      std::pair<unsigned int, unsigned int> edge_nodes;
-      elem->nodes_on_edge(ne, edge_nodes);
+      const unsigned int edge = edge_table.cell_begin[nelem] + ne;
+      const std::pair<unsigned int, unsigned int> edge_nodes(edge_table.node1[edge], edge_table.node2[edge]);
 
       // the length of this edge
-      const double length = elem->edge_length(ne);
+      const double length = edge_table.length[edge];
 
       // fvm_node of node1
-      FVM_Node * fvm_n1 = elem->get_fvm_node(edge_nodes.first);
+      FVM_Node * fvm_n1 = edge_table.fvm_node1[edge];
       // fvm_node of node2
-      FVM_Node * fvm_n2 = elem->get_fvm_node(edge_nodes.second);
+      FVM_Node * fvm_n2 = edge_table.fvm_node2[edge];
 
       FVM_NodeData * n1_data = fvm_n1->node_data();  genius_assert(n1_data);            // fvm_node_data of node1
       FVM_NodeData * n2_data = fvm_n2->node_data();  genius_assert(n2_data);            // fvm_node_data of node2
 
-      double partial_area = elem->partial_area_with_edge(ne);        // partial area associated with this edge
-      double partial_volume = elem->partial_volume_with_edge(ne);    // partial volume associated with this edge
+      double partial_area = edge_table.partial_area[edge];        // partial area associated with this edge
+      double partial_volume = edge_table.partial_volume[edge];    // partial volume associated with this edge
       double truncated_partial_area =  partial_area;
       double truncated_partial_volume =  partial_volume;
       if(truncation)
       {
         // use truncated partial area to avoid negative area due to bad mesh elem
-        truncated_partial_area =  this->truncated_partial_area(elem, ne);
-        truncated_partial_volume =  elem->partial_volume_with_edge_truncated(ne);
+        truncated_partial_area =  edge_table.truncated_partial_area[edge];
+        truncated_partial_volume =  edge_table.truncated_partial_volume[edge];
       }
 
       unsigned int n1_local_offset = fvm_n1->local_offset();
@@ -633,39 +649,39 @@ void SemiconductorSimulationRegion::EBM3_Function(PetscScalar * x, Vec f, Insert
         {
 
           // poisson's equation
-          iy.push_back( fvm_n1->global_offset() + node_psi_offset );
-          y.push_back ( eps*(V2 - V1)/length*partial_area );
+          iy_buffer.push_back( fvm_n1->global_offset() + node_psi_offset );
+          y_buffer.push_back ( eps*(V2 - V1)/length*partial_area );
 
           // continuity equation of electron
-          iy.push_back( fvm_n1->global_offset() + node_n_offset );
-          y.push_back ( Jn*truncated_partial_area );
+          iy_buffer.push_back( fvm_n1->global_offset() + node_n_offset );
+          y_buffer.push_back ( Jn*truncated_partial_area );
 
           // continuity equation of hole
-          iy.push_back( fvm_n1->global_offset() + node_p_offset );
-          y.push_back ( - Jp*truncated_partial_area );
+          iy_buffer.push_back( fvm_n1->global_offset() + node_p_offset );
+          y_buffer.push_back ( - Jp*truncated_partial_area );
 
 
           // heat transport equation if required
           if(get_advanced_model()->enable_Tl())
           {
-            iy.push_back( fvm_n1->global_offset() + node_Tl_offset );
-            y.push_back ( kap*(T2 - T1)/length*partial_area + H*truncated_partial_area);
+            iy_buffer.push_back( fvm_n1->global_offset() + node_Tl_offset );
+            y_buffer.push_back ( kap*(T2 - T1)/length*partial_area + H*truncated_partial_area);
           }
 
 
           // energy balance equation for electron if required
           if(get_advanced_model()->enable_Tn())
           {
-            iy.push_back( fvm_n1->global_offset() + node_Tn_offset );
-            y.push_back ( -Sn*truncated_partial_area + Hn*truncated_partial_area);
+            iy_buffer.push_back( fvm_n1->global_offset() + node_Tn_offset );
+            y_buffer.push_back ( -Sn*truncated_partial_area + Hn*truncated_partial_area);
           }
 
 
           // energy balance equation for hole if required
           if(get_advanced_model()->enable_Tp())
           {
-            iy.push_back( fvm_n1->global_offset() + node_Tp_offset );
-            y.push_back ( -Sp*truncated_partial_area + Hp*truncated_partial_area);
+            iy_buffer.push_back( fvm_n1->global_offset() + node_Tp_offset );
+            y_buffer.push_back ( -Sp*truncated_partial_area + Hp*truncated_partial_area);
           }
 
         }
@@ -675,39 +691,39 @@ void SemiconductorSimulationRegion::EBM3_Function(PetscScalar * x, Vec f, Insert
         {
 
           // poisson's equation
-          iy.push_back( fvm_n2->global_offset() + node_psi_offset );
-          y.push_back ( eps*(V1 - V2)/length*partial_area );
+          iy_buffer.push_back( fvm_n2->global_offset() + node_psi_offset );
+          y_buffer.push_back ( eps*(V1 - V2)/length*partial_area );
 
           // continuity equation of electron
-          iy.push_back( fvm_n2->global_offset() + node_n_offset );
-          y.push_back ( - Jn*truncated_partial_area );
+          iy_buffer.push_back( fvm_n2->global_offset() + node_n_offset );
+          y_buffer.push_back ( - Jn*truncated_partial_area );
 
           // continuity equation of hole
-          iy.push_back( fvm_n2->global_offset() + node_p_offset );
-          y.push_back ( Jp*truncated_partial_area );
+          iy_buffer.push_back( fvm_n2->global_offset() + node_p_offset );
+          y_buffer.push_back ( Jp*truncated_partial_area );
 
 
           // heat transport equation if required
           if(get_advanced_model()->enable_Tl())
           {
-            iy.push_back( fvm_n2->global_offset() + node_Tl_offset );
-            y.push_back ( kap*(T1 - T2)/length*partial_area + H*truncated_partial_area);
+            iy_buffer.push_back( fvm_n2->global_offset() + node_Tl_offset );
+            y_buffer.push_back ( kap*(T1 - T2)/length*partial_area + H*truncated_partial_area);
           }
 
 
           // energy balance equation for electron if required
           if(get_advanced_model()->enable_Tn())
           {
-            iy.push_back( fvm_n2->global_offset() + node_Tn_offset );
-            y.push_back ( Sn*truncated_partial_area + Hn*truncated_partial_area);
+            iy_buffer.push_back( fvm_n2->global_offset() + node_Tn_offset );
+            y_buffer.push_back ( Sn*truncated_partial_area + Hn*truncated_partial_area);
           }
 
 
           // energy balance equation for hole if required
           if(get_advanced_model()->enable_Tp())
           {
-            iy.push_back( fvm_n2->global_offset() + node_Tp_offset );
-            y.push_back ( Sp*truncated_partial_area + Hp*truncated_partial_area);
+            iy_buffer.push_back( fvm_n2->global_offset() + node_Tp_offset );
+            y_buffer.push_back ( Sp*truncated_partial_area + Hp*truncated_partial_area);
           }
 
         }
@@ -720,21 +736,21 @@ void SemiconductorSimulationRegion::EBM3_Function(PetscScalar * x, Vec f, Insert
           if( fvm_n1->root_node()->processor_id()==Genius::processor_id() )
           {
             // continuity equation
-            iy.push_back( fvm_n1->global_offset() + node_n_offset );
-            y.push_back ( 0.5*GBTBT1*truncated_partial_volume );
+            iy_buffer.push_back( fvm_n1->global_offset() + node_n_offset );
+            y_buffer.push_back ( 0.5*GBTBT1*truncated_partial_volume );
 
-            iy.push_back( fvm_n1->global_offset() + node_p_offset );
-            y.push_back ( 0.5*GBTBT1*truncated_partial_volume );
+            iy_buffer.push_back( fvm_n1->global_offset() + node_p_offset );
+            y_buffer.push_back ( 0.5*GBTBT1*truncated_partial_volume );
           }
 
           if( fvm_n2->root_node()->processor_id()==Genius::processor_id() )
           {
             // continuity equation
-            iy.push_back( fvm_n2->global_offset() + node_n_offset );
-            y.push_back ( 0.5*GBTBT2*truncated_partial_volume );
+            iy_buffer.push_back( fvm_n2->global_offset() + node_n_offset );
+            y_buffer.push_back ( 0.5*GBTBT2*truncated_partial_volume );
 
-            iy.push_back( fvm_n2->global_offset() + node_p_offset );
-            y.push_back ( 0.5*GBTBT2*truncated_partial_volume );
+            iy_buffer.push_back( fvm_n2->global_offset() + node_p_offset );
+            y_buffer.push_back ( 0.5*GBTBT2*truncated_partial_volume );
           }
         }
 
@@ -794,50 +810,50 @@ void SemiconductorSimulationRegion::EBM3_Function(PetscScalar * x, Vec f, Insert
           if( fvm_n1->root_node()->processor_id()==Genius::processor_id() )
           {
             // continuity equation
-            iy.push_back( fvm_n1->global_offset() + node_n_offset );
-            y.push_back ( (riin1*GIIn+riip1*GIIp)*truncated_partial_volume );
+            iy_buffer.push_back( fvm_n1->global_offset() + node_n_offset );
+            y_buffer.push_back ( (riin1*GIIn+riip1*GIIp)*truncated_partial_volume );
 
-            iy.push_back( fvm_n1->global_offset() + node_p_offset );
-            y.push_back ( (riin1*GIIn+riip1*GIIp)*truncated_partial_volume );
+            iy_buffer.push_back( fvm_n1->global_offset() + node_p_offset );
+            y_buffer.push_back ( (riin1*GIIn+riip1*GIIp)*truncated_partial_volume );
 
-            n1_data->ImpactIonization() += (riin1*GIIn+riip1*GIIp)*truncated_partial_volume/fvm_n1->volume();
+            impact_ionization_buffer.push_back( std::make_pair(n1_data, (riin1*GIIn+riip1*GIIp)*truncated_partial_volume/fvm_n1->volume()) );
 
             if (get_advanced_model()->enable_Tn())
             {
               Hn = - (Eg+1.5*kb*Tp) * riin1*GIIn + 1.5*kb*Tn * riip1*GIIp;
-              iy.push_back(fvm_n1->global_offset()+node_Tn_offset);
-              y.push_back( Hn*truncated_partial_volume );
+              iy_buffer.push_back(fvm_n1->global_offset()+node_Tn_offset);
+              y_buffer.push_back( Hn*truncated_partial_volume );
             }
             if (get_advanced_model()->enable_Tp())
             {
               Hp = - (Eg+1.5*kb*Tn) * riip1*GIIp + 1.5*kb*Tp * riin1*GIIn;
-              iy.push_back(fvm_n1->global_offset()+node_Tp_offset);
-              y.push_back( Hp*truncated_partial_volume );
+              iy_buffer.push_back(fvm_n1->global_offset()+node_Tp_offset);
+              y_buffer.push_back( Hp*truncated_partial_volume );
             }
           }
 
           if( fvm_n2->root_node()->processor_id()==Genius::processor_id() )
           {
             // continuity equation
-            iy.push_back( fvm_n2->global_offset() + node_n_offset );
-            y.push_back ( (riin2*GIIn+riip2*GIIp)*truncated_partial_volume );
+            iy_buffer.push_back( fvm_n2->global_offset() + node_n_offset );
+            y_buffer.push_back ( (riin2*GIIn+riip2*GIIp)*truncated_partial_volume );
 
-            iy.push_back( fvm_n2->global_offset() + node_p_offset );
-            y.push_back ( (riin2*GIIn+riip2*GIIp)*truncated_partial_volume );
+            iy_buffer.push_back( fvm_n2->global_offset() + node_p_offset );
+            y_buffer.push_back ( (riin2*GIIn+riip2*GIIp)*truncated_partial_volume );
 
-            n2_data->ImpactIonization() += (riin2*GIIn+riip2*GIIp)*truncated_partial_volume/fvm_n2->volume();
+            impact_ionization_buffer.push_back( std::make_pair(n2_data, (riin2*GIIn+riip2*GIIp)*truncated_partial_volume/fvm_n2->volume()) );
 
             if (get_advanced_model()->enable_Tn())
             {
               Hn = - (Eg+1.5*kb*Tp) * riin2*GIIn + 1.5*kb*Tn * riip2*GIIp;
-              iy.push_back(fvm_n2->global_offset()+node_Tn_offset);
-              y.push_back( Hn*truncated_partial_volume );
+              iy_buffer.push_back(fvm_n2->global_offset()+node_Tn_offset);
+              y_buffer.push_back( Hn*truncated_partial_volume );
             }
             if (get_advanced_model()->enable_Tp())
             {
               Hp = - (Eg+1.5*kb*Tn) * riip2*GIIp + 1.5*kb*Tp * riin2*GIIn;
-              iy.push_back(fvm_n2->global_offset()+node_Tp_offset);
-              y.push_back( Hp*truncated_partial_volume );
+              iy_buffer.push_back(fvm_n2->global_offset()+node_Tp_offset);
+              y_buffer.push_back( Hp*truncated_partial_volume );
             }
           }
         }
@@ -851,17 +867,34 @@ void SemiconductorSimulationRegion::EBM3_Function(PetscScalar * x, Vec f, Insert
 
   }
 
+  for(int t=0; t<n_threads; ++t)
+  {
+    iy.insert(iy.end(), iy_thread[t].begin(), iy_thread[t].end());
+    y.insert(y.end(), y_thread[t].begin(), y_thread[t].end());
+    for(unsigned int k=0; k<impact_ionization_thread[t].size(); ++k)
+      impact_ionization_thread[t][k].first->ImpactIonization() += impact_ionization_thread[t][k].second;
+    iy_thread[t].clear();
+    y_thread[t].clear();
+  }
+
 #if defined(HAVE_FENV_H) && defined(DEBUG)
   genius_assert( !fetestexcept(FE_INVALID) );
 #endif
 
   // process node related terms
   // including \rho of poisson's equation and recombination term of continuation equation
-  const_processor_node_iterator node_it = on_processor_nodes_begin();
-  const_processor_node_iterator node_it_end = on_processor_nodes_end();
-  for(; node_it!=node_it_end; ++node_it)
+  // the nodes are processed by threads with their own function buffers
+  const int n_nodes = n_on_processor_node();
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+#endif
+  for(int i=0; i<n_nodes; ++i)
   {
-    const FVM_Node * fvm_node = *node_it;
+    const FVM_Node * fvm_node = *(on_processor_nodes_begin() + i);
+
+    std::vector<int>         & iy_buffer = iy_thread[Genius::thread_id()];
+    std::vector<PetscScalar> & y_buffer  = y_thread[Genius::thread_id()];
+
     const FVM_NodeData * node_data = fvm_node->node_data();
 
 
@@ -889,8 +922,8 @@ void SemiconductorSimulationRegion::EBM3_Function(PetscScalar * x, Vec f, Insert
 
     // the charge density
     PetscScalar rho = e*(node_data->Net_doping() + p - n)*fvm_node->volume();
-    iy.push_back(fvm_node->global_offset()+node_psi_offset);
-    y.push_back( rho );
+    iy_buffer.push_back(fvm_node->global_offset()+node_psi_offset);
+    y_buffer.push_back( rho );
 
     // the recombination term
     PetscScalar R_SHR  = mt->band->R_SHR(p,n,T);
@@ -903,10 +936,10 @@ void SemiconductorSimulationRegion::EBM3_Function(PetscScalar * x, Vec f, Insert
     PetscScalar Field_G = node_data->Field_G()*fvm_node->volume();
     PetscScalar OptQ = node_data->OptQ()*fvm_node->volume();
 
-    iy.push_back(fvm_node->global_offset()+node_n_offset);
-    iy.push_back(fvm_node->global_offset()+node_p_offset);
-    y.push_back( Field_G - R  + node_data->EIn());
-    y.push_back( Field_G - R  + node_data->HIn());
+    iy_buffer.push_back(fvm_node->global_offset()+node_n_offset);
+    iy_buffer.push_back(fvm_node->global_offset()+node_p_offset);
+    y_buffer.push_back( Field_G - R  + node_data->EIn());
+    y_buffer.push_back( Field_G - R  + node_data->HIn());
 
     // process heat consume due to R/G and collision
     PetscScalar H=0, Hn=0, Hp=0;
@@ -935,20 +968,20 @@ void SemiconductorSimulationRegion::EBM3_Function(PetscScalar * x, Vec f, Insert
     // save extra equation to data buffer if required
     if(get_advanced_model()->enable_Tl())
     {
-      iy.push_back(fvm_node->global_offset()+node_Tl_offset);
-      y.push_back( H*fvm_node->volume() );
+      iy_buffer.push_back(fvm_node->global_offset()+node_Tl_offset);
+      y_buffer.push_back( H*fvm_node->volume() );
     }
 
     if(get_advanced_model()->enable_Tn())
     {
-      iy.push_back(fvm_node->global_offset()+node_Tn_offset);
-      y.push_back( Hn*fvm_node->volume() );
+      iy_buffer.push_back(fvm_node->global_offset()+node_Tn_offset);
+      y_buffer.push_back( Hn*fvm_node->volume() );
     }
 
     if(get_advanced_model()->enable_Tp())
     {
-      iy.push_back(fvm_node->global_offset()+node_Tp_offset);
-      y.push_back( Hp*fvm_node->volume() );
+      iy_buffer.push_back(fvm_node->global_offset()+node_Tp_offset);
+      y_buffer.push_back( Hp*fvm_node->volume() );
     }
 
 
@@ -964,31 +997,31 @@ void SemiconductorSimulationRegion::EBM3_Function(PetscScalar * x, Vec f, Insert
       PetscScalar TrappedC = mt->trap->Charge(true);
       if (TrappedC !=0)
       {
-        iy.push_back(fvm_node->global_offset()+node_psi_offset);
-        y.push_back(TrappedC * fvm_node->volume());
+        iy_buffer.push_back(fvm_node->global_offset()+node_psi_offset);
+        y_buffer.push_back(TrappedC * fvm_node->volume());
       }
 
       // calculate the rates of electron and hole capture
       PetscScalar TrapElec = mt->trap->ElectronTrapRate(true,n,ni,T);
       PetscScalar TrapHole = mt->trap->HoleTrapRate    (true,p,ni,T);
 
-      iy.push_back(fvm_node->global_offset()+node_n_offset);
-      iy.push_back(fvm_node->global_offset()+node_p_offset);
-      y.push_back( - TrapElec * fvm_node->volume());
-      y.push_back( - TrapHole * fvm_node->volume());
+      iy_buffer.push_back(fvm_node->global_offset()+node_n_offset);
+      iy_buffer.push_back(fvm_node->global_offset()+node_p_offset);
+      y_buffer.push_back( - TrapElec * fvm_node->volume());
+      y_buffer.push_back( - TrapHole * fvm_node->volume());
 
       if(get_advanced_model()->enable_Tn())
       {
         Hn = - 1.5 * kb*Tn * TrapElec;
-        iy.push_back(fvm_node->global_offset()+node_Tn_offset);
-        y.push_back( Hn*fvm_node->volume() );
+        iy_buffer.push_back(fvm_node->global_offset()+node_Tn_offset);
+        y_buffer.push_back( Hn*fvm_node->volume() );
       }
 
       if(get_advanced_model()->enable_Tp())
       {
         Hp = - 1.5 * kb*Tp * TrapHole;
-        iy.push_back(fvm_node->global_offset()+node_Tp_offset);
-        y.push_back( Hp*fvm_node->volume() );
+        iy_buffer.push_back(fvm_node->global_offset()+node_Tp_offset);
+        y_buffer.push_back( Hp*fvm_node->volume() );
       }
 
       if(get_advanced_model()->enable_Tl())
@@ -996,13 +1029,19 @@ void SemiconductorSimulationRegion::EBM3_Function(PetscScalar * x, Vec f, Insert
         PetscScalar EcEi = 0.5*Eg - kb*T*log(node_data->Nc()/node_data->Nv());
         PetscScalar EiEv = 0.5*Eg + kb*T*log(node_data->Nc()/node_data->Nv());
         H = mt->trap->TrapHeat(true,p,n,ni,Tp,Tn,T,EcEi,EiEv);
-        iy.push_back(fvm_node->global_offset()+node_Tl_offset);
-        y.push_back( H*fvm_node->volume() );
+        iy_buffer.push_back(fvm_node->global_offset()+node_Tl_offset);
+        y_buffer.push_back( H*fvm_node->volume() );
       }
     }
   }
 
 
+  for(int t=0; t<n_threads; ++t)
+  {
+    iy.insert(iy.end(), iy_thread[t].begin(), iy_thread[t].end());
+    y.insert(y.end(), y_thread[t].begin(), y_thread[t].end());
+  }
+
   // add into petsc vector, we should prevent zero length vector add here.
   if(iy.size())  VecSetValues(f, iy.size(), &iy[0], &y[0], ADD_VALUES);
 
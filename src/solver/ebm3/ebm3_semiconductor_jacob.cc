@@ -29,6 +29,7 @@
 #include "jflux1.h"
 #include "jflux2.h"
 #include "jflux3.h"
+#include "sparse_matrix_buffer.h"
 
 
 using PhysicalUnit::kb;
@@ -65,11 +66,22 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, SparseMatrix<
   // search all the element in this region.
   // note, they are all local element, thus must be processed
 
-  const_element_iterator it = elements_begin();
-  const_element_iterator it_end = elements_end();
-  for(; it!=it_end; ++it)
+  // the elements are processed by threads. each thread owns a jacobian buffer, they are added to
+  // jac by thread order, which keeps the serial order of elements.
+  const int n_threads = Genius::n_threads();
+  std::vector< SparseMatrixBuffer<PetscScalar> > jac_thread(n_threads);
+
+  const CellEdgeTable & edge_table = this->cell_edge_table();
+  const int n_elems = n_cell();
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+#endif
+  for(int nelem=0; nelem<n_elems; ++nelem)
   {
-    const Elem * elem = *it;
+    const Elem * elem = get_region_elem(nelem);
+
+    SparseMatrixBuffer<PetscScalar> & jac_buffer = jac_thread[Genius::thread_id()];
+
     bool insulator_interface_elem = is_elem_on_insulator_interface(elem);
     bool mos_channel_elem = is_elem_in_mos_channel(elem);
     bool truncation =  SolverSpecify::VoronoiTruncation == SolverSpecify::VoronoiTruncationAlways ||
@@ -264,31 +276,31 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, SparseMatrix<
     // search for all the Edge this cell own
     for(unsigned int ne=0; ne<elem->n_edges(); ++ne )
     {
-      std::pair<unsigned int, unsigned int> edge_nodes;
-      elem->nodes_on_edge(ne, edge_nodes);
+      const unsigned int edge = edge_table.cell_begin[nelem] + ne;
+      const std::pair<unsigned int, unsigned int> edge_nodes(edge_table.node1[edge], edge_table.node2[edge]);
 
       // the length of this edge
-      const double length = elem->edge_length(ne);
+      const double length = edge_table.length[edge];
 
       // fvm_node of node1
-      const FVM_Node * fvm_n1 = elem->get_fvm_node(edge_nodes.first);
+      const FVM_Node * fvm_n1 = edge_table.fvm_node1[edge];
       // fvm_node of node2
-      const FVM_Node * fvm_n2 = elem->get_fvm_node(edge_nodes.second);
+      const FVM_Node * fvm_n2 = edge_table.fvm_node2[edge];
 
       // fvm_node_data of node1
       const FVM_NodeData * n1_data =  fvm_n1->node_data() ;   genius_assert(n1_data);
       // fvm_node_data of node2
       const FVM_NodeData * n2_data =  fvm_n2->node_data() ;   genius_assert(n2_data);
 
-      double partial_area = elem->partial_area_with_edge(ne);        // partial area associated with this edge
-      double partial_volume = elem->partial_volume_with_edge(ne);    // partial volume associated with this edge
+      double partial_area = edge_table.partial_area[edge];        // partial area associated with this edge
+      double partial_volume = edge_table.partial_volume[edge];    // partial volume associated with this edge
       double truncated_partial_area =  partial_area;
       double truncated_partial_volume =  partial_volume;
       if(truncation)
       {
         // use truncated partial area to avoid negative area due to bad mesh elem
-        truncated_partial_area =  this->truncated_partial_area(elem, ne);
-        truncated_partial_volume =  elem->partial_volume_with_edge_truncated(ne);
+        truncated_partial_area =  edge_table.truncated_partial_area[edge];
+        truncated_partial_volume =  edge_table.truncated_partial_volume[edge];
       }
 
       unsigned int n1_local_offset = fvm_n1->local_offset();
@@ -459,37 +471,73 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, SparseMatrix<
         AutoDScalar kap = 0.5*(kap1+kap2); // kapa at mid point of the edge
 
 
+        // the S-G flux and the poisson flux only depend on the 2*n_node_var variables of the edge,
+        // evaluate them with the fixed size AD scalar and expand to the element directions.
+        // the band edges and temperatures are computed on AutoDScalar, they are gathered at this boundary
+        const unsigned int n_edge_var = 2*n_node_var;
+        unsigned int order[12];
+        for(unsigned int nv=0; nv<n_node_var; ++nv)
+        {
+          order[nv]            = n_node_var*edge_nodes.first  + nv;
+          order[n_node_var+nv] = n_node_var*edge_nodes.second + nv;
+        }
+
+        AutoDScalar12 V1_e = V1.getValue();    V1_e.setADValue(node_psi_offset, 1.0);
+        AutoDScalar12 n1_e = n1.getValue();    n1_e.setADValue(node_n_offset, 1.0);
+        AutoDScalar12 p1_e = p1.getValue();    p1_e.setADValue(node_p_offset, 1.0);
+        AutoDScalar12 V2_e = V2.getValue();    V2_e.setADValue(n_node_var+node_psi_offset, 1.0);
+        AutoDScalar12 n2_e = n2.getValue();    n2_e.setADValue(n_node_var+node_n_offset, 1.0);
+        AutoDScalar12 p2_e = p2.getValue();    p2_e.setADValue(n_node_var+node_p_offset, 1.0);
+
+        const AutoDScalar12 T1_e  = AutoDScalar12::gather(T1,  order, n_edge_var);
+        const AutoDScalar12 T2_e  = AutoDScalar12::gather(T2,  order, n_edge_var);
+        const AutoDScalar12 Ec1_e = AutoDScalar12::gather(Ec1, order, n_edge_var);
+        const AutoDScalar12 Ec2_e = AutoDScalar12::gather(Ec2, order, n_edge_var);
+        const AutoDScalar12 Ev1_e = AutoDScalar12::gather(Ev1, order, n_edge_var);
+        const AutoDScalar12 Ev2_e = AutoDScalar12::gather(Ev2, order, n_edge_var);
+
         // S-G current along the edge, call different SG scheme selected by EBM level
         AutoDScalar Jn, Jp, Sn=0, Sp=0;
 
         switch(Jn_level)
         {
         case 1:
-          Jn =  mun*In_dd(kb*T_external()/e, (Ec2-Ec1)/e, n1, n2, length);
+          Jn =  mun*In_dd(kb*T_external()/e, (Ec2_e-Ec1_e)/e, n1_e, n2_e, length).expand(order, n_edge_var);
           break;
         case 2:
-          Jn =  mun*In_lt(kb, e, (Ec1-Ec2)/e, n1, n2, 0.5*(T1+T2), T2-T1, length);
+          Jn =  mun*In_lt(kb, e, (Ec1_e-Ec2_e)/e, n1_e, n2_e, 0.5*(T1_e+T2_e), T2_e-T1_e, length).expand(order, n_edge_var);
           break;
         case 3:
-          Jn =  mun*In_eb(kb, e, -Ec1/e, -Ec2/e, n1, n2, Tn1, Tn2, length);
-          Sn =  mun*Sn_eb(kb, e, -Ec1/e, -Ec2/e, n1, n2, Tn1, Tn2, length);
-          break;
+          {
+            const AutoDScalar12 Tn1_e = AutoDScalar12::gather(Tn1, order, n_edge_var);
+            const AutoDScalar12 Tn2_e = AutoDScalar12::gather(Tn2, order, n_edge_var);
+            Jn =  mun*In_eb(kb, e, -Ec1_e/e, -Ec2_e/e, n1_e, n2_e, Tn1_e, Tn2_e, length).expand(order, n_edge_var);
+            Sn =  mun*Sn_eb(kb, e, -Ec1_e/e, -Ec2_e/e, n1_e, n2_e, Tn1_e, Tn2_e, length).expand(order, n_edge_var);
+            break;
+          }
         }
 
         switch(Jp_level)
         {
         case 1:
-          Jp =  mup*Ip_dd(kb*T_external()/e, (Ev2-Ev1)/e, p1, p2, length);
+          Jp =  mup*Ip_dd(kb*T_external()/e, (Ev2_e-Ev1_e)/e, p1_e, p2_e, length).expand(order, n_edge_var);
           break;
         case 2:
-          Jp =  mup*Ip_lt(kb, e, (Ev1-Ev2)/e, p1, p2, 0.5*(T1+T2), T2-T1, length);
+          Jp =  mup*Ip_lt(kb, e, (Ev1_e-Ev2_e)/e, p1_e, p2_e, 0.5*(T1_e+T2_e), T2_e-T1_e, length).expand(order, n_edge_var);
           break;
         case 3:
-          Jp =  mup*Ip_eb(kb, e, -Ev1/e, -Ev2/e, p1, p2, Tp1, Tp2, length);
-          Sp =  mup*Sp_eb(kb, e, -Ev1/e, -Ev2/e, p1, p2, Tp1, Tp2, length);
-          break;
+          {
+            const AutoDScalar12 Tp1_e = AutoDScalar12::gather(Tp1, order, n_edge_var);
+            const AutoDScalar12 Tp2_e = AutoDScalar12::gather(Tp2, order, n_edge_var);
+            Jp =  mup*Ip_eb(kb, e, -Ev1_e/e, -Ev2_e/e, p1_e, p2_e, Tp1_e, Tp2_e, length).expand(order, n_edge_var);
+            Sp =  mup*Sp_eb(kb, e, -Ev1_e/e, -Ev2_e/e, p1_e, p2_e, Tp1_e, Tp2_e, length).expand(order, n_edge_var);
+            break;
+          }
         }
 
+        // poisson flux from node 1 to node 2
+        const AutoDScalar12 f_phi = eps*(V2_e - V1_e)/length*partial_area;
+
 
         // joule heating
         AutoDScalar H=0, Hn=0, Hp=0;
@@ -513,20 +561,20 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, SparseMatrix<
         if( fvm_n1->root_node()->processor_id()==Genius::processor_id() )
         {
 
-          AutoDScalar poisson = ( eps*(V2 - V1)/length*partial_area );
-          jac->add_row(  row1[node_psi_offset],  cell_col.size(),  &cell_col[0],  poisson.getADValue() );
+          AutoDScalar poisson = f_phi.expand(order, n_edge_var);
+          jac_buffer.add_row(  row1[node_psi_offset],  cell_col.size(),  &cell_col[0],  poisson.getADValue() );
 
           AutoDScalar electron_continuation = ( Jn*truncated_partial_area );
-          jac->add_row(  row1[node_n_offset],  cell_col.size(),  &cell_col[0],  electron_continuation.getADValue() );
+          jac_buffer.add_row(  row1[node_n_offset],  cell_col.size(),  &cell_col[0],  electron_continuation.getADValue() );
 
           AutoDScalar hole_continuation = ( - Jp*truncated_partial_area );
-          jac->add_row(  row1[node_p_offset],  cell_col.size(),  &cell_col[0],  hole_continuation.getADValue() );
+          jac_buffer.add_row(  row1[node_p_offset],  cell_col.size(),  &cell_col[0],  hole_continuation.getADValue() );
 
           // heat transport equation if required
           if(get_advanced_model()->enable_Tl())
           {
             AutoDScalar heating_equ = ( kap*(T2 - T1)/length*partial_area + H*truncated_partial_area);
-            jac->add_row(  row1[node_Tl_offset],  cell_col.size(),  &cell_col[0],  heating_equ.getADValue() );
+            jac_buffer.add_row(  row1[node_Tl_offset],  cell_col.size(),  &cell_col[0],  heating_equ.getADValue() );
           }
 
 
@@ -534,7 +582,7 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, SparseMatrix<
           if(get_advanced_model()->enable_Tn())
           {
             AutoDScalar electron_energy = -Sn*truncated_partial_area + Hn*truncated_partial_area;
-            jac->add_row(  row1[node_Tn_offset],  cell_col.size(),  &cell_col[0],  electron_energy.getADValue() );
+            jac_buffer.add_row(  row1[node_Tn_offset],  cell_col.size(),  &cell_col[0],  electron_energy.getADValue() );
           }
 
 
@@ -542,7 +590,7 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, SparseMatrix<
           if(get_advanced_model()->enable_Tp())
           {
             AutoDScalar hole_energy = -Sp*truncated_partial_area + Hp*truncated_partial_area;
-            jac->add_row(  row1[node_Tp_offset],  cell_col.size(),  &cell_col[0],  hole_energy.getADValue() );
+            jac_buffer.add_row(  row1[node_Tp_offset],  cell_col.size(),  &cell_col[0],  hole_energy.getADValue() );
           }
 
         }
@@ -550,34 +598,34 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, SparseMatrix<
         if( fvm_n2->root_node()->processor_id()==Genius::processor_id() )
         {
 
-          AutoDScalar poisson = ( eps*(V1 - V2)/length*partial_area );
-          jac->add_row(  row2[node_psi_offset],  cell_col.size(),  &cell_col[0],  poisson.getADValue() );
+          AutoDScalar poisson = (-f_phi).expand(order, n_edge_var);
+          jac_buffer.add_row(  row2[node_psi_offset],  cell_col.size(),  &cell_col[0],  poisson.getADValue() );
 
           AutoDScalar electron_continuation = ( - Jn*truncated_partial_area );
-          jac->add_row(  row2[node_n_offset],  cell_col.size(),  &cell_col[0],  electron_continuation.getADValue() );
+          jac_buffer.add_row(  row2[node_n_offset],  cell_col.size(),  &cell_col[0],  electron_continuation.getADValue() );
 
           AutoDScalar hole_continuation = ( Jp*truncated_partial_area );
-          jac->add_row(  row2[node_p_offset],  cell_col.size(),  &cell_col[0],  hole_continuation.getADValue() );
+          jac_buffer.add_row(  row2[node_p_offset],  cell_col.size(),  &cell_col[0],  hole_continuation.getADValue() );
 
           // heat transport equation if required
           if(get_advanced_model()->enable_Tl())
           {
             AutoDScalar heating_equ = ( kap*(T1 - T2)/length*partial_area + H*truncated_partial_area);
-            jac->add_row(  row2[node_Tl_offset],  cell_col.size(),  &cell_col[0],  heating_equ.getADValue() );
+            jac_buffer.add_row(  row2[node_Tl_offset],  cell_col.size(),  &cell_col[0],  heating_equ.getADValue() );
           }
 
           // energy balance equation for electron if required
           if(get_advanced_model()->enable_Tn())
           {
             AutoDScalar electron_energy = Sn*truncated_partial_area + Hn*truncated_partial_area;
-            jac->add_row(  row2[node_Tn_offset],  cell_col.size(),  &cell_col[0],  electron_energy.getADValue() );
+            jac_buffer.add_row(  row2[node_Tn_offset],  cell_col.size(),  &cell_col[0],  electron_energy.getADValue() );
           }
 
           // energy balance equation for hole if required
           if(get_advanced_model()->enable_Tp())
           {
             AutoDScalar hole_energy = Sp*truncated_partial_area + Hp*truncated_partial_area;
-            jac->add_row(  row2[node_Tp_offset],  cell_col.size(),  &cell_col[0],  hole_energy.getADValue() );
+            jac_buffer.add_row(  row2[node_Tp_offset],  cell_col.size(),  &cell_col[0],  hole_energy.getADValue() );
           }
 
         }
@@ -592,16 +640,16 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, SparseMatrix<
           {
             // continuity equation
             AutoDScalar continuity = 0.5*GBTBT1*truncated_partial_volume;
-            jac->add_row(  row1[node_n_offset],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
-            jac->add_row(  row1[node_p_offset],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
+            jac_buffer.add_row(  row1[node_n_offset],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
+            jac_buffer.add_row(  row1[node_p_offset],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
           }
 
           if( fvm_n2->root_node()->processor_id()==Genius::processor_id() )
           {
             // continuity equation
             AutoDScalar continuity = 0.5*GBTBT2*truncated_partial_volume;
-            jac->add_row(  row2[node_n_offset],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
-            jac->add_row(  row2[node_p_offset],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
+            jac_buffer.add_row(  row2[node_n_offset],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
+            jac_buffer.add_row(  row2[node_p_offset],  cell_col.size(),  &cell_col[0],  continuity.getADValue() );
           }
         }
 
@@ -665,20 +713,20 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, SparseMatrix<
             // continuity equation
             AutoDScalar electron_continuity = (riin1*GIIn+riip1*GIIp)*truncated_partial_volume ;
             AutoDScalar hole_continuity     = (riin1*GIIn+riip1*GIIp)*truncated_partial_volume ;
-            jac->add_row(  row1[node_n_offset],  cell_col.size(),  &cell_col[0],  electron_continuity.getADValue() );
-            jac->add_row(  row1[node_p_offset],  cell_col.size(),  &cell_col[0],  hole_continuity.getADValue() );
+            jac_buffer.add_row(  row1[node_n_offset],  cell_col.size(),  &cell_col[0],  electron_continuity.getADValue() );
+            jac_buffer.add_row(  row1[node_p_offset],  cell_col.size(),  &cell_col[0],  hole_continuity.getADValue() );
 
             if (get_advanced_model()->enable_Tn())
             {
               Hn = - (Eg+1.5*kb*Tp) * riin1*GIIn + 1.5*kb*Tn * riip1*GIIp;
               AutoDScalar electron_energy = Hn*truncated_partial_volume;
-              jac->add_row(  row1[node_Tn_offset],  cell_col.size(),  &cell_col[0],  electron_energy.getADValue() );
+              jac_buffer.add_row(  row1[node_Tn_offset],  cell_col.size(),  &cell_col[0],  electron_energy.getADValue() );
             }
             if (get_advanced_model()->enable_Tp())
             {
               Hp = - (Eg+1.5*kb*Tn) * riip1*GIIp + 1.5*kb*Tp * riin1*GIIn;
               AutoDScalar hole_energy = Hp*truncated_partial_volume;
-              jac->add_row(  row1[node_Tp_offset],  cell_col.size(),  &cell_col[0],  hole_energy.getADValue() );
+              jac_buffer.add_row(  row1[node_Tp_offset],  cell_col.size(),  &cell_col[0],  hole_energy.getADValue() );
             }
           }
 
@@ -687,20 +735,20 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, SparseMatrix<
             // continuity equation of electron
             AutoDScalar electron_continuity = (riin2*GIIn+riip2*GIIp)*truncated_partial_volume ;
             AutoDScalar hole_continuity     = (riin2*GIIn+riip2*GIIp)*truncated_partial_volume ;
-            jac->add_row(  row2[node_n_offset],  cell_col.size(),  &cell_col[0],  electron_continuity.getADValue() );
-            jac->add_row(  row2[node_p_offset],  cell_col.size(),  &cell_col[0],  hole_continuity.getADValue() );
+            jac_buffer.add_row(  row2[node_n_offset],  cell_col.size(),  &cell_col[0],  electron_continuity.getADValue() );
+            jac_buffer.add_row(  row2[node_p_offset],  cell_col.size(),  &cell_col[0],  hole_continuity.getADValue() );
 
             if (get_advanced_model()->enable_Tn())
             {
               Hn = - (Eg+1.5*kb*Tp) * riin2*GIIn + 1.5*kb*Tn * riip2*GIIp;
               AutoDScalar electron_energy = Hn*truncated_partial_volume;
-              jac->add_row(  row2[node_Tn_offset],  cell_col.size(),  &cell_col[0],  electron_energy.getADValue() );
+              jac_buffer.add_row(  row2[node_Tn_offset],  cell_col.size(),  &cell_col[0],  electron_energy.getADValue() );
             }
             if (get_advanced_model()->enable_Tp())
             {
               Hp = - (Eg+1.5*kb*Tn) * riip2*GIIp + 1.5*kb*Tp * riin2*GIIn;
               AutoDScalar hole_energy = Hp*truncated_partial_volume;
-              jac->add_row(  row2[node_Tp_offset],  cell_col.size(),  &cell_col[0],  hole_energy.getADValue() );
+              jac_buffer.add_row(  row2[node_Tp_offset],  cell_col.size(),  &cell_col[0],  hole_energy.getADValue() );
             }
           }
         } // end of II
@@ -710,6 +758,12 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, SparseMatrix<
 
   }// end of scan all the cell
 
+  for(int t=0; t<n_threads; ++t)
+  {
+    jac_thread[t].add_to(jac);
+    jac_thread[t].clear();
+  }
+
 #if defined(HAVE_FENV_H) && defined(DEBUG)
   genius_assert( !fetestexcept(FE_INVALID) );
 #endif
@@ -717,19 +771,22 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, SparseMatrix<
   // process node related terms
   // including \rho of poisson's equation, recombination term of continuation equation and heat consume due to R/G and collision
 
-  //the indepedent variable number, n_node_var for each node
-  adtl::AutoDScalar::numdir = n_node_var;
-
-  //synchronize with material database
-  mt->set_ad_num(adtl::AutoDScalar::numdir);
-
   // process node related terms
   // including \rho of poisson's equation and recombination term of continuation equation
-  const_processor_node_iterator node_it = on_processor_nodes_begin();
-  const_processor_node_iterator node_it_end = on_processor_nodes_end();
-  for(; node_it!=node_it_end; ++node_it)
+  // the nodes are processed by threads with their own jacobian buffers
+  const int n_nodes = n_on_processor_node();
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+#endif
+  for(int i=0; i<n_nodes; ++i)
   {
-    const FVM_Node * fvm_node = *node_it;
+    const FVM_Node * fvm_node = *(on_processor_nodes_begin() + i);
+
+    SparseMatrixBuffer<PetscScalar> & jac_buffer = jac_thread[Genius::thread_id()];
+
+    //the indepedent variable number, n_node_var for each node. it is thread local, set it for each thread
+    adtl::AutoDScalar::numdir = n_node_var;
+
     const FVM_NodeData * node_data = fvm_node->node_data();
 
 
@@ -772,12 +829,12 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, SparseMatrix<
       Tp = pTp/p;
     }
 
-    // map this node and its data to material database
-    mt->mapping(fvm_node->root_node(), node_data, SolverSpecify::clock);
+    // map this node and its data to material database, also synchronize the AD number
+    mt->mapping(PMI_Context(fvm_node->root_node(), node_data, SolverSpecify::clock, adtl::AutoDScalar::numdir));
 
     // the charge density for poisson's equation
     AutoDScalar rho = e*(node_data->Net_doping() + p - n)*fvm_node->volume();
-    jac->add_row(  index[node_psi_offset],  n_node_var,  &index[0],  rho.getADValue() );
+    jac_buffer.add_row(  index[node_psi_offset],  n_node_var,  &index[0],  rho.getADValue() );
 
     // the recombination term
     AutoDScalar R_SHR  = mt->band->R_SHR(p,n,T);
@@ -786,8 +843,8 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, SparseMatrix<
     AutoDScalar R_DIR  = mt->band->R_Direct(p,n,T);
     AutoDScalar R   = (R_SHR + R_AUG_N + R_AUG_P + R_DIR)*fvm_node->volume();
     AutoDScalar G   = 0;
-    jac->add_row(  index[node_n_offset],  n_node_var,  &index[0],  (G-R).getADValue() );
-    jac->add_row(  index[node_p_offset],  n_node_var,  &index[0],  (G-R).getADValue() );
+    jac_buffer.add_row(  index[node_n_offset],  n_node_var,  &index[0],  (G-R).getADValue() );
+    jac_buffer.add_row(  index[node_p_offset],  n_node_var,  &index[0],  (G-R).getADValue() );
 
 
     // process heat consume due to R/G and collision
@@ -817,17 +874,17 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, SparseMatrix<
     // save extra equation to data buffer if required
     if(get_advanced_model()->enable_Tl())
     {
-      jac->add_row(  index[node_Tl_offset],  n_node_var,  &index[0],  (H*fvm_node->volume()).getADValue() );
+      jac_buffer.add_row(  index[node_Tl_offset],  n_node_var,  &index[0],  (H*fvm_node->volume()).getADValue() );
     }
 
     if(get_advanced_model()->enable_Tn())
     {
-      jac->add_row(  index[node_Tn_offset],  n_node_var,  &index[0],  (Hn*fvm_node->volume()).getADValue() );
+      jac_buffer.add_row(  index[node_Tn_offset],  n_node_var,  &index[0],  (Hn*fvm_node->volume()).getADValue() );
     }
 
     if(get_advanced_model()->enable_Tp())
     {
-      jac->add_row(  index[node_Tp_offset],  n_node_var,  &index[0],  (Hp*fvm_node->volume()).getADValue() );
+      jac_buffer.add_row(  index[node_Tp_offset],  n_node_var,  &index[0],  (Hp*fvm_node->volume()).getADValue() );
     }
 
     if (get_advanced_model()->Trap)
@@ -842,26 +899,26 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, SparseMatrix<
       AutoDScalar TrappedC = mt->trap->ChargeAD(true);
       if (TrappedC !=0)
       {
-        jac->add_row(  index[node_psi_offset],  n_node_var,  &index[0],  (TrappedC*fvm_node->volume()).getADValue() );
+        jac_buffer.add_row(  index[node_psi_offset],  n_node_var,  &index[0],  (TrappedC*fvm_node->volume()).getADValue() );
       }
 
       // calculate the rates of electron and hole capture
       AutoDScalar TrapElec = mt->trap->ElectronTrapRate(true,n,ni,T);
       AutoDScalar TrapHole = mt->trap->HoleTrapRate    (true,p,ni,T);
 
-      jac->add_row(  index[node_n_offset],  n_node_var,  &index[0],  (-TrapElec*fvm_node->volume()).getADValue() );
-      jac->add_row(  index[node_p_offset],  n_node_var,  &index[0],  (-TrapHole*fvm_node->volume()).getADValue() );
+      jac_buffer.add_row(  index[node_n_offset],  n_node_var,  &index[0],  (-TrapElec*fvm_node->volume()).getADValue() );
+      jac_buffer.add_row(  index[node_p_offset],  n_node_var,  &index[0],  (-TrapHole*fvm_node->volume()).getADValue() );
 
       if(get_advanced_model()->enable_Tn())
       {
         Hn = - 1.5 * kb*Tn * TrapElec;
-        jac->add_row(  index[node_Tn_offset],  n_node_var,  &index[0],  (Hn*fvm_node->volume()).getADValue() );
+        jac_buffer.add_row(  index[node_Tn_offset],  n_node_var,  &index[0],  (Hn*fvm_node->volume()).getADValue() );
       }
 
       if(get_advanced_model()->enable_Tp())
       {
         Hp = - 1.5 * kb*Tp * TrapHole;
-        jac->add_row(  index[node_Tp_offset],  n_node_var,  &index[0],  (Hp*fvm_node->volume()).getADValue() );
+        jac_buffer.add_row(  index[node_Tp_offset],  n_node_var,  &index[0],  (Hp*fvm_node->volume()).getADValue() );
       }
 
       if(get_advanced_model()->enable_Tl())
@@ -869,13 +926,16 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, SparseMatrix<
         AutoDScalar EcEi = 0.5*Eg - kb*T*log(node_data->Nc()/node_data->Nv());
         AutoDScalar EiEv = 0.5*Eg + kb*T*log(node_data->Nc()/node_data->Nv());
         H = mt->trap->TrapHeat(true,p,n,ni,Tp,Tn,T,EcEi,EiEv);
-        jac->add_row(  index[node_Tl_offset],  n_node_var,  &index[0],  (H*fvm_node->volume()).getADValue() );
+        jac_buffer.add_row(  index[node_Tl_offset],  n_node_var,  &index[0],  (H*fvm_node->volume()).getADValue() );
       }
     }
 
   }
 
 
+  for(int t=0; t<n_threads; ++t)
+    jac_thread[t].add_to(jac);
+
   // boundary condition should be processed later!
 
   // the last operator is ADD_VALUES
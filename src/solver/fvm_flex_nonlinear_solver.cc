@@ -26,6 +26,8 @@
 #include "fvm_flex_nonlinear_solver.h"
 #include "parallel.h"
 #include "petsc_matrix.h"
+#include "petsc_type.h"
+#include "bordered_schur_pc.h"
 
 #ifdef HAVE_SLEPC
 #include "slepceps.h"
@@ -93,7 +95,10 @@ extern "C"
     // convert void* to FVM_FlexNonlinearSolver*
     FVM_FlexNonlinearSolver * nonlinear_solver = (FVM_FlexNonlinearSolver *)ctx;
 
-    nonlinear_solver->build_petsc_sens_residual(x, f);
+    if(nonlinear_solver->fused_evaluation())
+      nonlinear_solver->build_petsc_sens_fused(x, f);
+    else
+      nonlinear_solver->build_petsc_sens_residual(x, f);
 
     return ierr;
   }
@@ -110,11 +115,33 @@ extern "C"
 
     // convert void* to FVM_FlexNonlinearSolver*
     FVM_FlexNonlinearSolver * nonlinear_solver = (FVM_FlexNonlinearSolver *)ctx;
+
+    // the jacobian at x may be built together with residual. otherwise, when the jacobian is reused,
+    // the matrix is left untouched and PETSc skips the factorization
+    bool rebuild = false;
+    if(!nonlinear_solver->jacobian_fused_at(x))
+      rebuild = nonlinear_solver->jacobian_rebuild_test();
+
 #if PETSC_VERSION_GE(3,5,0)
-    nonlinear_solver->build_petsc_sens_jacobian(x, &jac, &pc);
+    if(rebuild)
+      nonlinear_solver->build_petsc_sens_jacobian(x, &jac, &pc);
+
+    // matrix free operator, set its base point to current solution
+    if(jac != pc)
+    {
+      ierr = MatAssemblyBegin(jac, MAT_FINAL_ASSEMBLY);
+      ierr = MatAssemblyEnd(jac, MAT_FINAL_ASSEMBLY);
+    }
 #else
-    nonlinear_solver->build_petsc_sens_jacobian(x, jac, pc);
-    *msflag = SAME_NONZERO_PATTERN;
+    if(rebuild)
+      nonlinear_solver->build_petsc_sens_jacobian(x, jac, pc);
+    *msflag = (rebuild || nonlinear_solver->fused_evaluation()) ? SAME_NONZERO_PATTERN : SAME_PRECONDITIONER;
+
+    if(*jac != *pc)
+    {
+      ierr = MatAssemblyBegin(*jac, MAT_FINAL_ASSEMBLY);
+      ierr = MatAssemblyEnd(*jac, MAT_FINAL_ASSEMBLY);
+    }
 #endif
 
 
@@ -170,7 +197,9 @@ extern "C"
  * constructor, setup context
  */
 FVM_FlexNonlinearSolver::FVM_FlexNonlinearSolver(SimulationSystem & system)
-: FVM_FlexPDESolver(system), jacobian_matrix_first_assemble(false), Jac(0)
+: FVM_FlexPDESolver(system), jacobian_matrix_first_assemble(false), Jac(0), J_mf(0),
+  _jacobian_age(-1), _jacobian_fnorm(0.0), _n_jacobian_request(0), _n_jacobian_assemble(0),
+  x_fused(0), _jacobian_fused(false), _n_residual_fused(0), _n_jacobian_fused(0), _border_pc(0)
 {
 
 }
@@ -236,7 +265,23 @@ void FVM_FlexNonlinearSolver::setup_nonlinear_data()
   ierr = SNESSetFunction (snes, f, __genius_petsc_snes_residual, this);genius_assert(!ierr);
 
   // set the nonlinear Jacobian
-  ierr = SNESSetJacobian (snes, J, J, __genius_petsc_snes_jacobian, this);genius_assert(!ierr);
+  if(SolverSpecify::JacobianMatrixFree)
+  {
+    // Jacobian-free Newton-Krylov, finite difference of residual as operator and J as preconditioner
+    ierr = MatCreateSNESMF(snes, &J_mf); genius_assert(!ierr);
+    ierr = SNESSetJacobian (snes, J_mf, J, __genius_petsc_snes_jacobian, this);genius_assert(!ierr);
+  }
+  else
+  {
+    ierr = SNESSetJacobian (snes, J, J, __genius_petsc_snes_jacobian, this);genius_assert(!ierr);
+  }
+
+  _jacobian_age        = -1;
+  _n_jacobian_request  = 0;
+  _n_jacobian_assemble = 0;
+  _jacobian_fused      = false;
+  _n_residual_fused    = 0;
+  _n_jacobian_fused    = 0;
 
   // set nonlinear solver monitor
   ierr = SNESMonitorSet (snes, __genius_petsc_snes_monitor, this, PETSC_NULL); genius_assert(!ierr);
@@ -264,6 +309,46 @@ void FVM_FlexNonlinearSolver::setup_nonlinear_data()
   set_petsc_linear_solver_type ();
   set_petsc_preconditioner_type();
 
+  // direct solver is kept as preconditioner of the matrix free operator
+  if(SolverSpecify::JacobianMatrixFree)
+  {
+    if (_linear_solver_type == SolverSpecify::LU ||
+        _linear_solver_type == SolverSpecify::UMFPACK ||
+        _linear_solver_type == SolverSpecify::SuperLU ||
+        _linear_solver_type == SolverSpecify::MUMPS   ||
+        _linear_solver_type == SolverSpecify::PASTIX  ||
+        _linear_solver_type == SolverSpecify::SuperLU_DIST
+       )
+    {
+      ierr = KSPSetType (ksp, (char*) KSPGMRES);      genius_assert(!ierr);
+      ierr = KSPGMRESSetRestart(ksp, 60);            genius_assert(!ierr);
+    }
+    MESSAGE<< "Using Jacobian-free Newton-Krylov method..."<<std::endl;  RECORD();
+  }
+
+  // the electrode/circuit dofs are eliminated by the Schur complement,
+  // and the configured preconditioner only works on the PDE block
+  if(SolverSpecify::BorderSchur)
+  {
+    if( SolverSpecify::linear_solver_category(_linear_solver_type) == SolverSpecify::ITERATIVE &&
+        n_global_dofs > n_global_node_dofs )
+    {
+      PC shell;
+      ierr = PCCreate(PETSC_COMM_WORLD, &shell);  genius_assert(!ierr);
+      _border_pc = new BorderedSchurPC(pc, J, n_global_node_dofs);
+      _border_pc->attach(shell);
+      ierr = KSPSetPC(ksp, shell);                genius_assert(!ierr);
+      ierr = PCDestroy(PetscDestroyObject(shell)); genius_assert(!ierr);
+      ierr = KSPGetPC(ksp, &pc);                  genius_assert(!ierr);
+      MESSAGE<< "Using bordered Schur complement for " << _border_pc->n_border() << " electrode/circuit dofs..."<<std::endl;  RECORD();
+    }
+    else
+    {
+      MESSAGE << "Warning:  bordered Schur complement requires iterative linear solver with electrode/circuit dofs, ignored." << std::endl;
+      RECORD();
+    }
+  }
+
 
   _ksp_residual_history.resize(1000, 0.0);
   KSPSetResidualHistory(ksp, &_ksp_residual_history[0], _ksp_residual_history.size(), PETSC_TRUE);
@@ -399,6 +484,24 @@ void FVM_FlexNonlinearSolver::destroy_vector(Vec &vec)
 void FVM_FlexNonlinearSolver::clear_nonlinear_data()
 {
   PetscErrorCode ierr;
+
+  if(SolverSpecify::JacobianReuse && _n_jacobian_request)
+  {
+    MESSAGE<< "Jacobian assembled " << _n_jacobian_assemble << " times in " << _n_jacobian_request
+           << " Newton iterations, " << _n_jacobian_request - _n_jacobian_assemble << " assembly and factorization saved." << std::endl;
+    RECORD();
+  }
+
+  if(x_fused)
+  {
+    MESSAGE<< "Jacobian evaluated together with residual for " << _n_jacobian_fused << " of " << _n_jacobian_request
+           << " Newton iterations, " << _n_residual_fused - _n_jacobian_fused << " of " << _n_residual_fused
+           << " fused evaluations not used." << std::endl;
+    RECORD();
+    ierr = VecDestroy(PetscDestroyObject(x_fused));          genius_assert(!ierr);
+    x_fused = 0;
+  }
+
   // free everything
   ierr = VecDestroy(PetscDestroyObject(x));                 genius_assert(!ierr);
   ierr = VecDestroy(PetscDestroyObject(f));                 genius_assert(!ierr);
@@ -410,8 +513,16 @@ void FVM_FlexNonlinearSolver::clear_nonlinear_data()
   ierr = ISDestroy(PetscDestroyObject(lis));                genius_assert(!ierr);
   ierr = VecScatterDestroy(PetscDestroyObject(scatter));    genius_assert(!ierr);
   ierr = MatDestroy(PetscDestroyObject(J));                 genius_assert(!ierr);
+  if(J_mf)
+  {
+    ierr = MatDestroy(PetscDestroyObject(J_mf));            genius_assert(!ierr);
+    J_mf = 0;
+  }
   ierr = SNESDestroy(PetscDestroyObject(snes));             genius_assert(!ierr);
 
+  delete _border_pc;
+  _border_pc = 0;
+
   // clear petsc options
   std::map<std::string, std::string>::const_iterator it = petsc_options.begin();
   for(; it != petsc_options.end(); ++it)
@@ -454,6 +565,92 @@ void FVM_FlexNonlinearSolver::petsc_snes_monitor(PetscInt its, PetscReal fnorm)
 }
 
 
+/*------------------------------------------------------------------
+ * decide if the jacobian should be assembled again
+ */
+bool FVM_FlexNonlinearSolver::jacobian_rebuild_test()
+{
+  _n_jacobian_request++;
+
+  PetscInt its;
+  SNESGetIterationNumber(snes, &its);
+
+  // f holds the residual of current Newton iteration
+  PetscReal fnorm;
+  VecNorm(f, NORM_2, &fnorm);
+
+  bool rebuild = !SolverSpecify::JacobianReuse ||
+                 !this->jacobian_reuse_allowed() ||
+                 _jacobian_age < 0 ||
+                 _jacobian_age >= SolverSpecify::JacobianReuseMax;
+
+  // the old jacobian no longer gives a good Newton direction
+  if( its > 0 && fnorm > SolverSpecify::JacobianReuseRatio*_jacobian_fnorm )
+    rebuild = true;
+
+  _jacobian_fnorm = fnorm;
+
+  if( rebuild )
+  {
+    _jacobian_age = 0;
+    _n_jacobian_assemble++;
+  }
+  else
+    _jacobian_age++;
+
+  return rebuild;
+}
+
+
+/*------------------------------------------------------------------
+ * evaluate residual and jacobian one by one
+ */
+void FVM_FlexNonlinearSolver::build_petsc_sens_residual_jacobian(Vec x, Vec r)
+{
+  this->build_petsc_sens_residual(x, r);
+  this->build_petsc_sens_jacobian(x, &J, &J);
+}
+
+
+/*------------------------------------------------------------------
+ * residual evaluation which also leaves the jacobian at x in J
+ */
+void FVM_FlexNonlinearSolver::build_petsc_sens_fused(Vec x, Vec r)
+{
+  if(!x_fused)
+    VecDuplicate(x, &x_fused);
+
+  this->build_petsc_sens_residual_jacobian(x, r);
+
+  VecCopy(x, x_fused);
+  _jacobian_fused = true;
+  _n_residual_fused++;
+}
+
+
+/*------------------------------------------------------------------
+ * test if the jacobian request at x can be served by fused evaluation
+ */
+bool FVM_FlexNonlinearSolver::jacobian_fused_at(Vec x)
+{
+  if(!_jacobian_fused) return false;
+
+  // J is only valid for one jacobian request
+  _jacobian_fused = false;
+
+  // the accepted line search point is copied into solution vector, compare by value
+  PetscBool same;
+  VecEqual(x, x_fused, &same);
+  if(same == PETSC_TRUE)
+  {
+    _n_jacobian_request++;
+    _n_jacobian_fused++;
+  }
+
+  return same == PETSC_TRUE;
+}
+
+
 /*------------------------------------------------------------------
  * default snes convergence test
  */
@@ -24,23 +24,19 @@
 #include "genius_common.h"
 #include "fvm_flex_pde_solver.h"
 
-#ifdef COGENDA_COMMERCIAL_PRODUCT
-  #include "fvm_flex_parallel_dof_map.h"
-#else
-  #include "fvm_flex_serial_dof_map.h"
-#endif
+#include "fvm_flex_parallel_dof_map.h"
+#include "fvm_flex_serial_dof_map.h"
 
 
 
 void FVM_FlexPDESolver::build_dof_map()
 {
-#ifdef COGENDA_COMMERCIAL_PRODUCT
-    // for commercial version
+  // the serial dof map has no ghost dofs and is cheaper to build,
+  // use it when only one processor is involved
+  if( Genius::n_processors() > 1 )
     set_parallel_dof_map();
-#else
-    // for open source version
+  else
     set_serial_dof_map();
-#endif
 }
 
 
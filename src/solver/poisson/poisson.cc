@@ -322,7 +322,9 @@ void PoissonSolver::build_petsc_sens_residual(Vec x, Vec r)
   for(unsigned int n=0; n<_system.n_regions(); ++n)
   {
     SimulationRegion * region = _system.region(n);
+    region->assembly_perf().start();
     region->Poissin_Function(lxx, r, add_value_flag);
+    region->assembly_perf().stopit();
   }
 
   // process hanging node here
@@ -405,7 +407,9 @@ void PoissonSolver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
   for(unsigned int n=0; n<_system.n_regions(); ++n)
   {
     SimulationRegion * region = _system.region(n);
+    region->assembly_perf().start();
     region->Poissin_Jacobian(lxx, Jac, add_value_flag);
+    region->assembly_perf().stopit();
   }
 
   // process hanging node here
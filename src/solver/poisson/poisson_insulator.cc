@@ -260,9 +260,10 @@ void InsulatorSimulationRegion::Poissin_Function(PetscScalar * x, Vec f, InsertM
   // search all the element in this region.
   // note, they are all local element, thus must be processed
 
+  const CellEdgeTable & edge_table = this->cell_edge_table();
   const_element_iterator it = elements_begin();
   const_element_iterator it_end = elements_end();
-  for(; it!=it_end; ++it)
+  for(unsigned int nelem=0 ; it!=it_end; ++it, ++nelem)
 {
     const Elem * elem = *it;
 
@@ -272,19 +273,18 @@ void InsulatorSimulationRegion::Poissin_Function(PetscScalar * x, Vec f, InsertM
     //search for all the Edge this cell own
     for(unsigned int ne=0; ne<elem->n_edges(); ++ne )
 {
-      std::pair<unsigned int, unsigned int> edge_nodes;
-      elem->nodes_on_edge(ne, edge_nodes);
+      const unsigned int edge = edge_table.cell_begin[nelem] + ne;
 
       // the length of this edge
-      const double length = elem->edge_length(ne);
+      const double length = edge_table.length[edge];
 
       // partial area associated with this edge
-      const double partial_area = elem->partial_area_with_edge(ne);
+      const double partial_area = edge_table.partial_area[edge];
 
       // fvm_node of node1
-      const FVM_Node * fvm_n1 = elem->get_fvm_node(edge_nodes.first);
+      const FVM_Node * fvm_n1 = edge_table.fvm_node1[edge];
       // fvm_node of node2
-      const FVM_Node * fvm_n2 = elem->get_fvm_node(edge_nodes.second);
+      const FVM_Node * fvm_n2 = edge_table.fvm_node2[edge];
 
       // fvm_node_data of node1
       const FVM_NodeData * n1_data = fvm_n1->node_data();
@@ -360,9 +360,10 @@ void InsulatorSimulationRegion::Poissin_Jacobian(PetscScalar * x, Mat *jac, Inse
   // search all the element in this region.
   // note, they are all local element, thus must be processed
 
+  const CellEdgeTable & edge_table = this->cell_edge_table();
   const_element_iterator it = elements_begin();
   const_element_iterator it_end = elements_end();
-  for(; it!=it_end; ++it)
+  for(unsigned int nelem=0 ; it!=it_end; ++it, ++nelem)
   {
     const Elem * elem = *it;
 
@@ -372,19 +373,18 @@ void InsulatorSimulationRegion::Poissin_Jacobian(PetscScalar * x, Mat *jac, Inse
     //search for all the Edge this cell own
     for(unsigned int ne=0; ne<elem->n_edges(); ++ne )
     {
-      std::pair<unsigned int, unsigned int> edge_nodes;
-      elem->nodes_on_edge(ne, edge_nodes);
+      const unsigned int edge = edge_table.cell_begin[nelem] + ne;
 
       // the length of this edge
-      const double length = elem->edge_length(ne);
+      const double length = edge_table.length[edge];
 
       // partial area associated with this edge
-      const double partial_area = elem->partial_area_with_edge(ne);
+      const double partial_area = edge_table.partial_area[edge];
 
       // fvm_node of node1
-      const FVM_Node * fvm_n1 = elem->get_fvm_node(edge_nodes.first);
+      const FVM_Node * fvm_n1 = edge_table.fvm_node1[edge];
       // fvm_node of node2
-      const FVM_Node * fvm_n2 = elem->get_fvm_node(edge_nodes.second);
+      const FVM_Node * fvm_n2 = edge_table.fvm_node2[edge];
 
       // fvm_node_data of node1
       const FVM_NodeData * n1_data =  fvm_n1->node_data();
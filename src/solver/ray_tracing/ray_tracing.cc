@@ -32,6 +32,7 @@
 #include "field_source.h"
 #include "light_lenses.h"
 #include "object_tree.h"
+#include "elem_bvh.h"
 #include "ray_tracing/light_thread.h"
 #include "ray_tracing/ray_tracing.h"
 #include "ray_tracing/anti_reflection_coating.h"
@@ -54,7 +55,7 @@ using PhysicalUnit::W;
 
 
 RayTraceSolver::RayTraceSolver(SimulationSystem & system, const Parser::Card & c)
-  : SolverBase(system), _card(c), surface_elem_tree(0),
+  : SolverBase(system), _card(c), surface_elem_tree(0), surface_elem_bvh(0),
    _incident_power(0.0), _pass_power(0.0), _escape_power(0.0), _absorb_power(0.0)
 {
   system.record_active_solver(this->solver_type());
@@ -72,6 +73,15 @@ int RayTraceSolver::create_solver()
 
   // do necessary precomputation for fast ray tracing
   surface_elem_tree = new ObjectTree(mesh, Trees::ELEMENTS_ON_BOUNDARY);
+  {
+    std::vector<const Elem *> boundary_elems;
+    MeshBase::const_element_iterator       el  = mesh.active_elements_begin();
+    const MeshBase::const_element_iterator el_end = mesh.active_elements_end();
+    for (; el != el_end; ++el)
+      if((*el)->on_boundary())
+        boundary_elems.push_back(*el);
+    surface_elem_bvh = new ElemBVH(boundary_elems);
+  }
   build_elems_node_map();
   build_elems_edge_map();
   build_boundary_elems_map();
@@ -103,6 +113,7 @@ int RayTraceSolver::solve()
     double power     = _dim==2 ? intensity*_wave_plane.min_dist : intensity*_wave_plane.ray_area();
 
     build_elem_refractive_index(lamda);
+    build_elem_free_carrier_absorption(lamda);
 
     // clear and re-create the array to record energy deposition
     _band_absorption_energy_in_elem.clear();
@@ -114,45 +125,114 @@ int RayTraceSolver::solve()
     MESSAGE<< "  process light of " /*<< std::setiosflags(std::ios::fixed)*/  << lamda/um << " um";
     RECORD();
 
-    //process all the rays
-    unsigned int n_on_processor_rays = _wave_plane.n_on_processor_rays();
-    for(unsigned int k=0; k<n_on_processor_rays; ++k)
+    const unsigned int n_on_processor_rays = _wave_plane.n_on_processor_rays();
+
+    // ray power after optical grating, evaluated before tracing since ExprEvalute is not thread safe
+    std::vector<double> ray_power(n_on_processor_rays, power);
+    if(grating_expr_eva && n_on_processor_rays)
     {
-      double ray_power = power;
-      if(grating_expr_eva)
+      std::vector<double> x(n_on_processor_rays), y(n_on_processor_rays), z(n_on_processor_rays), grating(n_on_processor_rays);
+      for(unsigned int k=0; k<n_on_processor_rays; ++k)
       {
         Point offset = _wave_plane.ray_start_point(k) - _wave_plane.center;
-        ray_power *= grating_expr_eva->eval(offset.x(), offset.y(), offset.z(), 0.0);
+        x[k] = offset.x();
+        y[k] = offset.y();
+        z[k] = offset.z();
       }
+      grating_expr_eva->eval(n_on_processor_rays, &x[0], &y[0], &z[0], 0.0, &grating[0]);
+      for(unsigned int k=0; k<n_on_processor_rays; ++k)
+        ray_power[k] *= grating[k];
+    }
 
-      // create ray
-      LightThread * light = new  LightThread(_wave_plane.ray_start_point(k),
-                                             _wave_plane.norm,
-                                             _wave_plane.E_dir,
-                                             lamda,
-                                             ray_power,
-                                             ray_power
-                                            );
+    // each thread records energy deposit to its own accumulator
+    const unsigned int n_threads = Genius::n_threads();
+    std::vector<RayAccumulator> accumulators(n_threads);
+    for(unsigned int t=0; t<n_threads; ++t)
+    {
+      accumulators[t].band_absorption_energy_in_elem.resize(_system.mesh().n_elem(), 0.0);
+      accumulators[t].total_absorption_energy_in_elem.resize(_system.mesh().n_elem(), 0.0);
+      accumulators[t].incident_power = 0.0;
+      accumulators[t].pass_power     = 0.0;
+      accumulators[t].escape_power   = 0.0;
+      accumulators[t].absorb_power   = 0.0;
+    }
+
+    // the rays are traced by packets, the first hit of all the rays in a packet is determined together.
+    // packets are processed by threads in several stages, one indicator for each stage
+    const unsigned int packet_size = ElemBVH::packet_size;
+    const int n_packets = (n_on_processor_rays + packet_size - 1)/packet_size;
+    const int n_stages  = 20;
+    for(int stage=0; stage<n_stages; ++stage)
+    {
+      const int packet_begin = (n_packets*stage)/n_stages;
+      const int packet_end   = (n_packets*(stage+1))/n_stages;
+      if(packet_end == packet_begin) continue;
 
-      if(!_lenses->empty())
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(n_threads)
+#endif
+      for(int k=packet_begin; k<packet_end; ++k)
       {
-        light = (*_lenses) << light;
-        if(!light) continue;
-      }
+        RayAccumulator & accumulator = accumulators[Genius::thread_id()];
 
-      // call function ray_tracing to process a single ray
-      ray_tracing(light);
+        LightThread * lights[ElemBVH::packet_size];
+        Point         starts[ElemBVH::packet_size];
+        Point         dirs[ElemBVH::packet_size];
+        const Elem *  first_hits[ElemBVH::packet_size];
 
-      //indicator
-      if(k%(1+(n_on_processor_rays)/20)==0) // +1 for prevent divide by zero error
-      {
-        MESSAGE<< ".";
-        RECORD();
+        unsigned int m=0;
+        const unsigned int ray_end = std::min((k+1)*packet_size, n_on_processor_rays);
+        for(unsigned int i=k*packet_size; i<ray_end; ++i)
+        {
+          // create ray
+          LightThread * light = new  LightThread(_wave_plane.ray_start_point(i),
+                                                 _wave_plane.norm,
+                                                 _wave_plane.E_dir,
+                                                 lamda,
+                                                 ray_power[i],
+                                                 ray_power[i]
+                                                );
+
+          if(!_lenses->empty())
+          {
+            light = (*_lenses) << light;
+            if(!light) continue;
+          }
+
+          lights[m] = light;
+          starts[m] = light->start_point();
+          dirs[m]   = light->dir();
+          ++m;
+        }
+
+        surface_elem_bvh->hit(m, starts, dirs, first_hits);
+
+        // call function ray_tracing to process a single ray
+        for(unsigned int i=0; i<m; ++i)
+          ray_tracing(lights[i], first_hits[i], accumulator);
       }
+
+      //indicator
+      MESSAGE<< ".";
+      RECORD();
 #if defined(HAVE_FENV_H) && defined(DEBUG)
       genius_assert( !fetestexcept(FE_INVALID) );
 #endif
+    }
 
+    // sum the accumulators by thread order
+    for(unsigned int t=0; t<n_threads; ++t)
+    {
+      const RayAccumulator & accumulator = accumulators[t];
+      for(unsigned int i=0; i<_band_absorption_energy_in_elem.size(); ++i)
+      {
+        _band_absorption_energy_in_elem[i]  += accumulator.band_absorption_energy_in_elem[i];
+        _total_absorption_energy_in_elem[i] += accumulator.total_absorption_energy_in_elem[i];
+      }
+      _incident_power += accumulator.incident_power;
+      _pass_power     += accumulator.pass_power;
+      _escape_power   += accumulator.escape_power;
+      _absorb_power   += accumulator.absorb_power;
     }
 
 
@@ -190,6 +270,7 @@ int RayTraceSolver::solve()
 int RayTraceSolver::destroy_solver()
 {
   delete surface_elem_tree;
+  delete surface_elem_bvh;
 
   {
     std::map<const Elem *, std::vector<const Elem *>,  lt_edge>::iterator it = _elems_shared_this_edge.begin();
@@ -378,11 +459,12 @@ void RayTraceSolver::create_rays()
     // how many rays in one of the direction
     int n_rays_half = int(ceil(_wave_plane.R/_wave_plane.min_dist));
 
+    // neighbor rays are distributed to processors by packet, which keeps the rays in a packet coherent
     unsigned int count=0;
     for(int i=-n_rays_half; i<=n_rays_half; ++i)
       for(int j=-n_rays_half; j<=n_rays_half; ++j)
       {
-        if(Genius::processor_id() != (count++)%Genius::n_processors()) continue;
+        if(Genius::processor_id() != ((count++)/ElemBVH::packet_size)%Genius::n_processors()) continue;
 
         Point s = _wave_plane.center + i*_wave_plane.min_dist*d1 + j*_wave_plane.min_dist*d2;
         // limit the ray start point inside the radius
@@ -413,7 +495,7 @@ void RayTraceSolver::create_rays()
     unsigned int count=0;
     for(int i=-n_rays_half; i<=n_rays_half; ++i)
     {
-      if(Genius::processor_id() != (count++)%Genius::n_processors()) continue;
+      if(Genius::processor_id() != ((count++)/ElemBVH::packet_size)%Genius::n_processors()) continue;
 
       Point s = _wave_plane.center + i*_wave_plane.min_dist*d;
       if(_lenses->empty())
@@ -647,16 +729,29 @@ void RayTraceSolver::build_elem_carrier_density()
 }
 
 
-double RayTraceSolver::get_free_carrier_absorption(const Elem* elem, double wavelength) const
+void RayTraceSolver::build_elem_free_carrier_absorption(double lamda)
 {
-  const SimulationRegion * region =  _system.region(elem->subdomain_id());
-  if( region->type() == SemiconductorRegion )
+  _elem_free_carrier_absorption.clear();
+  _elem_free_carrier_absorption.resize(_system.mesh().n_elem(), 0.0);
+
+  std::map<unsigned int, std::pair<double, double> >::const_iterator it = _elem_carrier_density.begin();
+  for(; it != _elem_carrier_density.end(); ++it)
   {
+    const Elem * elem = _system.mesh().elem(it->first);
+    const SimulationRegion * region =  _system.region(elem->subdomain_id());
+    if( region->type() != SemiconductorRegion ) continue;
+
     const SemiconductorSimulationRegion * semiconductor_region = dynamic_cast<const SemiconductorSimulationRegion *>(region);
-    std::pair<double, double> carrier = _elem_carrier_density.find(elem->id())->second;
-    return semiconductor_region->material()->optical->FreeCarrierAbsorption(wavelength, carrier.first, carrier.second, _system.T_external() );
+    const std::pair<double, double> & carrier = it->second;
+    _elem_free_carrier_absorption[it->first] =
+      semiconductor_region->material()->optical->FreeCarrierAbsorption(lamda, carrier.first, carrier.second, _system.T_external() );
   }
-  return 0.0;
+}
+
+
+double RayTraceSolver::get_free_carrier_absorption(const Elem* elem) const
+{
+  return _elem_free_carrier_absorption[elem->id()];
 }
 
 
@@ -854,32 +949,38 @@ const Elem * RayTraceSolver::ray_hit(const Point &p, const Point &dir, const Ele
 
 
 
-void RayTraceSolver::ray_tracing(LightThread *ray)
+void RayTraceSolver::ray_tracing(LightThread *ray, const Elem * first_hit, RayAccumulator & accumulator) const
 {
 
   // use stack to save all the rays (origin and secondary)
   std::stack<LightThread *> ray_stack;
   ray_stack.push(ray);
 
-  _incident_power += ray->power();
+  accumulator.incident_power += ray->power();
+
+  // the first hit of the incident ray is given, only secondary rays need to search the BVH
+  bool incident = true;
 
   while(!ray_stack.empty())
   {
     LightThread * current_ray = ray_stack.top();
     ray_stack.pop();
 
+    const bool incident_ray = incident;
+    incident = false;
+
     if(current_ray==NULL) continue;
 
     // the ray doesn't hit any elem yet?
     if(current_ray->hit_elem==NULL)
     {
       // find the first element this ray hit
-      const Elem * elem = surface_elem_tree->hit(current_ray->start_point(), current_ray->dir());
+      const Elem * elem = incident_ray ? first_hit : surface_elem_bvh->hit(current_ray->start_point(), current_ray->dir());
 
       // not hit any elem
       if(elem==NULL)
       {
-        _pass_power+=current_ray->power(); delete current_ray; continue;
+        accumulator.pass_power+=current_ray->power(); delete current_ray; continue;
       }
 
       current_ray->hit_elem = elem;
@@ -908,7 +1009,7 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
           unsigned int edge_index = hit_point.mark;
           AutoPtr<Elem> edge = elem->build_edge(edge_index);
           if(_boundary_edge_to_elem_side_map.find(edge.get())==_boundary_edge_to_elem_side_map.end())
-          { _pass_power+=current_ray->power(); delete current_ray; continue;}
+          { accumulator.pass_power+=current_ray->power(); delete current_ray; continue;}
           hit_elems = _boundary_edge_to_elem_side_map.find(edge.get())->second;
           break;
         }
@@ -917,7 +1018,7 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
           unsigned int vertex_index = hit_point.mark;
           const Node * current_node = elem->get_node(vertex_index);
           if(_boundary_node_to_elem_side_map.find(current_node)==_boundary_node_to_elem_side_map.end())
-          { _pass_power+=current_ray->power(); delete current_ray; continue;}
+          { accumulator.pass_power+=current_ray->power(); delete current_ray; continue;}
           hit_elems = _boundary_node_to_elem_side_map.find(current_node)->second;
           break;
         }
@@ -934,7 +1035,7 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
         Point norm = boundary_elem->outside_unit_normal(side);
         //the surface norm should has a angle >90 degree to ray dir
         if(norm.dot(current_ray->dir()) > -1e-10)
-        { _pass_power+=current_ray->power(); continue; }
+        { accumulator.pass_power+=current_ray->power(); continue; }
 
         // if reflect surface
         if(is_full_reflect_surface(boundary_elem, side))
@@ -943,7 +1044,7 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
           // some stupid skill: shift the reflect ray to prevent it hit this elem again
           reflect_ray->start_point() = reflect_ray->start_point() + 1e-6*reflect_ray->dir();
           // the reflect ray hit the mesh again?
-          const Elem *surface_elem = surface_elem_tree->hit(reflect_ray->start_point(), reflect_ray->dir());
+          const Elem *surface_elem = surface_elem_bvh->hit(reflect_ray->start_point(), reflect_ray->dir());
           if(surface_elem && surface_elem!=elem)
           {
             reflect_ray->hit_elem = this->ray_hit(reflect_ray->start_point(), reflect_ray->dir(), surface_elem, reflect_ray->result);
@@ -951,13 +1052,13 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
               ray_stack.push(reflect_ray);
             else
             {
-              _escape_power += reflect_ray->power();
+              accumulator.escape_power += reflect_ray->power();
               delete reflect_ray;
             }
           }
           else
           {
-            _escape_power += reflect_ray->power();
+            accumulator.escape_power += reflect_ray->power();
             delete reflect_ray;
           }
           continue;
@@ -983,7 +1084,7 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
             ray_stack.push(refract_ray);
           else
           { // the refract ray has already penetrat through the device?
-            _escape_power += refract_ray->power();
+            accumulator.escape_power += refract_ray->power();
             delete refract_ray;
           }
         }
@@ -995,7 +1096,7 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
           // some stupid skill: shift the reflect ray to prevent it hit this elem again
           reflect_ray->start_point() = reflect_ray->start_point() + 1e-8*reflect_ray->dir();
           // the refract ray hit the mesh again?
-          const Elem *surface_elem = surface_elem_tree->hit(reflect_ray->start_point(), reflect_ray->dir());
+          const Elem *surface_elem = surface_elem_bvh->hit(reflect_ray->start_point(), reflect_ray->dir());
           if(surface_elem && surface_elem!=elem)
           {
             reflect_ray->hit_elem = this->ray_hit(reflect_ray->start_point(), reflect_ray->dir(), surface_elem, reflect_ray->result);
@@ -1003,13 +1104,13 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
               ray_stack.push(reflect_ray);
             else
             {
-              _escape_power += reflect_ray->power();
+              accumulator.escape_power += reflect_ray->power();
               delete reflect_ray;
             }
           }
           else
           {
-            _escape_power += reflect_ray->power();
+            accumulator.escape_power += reflect_ray->power();
             delete reflect_ray;
           }
         }
@@ -1024,7 +1125,7 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
     if( current_ray->result.hit_points.size() != 2 )
     {
       // FIXME, should not happen...
-      _pass_power += current_ray->power(); delete current_ray; continue;
+      accumulator.pass_power += current_ray->power(); delete current_ray; continue;
     }
 
     // calculate energy deposit
@@ -1034,30 +1135,30 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
 
     double a_band = 4*3.14159265358979*this->get_refractive_index_im(elem)/current_ray->wavelength();
     double a_tail = 0.0;
-    double a_fc   = this->get_free_carrier_absorption(elem, current_ray->wavelength());
+    double a_fc   = this->get_free_carrier_absorption(elem);
 
     std::vector<double> energy_deposit = current_ray->advance_to(end_point.p, a_band, a_tail, a_fc);
     double total_energy_deposit = std::accumulate(energy_deposit.begin(), energy_deposit.end(), 0.0);
-    _absorb_power+= total_energy_deposit;
+    accumulator.absorb_power+= total_energy_deposit;
 
     switch(current_ray->result.state)
     {
       // all the energy deposited in this elem
     case Intersect_Body :
-      _band_absorption_energy_in_elem[elem->id()] += energy_deposit[0];
-      _total_absorption_energy_in_elem[elem->id()] += total_energy_deposit;
+      accumulator.band_absorption_energy_in_elem[elem->id()] += energy_deposit[0];
+      accumulator.total_absorption_energy_in_elem[elem->id()] += total_energy_deposit;
       break;
       // two elem shares the energy deposite
     case On_Face        :
       {
-        _band_absorption_energy_in_elem[elem->id()] += 0.5*energy_deposit[0];
-        _total_absorption_energy_in_elem[elem->id()] += 0.5*total_energy_deposit;
+        accumulator.band_absorption_energy_in_elem[elem->id()] += 0.5*energy_deposit[0];
+        accumulator.total_absorption_energy_in_elem[elem->id()] += 0.5*total_energy_deposit;
         unsigned int side = current_ray->result.mark;
         const Elem * neighbor = elem->neighbor(side);
         if(neighbor)
         {
-          _band_absorption_energy_in_elem[neighbor->id()] += 0.5*energy_deposit[0];
-          _total_absorption_energy_in_elem[neighbor->id()] += 0.5*total_energy_deposit;
+          accumulator.band_absorption_energy_in_elem[neighbor->id()] += 0.5*energy_deposit[0];
+          accumulator.total_absorption_energy_in_elem[neighbor->id()] += 0.5*total_energy_deposit;
         }
         break;
       }
@@ -1070,8 +1171,8 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
         assert(elems.size());
         for(unsigned int n=0; n<elems.size(); ++n)
         {
-          _band_absorption_energy_in_elem[elems[n]->id()] += energy_deposit[0]/elems.size();
-          _total_absorption_energy_in_elem[elems[n]->id()] += total_energy_deposit/elems.size();
+          accumulator.band_absorption_energy_in_elem[elems[n]->id()] += energy_deposit[0]/elems.size();
+          accumulator.total_absorption_energy_in_elem[elems[n]->id()] += total_energy_deposit/elems.size();
         }
         break;
       }
@@ -1081,7 +1182,7 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
 
 
     if(current_ray->is_dead())
-    { _pass_power += current_ray->power(); delete current_ray; continue; }
+    { accumulator.pass_power += current_ray->power(); delete current_ray; continue; }
 
     // safe guard: when the number of rays in stack exceed 1000, we may fall into endless loop
     // force to exit
@@ -1091,7 +1192,7 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
       {
         LightThread * current_ray = ray_stack.top();
         ray_stack.pop();
-        _pass_power += current_ray->power();
+        accumulator.pass_power += current_ray->power();
         delete current_ray;
       }
       return;
@@ -1117,7 +1218,7 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
         {
           // if reflect surface
           if(is_surface(elem, side) && is_full_reflect_surface(elem, side))
-          {  _escape_power += current_ray->power(); delete current_ray; continue; }
+          {  accumulator.escape_power += current_ray->power(); delete current_ray; continue; }
 
           Point p = end_point.p;
           Point norm = - elem->outside_unit_normal(side);
@@ -1194,11 +1295,11 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
 
             // if reflect surface
             if(is_surface(boundary_elem, side) && is_full_reflect_surface(boundary_elem, side))
-            { _escape_power += current_ray->power();  continue; }
+            { accumulator.escape_power += current_ray->power();  continue; }
 
             Point norm = boundary_elem->outside_unit_normal(side);
             //the surface norm should has a angle >90 degree to ray dir
-            if(norm.dot(current_ray->dir()) > -1e-10) { _escape_power += current_ray->power();  continue; }
+            if(norm.dot(current_ray->dir()) > -1e-10) { accumulator.escape_power += current_ray->power();  continue; }
 
             double n1 = get_refractive_index_re(boundary_elem->neighbor(side));
             double n2 = get_refractive_index_re(boundary_elem);
@@ -1214,7 +1315,7 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
                 ray_stack.push(refract_ray);
               else
               {
-                _escape_power += refract_ray->power();
+                accumulator.escape_power += refract_ray->power();
                 delete refract_ray;
               }
             }
@@ -1228,7 +1329,7 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
                 ray_stack.push(reflect_ray);
               else
               {
-                _escape_power += reflect_ray->power();
+                accumulator.escape_power += reflect_ray->power();
                 delete reflect_ray;
               }
             }
@@ -1242,7 +1343,7 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
       {
         unsigned int vertex_index = end_point.mark;
         const Node * node = elem->get_node(vertex_index);
-        std::vector<const Elem *> & elems = _elems_shared_this_node[node->id()];
+        const std::vector<const Elem *> & elems = _elems_shared_this_node[node->id()];
         // the node is not on boundary
         if( _boundary_node_to_elem_side_map.find(node)==_boundary_node_to_elem_side_map.end())
         {
@@ -1269,7 +1370,7 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
             effective_faces++;
           }
           if(effective_faces ==0)
-          { _escape_power += current_ray->power(); delete current_ray; continue; }
+          { accumulator.escape_power += current_ray->power(); delete current_ray; continue; }
 
           current_ray->power() = current_ray->power()/effective_faces;
 
@@ -1280,11 +1381,11 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
 
             // if reflect surface
             if(is_surface(boundary_elem, side) && is_full_reflect_surface(boundary_elem, side))
-            { _escape_power += current_ray->power(); continue; }
+            { accumulator.escape_power += current_ray->power(); continue; }
 
             Point norm = boundary_elem->outside_unit_normal(side);
             //the surface norm should has a angle >90 degree to ray dir
-            if(norm.dot(current_ray->dir()) > -1e-10) { _escape_power += current_ray->power(); continue; }
+            if(norm.dot(current_ray->dir()) > -1e-10) { accumulator.escape_power += current_ray->power(); continue; }
 
             double n1 = get_refractive_index_re(boundary_elem->neighbor(side));
             double n2 = get_refractive_index_re(boundary_elem);
@@ -1300,7 +1401,7 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
                 ray_stack.push(refract_ray);
               else
               {
-                _escape_power += refract_ray->power();
+                accumulator.escape_power += refract_ray->power();
                 delete refract_ray;
               }
             }
@@ -1314,7 +1415,7 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
                 ray_stack.push(reflect_ray);
               else
               {
-                _escape_power += reflect_ray->power();
+                accumulator.escape_power += reflect_ray->power();
                 delete reflect_ray;
               }
             }
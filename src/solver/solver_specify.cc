@@ -90,6 +90,56 @@ namespace SolverSpecify
    */
   int     NSLagJacobian;
 
+  /**
+   * reuse the jacobian and its factorization across Newton iterations and time steps
+   */
+  bool    JacobianReuse;
+
+  /**
+   * max Newton iterations a jacobian can be reused before it is rebuilt
+   */
+  int     JacobianReuseMax;
+
+  /**
+   * rebuild the reused jacobian when residual reduction of a Newton iteration is worse than this ratio
+   */
+  double  JacobianReuseRatio;
+
+  /**
+   * Jacobian-free Newton-Krylov
+   */
+  bool    JacobianMatrixFree;
+
+  /**
+   * evaluate residual together with jacobian in one pass
+   */
+  bool    FusedAssembly;
+
+  /**
+   * bordered solve for electrode/circuit dofs
+   */
+  bool    BorderSchur;
+
+  /**
+   * repartition the mesh when load imbalance exceeds it
+   */
+  double  RepartitionThreshold;
+
+  /**
+   * refine the mesh every AdaptInterval bias points or time steps
+   */
+  unsigned int AdaptInterval;
+
+  /**
+   * the solver stops the sweep for mesh adaptation
+   */
+  bool    AdaptPending;
+
+  /**
+   * the solve continues a sweep stopped for mesh adaptation
+   */
+  bool    AdaptContinue;
+
   /**
    * linear solver scheme: LU, BCGS, GMRES ...
    */
@@ -496,6 +546,21 @@ namespace SolverSpecify
    */
   int       DC_Cycles;
 
+  /**
+   * electrode(s) held at each branch voltage while the DC sweep is repeated
+   */
+  std::vector<std::string>    Electrode_VBranch;
+
+  /**
+   * the branch voltages, one full DC sweep for each
+   */
+  std::vector<double>         VBranch;
+
+  /**
+   * index of the branch in VBranch being swept
+   */
+  unsigned int   VBranch_Index;
+
   /**
    * use node set, only for mixA solver
    */
@@ -566,6 +631,46 @@ namespace SolverSpecify
    */
   double    Freq;
 
+  /**
+   * each electrode in Electrode_ACScan is an individual port
+   */
+  bool      ACMultiPort;
+
+  /**
+   * admittance matrix of the ports
+   */
+  std::vector< std::complex<double> > ACPortY;
+
+  /**
+   * impedance matrix of the ports
+   */
+  std::vector< std::complex<double> > ACPortZ;
+
+  /**
+   * fast AC sweep by reduced order model
+   */
+  bool      ACMOR;
+
+  /**
+   * relative residual tolerance of reduced solution
+   */
+  double    ACMORTol;
+
+  /**
+   * number of basis vectors added at each expansion frequency
+   */
+  unsigned int ACMOROrder;
+
+  /**
+   * max number of basis vectors of the reduced model
+   */
+  unsigned int ACMORMaxBasis;
+
+  /**
+   * frequency parallel AC sweep
+   */
+  bool      ACFreqParallel;
+
 
   //------------------------------------------------------
   // parameters for pseudo time stepping method
@@ -714,6 +819,16 @@ namespace SolverSpecify
     NSLagPCLU         = 1;
     NSLagJacobian     = 1;
 #endif
+    JacobianReuse      = false;
+    JacobianReuseMax   = 10;
+    JacobianReuseRatio = 0.5;
+    JacobianMatrixFree = false;
+    FusedAssembly      = false;
+    BorderSchur        = false;
+    RepartitionThreshold = 0.0;
+    AdaptInterval      = 0;
+    AdaptPending       = false;
+    AdaptContinue      = false;
 
     out_append        = false;
 
@@ -779,6 +894,9 @@ namespace SolverSpecify
 
     Electrode_VScan_Voltage = 0.0;
     Electrode_IScan_Current = 0.0;
+    Electrode_VBranch.clear();
+    VBranch.clear();
+    VBranch_Index = 0;
 
     NodeSet           = true;
     RampUpSteps       = 0;
@@ -789,6 +907,12 @@ namespace SolverSpecify
     Gmin              = 1e-12;
 
     VAC               = 0.0;
+    ACMultiPort       = false;
+    ACMOR             = false;
+    ACMORTol          = 1e-6;
+    ACMOROrder        = 4;
+    ACMORMaxBasis     = 40;
+    ACFreqParallel    = false;
 
     OpToSteady        = true;
 
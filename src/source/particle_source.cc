@@ -681,129 +681,186 @@ void Particle_Source_Track::update_source()
   const double pi = 3.1415926536;
   genius_assert(_system.mesh().mesh_dimension() == 3);
 
-  std::vector<double> region_energy(_system.n_regions(), 0.0);
-  double total_energy=0.0;
-
-  AutoPtr<NearestNodeLocator> nn_locator( new NearestNodeLocator(_system.mesh()) );
+  const double t_factor = 1.0/(_t_char/2.0*sqrt(pi)*(1+Erf((_t_max-_t0)/_t_char)));
 
-  for(unsigned int t=0; t<_tracks.size(); ++t)
+  // dense index of all the on processor FVM nodes, a slot for each (region, node) pair.
+  // slot_begin is CSR style indexed by node id, a node shared by several regions owns several slots
+  std::vector<const FVM_Node *> slot_node;
+  std::vector<unsigned int>     slot_region;
+  std::vector<unsigned int>     slot_begin(_system.mesh().max_node_id()+1, 0);
   {
-    if( t%(1+_tracks.size()/20) ==0 )
+    for(unsigned int r=0; r<_system.n_regions(); r++)
     {
-      MESSAGE<< ".";
-      RECORD();
+      const SimulationRegion * region = _system.region(r);
+      SimulationRegion::const_processor_node_iterator it = region->on_processor_nodes_begin();
+      for(; it!=region->on_processor_nodes_end(); ++it)
+        slot_begin[(*it)->root_node()->id()+1]++;
     }
+    for(unsigned int n=1; n<slot_begin.size(); ++n)
+      slot_begin[n] += slot_begin[n-1];
 
-    const track_t & track = _tracks[t];
-    genius_assert(track.energy > 0.0 && (track.end - track.start).size() > 0.0);
-
-    /*
-    // prevent bad tracks
-    int bad_track = 0;
-    if( track.energy == 0.0 || (track.end - track.start).size() == 0.0) bad_track=1;
-    Parallel::broadcast(bad_track);
-    if(bad_track) continue;
-    */
-
-    double track_energy = 0.0;
-    std::map<const FVM_Node *, double> track_energy_density;
-
-    const Point track_dir = (track.end - track.start).unit(); // track direction
-    const double dEdx = track.energy/(track.end - track.start).size(); // linear energy density
-    const double lateral_char = track.lateral_char;
-    // find the nodes that near the track
+    slot_node.resize(slot_begin.back(), 0);
+    slot_region.resize(slot_begin.back(), 0);
+    std::vector<unsigned int> fill(slot_begin.begin(), slot_begin.end()-1);
     for(unsigned int r=0; r<_system.n_regions(); r++)
     {
       const SimulationRegion * region = _system.region(r);
+      SimulationRegion::const_processor_node_iterator it = region->on_processor_nodes_begin();
+      for(; it!=region->on_processor_nodes_end(); ++it)
+      {
+        unsigned int slot = fill[(*it)->root_node()->id()]++;
+        slot_node[slot]   = *it;
+        slot_region[slot] = r;
+      }
+    }
+  }
 
-      // fast return
-      const std::pair<Point, Real> bsphere = region->boundingsphere();
-      const Point cent = 0.5*(track.start+track.end);
-      const double diag = 0.5*(track.start-track.end).size();
-      if( (bsphere.first - cent).size() > bsphere.second + diag + 5*lateral_char ) continue;
+  // energy density deposited to each slot
+  std::vector<double> slot_deposit(slot_node.size(), 0.0);
 
+  std::vector<double> region_energy(_system.n_regions(), 0.0);
+  double total_energy=0.0;
 
-      std::vector<const Node *> nn = nn_locator->nearest_nodes(track.start, track.end, 5*lateral_char, r);
-      for(unsigned int n=0; n<nn.size(); ++n)
-      {
-        Point loc = *nn[n];
-        const FVM_Node * fvm_node = region->region_fvm_node(nn[n]); // may be NULL, if not on local
-        if(!fvm_node || !fvm_node->on_processor()) continue;
+  AutoPtr<NearestNodeLocator> nn_locator( new NearestNodeLocator(_system.mesh()) );
 
-        Point loc_pp = track.start + (loc-track.start)*track_dir*track_dir;
-        Real r = (loc-loc_pp).size();
-        double e_r = exp(-r*r/(lateral_char*lateral_char));
-        double e_z = Erf((loc_pp-track.start)*track_dir/lateral_char) - Erf((loc_pp-track.end)*track_dir/lateral_char);
-        double energy_density = dEdx/(2*pi*lateral_char*lateral_char)*e_r*e_z;
-        track_energy += energy_density*fvm_node->volume();
-        track_energy_density[fvm_node] += energy_density;
-      }
+  // tracks are processed by block, only one reduction is required for each block.
+  // the energy density of each track is kept as (slot, energy density) pairs since
+  // the conservation factor is not known until the block reduction finished
+  const unsigned int block_size = 1024;
+  std::vector< std::vector< std::pair<unsigned int, double> > > block_density(block_size);
+
+  const unsigned int n_block = (_tracks.size()+block_size-1)/block_size;
+  for(unsigned int b=0; b<n_block; ++b)
+  {
+    if( b%(1+n_block/20) ==0 )
+    {
+      MESSAGE<< ".";
+      RECORD();
     }
 
-    Parallel::sum(track_energy);
+    const unsigned int t_begin = b*block_size;
+    const unsigned int t_end   = std::min(static_cast<unsigned int>(_tracks.size()), t_begin+block_size);
+    const int n_track = t_end - t_begin;
+
+    std::vector<double> block_energy(n_track, 0.0);
+    std::vector<double> block_distance(n_track, std::numeric_limits<double>::infinity());
+    std::vector<int>    block_nearest(n_track, -1);
 
-    if(track_energy > 0.0)
+    // the tracks in the block are independent, process them by threads
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic, 16) num_threads(Genius::n_threads())
+#endif
+    for(int i=0; i<n_track; ++i)
     {
-      double alpha = track.energy/track_energy; //used for keep energy conservation track.energy;
-      std::map<const FVM_Node *, double>::const_iterator it = track_energy_density.begin();
-      for(; it != track_energy_density.end(); ++it)
-      {
-        const FVM_Node * fvm_node = it->first;
-        if(!fvm_node) continue;
+      const track_t & track = _tracks[t_begin+i];
+      genius_assert(track.energy > 0.0 && (track.end - track.start).size() > 0.0);
 
-        double energy_density = it->second;
+      double track_energy = 0.0;
+      std::vector< std::pair<unsigned int, double> > & track_energy_density = block_density[i];
+      track_energy_density.clear();
+
+      const Point track_dir = (track.end - track.start).unit(); // track direction
+      const double dEdx = track.energy/(track.end - track.start).size(); // linear energy density
+      const double lateral_char = track.lateral_char;
+      // find the nodes that near the track
+      for(unsigned int r=0; r<_system.n_regions(); r++)
+      {
+        const SimulationRegion * region = _system.region(r);
 
-        const SimulationRegion * region = _system.region(fvm_node->subdomain_id());
-        // if( region->type() != SemiconductorRegion) continue;
-        double _quan_eff = quan_eff(region);
+        // fast return
+        const std::pair<Point, Real> bsphere = region->boundingsphere();
+        const Point cent = 0.5*(track.start+track.end);
+        const double diag = 0.5*(track.start-track.end).size();
+        if( (bsphere.first - cent).size() > bsphere.second + diag + 5*lateral_char ) continue;
 
-        if(fvm_node && fvm_node->on_local())
+        std::vector<const Node *> nn = nn_locator->nearest_nodes(track.start, track.end, 5*lateral_char, r);
+        for(unsigned int n=0; n<nn.size(); ++n)
         {
-          _fvm_node_particle_deposit[fvm_node] += alpha*energy_density/_quan_eff/(_t_char/2.0*sqrt(pi)*(1+Erf((_t_max-_t0)/_t_char)));
-          //node_data->PatE() += alpha*energy_density;
-          total_energy += alpha*energy_density*fvm_node->volume();
-          region_energy[ fvm_node->subdomain_id() ] += alpha*energy_density*fvm_node->volume();
+          // find the slot of this node in region r, no slot if it is not on processor
+          unsigned int slot = slot_begin[nn[n]->id()];
+          for(; slot<slot_begin[nn[n]->id()+1]; ++slot)
+            if(slot_region[slot] == r) break;
+          if(slot == slot_begin[nn[n]->id()+1]) continue;
+
+          Point loc = *nn[n];
+          Point loc_pp = track.start + (loc-track.start)*track_dir*track_dir;
+          Real r = (loc-loc_pp).size();
+          double e_r = exp(-r*r/(lateral_char*lateral_char));
+          double e_z = Erf((loc_pp-track.start)*track_dir/lateral_char) - Erf((loc_pp-track.end)*track_dir/lateral_char);
+          double energy_density = dEdx/(2*pi*lateral_char*lateral_char)*e_r*e_z;
+          track_energy += energy_density*slot_node[slot]->volume();
+          track_energy_density.push_back(std::make_pair(slot, energy_density));
         }
       }
+
+      block_energy[i] = track_energy;
     }
-    else
+
+    Parallel::sum(block_energy);
+
+    // tracks deposit no energy to any node, find the nearest node of the track
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic, 16) num_threads(Genius::n_threads())
+#endif
+    for(int i=0; i<n_track; ++i)
     {
-      // find the nearest node of the track
-      const FVM_Node * neraset_node=0;
-      double distance=std::numeric_limits<double>::infinity();
+      if(block_energy[i] > 0.0) continue;
+
+      const track_t & track = _tracks[t_begin+i];
       for(unsigned int r=0; r<_system.n_regions(); r++)
       {
-        const SimulationRegion * region = _system.region(r);
         double dist;
         const Node * n = nn_locator->nearest_node(0.5*(track.start+track.end), r, dist);
         if(n == NULL) continue;
 
-        const FVM_Node * fvm_node = region->region_fvm_node(n); // may be NULL, if not on local
-        if(!fvm_node || !fvm_node->on_processor()) continue;
+        unsigned int slot = slot_begin[n->id()];
+        for(; slot<slot_begin[n->id()+1]; ++slot)
+          if(slot_region[slot] == r) break;
+        if(slot == slot_begin[n->id()+1]) continue;
 
-        if( dist < distance)
+        if( dist < block_distance[i])
         {
-          distance = dist;
-          neraset_node = fvm_node;
+          block_distance[i] = dist;
+          block_nearest[i]  = slot;
         }
       }
+    }
 
-      double min_distance=distance;
-      Parallel::min(min_distance);
+    std::vector<double> min_distance(block_distance);
+    Parallel::min(min_distance);
 
-      if( min_distance == distance && neraset_node)
+    // accumulate the energy density by track order, keeps the result independent of thread number
+    for(int i=0; i<n_track; ++i)
+    {
+      const track_t & track = _tracks[t_begin+i];
+      if(block_energy[i] > 0.0)
       {
-        const SimulationRegion * region = _system.region(neraset_node->subdomain_id());
-        double _quan_eff = quan_eff(region);
-
-        double energy_density = track.energy/neraset_node->volume();
-        _fvm_node_particle_deposit[neraset_node] += energy_density/_quan_eff/(_t_char/2.0*sqrt(pi)*(1+Erf((_t_max-_t0)/_t_char)));
-        //node_data->PatE() += energy_density;
+        double alpha = track.energy/block_energy[i]; //used for keep energy conservation track.energy;
+        const std::vector< std::pair<unsigned int, double> > & track_energy_density = block_density[i];
+        for(unsigned int n=0; n<track_energy_density.size(); ++n)
+        {
+          const unsigned int slot = track_energy_density[n].first;
+          const double energy = alpha*track_energy_density[n].second*slot_node[slot]->volume();
+          slot_deposit[slot] += alpha*track_energy_density[n].second;
+          total_energy += energy;
+          region_energy[slot_region[slot]] += energy;
+        }
+      }
+      else if( block_nearest[i] >= 0 && min_distance[i] == block_distance[i] )
+      {
+        const unsigned int slot = block_nearest[i];
+        slot_deposit[slot] += track.energy/slot_node[slot]->volume();
         total_energy += track.energy;
-        region_energy[neraset_node->subdomain_id()] += track.energy;
+        region_energy[slot_region[slot]] += track.energy;
       }
     }
+  }
 
+  for(unsigned int slot=0; slot<slot_node.size(); ++slot)
+  {
+    if(slot_deposit[slot] == 0.0) continue;
+    const SimulationRegion * region = _system.region(slot_region[slot]);
+    _fvm_node_particle_deposit[slot_node[slot]] += slot_deposit[slot]/quan_eff(region)*t_factor;
   }
 
   MESSAGE<< "ok" <<std::endl;
@@ -0,0 +1,150 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+
+#include "async_writer.h"
+
+
+AsyncWriter::AsyncWriter(unsigned int max_pending)
+  : _max_pending(max_pending > 0 ? max_pending : 1), _n_finished(0)
+{
+#ifndef WINDOWS
+  _started = false;
+  _stop = false;
+  pthread_mutex_init(&_mutex, NULL);
+  pthread_cond_init(&_cond, NULL);
+#endif
+}
+
+
+AsyncWriter::~AsyncWriter()
+{
+#ifndef WINDOWS
+  if(_started)
+  {
+    pthread_mutex_lock(&_mutex);
+    _stop = true;
+    pthread_cond_broadcast(&_cond);
+    pthread_mutex_unlock(&_mutex);
+    // the thread quits after the pending jobs are finished
+    pthread_join(_thread, NULL);
+  }
+  _reap();
+  pthread_cond_destroy(&_cond);
+  pthread_mutex_destroy(&_mutex);
+#else
+  _reap();
+#endif
+}
+
+
+void AsyncWriter::submit(Job * job)
+{
+#ifndef WINDOWS
+  pthread_mutex_lock(&_mutex);
+
+  if(!_started)
+  {
+    if(pthread_create(&_thread, NULL, &AsyncWriter::_thread_entry, this) == 0)
+      _started = true;
+  }
+
+  // can not start a thread, do it here
+  if(!_started)
+  {
+    pthread_mutex_unlock(&_mutex);
+    job->run();
+    delete job;
+    ++_n_finished;
+    return;
+  }
+
+  while(_pending.size() >= _max_pending)
+    pthread_cond_wait(&_cond, &_mutex);
+
+  _reap();
+  _pending.push_back(job);
+  pthread_cond_broadcast(&_cond);
+  pthread_mutex_unlock(&_mutex);
+#else
+  job->run();
+  delete job;
+  ++_n_finished;
+#endif
+}
+
+
+void AsyncWriter::wait()
+{
+#ifndef WINDOWS
+  pthread_mutex_lock(&_mutex);
+  while(!_pending.empty())
+    pthread_cond_wait(&_cond, &_mutex);
+  _reap();
+  pthread_mutex_unlock(&_mutex);
+#endif
+}
+
+
+void AsyncWriter::_reap()
+{
+  for(unsigned int n=0; n<_finished.size(); ++n)
+    delete _finished[n];
+  _finished.clear();
+}
+
+
+#ifndef WINDOWS
+
+void * AsyncWriter::_thread_entry(void * p)
+{
+  static_cast<AsyncWriter *>(p)->_loop();
+  return NULL;
+}
+
+
+void AsyncWriter::_loop()
+{
+  pthread_mutex_lock(&_mutex);
+  while(true)
+  {
+    while(_pending.empty() && !_stop)
+      pthread_cond_wait(&_cond, &_mutex);
+
+    if(_pending.empty()) break; // stop and nothing left
+
+    // the job stays in queue while running, so wait() returns after it is written
+    Job * job = _pending.front();
+    pthread_mutex_unlock(&_mutex);
+
+    job->run();
+
+    pthread_mutex_lock(&_mutex);
+    _pending.pop_front();
+    _finished.push_back(job);
+    ++_n_finished;
+    pthread_cond_broadcast(&_cond);
+  }
+  pthread_mutex_unlock(&_mutex);
+}
+
+#endif
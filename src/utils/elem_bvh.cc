@@ -0,0 +1,319 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+
+#include <algorithm>
+
+#include "elem.h"
+#include "elem_bvh.h"
+
+
+// max number of elements in a leaf
+static const unsigned int bvh_leaf_size = 4;
+
+// max depth of the tree traversal stack
+static const unsigned int bvh_stack_size = 128;
+
+
+namespace {
+  // compare element centroid along a given axis, used for median split
+  struct CentroidLess
+  {
+    CentroidLess(const std::vector<Point> & c, unsigned int a) : centroid(c), axis(a) {}
+    bool operator()(unsigned int i, unsigned int j) const
+    { return centroid[i](axis) < centroid[j](axis); }
+    const std::vector<Point> & centroid;
+    unsigned int axis;
+  };
+}
+
+
+ElemBVH::ElemBVH(const std::vector<const Elem *> & elems)
+  : _elems(elems)
+{
+  if(_elems.empty()) return;
+
+  std::vector<std::pair<Point, Point> > bbox(_elems.size());
+  std::vector<Point> centroid(_elems.size());
+  for(unsigned int n=0; n<_elems.size(); ++n)
+  {
+    const Elem * elem = _elems[n];
+    Point lo = elem->point(0);
+    Point hi = elem->point(0);
+    for(unsigned int i=1; i<elem->n_nodes(); ++i)
+      for(unsigned int a=0; a<3; ++a)
+      {
+        lo(a) = std::min(lo(a), elem->point(i)(a));
+        hi(a) = std::max(hi(a), elem->point(i)(a));
+      }
+    // pad the box a bit, also gives flat (2D) element a nonzero thickness
+    const double pad = 1e-6*(hi-lo).size();
+    for(unsigned int a=0; a<3; ++a)
+    {
+      lo(a) -= pad;
+      hi(a) += pad;
+    }
+    bbox[n] = std::make_pair(lo, hi);
+    centroid[n] = 0.5*(lo+hi);
+  }
+
+  _nodes.reserve(2*_elems.size()/bvh_leaf_size + 1);
+  _build(0, _elems.size(), bbox, centroid);
+}
+
+
+
+unsigned int ElemBVH::_build(unsigned int begin, unsigned int end,
+                             std::vector<std::pair<Point, Point> > & bbox,
+                             std::vector<Point> & centroid)
+{
+  const unsigned int index = _nodes.size();
+  _nodes.push_back(BVHNode());
+
+  Point lo = bbox[begin].first,  hi = bbox[begin].second;
+  Point clo = centroid[begin],   chi = centroid[begin];
+  for(unsigned int n=begin+1; n<end; ++n)
+    for(unsigned int a=0; a<3; ++a)
+    {
+      lo(a)  = std::min(lo(a),  bbox[n].first(a));
+      hi(a)  = std::max(hi(a),  bbox[n].second(a));
+      clo(a) = std::min(clo(a), centroid[n](a));
+      chi(a) = std::max(chi(a), centroid[n](a));
+    }
+
+  for(unsigned int a=0; a<3; ++a)
+  {
+    _nodes[index].lo[a] = lo(a);
+    _nodes[index].hi[a] = hi(a);
+  }
+
+  // split along the longest axis of centroid box
+  unsigned int axis = 0;
+  for(unsigned int a=1; a<3; ++a)
+    if( chi(a)-clo(a) > chi(axis)-clo(axis) ) axis = a;
+
+  if( end-begin <= bvh_leaf_size )
+  {
+    _nodes[index].offset = begin;
+    _nodes[index].count  = end-begin;
+    _nodes[index].axis   = 0;
+    return index;
+  }
+
+  // median split, reorder elements and their boxes together
+  const unsigned int mid = (begin+end)/2;
+  {
+    std::vector<unsigned int> order(end-begin);
+    for(unsigned int n=begin; n<end; ++n) order[n-begin] = n;
+    std::nth_element(order.begin(), order.begin()+(mid-begin), order.end(), CentroidLess(centroid, axis));
+
+    std::vector<const Elem *> elems(end-begin);
+    std::vector<std::pair<Point, Point> > boxes(end-begin);
+    std::vector<Point> centers(end-begin);
+    for(unsigned int n=0; n<order.size(); ++n)
+    {
+      elems[n]   = _elems[order[n]];
+      boxes[n]   = bbox[order[n]];
+      centers[n] = centroid[order[n]];
+    }
+    std::copy(elems.begin(), elems.end(), _elems.begin()+begin);
+    std::copy(boxes.begin(), boxes.end(), bbox.begin()+begin);
+    std::copy(centers.begin(), centers.end(), centroid.begin()+begin);
+  }
+
+  _build(begin, mid, bbox, centroid);
+  const unsigned int right = _build(mid, end, bbox, centroid);
+
+  _nodes[index].offset = right;
+  _nodes[index].count  = 0;
+  _nodes[index].axis   = axis;
+  return index;
+}
+
+
+
+void ElemBVH::_inverse_dir(const Point & d, double * inv)
+{
+  for(unsigned int a=0; a<3; ++a)
+  {
+    const double da = d(a);
+    if( std::abs(da) < 1e-300 )
+      inv[a] = da < 0.0 ? -1e300 : 1e300;
+    else
+      inv[a] = 1.0/da;
+  }
+}
+
+
+
+bool ElemBVH::_hit_box(const BVHNode & node, const double * p, const double * inv, double tmax)
+{
+  double tmin = -1e30;
+  for(unsigned int a=0; a<3; ++a)
+  {
+    const double t1 = (node.lo[a] - p[a])*inv[a];
+    const double t2 = (node.hi[a] - p[a])*inv[a];
+    tmin = std::max(tmin, std::min(t1, t2));
+    tmax = std::min(tmax, std::max(t1, t2));
+  }
+  return tmax >= 0.0 && tmin <= tmax;
+}
+
+
+
+const Elem * ElemBVH::hit(const Point & p, const Point & d) const
+{
+  if(_nodes.empty()) return NULL;
+
+  const double o[3] = { p(0), p(1), p(2) };
+  double inv[3];
+  _inverse_dir(d, inv);
+
+  const Elem * hit_elem = NULL;
+  double dist = 1e30;
+
+  unsigned int stack[bvh_stack_size];
+  unsigned int sp = 0;
+  stack[sp++] = 0;
+  while(sp)
+  {
+    const unsigned int index = stack[--sp];
+    const BVHNode & node = _nodes[index];
+    if( !_hit_box(node, o, inv, dist) ) continue;
+
+    if(node.count)
+    {
+      for(unsigned int n=node.offset; n<node.offset+node.count; ++n)
+      {
+        IntersectionResult result;
+        _elems[n]->ray_hit(p, d, result);
+        if(result.state!=Missed && result.hit_points[0].t < dist)
+        {
+          dist     = result.hit_points[0].t;
+          hit_elem = _elems[n];
+        }
+      }
+      continue;
+    }
+
+    // visit the near child first
+    genius_assert(sp+2 <= bvh_stack_size);
+    if( d(node.axis) < 0.0 )
+    {
+      stack[sp++] = index+1;
+      stack[sp++] = node.offset;
+    }
+    else
+    {
+      stack[sp++] = node.offset;
+      stack[sp++] = index+1;
+    }
+  }
+
+  return hit_elem;
+}
+
+
+
+void ElemBVH::hit(unsigned int n, const Point * p, const Point * d, const Elem ** elems) const
+{
+  for(unsigned int begin=0; begin<n; begin+=packet_size)
+  {
+    const unsigned int m = std::min(packet_size, n-begin);
+
+    // SoA layout of the packet
+    double o[3][packet_size];
+    double inv[3][packet_size];
+    double dist[packet_size];
+    bool   active[packet_size];
+    for(unsigned int k=0; k<m; ++k)
+    {
+      double inv_k[3];
+      _inverse_dir(d[begin+k], inv_k);
+      for(unsigned int a=0; a<3; ++a)
+      {
+        o[a][k]   = p[begin+k](a);
+        inv[a][k] = inv_k[a];
+      }
+      dist[k] = 1e30;
+      elems[begin+k] = NULL;
+    }
+
+    if(_nodes.empty()) continue;
+
+    unsigned int stack[bvh_stack_size];
+    unsigned int sp = 0;
+    stack[sp++] = 0;
+    while(sp)
+    {
+      const unsigned int index = stack[--sp];
+      const BVHNode & node = _nodes[index];
+
+      // slab test of all the rays in the packet against this node
+      bool any = false;
+      for(unsigned int k=0; k<m; ++k)
+      {
+        double tmin = -1e30, tmax = dist[k];
+        for(unsigned int a=0; a<3; ++a)
+        {
+          const double t1 = (node.lo[a] - o[a][k])*inv[a][k];
+          const double t2 = (node.hi[a] - o[a][k])*inv[a][k];
+          tmin = std::max(tmin, std::min(t1, t2));
+          tmax = std::min(tmax, std::max(t1, t2));
+        }
+        active[k] = tmax >= 0.0 && tmin <= tmax;
+        any = any || active[k];
+      }
+      if(!any) continue;
+
+      if(node.count)
+      {
+        for(unsigned int i=node.offset; i<node.offset+node.count; ++i)
+          for(unsigned int k=0; k<m; ++k)
+          {
+            if(!active[k]) continue;
+            IntersectionResult result;
+            _elems[i]->ray_hit(p[begin+k], d[begin+k], result);
+            if(result.state!=Missed && result.hit_points[0].t < dist[k])
+            {
+              dist[k] = result.hit_points[0].t;
+              elems[begin+k] = _elems[i];
+            }
+          }
+        continue;
+      }
+
+      // near child first, ordered by the leading ray of the packet
+      genius_assert(sp+2 <= bvh_stack_size);
+      if( d[begin](node.axis) < 0.0 )
+      {
+        stack[sp++] = index+1;
+        stack[sp++] = node.offset;
+      }
+      else
+      {
+        stack[sp++] = node.offset;
+        stack[sp++] = index+1;
+      }
+    }
+  }
+}
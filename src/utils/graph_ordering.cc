@@ -0,0 +1,226 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+
+// C++ includes
+#include <algorithm>
+
+// Local includes
+#include "graph_ordering.h"
+
+
+namespace
+{
+
+  /**
+   * breadth first search from vertex \p root over vertices not yet numbered,
+   * \p depth is set to the number of levels of the rooted level structure.
+   * @return the vertex with minimal degree in the last level
+   */
+  unsigned int _level_structure(const std::vector<unsigned int> & xadj,
+                                const std::vector<unsigned int> & adjncy,
+                                unsigned int root,
+                                std::vector<int> & mark,
+                                int stamp,
+                                unsigned int & depth)
+  {
+    std::vector<unsigned int> front(1, root), next;
+    mark[root] = stamp;
+    depth = 0;
+    unsigned int last = root;
+
+    while (!front.empty())
+    {
+      unsigned int min_degree = invalid_uint;
+      for (unsigned int i=0; i<front.size(); ++i)
+      {
+        unsigned int v = front[i];
+        unsigned int degree = xadj[v+1] - xadj[v];
+        if (degree < min_degree) { min_degree = degree; last = v; }
+
+        for (unsigned int j=xadj[v]; j<xadj[v+1]; ++j)
+        {
+          unsigned int w = adjncy[j];
+          if (mark[w] == stamp || mark[w] == -1) continue;
+          mark[w] = stamp;
+          next.push_back(w);
+        }
+      }
+      if (next.empty()) break;
+      front.swap(next);
+      next.clear();
+      ++depth;
+    }
+    return last;
+  }
+
+
+  /**
+   * the Hilbert index of integer coordinate (x, y, z) with \p bits per axis.
+   * the transpose form of J. Skilling, "Programming the Hilbert curve", AIP Conf. Proc. 707, 2004
+   */
+  unsigned long long _hilbert_index(unsigned int x[3], unsigned int bits)
+  {
+    const unsigned int n = 3;
+    unsigned int M = 1U << (bits-1);
+
+    // inverse undo
+    for (unsigned int Q = M; Q > 1; Q >>= 1)
+    {
+      unsigned int P = Q - 1;
+      for (unsigned int i=0; i<n; ++i)
+      {
+        if (x[i] & Q) x[0] ^= P;
+        else
+        {
+          unsigned int t = (x[0] ^ x[i]) & P;
+          x[0] ^= t;
+          x[i] ^= t;
+        }
+      }
+    }
+
+    // gray encode
+    for (unsigned int i=1; i<n; ++i) x[i] ^= x[i-1];
+    unsigned int t = 0;
+    for (unsigned int Q = M; Q > 1; Q >>= 1)
+      if (x[n-1] & Q) t ^= Q - 1;
+    for (unsigned int i=0; i<n; ++i) x[i] ^= t;
+
+    // interleave the transposed bits, the most significant bit of x[0] goes first
+    unsigned long long h = 0;
+    for (int b = bits-1; b >= 0; --b)
+      for (unsigned int i=0; i<n; ++i)
+        h = (h << 1) | ((x[i] >> b) & 1U);
+    return h;
+  }
+
+}
+
+
+
+namespace GraphOrdering
+{
+
+  void reverse_cuthill_mckee(const std::vector<unsigned int> & xadj,
+                             const std::vector<unsigned int> & adjncy,
+                             std::vector<unsigned int> & order)
+  {
+    genius_assert(!xadj.empty());
+    const unsigned int n = xadj.size() - 1;
+
+    order.clear();
+    order.reserve(n);
+
+    // -1 means the vertex is already numbered
+    std::vector<int> mark(n, 0);
+    int stamp = 0;
+
+    // vertex sorted by degree, the start vertex of each component is searched from it
+    std::vector< std::pair<unsigned int, unsigned int> > degree_vertex(n);
+    for (unsigned int v=0; v<n; ++v)
+      degree_vertex[v] = std::make_pair(xadj[v+1] - xadj[v], v);
+    std::sort(degree_vertex.begin(), degree_vertex.end());
+
+    std::vector< std::pair<unsigned int, unsigned int> > neighbors;
+    for (unsigned int k=0; k<n; ++k)
+    {
+      unsigned int root = degree_vertex[k].second;
+      if (mark[root] == -1) continue;
+
+      // find a pseudo-peripheral vertex by George-Liu algorithm
+      unsigned int depth = 0;
+      unsigned int last = _level_structure(xadj, adjncy, root, mark, ++stamp, depth);
+      for (unsigned int it=0; it<8; ++it)
+      {
+        unsigned int new_depth = 0;
+        unsigned int new_last = _level_structure(xadj, adjncy, last, mark, ++stamp, new_depth);
+        if (new_depth <= depth) break;
+        root  = last;
+        last  = new_last;
+        depth = new_depth;
+      }
+
+      // Cuthill-McKee breadth first search, neighbors visited by increasing degree
+      std::size_t head = order.size();
+      order.push_back(root);
+      mark[root] = -1;
+      while (head < order.size())
+      {
+        unsigned int v = order[head++];
+        neighbors.clear();
+        for (unsigned int j=xadj[v]; j<xadj[v+1]; ++j)
+        {
+          unsigned int w = adjncy[j];
+          if (mark[w] == -1) continue;
+          mark[w] = -1;
+          neighbors.push_back(std::make_pair(xadj[w+1] - xadj[w], w));
+        }
+        std::sort(neighbors.begin(), neighbors.end());
+        for (unsigned int j=0; j<neighbors.size(); ++j)
+          order.push_back(neighbors[j].second);
+      }
+    }
+
+    genius_assert(order.size() == n);
+
+    // reverse it
+    std::reverse(order.begin(), order.end());
+  }
+
+
+
+  void hilbert(const std::vector<Point> & pts, std::vector<unsigned int> & order)
+  {
+    const unsigned int n = pts.size();
+    const unsigned int bits = 21; // 3*21 bits fit in the 64bit key
+
+    order.resize(n);
+    if (n == 0) return;
+
+    Point min = pts[0], max = pts[0];
+    for (unsigned int i=1; i<n; ++i)
+      for (unsigned int d=0; d<3; ++d)
+      {
+        min(d) = std::min(min(d), pts[i](d));
+        max(d) = std::max(max(d), pts[i](d));
+      }
+
+    const Real scale = static_cast<Real>((1U << bits) - 1);
+    std::vector< std::pair<unsigned long long, unsigned int> > keys(n);
+    for (unsigned int i=0; i<n; ++i)
+    {
+      unsigned int x[3];
+      for (unsigned int d=0; d<3; ++d)
+      {
+        Real extent = max(d) - min(d);
+        x[d] = extent > 0 ? static_cast<unsigned int>((pts[i](d) - min(d))/extent*scale) : 0;
+      }
+      keys[i] = std::make_pair(_hilbert_index(x, bits), i);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    for (unsigned int i=0; i<n; ++i)
+      order[i] = keys[i].second;
+  }
+
+}